@@ -0,0 +1,53 @@
+#include "vslrt.h"
+#include "benchmark/benchmark.h"
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+// keeps a number of objects alive, replacing a random one at a time, which is
+//  roughly what a vsl program does with its temporaries
+template<typename Alloc, typename Free>
+static void churn(benchmark::State& state, Alloc alloc, Free free)
+{
+    std::vector<void*> live(static_cast<size_t>(state.range(0)));
+    for (void*& obj : live)
+    {
+        obj = alloc();
+    }
+    std::mt19937 rng{ 0 };
+    std::vector<size_t> victims(4096);
+    for (size_t& victim : victims)
+    {
+        victim = rng() % live.size();
+    }
+    while (state.KeepRunning())
+    {
+        for (size_t victim : victims)
+        {
+            free(live[victim]);
+            live[victim] = alloc();
+            benchmark::DoNotOptimize(live[victim]);
+        }
+    }
+    for (void* obj : live)
+    {
+        free(obj);
+    }
+    state.SetItemsProcessed(state.iterations() * victims.size());
+}
+
+// a 32 byte object, e.g. a refcount and a few fields
+static void BM_AllocMalloc(benchmark::State& state)
+{
+    churn(state, [] { return std::malloc(32); },
+        [](void* ptr) { std::free(ptr); });
+}
+BENCHMARK(BM_AllocMalloc)->Arg(16)->Arg(1024)->Arg(65536);
+
+static void BM_AllocPool(benchmark::State& state)
+{
+    churn(state, [] { return vsl_alloc(1); },
+        [](void* ptr) { vsl_free(ptr, 1); });
+}
+BENCHMARK(BM_AllocPool)->Arg(16)->Arg(1024)->Arg(65536);
@@ -0,0 +1,235 @@
+#include "corpus.hpp"
+#include <random>
+
+namespace
+{
+
+/**
+ * Writes out a program one function at a time.
+ */
+class Generator
+{
+public:
+    Generator(const CorpusShape& shape, unsigned seed)
+        : shape{ shape }, rng{ seed }, numVars{ 0 }
+    {
+    }
+    std::string run()
+    {
+        for (size_t i = 0; i < shape.classes; ++i)
+        {
+            genClass(i);
+        }
+        for (size_t i = 0; i < shape.funcs; ++i)
+        {
+            genFunc(i);
+        }
+        return std::move(s);
+    }
+
+private:
+    // a class with a field of each type, which functions can construct
+    void genClass(size_t i)
+    {
+        std::string n = std::to_string(i);
+        s += "public class C" + n + "\n"
+            "{\n"
+            "    public var x: Int;\n"
+            "    private let y: Bool;\n"
+            "    public init(x: Int, y: Bool)\n"
+            "    {\n"
+            "        self.x = x;\n"
+            "        self.y = y;\n"
+            "    }\n"
+            "    public func get(scale: Int) -> Int\n"
+            "    {\n"
+            "        return self.y ? self.x * scale : -self.x;\n"
+            "    }\n"
+            "}\n\n";
+    }
+    // a function that starts with one big expression, then does a bunch of
+    //  random things with the variables it has so far
+    void genFunc(size_t i)
+    {
+        numVars = 0;
+        s += "public func f" + std::to_string(i) + "(a: Int, b: Int) -> Int\n"
+            "{\n"
+            "    var v0: Int = ";
+        genExpr(shape.exprDepth);
+        s += ";\n";
+        ++numVars;
+        for (size_t j = 0; j < shape.statements; ++j)
+        {
+            s += "    ";
+            genStatement(i, j);
+        }
+        s += "    return " + randomVar() + ";\n"
+            "}\n\n";
+    }
+    void genStatement(size_t func, size_t index)
+    {
+        switch (rng() % 5)
+        {
+        case 0:
+            // the new variable isn't in scope until after its initializer
+            s += "var v" + std::to_string(numVars) + ": Int = ";
+            genExpr(3);
+            s += ";\n";
+            ++numVars;
+            break;
+        case 1:
+            s += "if (";
+            genCond();
+            s += ") { " + randomVar() + " = ";
+            genExpr(2);
+            s += "; } else { " + randomVar() + " = ";
+            genExpr(2);
+            s += "; }\n";
+            break;
+        case 2:
+            // only earlier functions are called, which keeps the call graph
+            //  acyclic like most real code
+            if (func)
+            {
+                s += randomVar() + " = f" + std::to_string(rng() % func) +
+                    "(a: ";
+                genExpr(1);
+                s += ", b: " + randomVar() + ");\n";
+                break;
+            }
+            // fallthrough
+        case 3:
+            if (shape.classes)
+            {
+                std::string c = "C" + std::to_string(rng() % shape.classes);
+                std::string o = "o" + std::to_string(index);
+                s += "let " + o + ": " + c + " = " + c + "(x: ";
+                genExpr(1);
+                s += ", y: ";
+                genCond();
+                s += "); " + randomVar() + " = " + o + ".get(scale: " +
+                    randomVar() + ");\n";
+                break;
+            }
+            // fallthrough
+        default:
+            s += randomVar() + " = ";
+            genExpr(3);
+            s += ";\n";
+            break;
+        }
+    }
+    // nests operations down one side, so the size stays linear in the depth
+    void genExpr(size_t depth)
+    {
+        if (!depth)
+        {
+            genLeaf();
+            return;
+        }
+        static const char* const ops[] = { " + ", " - ", " * ", " / ",
+            " % " };
+        const char* op = ops[rng() % 5];
+        s += '(';
+        switch (rng() % 8)
+        {
+        case 0:
+            genCond();
+            s += " ? ";
+            genExpr(depth - 1);
+            s += " : ";
+            genLeaf();
+            break;
+        case 1:
+        case 2:
+            // never divide by zero
+            if (op[1] != '/' && op[1] != '%')
+            {
+                genLeaf();
+                s += op;
+                genExpr(depth - 1);
+                break;
+            }
+            // fallthrough
+        default:
+            genExpr(depth - 1);
+            s += op;
+            if (op[1] == '/' || op[1] == '%')
+            {
+                s += std::to_string(1 + rng() % 99);
+            }
+            else
+            {
+                genLeaf();
+            }
+            break;
+        }
+        s += ')';
+    }
+    void genCond()
+    {
+        static const char* const ops[] = { " < ", " <= ", " > ", " >= ",
+            " == ", " != " };
+        switch (rng() % 4)
+        {
+        case 0:
+            s += "!(";
+            genLeaf();
+            s += ops[rng() % 6];
+            genLeaf();
+            s += ')';
+            break;
+        case 1:
+            genLeaf();
+            s += ops[rng() % 6];
+            genLeaf();
+            s += rng() % 2 ? " && " : " || ";
+            genLeaf();
+            s += ops[rng() % 6];
+            genLeaf();
+            break;
+        default:
+            genLeaf();
+            s += ops[rng() % 6];
+            genLeaf();
+            break;
+        }
+    }
+    void genLeaf()
+    {
+        switch (rng() % 5)
+        {
+        case 0:
+            s += 'a';
+            break;
+        case 1:
+            s += 'b';
+            break;
+        case 2:
+            s += std::to_string(rng() % 1000);
+            break;
+        case 3:
+            s += '-' + randomVar();
+            break;
+        default:
+            s += numVars ? randomVar() : "a";
+            break;
+        }
+    }
+    std::string randomVar()
+    {
+        return numVars ? "v" + std::to_string(rng() % numVars) : "b";
+    }
+    const CorpusShape& shape;
+    std::mt19937 rng;
+    std::string s;
+    /** Number of variables declared so far in the current function. */
+    size_t numVars;
+};
+
+} // end anonymous namespace
+
+std::string makeCorpus(const CorpusShape& shape, unsigned seed)
+{
+    return Generator{ shape, seed }.run();
+}
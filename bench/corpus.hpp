@@ -0,0 +1,38 @@
+#ifndef CORPUS_HPP
+#define CORPUS_HPP
+
+#include <cstddef>
+#include <string>
+
+/**
+ * The shape of a generated VSL program. Each part scales on its own, so a
+ * benchmark can find out how a stage copes with e.g. lots of small functions
+ * versus a few huge ones.
+ */
+struct CorpusShape
+{
+    /** Number of free functions. */
+    size_t funcs;
+    /**
+     * Number of classes, each with a couple of fields, an init and a method.
+     * The functions construct them and call their methods.
+     */
+    size_t classes;
+    /** How deeply the expression that starts each function is nested. */
+    size_t exprDepth;
+    /** Number of statements in each function after that expression. */
+    size_t statements;
+};
+
+/**
+ * Generates a valid VSL program, which is the same every time for the same
+ * shape and seed.
+ *
+ * @param shape The shape of the program.
+ * @param seed Seeds the choice of operators, operands and statements.
+ *
+ * @returns The source code.
+ */
+std::string makeCorpus(const CorpusShape& shape, unsigned seed = 0);
+
+#endif // CORPUS_HPP
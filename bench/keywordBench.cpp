@@ -0,0 +1,79 @@
+#include "lexer/tokenKind.hpp"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "benchmark/benchmark.h"
+#include <random>
+#include <string>
+#include <vector>
+
+// the way getKeywordKind used to work, for comparison
+static const llvm::StringMap<TokenKind> keywordMap
+{
+    /** @cond */
+#define KEYWORD(kind, name) { name, TokenKind::KW_ ## kind },
+    /** @endcond */
+#include "lexer/tokenKind.def"
+};
+
+// a mix of keywords and identifiers, like what the lexer sees in practice
+static const std::vector<std::string>& getWords()
+{
+    static std::vector<std::string> words;
+    if (!words.empty())
+    {
+        return words;
+    }
+    std::mt19937 rng{ 0 };
+    static const char chars[] = "abcdefghijklmnopqrstuvwxyz"
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+    std::vector<llvm::StringRef> keywords;
+    for (const auto& entry : keywordMap)
+    {
+        keywords.push_back(entry.getKey());
+    }
+    for (size_t i = 0; i < 4096; ++i)
+    {
+        if (rng() % 3 == 0)
+        {
+            words.push_back(keywords[rng() % keywords.size()].str());
+            continue;
+        }
+        std::string word(1, chars[rng() % 52]);
+        for (size_t len = rng() % 12; len; --len)
+        {
+            word += chars[rng() % (sizeof(chars) - 1)];
+        }
+        words.push_back(word);
+    }
+    return words;
+}
+
+static void BM_KeywordPerfectHash(benchmark::State& state)
+{
+    const std::vector<std::string>& words = getWords();
+    while (state.KeepRunning())
+    {
+        for (const std::string& word : words)
+        {
+            benchmark::DoNotOptimize(getKeywordKind(word));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * words.size());
+}
+BENCHMARK(BM_KeywordPerfectHash);
+
+static void BM_KeywordStringMap(benchmark::State& state)
+{
+    const std::vector<std::string>& words = getWords();
+    while (state.KeepRunning())
+    {
+        for (const std::string& word : words)
+        {
+            auto it = keywordMap.find(word);
+            benchmark::DoNotOptimize(it == keywordMap.end() ?
+                TokenKind::IDENTIFIER : it->getValue());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * words.size());
+}
+BENCHMARK(BM_KeywordStringMap);
@@ -0,0 +1,121 @@
+#include "diag/diag.hpp"
+#include "lexer/vslLexer.hpp"
+#include "benchmark/benchmark.h"
+#include <random>
+#include <string>
+
+// roughly how much source code each benchmark lexes
+static constexpr size_t inputSize = 1 << 20;
+
+// generates ordinary looking vsl code
+static std::string makeCode()
+{
+    std::mt19937 rng{ 0 };
+    std::string s;
+    for (size_t i = 0; s.size() < inputSize; ++i)
+    {
+        std::string n = std::to_string(i);
+        s += "// computes something interesting\n"
+            "public func function" + n + "(value: Int, other: Int) -> Int\n"
+            "{\n"
+            "    let result" + n + " = value * " +
+            std::to_string(rng() % 1000) + " + other;\n"
+            "    if (result" + n + " >= 42 && other != 0)\n"
+            "    {\n"
+            "        return result" + n + " % other;\n"
+            "    }\n"
+            "    /* fall back to the original value */\n"
+            "    return value;\n"
+            "}\n\n";
+    }
+    return s;
+}
+
+// generates long identifiers separated by single spaces
+static std::string makeIdents()
+{
+    std::mt19937 rng{ 0 };
+    static const char chars[] = "abcdefghijklmnopqrstuvwxyz"
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+    std::string s;
+    while (s.size() < inputSize)
+    {
+        s += chars[rng() % 52];
+        for (size_t len = 8 + rng() % 56; len; --len)
+        {
+            s += chars[rng() % (sizeof(chars) - 1)];
+        }
+        s += ' ';
+    }
+    return s;
+}
+
+// generates deeply indented statements
+static std::string makeWhitespace()
+{
+    std::string s;
+    for (size_t depth = 0; s.size() < inputSize; depth = (depth + 1) % 16)
+    {
+        s += std::string(depth * 4, ' ') + "x = 1;\n\n";
+    }
+    return s;
+}
+
+// generates mostly comments
+static std::string makeComments()
+{
+    std::string s;
+    while (s.size() < inputSize)
+    {
+        s += "// a line comment that goes on for quite a while, like most do\n"
+            "/* a block comment\n   that spans a couple of lines\n */\n"
+            "x;\n";
+    }
+    return s;
+}
+
+// lexes the given source over and over
+static void lexInput(benchmark::State& state, const std::string& src)
+{
+    Diag diag{ llvm::nulls() };
+    size_t tokens = 0;
+    while (state.KeepRunning())
+    {
+        VSLLexer lexer{ diag, src };
+        while (lexer.nextToken().isNot(TokenKind::END))
+        {
+            ++tokens;
+        }
+    }
+    benchmark::DoNotOptimize(tokens);
+    state.SetBytesProcessed(state.iterations() * src.size());
+    state.SetItemsProcessed(tokens);
+}
+
+static void BM_LexCode(benchmark::State& state)
+{
+    static const std::string src = makeCode();
+    lexInput(state, src);
+}
+BENCHMARK(BM_LexCode);
+
+static void BM_LexIdents(benchmark::State& state)
+{
+    static const std::string src = makeIdents();
+    lexInput(state, src);
+}
+BENCHMARK(BM_LexIdents);
+
+static void BM_LexWhitespace(benchmark::State& state)
+{
+    static const std::string src = makeWhitespace();
+    lexInput(state, src);
+}
+BENCHMARK(BM_LexWhitespace);
+
+static void BM_LexComments(benchmark::State& state)
+{
+    static const std::string src = makeComments();
+    lexInput(state, src);
+}
+BENCHMARK(BM_LexComments);
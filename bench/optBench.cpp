@@ -0,0 +1,358 @@
+#include "ast/vslContext.hpp"
+#include "codegen/codegen.hpp"
+#include "diag/diag.hpp"
+#include "irgen/irgen.hpp"
+#include "lexer/vslLexer.hpp"
+#include "parser/vslParser.hpp"
+#include "vslrt.h"
+#include "llvm/ExecutionEngine/ExecutionEngine.h"
+#include "llvm/ExecutionEngine/MCJIT.h"
+#include "llvm/ExecutionEngine/SectionMemoryManager.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/DynamicLibrary.h"
+#include "benchmark/benchmark.h"
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+// naive recursion, mostly function call overhead
+static const char* const fibSrc =
+    "public func run(n: Int) -> Int\n"
+    "{\n"
+    "    if (n < 2) return n;\n"
+    "    return run(n: n - 1) + run(n: n - 2);\n"
+    "}\n";
+
+// lots of tiny helpers that should get inlined
+static const char* const helpersSrc =
+    "private func square(x: Int) -> Int { return x * x; }\n"
+    "private func clamp(x: Int) -> Int { return x > 1000 ? x % 1000 : x; }\n"
+    "private func mix(a: Int, b: Int) -> Int\n"
+    "{\n"
+    "    return clamp(x: square(x: a) + b * 3 - a / 7);\n"
+    "}\n"
+    "private func loop(n: Int, acc: Int) -> Int\n"
+    "{\n"
+    "    if (n == 0) return acc;\n"
+    "    return loop(n: n - 1, acc: mix(a: acc, b: n));\n"
+    "}\n"
+    "public func run(n: Int) -> Int { return loop(n: n * 1000, acc: 1); }\n";
+
+// objects whose fields only live in locals, which SROA can break apart
+static const char* const objectsSrc =
+    "public class Point\n"
+    "{\n"
+    "    public var x: Int;\n"
+    "    public var y: Int;\n"
+    "    public init(x: Int, y: Int) { self.x = x; self.y = y; }\n"
+    "    public func dot(p: Point) -> Int\n"
+    "    {\n"
+    "        return self.x * p.x + self.y * p.y;\n"
+    "    }\n"
+    "}\n"
+    "private func walk(n: Int, acc: Int) -> Int\n"
+    "{\n"
+    "    if (n == 0) return acc;\n"
+    "    let a = Point(x: n, y: acc % 100);\n"
+    "    let b = Point(x: acc % 7, y: n);\n"
+    "    return walk(n: n - 1, acc: (acc + a.dot(p: b)) % 100000);\n"
+    "}\n"
+    "public func run(n: Int) -> Int { return walk(n: n * 100, acc: 1); }\n";
+
+// keeps copying an object in and out of a field, so every iteration has to
+//  update its refcount a few times
+static const char* const sharingSrc =
+    "public class Box\n"
+    "{\n"
+    "    public var v: Int;\n"
+    "    public init(v: Int) { self.v = v; }\n"
+    "}\n"
+    "public class Holder\n"
+    "{\n"
+    "    public var box: Box;\n"
+    "    public init(box: Box) { self.box = box; }\n"
+    "}\n"
+    "private func churn(h: Holder, n: Int, acc: Int) -> Int\n"
+    "{\n"
+    "    if (n == 0) return acc;\n"
+    "    let b = h.box;\n"
+    "    h.box = b;\n"
+    "    return churn(h: h, n: n - 1, acc: (acc + b.v) % 100000);\n"
+    "}\n"
+    "public func run(n: Int) -> Int\n"
+    "{\n"
+    "    let h = Holder(box: Box(v: 3));\n"
+    "    return churn(h: h, n: n * 1000, acc: 1);\n"
+    "}\n";
+
+// replaces the object in a field every time, so it can't avoid allocating
+static const char* const churnSrc =
+    "public class Box\n"
+    "{\n"
+    "    public var v: Int;\n"
+    "    public init(v: Int) { self.v = v; }\n"
+    "}\n"
+    "public class Holder\n"
+    "{\n"
+    "    public var box: Box;\n"
+    "    public init(box: Box) { self.box = box; }\n"
+    "}\n"
+    "private func churn(h: Holder, n: Int, acc: Int) -> Int\n"
+    "{\n"
+    "    if (n == 0) return acc;\n"
+    "    h.box = Box(v: n % 13);\n"
+    "    return churn(h: h, n: n - 1, acc: (acc + h.box.v) % 100000);\n"
+    "}\n"
+    "public func run(n: Int) -> Int\n"
+    "{\n"
+    "    let h = Holder(box: Box(v: 0));\n"
+    "    return churn(h: h, n: n * 1000, acc: 1);\n"
+    "}\n";
+
+// small methods calling each other through self
+static const char* const methodsSrc =
+    "public class Counter\n"
+    "{\n"
+    "    private var count: Int;\n"
+    "    private var step: Int;\n"
+    "    public init(step: Int) { self.count = 0; self.step = step; }\n"
+    "    public func get() -> Int { return self.count; }\n"
+    "    public func bump() -> Void\n"
+    "    {\n"
+    "        self.count = (self.count + self.step) % 100000;\n"
+    "    }\n"
+    "    public func twice() -> Void { self.bump(); self.bump(); }\n"
+    "}\n"
+    "private func loop(c: Counter, n: Int) -> Int\n"
+    "{\n"
+    "    if (n == 0) return c.get();\n"
+    "    c.twice();\n"
+    "    c.bump();\n"
+    "    return loop(c: c, n: n - 1);\n"
+    "}\n"
+    "public func run(n: Int) -> Int\n"
+    "{\n"
+    "    return loop(c: Counter(step: n), n: n * 1000);\n"
+    "}\n";
+
+// lots of short circuiting and ternaries, which are all branches at -O0
+static const char* const branchesSrc =
+    "private func pick(a: Int, b: Int) -> Int\n"
+    "{\n"
+    "    return (a > b && a % 3 != 0) || b % 7 == 0 ? a - b :\n"
+    "        (a < 100 || (b > 500 && !(a == b)) ? b : a + 1);\n"
+    "}\n"
+    "private func loop(n: Int, acc: Int) -> Int\n"
+    "{\n"
+    "    if (n == 0) return acc;\n"
+    "    let a = (acc * 31 + n) % 1000;\n"
+    "    return loop(n: n - 1, acc: (acc + pick(a: a, b: n % 997)) % 1000);\n"
+    "}\n"
+    "public func run(n: Int) -> Int { return loop(n: n * 1000, acc: 1); }\n";
+
+// counts the calls that compiled programs make to allocate and free objects
+static size_t numAllocs;
+static size_t numFrees;
+
+static void* countMalloc(size_t size)
+{
+    ++numAllocs;
+    return std::malloc(size);
+}
+
+static void countFree(void* ptr)
+{
+    ++numFrees;
+    std::free(ptr);
+}
+
+static void* countPoolAlloc(uint32_t sizeClass)
+{
+    ++numAllocs;
+    return vsl_alloc(sizeClass);
+}
+
+static void countPoolFree(void* ptr, uint32_t sizeClass)
+{
+    ++numFrees;
+    vsl_free(ptr, sizeClass);
+}
+
+// links compiled programs to the counting versions of the allocator
+class CountingMemoryManager : public llvm::SectionMemoryManager
+{
+public:
+    uint64_t getSymbolAddress(const std::string& name) override
+    {
+        llvm::StringRef symbol = name;
+#ifdef __APPLE__
+        symbol.consume_front("_");
+#endif
+        void* address = nullptr;
+        if (symbol == "malloc")
+        {
+            address = reinterpret_cast<void*>(&countMalloc);
+        }
+        else if (symbol == "free")
+        {
+            address = reinterpret_cast<void*>(&countFree);
+        }
+        else if (symbol == "vsl_alloc")
+        {
+            address = reinterpret_cast<void*>(&countPoolAlloc);
+        }
+        else if (symbol == "vsl_free")
+        {
+            address = reinterpret_cast<void*>(&countPoolFree);
+        }
+        else
+        {
+            return llvm::SectionMemoryManager::getSymbolAddress(name);
+        }
+        return reinterpret_cast<uint64_t>(address);
+    }
+};
+
+// compiles a program with the given optimization level and size level passed
+//  as arguments, then times calls to its run() function and counts how many
+//  objects each call allocates and frees
+static void runProgram(benchmark::State& state, const char* src, int32_t n,
+    const IRGenOptions& options = {})
+{
+    auto optLevel = static_cast<unsigned>(state.range(0));
+    auto sizeLevel = static_cast<unsigned>(state.range(1));
+    VSLContext vslCtx;
+    Diag diag{ llvm::errs() };
+    VSLLexer lexer{ diag, src };
+    VSLParser parser{ vslCtx, lexer };
+    parser.parse();
+    llvm::LLVMContext llvmContext;
+    auto module = std::make_unique<llvm::Module>("bench", llvmContext);
+    CodeGen codeGen{ diag, *module };
+    codeGen.configure();
+    IRGen irgen{ vslCtx, diag, *module, options };
+    irgen.run();
+    if (optLevel)
+    {
+        codeGen.optimize(optLevel, sizeLevel);
+    }
+    else
+    {
+        codeGen.promoteLocals();
+    }
+    // the runtime is linked into this executable, but its symbols aren't
+    //  exported for the jit to find on its own
+    llvm::sys::DynamicLibrary::AddSymbol("vsl_brc_init",
+        reinterpret_cast<void*>(&vsl_brc_init));
+    llvm::sys::DynamicLibrary::AddSymbol("vsl_brc_retain",
+        reinterpret_cast<void*>(&vsl_brc_retain));
+    llvm::sys::DynamicLibrary::AddSymbol("vsl_brc_release",
+        reinterpret_cast<void*>(&vsl_brc_release));
+    // the jit's own code generator stays at the same level every time, so
+    //  only the ir pipeline is being compared
+    std::string error;
+    std::unique_ptr<llvm::ExecutionEngine> engine{
+        llvm::EngineBuilder{ std::move(module) }
+            .setEngineKind(llvm::EngineKind::JIT)
+            .setErrorStr(&error)
+            .setMCJITMemoryManager(std::make_unique<CountingMemoryManager>())
+            .create() };
+    if (diag.getNumErrors() || !engine)
+    {
+        state.SkipWithError(error.empty() ? "invalid program" : error.c_str());
+        return;
+    }
+    auto* run = reinterpret_cast<int32_t (*)(int32_t)>(
+        engine->getFunctionAddress("run"));
+    numAllocs = 0;
+    numFrees = 0;
+    while (state.KeepRunning())
+    {
+        benchmark::DoNotOptimize(run(n));
+    }
+    state.counters["allocs"] = benchmark::Counter(
+        static_cast<double>(numAllocs), benchmark::Counter::kAvgIterations);
+    state.counters["frees"] = benchmark::Counter(
+        static_cast<double>(numFrees), benchmark::Counter::kAvgIterations);
+}
+
+static void BM_RunFib(benchmark::State& state)
+{
+    runProgram(state, fibSrc, 25);
+}
+
+static void BM_RunHelpers(benchmark::State& state)
+{
+    runProgram(state, helpersSrc, 10);
+}
+
+static void BM_RunObjects(benchmark::State& state)
+{
+    runProgram(state, objectsSrc, 10);
+}
+
+static void BM_RunChurn(benchmark::State& state)
+{
+    runProgram(state, churnSrc, 10);
+}
+
+static void BM_RunChurnPool(benchmark::State& state)
+{
+    IRGenOptions options;
+    options.allocator = IRGenOptions::POOL;
+    runProgram(state, churnSrc, 10, options);
+}
+
+static void BM_RunMethods(benchmark::State& state)
+{
+    runProgram(state, methodsSrc, 10);
+}
+
+static void BM_RunBranches(benchmark::State& state)
+{
+    runProgram(state, branchesSrc, 10);
+}
+
+static void BM_RunObjectsPool(benchmark::State& state)
+{
+    IRGenOptions options;
+    options.allocator = IRGenOptions::POOL;
+    runProgram(state, objectsSrc, 10, options);
+}
+
+// the same program with each way of updating refcounts, all on one thread
+static void BM_RunRefcountNonatomic(benchmark::State& state)
+{
+    runProgram(state, sharingSrc, 10);
+}
+
+static void BM_RunRefcountAtomic(benchmark::State& state)
+{
+    IRGenOptions options;
+    options.refcount = IRGenOptions::ATOMIC;
+    runProgram(state, sharingSrc, 10, options);
+}
+
+static void BM_RunRefcountBiased(benchmark::State& state)
+{
+    IRGenOptions options;
+    options.refcount = IRGenOptions::BIASED;
+    runProgram(state, sharingSrc, 10, options);
+}
+
+// -O0 through -O3, then -Os
+#define OPT_LEVELS ->Args({ 0, 0 })->Args({ 1, 0 })->Args({ 2, 0 }) \
+    ->Args({ 3, 0 })->Args({ 2, 1 })->Unit(benchmark::kMicrosecond)
+BENCHMARK(BM_RunFib) OPT_LEVELS;
+BENCHMARK(BM_RunHelpers) OPT_LEVELS;
+BENCHMARK(BM_RunObjects) OPT_LEVELS;
+BENCHMARK(BM_RunObjectsPool) OPT_LEVELS;
+BENCHMARK(BM_RunChurn) OPT_LEVELS;
+BENCHMARK(BM_RunChurnPool) OPT_LEVELS;
+BENCHMARK(BM_RunMethods) OPT_LEVELS;
+BENCHMARK(BM_RunBranches) OPT_LEVELS;
+BENCHMARK(BM_RunRefcountNonatomic) OPT_LEVELS;
+BENCHMARK(BM_RunRefcountAtomic) OPT_LEVELS;
+BENCHMARK(BM_RunRefcountBiased) OPT_LEVELS;
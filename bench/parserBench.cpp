@@ -0,0 +1,66 @@
+#include "ast/vslContext.hpp"
+#include "diag/diag.hpp"
+#include "lexer/vslLexer.hpp"
+#include "parser/vslParser.hpp"
+#include "benchmark/benchmark.h"
+#include <string>
+
+// generates a program with a mix of classes and functions
+static std::string makeProgram(size_t size)
+{
+    std::string s;
+    for (size_t i = 0; s.size() < size; ++i)
+    {
+        std::string n = std::to_string(i);
+        s += "public class C" + n + "\n"
+            "{\n"
+            "    public var x: Int;\n"
+            "    private let y: Bool;\n"
+            "    public init(x: Int, y: Bool)\n"
+            "    {\n"
+            "        self.x = x;\n"
+            "        self.y = y;\n"
+            "    }\n"
+            "    public func get(scale: Int) -> Int\n"
+            "    {\n"
+            "        return self.y ? self.x * scale : -self.x;\n"
+            "    }\n"
+            "}\n"
+            "public func f" + n + "(a: Int, b: Int) -> Int\n"
+            "{\n"
+            "    let c: C" + n + " = C" + n + "(x: a + b, y: a < b);\n"
+            "    var sum = c.get(scale: 2) + (a - b) * (a + b) / 3 % 7;\n"
+            "    if (sum >= 1000 && a != b)\n"
+            "    {\n"
+            "        sum = f" + n + "(a: sum, b: a) + 1;\n"
+            "    }\n"
+            "    else if (sum == 0 || !(a > b))\n"
+            "    {\n"
+            "        return 0;\n"
+            "    }\n"
+            "    return sum;\n"
+            "}\n\n";
+    }
+    return s;
+}
+
+// parses a program of the given size in bytes, which also includes lexing it
+static void BM_Parse(benchmark::State& state)
+{
+    const std::string src = makeProgram(state.range(0));
+    Diag diag{ llvm::nulls() };
+    size_t arenaSize = 0;
+    while (state.KeepRunning())
+    {
+        VSLContext vslCtx;
+        VSLLexer lexer{ diag, src };
+        VSLParser parser{ vslCtx, lexer };
+        parser.parse();
+        // the AST gets freed at the end of each iteration, which is timed too
+        arenaSize = vslCtx.getArenaSize();
+    }
+    state.SetBytesProcessed(state.iterations() * src.size());
+    state.counters["arenaBytes"] = arenaSize;
+}
+BENCHMARK(BM_Parse)->Arg(1 << 16)->Arg(1 << 20)->Arg(1 << 24)
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,110 @@
+#include "corpus.hpp"
+#include "ast/vslContext.hpp"
+#include "codegen/codegen.hpp"
+#include "diag/diag.hpp"
+#include "diag/timeReport.hpp"
+#include "irgen/irgen.hpp"
+#include "lexer/vslLexer.hpp"
+#include "parser/vslParser.hpp"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/raw_ostream.h"
+#include "benchmark/benchmark.h"
+#include <algorithm>
+#include <memory>
+#include <string>
+
+// every stage of the compiler in the order they run, named like the phases in
+//  --time-report
+static const char* const stages[] = { "lexer", "parser", "typeResolver",
+    "funcResolver", "ownershipAnalyzer", "escapeAnalyzer", "irEmitter",
+    "verify", "optimize", "compile" };
+static constexpr int numStages = sizeof(stages) / sizeof(stages[0]);
+static constexpr int parserStage = 1;
+static constexpr int optimizeStage = numStages - 2;
+static constexpr int compileStage = numStages - 1;
+
+// runs the compiler on the source up to and including the given stage
+static bool runStages(const std::string& src, int stage, TimeReport& report)
+{
+    Diag diag{ llvm::nulls() };
+    VSLContext vslCtx;
+    VSLLexer lexer{ diag, src };
+    VSLParser parser{ vslCtx, lexer, &report };
+    {
+        TimeReport::Scope scope{ &report, "parser" };
+        parser.parse();
+    }
+    if (stage <= parserStage)
+    {
+        return !diag.getNumErrors();
+    }
+    // the ir passes always run together
+    llvm::LLVMContext llvmContext;
+    auto module = std::make_unique<llvm::Module>("bench", llvmContext);
+    CodeGen codeGen{ diag, *module };
+    codeGen.configure();
+    IRGen irgen{ vslCtx, diag, *module };
+    irgen.run(/*jobs=*/1, &report);
+    if (stage >= optimizeStage)
+    {
+        TimeReport::Scope scope{ &report, "optimize" };
+        codeGen.optimize(/*optLevel=*/2);
+    }
+    if (stage >= compileStage)
+    {
+        llvm::SmallVector<char, 0> object;
+        llvm::raw_svector_ostream os{ object };
+        TimeReport::Scope scope{ &report, "compile" };
+        codeGen.compile(os);
+    }
+    return !diag.getNumErrors();
+}
+
+// times one stage of the compiler on a generated program, with the stage as
+//  the first argument
+static void runStage(benchmark::State& state, CorpusShape shape)
+{
+    const std::string src = makeCorpus(shape);
+    auto stage = static_cast<int>(state.range(0));
+    state.SetLabel(stages[stage]);
+    long long heapGrowth = 0;
+    while (state.KeepRunning())
+    {
+        TimeReport report;
+        if (!runStages(src, stage, report))
+        {
+            state.SkipWithError("invalid program");
+            return;
+        }
+        // the stages before this one still have to run, but only this one
+        //  counts
+        const TimeReport::Phase* phase = report.getPhase(stages[stage]);
+        state.SetIterationTime(phase->time.getWallTime());
+        heapGrowth = std::max(heapGrowth, phase->heapGrowth);
+    }
+    state.SetBytesProcessed(state.iterations() * src.size());
+    state.counters["heapBytes"] = heapGrowth;
+}
+
+// runs every stage, a fixed number of times since some of them take next to
+//  no time and each iteration still has to run all of the stages before
+static void stageArgs(benchmark::internal::Benchmark* b)
+{
+    b->DenseRange(0, numStages - 1)->UseManualTime()->Iterations(10)
+        ->Unit(benchmark::kMillisecond);
+}
+
+// lots of functions of an ordinary size
+BENCHMARK_CAPTURE(runStage, Funcs, CorpusShape{ 500, 0, 4, 8 })
+    ->Apply(stageArgs);
+// lots of classes being constructed
+BENCHMARK_CAPTURE(runStage, Classes, CorpusShape{ 200, 200, 2, 8 })
+    ->Apply(stageArgs);
+// a few deeply nested expressions
+BENCHMARK_CAPTURE(runStage, DeepExprs, CorpusShape{ 20, 0, 200, 2 })
+    ->Apply(stageArgs);
+// a few very long functions
+BENCHMARK_CAPTURE(runStage, LongBodies, CorpusShape{ 4, 0, 4, 2000 })
+    ->Apply(stageArgs);
@@ -0,0 +1,87 @@
+#include "llvm/ADT/None.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Program.h"
+#include "llvm/Support/raw_ostream.h"
+#include "benchmark/benchmark.h"
+#include <string>
+#include <vector>
+
+// a file that's as close to nothing as possible, so that startup is all that
+//  gets measured
+static const char* const trivialSrc =
+    "public func f(x: Int) -> Int { return x; }\n";
+
+// times the vsl executable from start to finish on a trivial file, with the
+//  given extra arguments
+static void runVSL(benchmark::State& state,
+    std::vector<const char*> extraArgs)
+{
+    llvm::SmallString<128> infile;
+    llvm::SmallString<128> outfile;
+    int fd;
+    if (llvm::sys::fs::createTemporaryFile("vsl-startup", "vsl", fd, infile) ||
+        llvm::sys::fs::createTemporaryFile("vsl-startup", "o", outfile))
+    {
+        state.SkipWithError("could not create temporary files");
+        return;
+    }
+    {
+        llvm::raw_fd_ostream os{ fd, /*shouldClose=*/true };
+        os << trivialSrc;
+    }
+    std::vector<const char*> args{ VSL_EXECUTABLE };
+    args.insert(args.end(), extraArgs.begin(), extraArgs.end());
+    args.push_back(infile.c_str());
+    args.push_back("-o");
+    args.push_back(outfile.c_str());
+    args.push_back(nullptr);
+    // help goes to stdout, which shouldn't end up in the results
+    llvm::StringRef empty;
+    llvm::Optional<llvm::StringRef> redirects[] = { llvm::None, empty,
+        llvm::None };
+    while (state.KeepRunning())
+    {
+        std::string error;
+        int result = llvm::sys::ExecuteAndWait(VSL_EXECUTABLE, args.data(),
+            /*env=*/nullptr, redirects, /*secondsToWait=*/0,
+            /*memoryLimit=*/0, &error);
+        if (result != 0)
+        {
+            state.SkipWithError(error.empty() ? "vsl failed" : error.c_str());
+            break;
+        }
+    }
+    llvm::sys::fs::remove(infile);
+    llvm::sys::fs::remove(outfile);
+}
+
+// doesn't touch llvm at all, which is the cost of just loading vsl
+static void BM_StartupHelp(benchmark::State& state)
+{
+    runVSL(state, { "--help" });
+}
+
+// has to set up the host target to compile anything
+static void BM_StartupCompile(benchmark::State& state)
+{
+    runVSL(state, {});
+}
+
+BENCHMARK(BM_StartupHelp)->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(BM_StartupCompile)->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+#ifdef VSL_CROSS_TARGETS
+// has to register every other target before it can find this one
+static void BM_StartupCompileCross(benchmark::State& state)
+{
+    runVSL(state, { "--target=aarch64-unknown-linux-gnu" });
+}
+
+BENCHMARK(BM_StartupCompileCross)->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+#endif // VSL_CROSS_TARGETS
@@ -0,0 +1,232 @@
+#include "corpus.hpp"
+#include "ast/node.hpp"
+#include "ast/nodeVisitor.hpp"
+#include "ast/vslContext.hpp"
+#include "diag/diag.hpp"
+#include "lexer/vslLexer.hpp"
+#include "parser/vslParser.hpp"
+#include "benchmark/benchmark.h"
+#include <string>
+
+// visits every node in the AST and counts them, going through the subclass to
+//  get to each child
+template<typename Derived>
+class NodeCounter : public NodeVisitor<Derived>
+{
+public:
+    size_t getCount() const { return count; }
+    void visitFunction(FunctionNode& node)
+    {
+        ++count;
+        visitParams(node);
+        enter(node.getBody());
+    }
+    void visitExtFunc(ExtFuncNode& node)
+    {
+        ++count;
+        visitParams(node);
+    }
+    void visitParam(ParamNode& node) { ++count; }
+    void visitVariable(VariableNode& node)
+    {
+        ++count;
+        if (node.hasInit())
+        {
+            enter(node.getInit());
+        }
+    }
+    void visitClass(ClassNode& node)
+    {
+        ++count;
+        for (FieldNode* field : node.getFields())
+        {
+            enter(*field);
+        }
+        if (node.hasCtor())
+        {
+            enter(node.getCtor());
+        }
+        for (MethodNode* method : node.getMethods())
+        {
+            enter(*method);
+        }
+    }
+    void visitField(FieldNode& node) { visitVariable(node); }
+    void visitMethod(MethodNode& node) { visitFunction(node); }
+    void visitCtor(CtorNode& node) { visitFunction(node); }
+    void visitBlock(BlockNode& node)
+    {
+        ++count;
+        for (Node* statement : node.getStatements())
+        {
+            enter(*statement);
+        }
+    }
+    void visitEmpty(EmptyNode& node) { ++count; }
+    void visitIf(IfNode& node)
+    {
+        ++count;
+        enter(node.getCondition());
+        enter(node.getThen());
+        if (node.hasElse())
+        {
+            enter(node.getElse());
+        }
+    }
+    void visitReturn(ReturnNode& node)
+    {
+        ++count;
+        if (node.hasValue())
+        {
+            enter(node.getValue());
+        }
+    }
+    void visitIdent(IdentNode& node) { ++count; }
+    void visitLiteral(LiteralNode& node) { ++count; }
+    void visitUnary(UnaryNode& node)
+    {
+        ++count;
+        enter(node.getExpr());
+    }
+    void visitBinary(BinaryNode& node)
+    {
+        ++count;
+        enter(node.getLhs());
+        enter(node.getRhs());
+    }
+    void visitTernary(TernaryNode& node)
+    {
+        ++count;
+        enter(node.getCondition());
+        enter(node.getThen());
+        enter(node.getElse());
+    }
+    void visitCall(CallNode& node)
+    {
+        ++count;
+        enter(node.getCallee());
+        for (ArgNode* arg : node.getArgs())
+        {
+            enter(*arg);
+        }
+    }
+    void visitArg(ArgNode& node)
+    {
+        ++count;
+        enter(node.getValue());
+    }
+    void visitFieldAccess(FieldAccessNode& node)
+    {
+        ++count;
+        enter(node.getObject());
+    }
+    void visitMethodCall(MethodCallNode& node) { visitCall(node); }
+    void visitSelf(SelfNode& node) { ++count; }
+
+private:
+    void enter(Node& node) { static_cast<Derived&>(*this).enter(node); }
+    void visitParams(FuncInterfaceNode& node)
+    {
+        for (ParamNode* param : node.getParams())
+        {
+            enter(*param);
+        }
+    }
+    size_t count = 0;
+};
+
+// dispatches with the switch in NodeVisitor, which is what the passes do
+class StaticCounter : public NodeCounter<StaticCounter>
+{
+public:
+    void enter(Node& node) { visit(node); }
+};
+
+// makes a virtual call to get to each node, and then another one for its visit
+//  method, which is what Node::accept used to do
+class VirtualCounter : public NodeCounter<VirtualCounter>
+{
+public:
+    using Base = NodeCounter<VirtualCounter>;
+    virtual ~VirtualCounter() = default;
+    virtual void enter(Node& node) { visit(node); }
+    virtual void visitFunction(FunctionNode& node)
+    {
+        Base::visitFunction(node);
+    }
+    virtual void visitExtFunc(ExtFuncNode& node) { Base::visitExtFunc(node); }
+    virtual void visitParam(ParamNode& node) { Base::visitParam(node); }
+    virtual void visitVariable(VariableNode& node)
+    {
+        Base::visitVariable(node);
+    }
+    virtual void visitClass(ClassNode& node) { Base::visitClass(node); }
+    virtual void visitField(FieldNode& node) { Base::visitField(node); }
+    virtual void visitMethod(MethodNode& node) { Base::visitMethod(node); }
+    virtual void visitCtor(CtorNode& node) { Base::visitCtor(node); }
+    virtual void visitBlock(BlockNode& node) { Base::visitBlock(node); }
+    virtual void visitEmpty(EmptyNode& node) { Base::visitEmpty(node); }
+    virtual void visitIf(IfNode& node) { Base::visitIf(node); }
+    virtual void visitReturn(ReturnNode& node) { Base::visitReturn(node); }
+    virtual void visitIdent(IdentNode& node) { Base::visitIdent(node); }
+    virtual void visitLiteral(LiteralNode& node) { Base::visitLiteral(node); }
+    virtual void visitUnary(UnaryNode& node) { Base::visitUnary(node); }
+    virtual void visitBinary(BinaryNode& node) { Base::visitBinary(node); }
+    virtual void visitTernary(TernaryNode& node) { Base::visitTernary(node); }
+    virtual void visitCall(CallNode& node) { Base::visitCall(node); }
+    virtual void visitArg(ArgNode& node) { Base::visitArg(node); }
+    virtual void visitFieldAccess(FieldAccessNode& node)
+    {
+        Base::visitFieldAccess(node);
+    }
+    virtual void visitMethodCall(MethodCallNode& node)
+    {
+        Base::visitMethodCall(node);
+    }
+    virtual void visitSelf(SelfNode& node) { Base::visitSelf(node); }
+};
+
+// times a traversal of the AST of a generated program, so the time per node is
+//  the cost of dispatching to it
+template<typename Counter>
+static void traverse(benchmark::State& state, CorpusShape shape)
+{
+    const std::string src = makeCorpus(shape);
+    Diag diag{ llvm::nulls() };
+    VSLContext vslCtx;
+    VSLLexer lexer{ diag, src };
+    VSLParser parser{ vslCtx, lexer };
+    parser.parse();
+    if (diag.getNumErrors())
+    {
+        state.SkipWithError("invalid program");
+        return;
+    }
+    size_t nodes = 0;
+    while (state.KeepRunning())
+    {
+        Counter counter;
+        counter.visitAST(vslCtx.getGlobals());
+        nodes = counter.getCount();
+        benchmark::DoNotOptimize(nodes);
+    }
+    state.SetItemsProcessed(state.iterations() * nodes);
+    state.counters["nodes"] = nodes;
+}
+
+static void BM_TraverseStatic(benchmark::State& state, CorpusShape shape)
+{
+    traverse<StaticCounter>(state, shape);
+}
+
+static void BM_TraverseVirtual(benchmark::State& state, CorpusShape shape)
+{
+    traverse<VirtualCounter>(state, shape);
+}
+
+// lots of functions of an ordinary size
+BENCHMARK_CAPTURE(BM_TraverseStatic, Funcs, CorpusShape{ 500, 0, 4, 8 });
+BENCHMARK_CAPTURE(BM_TraverseVirtual, Funcs, CorpusShape{ 500, 0, 4, 8 });
+// lots of classes being constructed
+BENCHMARK_CAPTURE(BM_TraverseStatic, Classes, CorpusShape{ 200, 200, 2, 8 });
+BENCHMARK_CAPTURE(BM_TraverseVirtual, Classes, CorpusShape{ 200, 200, 2, 8 });
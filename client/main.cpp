@@ -0,0 +1,61 @@
+#include "driver/serverProtocol.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+// Usage: vsl-client <socket> [vsl options] [file]
+//
+// Has the compile server at the given socket do what `vsl [vsl options] [file]`
+//  would do, then exits with the same status.
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: vsl-client <socket> [vsl options] [file]\n";
+        return 1;
+    }
+    const char* socketPath = argv[1];
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof addr);
+    addr.sun_family = AF_UNIX;
+    if (strlen(socketPath) >= sizeof addr.sun_path)
+    {
+        std::cerr << "Error: socket path '" << socketPath <<
+            "' is too long\n";
+        return 1;
+    }
+    strcpy(addr.sun_path, socketPath);
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock == -1 ||
+        connect(sock, reinterpret_cast<sockaddr*>(&addr), sizeof addr) == -1)
+    {
+        std::cerr << "Error: could not connect to '" << socketPath << "': " <<
+            strerror(errno) << '\n';
+        return 1;
+    }
+    int cwd = open(".", O_RDONLY | O_DIRECTORY);
+    if (cwd == -1)
+    {
+        std::cerr << "Error: could not open the working directory: " <<
+            strerror(errno) << '\n';
+        return 1;
+    }
+    // the server sees the arguments as if it was started in place of this
+    std::vector<std::string> args{ "vsl" };
+    args.insert(args.end(), argv + 2, argv + argc);
+    int fds[numRequestFds] = { cwd, STDIN_FILENO, STDOUT_FILENO,
+        STDERR_FILENO };
+    int status;
+    if (!sendRequest(sock, args, fds) || !receiveStatus(sock, status))
+    {
+        std::cerr << "Error: lost the connection to the compile server\n";
+        return 1;
+    }
+    return status;
+}
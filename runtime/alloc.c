@@ -0,0 +1,187 @@
+#include "vslrt.h"
+#include <pthread.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+/** Size of the chunks that the pools carve their blocks out of. */
+#define CHUNK_SIZE (64 * 1024)
+
+/** Links a free block to the next one in its size class. */
+struct FreeBlock
+{
+    struct FreeBlock* next;
+};
+
+/**
+ * Freed blocks of each size class. Each thread has its own pools, so nothing
+ * here needs to be locked. Blocks stay in the pool of whichever thread freed
+ * them until it exits, and are never given back to libc.
+ */
+static _Thread_local struct FreeBlock* freeLists[VSL_NUM_SIZE_CLASSES];
+/** Next unused byte of the current chunk. */
+static _Thread_local char* chunkPos;
+/** End of the current chunk. */
+static _Thread_local char* chunkEnd;
+/** Whether the calling thread has anything in its pools to hand back. */
+static _Thread_local int watched;
+/**
+ * Blocks left behind by threads that have exited, which threads take from
+ * once their own pools run out.
+ */
+static struct FreeBlock* sharedLists[VSL_NUM_SIZE_CLASSES];
+/** Guards sharedLists. */
+static pthread_mutex_t sharedLock = PTHREAD_MUTEX_INITIALIZER;
+/** Used to find out when a thread exits. */
+static pthread_key_t exitKey;
+/** Makes sure that exitKey is only created once. */
+static pthread_once_t exitKeyOnce = PTHREAD_ONCE_INIT;
+
+/**
+ * Called when a thread with blocks in its pools exits. Its free blocks, along
+ * with whatever's left of its current chunk, get moved to sharedLists.
+ *
+ * @param flag The exiting thread's watched flag.
+ */
+static void onExit(void* flag)
+{
+    // destructors of other keys can still free blocks after this, in which
+    //  case vsl_free() sets exitKey again and this gets called another time
+    *(int*)flag = 0;
+    // the rest of the chunk is split into blocks of the biggest size class,
+    //  since every block size is a multiple of the step
+    while (chunkEnd - chunkPos >= VSL_SIZE_CLASS_STEP)
+    {
+        size_t size = (size_t)(chunkEnd - chunkPos);
+        if (size > VSL_MAX_POOLED_SIZE)
+        {
+            size = VSL_MAX_POOLED_SIZE;
+        }
+        struct FreeBlock* block = (struct FreeBlock*)chunkPos;
+        uint32_t sizeClass = (uint32_t)(size / VSL_SIZE_CLASS_STEP - 1);
+        block->next = freeLists[sizeClass];
+        freeLists[sizeClass] = block;
+        chunkPos += size;
+    }
+    chunkPos = NULL;
+    chunkEnd = NULL;
+    pthread_mutex_lock(&sharedLock);
+    for (uint32_t sizeClass = 0; sizeClass < VSL_NUM_SIZE_CLASSES;
+        ++sizeClass)
+    {
+        struct FreeBlock* head = freeLists[sizeClass];
+        if (!head)
+        {
+            continue;
+        }
+        struct FreeBlock* tail = head;
+        while (tail->next)
+        {
+            tail = tail->next;
+        }
+        tail->next = sharedLists[sizeClass];
+        __atomic_store_n(&sharedLists[sizeClass], head, __ATOMIC_RELAXED);
+        freeLists[sizeClass] = NULL;
+    }
+    pthread_mutex_unlock(&sharedLock);
+}
+
+/** Creates exitKey. */
+static void createExitKey(void)
+{
+    pthread_key_create(&exitKey, onExit);
+}
+
+/**
+ * Makes sure that the calling thread's pools get handed back once it exits.
+ */
+static void watchExit(void)
+{
+    if (watched)
+    {
+        return;
+    }
+    pthread_once(&exitKeyOnce, createExitKey);
+    pthread_setspecific(exitKey, &watched);
+    watched = 1;
+}
+
+/**
+ * Takes every block of a size class that exited threads left behind.
+ *
+ * @param sizeClass The size class to take from.
+ *
+ * @returns The first block in the list, or null if there aren't any.
+ */
+static struct FreeBlock* takeShared(uint32_t sizeClass)
+{
+    // most of the time there's nothing there, which doesn't need the lock
+    if (!__atomic_load_n(&sharedLists[sizeClass], __ATOMIC_RELAXED))
+    {
+        return NULL;
+    }
+    pthread_mutex_lock(&sharedLock);
+    struct FreeBlock* block = sharedLists[sizeClass];
+    __atomic_store_n(&sharedLists[sizeClass], NULL, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&sharedLock);
+    if (block)
+    {
+        watchExit();
+    }
+    return block;
+}
+
+/**
+ * Carves a new block out of the current chunk, getting a new chunk if it's
+ * full. Whatever's left of the old chunk is wasted, which is at most one
+ * block of the biggest size class.
+ *
+ * @param size Size of the block in bytes.
+ *
+ * @returns The new block, or null if out of memory.
+ */
+static void* carve(size_t size)
+{
+    if ((size_t)(chunkEnd - chunkPos) < size)
+    {
+        // malloc aligns to at least 16 bytes on every target we care about,
+        //  and the block sizes keep that alignment
+        char* chunk = malloc(CHUNK_SIZE);
+        if (!chunk)
+        {
+            return NULL;
+        }
+        chunkPos = chunk;
+        chunkEnd = chunk + CHUNK_SIZE;
+        watchExit();
+    }
+    void* block = chunkPos;
+    chunkPos += size;
+    return block;
+}
+
+void* vsl_alloc(uint32_t sizeClass)
+{
+    struct FreeBlock* block = freeLists[sizeClass];
+    if (!block)
+    {
+        block = takeShared(sizeClass);
+    }
+    if (block)
+    {
+        freeLists[sizeClass] = block->next;
+        return block;
+    }
+    return carve((size_t)(sizeClass + 1) * VSL_SIZE_CLASS_STEP);
+}
+
+void vsl_free(void* ptr, uint32_t sizeClass)
+{
+    if (!ptr)
+    {
+        return;
+    }
+    watchExit();
+    struct FreeBlock* block = ptr;
+    block->next = freeLists[sizeClass];
+    freeLists[sizeClass] = block;
+}
@@ -0,0 +1,269 @@
+#include "vslrt.h"
+#include <pthread.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+/** An object that another thread handed to its owner to merge. */
+struct QueueNode
+{
+    struct QueueNode* next;
+    struct vsl_brc* hdr;
+    vsl_brc_destroy destroy;
+};
+
+/**
+ * Identifies a thread that owns objects. These are never freed, since objects
+ * can outlive their owner and still point to it.
+ */
+struct Thread
+{
+    /**
+     * Objects waiting to be merged, pushed by other threads without locking.
+     * Set to CLOSED once the thread exits.
+     */
+    struct QueueNode* queue;
+    /** Next thread in allThreads. */
+    struct Thread* next;
+};
+
+/** Marks the queue of a thread that has exited. */
+#define CLOSED ((struct QueueNode*)1)
+
+/**
+ * Stand-in for threads that haven't created any objects yet. It never owns
+ * anything, but unlike null it can't be mistaken for the owner of a merged
+ * object.
+ */
+static struct Thread noThread;
+/** The calling thread, or noThread until it creates its first object. */
+static _Thread_local struct Thread* self = &noThread;
+/** Every thread that was ever registered, so they stay reachable. */
+static struct Thread* allThreads;
+/** Used to find out when a thread exits. */
+static pthread_key_t exitKey;
+/** Makes sure that exitKey is only created once. */
+static pthread_once_t exitKeyOnce = PTHREAD_ONCE_INIT;
+
+/**
+ * Merges the biased counter of an object into the shared one and clears the
+ * owner. Only the owner can do this, unless it has already exited.
+ *
+ * @param hdr Header of the object.
+ *
+ * @returns Nonzero if the object is dead, zero otherwise.
+ */
+static int32_t merge(struct vsl_brc* hdr)
+{
+    int32_t biased = hdr->biased;
+    hdr->biased = 0;
+    int32_t shared = __atomic_load_n(&hdr->shared, __ATOMIC_RELAXED);
+    int32_t merged;
+    do
+    {
+        merged = ((shared & ~VSL_BRC_QUEUED) + biased * VSL_BRC_ONE) |
+            VSL_BRC_MERGED;
+    }
+    while (!__atomic_compare_exchange_n(&hdr->shared, &shared, merged, 1,
+            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+    __atomic_store_n(&hdr->owner, NULL, __ATOMIC_RELAXED);
+    return merged < VSL_BRC_ONE;
+}
+
+/**
+ * Merges every object in a list that was taken from a queue, destroying the
+ * ones that turn out to be dead.
+ *
+ * @param node The first node in the list, or CLOSED or null for none.
+ */
+static void drain(struct QueueNode* node)
+{
+    if (node == CLOSED)
+    {
+        return;
+    }
+    while (node)
+    {
+        struct QueueNode* next = node->next;
+        if (merge(node->hdr))
+        {
+            node->destroy(node->hdr);
+        }
+        free(node);
+        node = next;
+    }
+}
+
+/**
+ * Called when a thread that owns objects exits. Its queue gets closed so
+ * that other threads know to merge its objects on their own from then on.
+ *
+ * @param thread The exiting thread.
+ */
+static void onExit(void* thread)
+{
+    struct Thread* t = thread;
+    drain(__atomic_exchange_n(&t->queue, CLOSED, __ATOMIC_ACQ_REL));
+}
+
+/** Creates exitKey. */
+static void createExitKey(void)
+{
+    pthread_key_create(&exitKey, onExit);
+}
+
+/**
+ * Gets the calling thread, registering it the first time around.
+ *
+ * @returns The calling thread, or noThread if out of memory.
+ */
+static struct Thread* getSelf(void)
+{
+    if (self != &noThread)
+    {
+        return self;
+    }
+    struct Thread* t = malloc(sizeof(struct Thread));
+    if (!t)
+    {
+        return &noThread;
+    }
+    t->queue = NULL;
+    struct Thread* head = __atomic_load_n(&allThreads, __ATOMIC_RELAXED);
+    do
+    {
+        t->next = head;
+    }
+    while (!__atomic_compare_exchange_n(&allThreads, &head, t, 1,
+            __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    pthread_once(&exitKeyOnce, createExitKey);
+    pthread_setspecific(exitKey, t);
+    self = t;
+    return t;
+}
+
+/**
+ * Hands an object to its owner to merge.
+ *
+ * @param owner The owner of the object.
+ * @param hdr Header of the object.
+ * @param destroy How the owner can free the object.
+ *
+ * @returns Nonzero if the owner has already exited and the object turned out
+ * to be dead, zero otherwise.
+ */
+static int32_t enqueue(struct Thread* owner, struct vsl_brc* hdr,
+    vsl_brc_destroy destroy)
+{
+    struct QueueNode* node = malloc(sizeof(struct QueueNode));
+    if (!node)
+    {
+        // the object leaks, but that's better than destroying it too soon
+        return 0;
+    }
+    node->hdr = hdr;
+    node->destroy = destroy;
+    struct QueueNode* head = __atomic_load_n(&owner->queue, __ATOMIC_ACQUIRE);
+    do
+    {
+        // once the owner's gone, nobody else can touch the biased counter, so
+        //  it's safe to merge it here instead
+        if (head == CLOSED)
+        {
+            free(node);
+            return merge(hdr);
+        }
+        node->next = head;
+    }
+    while (!__atomic_compare_exchange_n(&owner->queue, &head, node, 1,
+            __ATOMIC_RELEASE, __ATOMIC_ACQUIRE));
+    return 0;
+}
+
+void vsl_brc_init(struct vsl_brc* hdr)
+{
+    struct Thread* t = getSelf();
+    vsl_brc_collect();
+    if (t == &noThread)
+    {
+        // without an owner, the object has to start out merged
+        hdr->biased = 0;
+        hdr->shared = VSL_BRC_ONE | VSL_BRC_MERGED;
+        hdr->owner = NULL;
+        return;
+    }
+    hdr->biased = 1;
+    hdr->shared = 0;
+    hdr->owner = t;
+}
+
+void vsl_brc_retain(struct vsl_brc* hdr)
+{
+    if (__atomic_load_n(&hdr->owner, __ATOMIC_RELAXED) == self)
+    {
+        ++hdr->biased;
+        return;
+    }
+    __atomic_fetch_add(&hdr->shared, VSL_BRC_ONE, __ATOMIC_RELAXED);
+}
+
+int32_t vsl_brc_release(struct vsl_brc* hdr, vsl_brc_destroy destroy)
+{
+    struct Thread* owner = __atomic_load_n(&hdr->owner, __ATOMIC_RELAXED);
+    int32_t shared;
+    if (owner == self)
+    {
+        if (--hdr->biased > 0)
+        {
+            return 0;
+        }
+        // the owner is done with the object, so from now on the shared counter
+        //  is all that's left, unless another thread already queued it up
+        shared = __atomic_load_n(&hdr->shared, __ATOMIC_RELAXED);
+        do
+        {
+            if (shared & VSL_BRC_QUEUED)
+            {
+                vsl_brc_collect();
+                return 0;
+            }
+        }
+        while (!__atomic_compare_exchange_n(&hdr->shared, &shared,
+                shared | VSL_BRC_MERGED, 1, __ATOMIC_ACQ_REL,
+                __ATOMIC_ACQUIRE));
+        __atomic_store_n(&hdr->owner, NULL, __ATOMIC_RELAXED);
+        return shared < VSL_BRC_ONE;
+    }
+    int32_t released;
+    int queue;
+    shared = __atomic_load_n(&hdr->shared, __ATOMIC_RELAXED);
+    do
+    {
+        released = shared - VSL_BRC_ONE;
+        // going negative means the owner has to merge before anyone can tell
+        //  if the object is dead, but it only needs to be queued once
+        queue = !(released & (VSL_BRC_MERGED | VSL_BRC_QUEUED)) &&
+            released < 0;
+        if (queue)
+        {
+            released |= VSL_BRC_QUEUED;
+        }
+    }
+    while (!__atomic_compare_exchange_n(&hdr->shared, &shared, released, 1,
+            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+    if (released & VSL_BRC_MERGED)
+    {
+        return released < VSL_BRC_ONE;
+    }
+    return queue ? enqueue(owner, hdr, destroy) : 0;
+}
+
+void vsl_brc_collect(void)
+{
+    struct QueueNode* head = __atomic_load_n(&self->queue, __ATOMIC_RELAXED);
+    // noThread's queue is always empty, and an exited thread's stays closed
+    if (!head || head == CLOSED)
+    {
+        return;
+    }
+    drain(__atomic_exchange_n(&self->queue, NULL, __ATOMIC_ACQ_REL));
+}
@@ -0,0 +1,120 @@
+#ifndef VSLRT_H
+#define VSLRT_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** Difference in size between one size class and the next. */
+#define VSL_SIZE_CLASS_STEP 16
+/** How many size classes there are. */
+#define VSL_NUM_SIZE_CLASSES 16
+/** Largest object size that can be allocated from a pool. */
+#define VSL_MAX_POOLED_SIZE (VSL_SIZE_CLASS_STEP * VSL_NUM_SIZE_CLASSES)
+
+/**
+ * Allocates a block from the calling thread's pool. Size class n holds objects
+ * of up to `(n + 1) * VSL_SIZE_CLASS_STEP` bytes, which the compiler works out
+ * ahead of time. Blocks are aligned to VSL_SIZE_CLASS_STEP bytes.
+ *
+ * @param sizeClass Which size class to allocate from. Must be less than
+ * VSL_NUM_SIZE_CLASSES.
+ *
+ * @returns The new block, or null if out of memory.
+ */
+void* vsl_alloc(uint32_t sizeClass);
+
+/**
+ * Returns a block to the calling thread's pool. It doesn't have to be the
+ * thread that allocated it.
+ *
+ * @param ptr The block to free, or null to do nothing.
+ * @param sizeClass The size class it was allocated from.
+ */
+void vsl_free(void* ptr, uint32_t sizeClass);
+
+/**
+ * Header of a class object compiled with --refcount=biased. Most objects are
+ * only ever touched by the thread that created them, so that thread (the
+ * owner) keeps its references in a plain counter that needs no atomics.
+ * Every other thread goes through the shared counter instead.
+ *
+ * The shared counter holds the reference count shifted left by two, plus the
+ * VSL_BRC_MERGED and VSL_BRC_QUEUED flags. It can go negative when other
+ * threads release references that the owner took out for them. Once the
+ * owner has no references left, or once another thread has to find out if
+ * the object is dead, the biased counter gets merged into the shared one and
+ * the owner is cleared, after which every thread uses the shared counter.
+ *
+ * The fields are only touched by the runtime. The layout has to match what
+ * the compiler emits.
+ */
+struct vsl_brc
+{
+    /** References held by the owner. Only the owner may touch this. */
+    int32_t biased;
+    /** References held by everyone else, along with the flags. */
+    int32_t shared;
+    /** Thread that created the object, or null once merged. */
+    void* owner;
+};
+
+/** Set once the biased counter has been merged into the shared one. */
+#define VSL_BRC_MERGED 1
+/** Set once the object is waiting in its owner's queue to be merged. */
+#define VSL_BRC_QUEUED 2
+/** What one reference adds to the shared counter. */
+#define VSL_BRC_ONE 4
+
+/**
+ * Frees an object whose refcount dropped to zero, including releasing its
+ * fields. The runtime calls it with a pointer to the object, whose header is
+ * always at the start.
+ */
+typedef void (*vsl_brc_destroy)(void* obj);
+
+/**
+ * Initializes the header of a new object, with one reference held by the
+ * calling thread. This also merges any objects that other threads have queued
+ * up for the calling thread.
+ *
+ * @param hdr The header to initialize.
+ */
+void vsl_brc_init(struct vsl_brc* hdr);
+
+/**
+ * Adds a reference to an object.
+ *
+ * @param hdr Header of the object.
+ */
+void vsl_brc_retain(struct vsl_brc* hdr);
+
+/**
+ * Removes a reference from an object. If the caller isn't the owner and this
+ * was the last reference it knows of, the object is handed to the owner to
+ * merge and, if it's dead, destroy.
+ *
+ * @param hdr Header of the object.
+ * @param destroy How to free the object if the owner ends up destroying it.
+ *
+ * @returns Nonzero if the object is dead and the caller has to destroy it,
+ * zero otherwise.
+ */
+int32_t vsl_brc_release(struct vsl_brc* hdr, vsl_brc_destroy destroy);
+
+/**
+ * Merges every object that other threads have queued up for the calling
+ * thread, destroying the ones that turn out to be dead. This happens on its
+ * own whenever the thread creates an object or exits, so this only has to be
+ * called by threads that hold on to shared objects without allocating.
+ */
+void vsl_brc_collect(void);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
+
+#endif /* VSLRT_H */
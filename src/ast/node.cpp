@@ -36,7 +36,10 @@ Node::Node(Kind kind, Location location)
 {
 }
 
-Node::~Node() = default;
+Node::Kind Node::getKind() const
+{
+    return kind;
+}
 
 bool Node::is(Kind k) const
 {
@@ -69,14 +72,19 @@ Access DeclNode::getAccess() const
 }
 
 FuncInterfaceNode::FuncInterfaceNode(Node::Kind kind, Location location,
-    Access access, llvm::StringRef name, std::vector<ParamNode*> params,
+    Access access, Symbol name, llvm::ArrayRef<ParamNode*> params,
     const Type* returnType)
     : DeclNode{ kind, location, access }, name{ name },
-    params{ std::move(params) }, returnType{ returnType }
+    params{ params }, returnType{ returnType }
 {
 }
 
 llvm::StringRef FuncInterfaceNode::getName() const
+{
+    return name.getName();
+}
+
+Symbol FuncInterfaceNode::getSymbol() const
 {
     return name;
 }
@@ -102,18 +110,13 @@ const Type* FuncInterfaceNode::getReturnType() const
 }
 
 FunctionNode::FunctionNode(Location location, Access access,
-    llvm::StringRef name, std::vector<ParamNode*> params,
+    Symbol name, llvm::ArrayRef<ParamNode*> params,
     const Type* returnType, BlockNode& body)
-    : FunctionNode{ Node::FUNCTION, location, access, name, std::move(params),
+    : FunctionNode{ Node::FUNCTION, location, access, name, params,
         returnType, body }
 {
 }
 
-void FunctionNode::accept(NodeVisitor& nodeVisitor)
-{
-    nodeVisitor.visitFunction(*this);
-}
-
 BlockNode& FunctionNode::getBody() const
 {
     return body;
@@ -130,24 +133,19 @@ void FunctionNode::setAlreadyDefined(bool alreadyDefined)
 }
 
 FunctionNode::FunctionNode(Node::Kind kind, Location location, Access access,
-    llvm::StringRef name, std::vector<ParamNode*> params,
+    Symbol name, llvm::ArrayRef<ParamNode*> params,
     const Type* returnType, BlockNode& body)
-    : FuncInterfaceNode{ kind, location, access, name, std::move(params),
+    : FuncInterfaceNode{ kind, location, access, name, params,
         returnType }, body{ body }, alreadyDefined{ false }
 {
 }
 
-ExtFuncNode::ExtFuncNode(Location location, Access access, llvm::StringRef name,
-    std::vector<ParamNode*> params, const Type* returnType,
+ExtFuncNode::ExtFuncNode(Location location, Access access, Symbol name,
+    llvm::ArrayRef<ParamNode*> params, const Type* returnType,
     llvm::StringRef alias)
     : FuncInterfaceNode{ Node::EXTFUNC, location, access, name,
-        std::move(params), returnType }, alias{ alias }
-{
-}
-
-void ExtFuncNode::accept(NodeVisitor& nodeVisitor)
+        params, returnType }, alias{ alias }
 {
-    nodeVisitor.visitExtFunc(*this);
 }
 
 llvm::StringRef ExtFuncNode::getAlias() const
@@ -155,17 +153,18 @@ llvm::StringRef ExtFuncNode::getAlias() const
     return alias;
 }
 
-ParamNode::ParamNode(Location location, llvm::StringRef name, const Type* type)
-    : Node{ Node::PARAM, location }, name{ name }, type{ type }
+ParamNode::ParamNode(Location location, Symbol name, const Type* type)
+    : Node{ Node::PARAM, location }, name{ name }, type{ type },
+    reassigned{ false }
 {
 }
 
-void ParamNode::accept(NodeVisitor& nodeVisitor)
+llvm::StringRef ParamNode::getName() const
 {
-    nodeVisitor.visitParam(*this);
+    return name.getName();
 }
 
-llvm::StringRef ParamNode::getName() const
+Symbol ParamNode::getSymbol() const
 {
     return name;
 }
@@ -175,19 +174,29 @@ const Type* ParamNode::getType() const
     return type;
 }
 
+bool ParamNode::isReassigned() const
+{
+    return reassigned;
+}
+
+void ParamNode::setReassigned(bool reassigned)
+{
+    this->reassigned = reassigned;
+}
+
 VariableNode::VariableNode(Location location, Access access,
-    llvm::StringRef name, const Type* type, ExprNode* init, bool constness)
+    Symbol name, const Type* type, ExprNode* init, bool constness)
     : VariableNode{ Node::VARIABLE, location, access, name, type, init,
         constness }
 {
 }
 
-void VariableNode::accept(NodeVisitor& nodeVisitor)
+llvm::StringRef VariableNode::getName() const
 {
-    nodeVisitor.visitVariable(*this);
+    return name.getName();
 }
 
-llvm::StringRef VariableNode::getName() const
+Symbol VariableNode::getSymbol() const
 {
     return name;
 }
@@ -222,10 +231,20 @@ bool VariableNode::isConst() const
     return constness;
 }
 
+bool VariableNode::isReassigned() const
+{
+    return reassigned;
+}
+
+void VariableNode::setReassigned(bool reassigned)
+{
+    this->reassigned = reassigned;
+}
+
 VariableNode::VariableNode(Node::Kind kind, Location location, Access access,
-    llvm::StringRef name, const Type* type, ExprNode* init, bool constness)
+    Symbol name, const Type* type, ExprNode* init, bool constness)
     : DeclNode{ kind, location, access }, name{ name }, type{ type },
-    init{ init }, constness{ constness }
+    init{ init }, constness{ constness }, reassigned{ false }
 {
 }
 
@@ -240,19 +259,19 @@ ClassNode& ClassNode::Member::getParent() const
     return parent;
 }
 
-ClassNode::ClassNode(Location location, Access access, llvm::StringRef name,
+ClassNode::ClassNode(Location location, Access access, Symbol name,
     const NamedType* type, ClassType* classType)
     : DeclNode{ Node::CLASS, location, access }, name{ name }, type{ type },
     classType{ classType }, ctor{ nullptr }
 {
 }
 
-void ClassNode::accept(NodeVisitor& nodeVisitor)
+llvm::StringRef ClassNode::getName() const
 {
-    nodeVisitor.visitClass(*this);
+    return name.getName();
 }
 
-llvm::StringRef ClassNode::getName() const
+Symbol ClassNode::getSymbol() const
 {
     return name;
 }
@@ -297,15 +316,9 @@ llvm::ArrayRef<MethodNode*> ClassNode::getMethods() const
     return methods;
 }
 
-bool ClassNode::addField(FieldNode& field)
+void ClassNode::setFields(llvm::ArrayRef<FieldNode*> fields)
 {
-    if (classType->setField(field.getName(), field.getType(), fields.size(),
-            field.getAccess()))
-    {
-        return true;
-    }
-    fields.push_back(&field);
-    return false;
+    this->fields = fields;
 }
 
 void ClassNode::setCtor(CtorNode& ctor)
@@ -313,12 +326,12 @@ void ClassNode::setCtor(CtorNode& ctor)
     this->ctor = &ctor;
 }
 
-void ClassNode::addMethod(MethodNode& method)
+void ClassNode::setMethods(llvm::ArrayRef<MethodNode*> methods)
 {
-    methods.push_back(&method);
+    this->methods = methods;
 }
 
-FieldNode::FieldNode(Location location, Access access, llvm::StringRef name,
+FieldNode::FieldNode(Location location, Access access, Symbol name,
     const Type* type, ExprNode* init, bool constness, ClassNode& parent)
     : VariableNode{ Node::FIELD, location, access, name, type, init,
         constness },
@@ -326,44 +339,24 @@ FieldNode::FieldNode(Location location, Access access, llvm::StringRef name,
 {
 }
 
-void FieldNode::accept(NodeVisitor& nodeVisitor)
-{
-    nodeVisitor.visitField(*this);
-}
-
-MethodNode::MethodNode(Location location, Access access, llvm::StringRef name,
-    std::vector<ParamNode*> params, const Type* returnType, BlockNode& body,
+MethodNode::MethodNode(Location location, Access access, Symbol name,
+    llvm::ArrayRef<ParamNode*> params, const Type* returnType, BlockNode& body,
     ClassNode& parent)
-    : FunctionNode{ Node::METHOD, location, access, name, std::move(params),
+    : FunctionNode{ Node::METHOD, location, access, name, params,
         returnType, body }, ClassNode::Member{ parent }
 {
 }
 
-void MethodNode::accept(NodeVisitor& nodeVisitor)
-{
-    nodeVisitor.visitMethod(*this);
-}
-
 CtorNode::CtorNode(Location location, Access access,
-    std::vector<ParamNode*> params, BlockNode& body, ClassNode& parent)
-    : FunctionNode{ Node::CTOR, location, access, parent.getName(),
-        std::move(params), parent.getType(), body }, ClassNode::Member{ parent }
-{
-}
-
-void CtorNode::accept(NodeVisitor& nodeVisitor)
-{
-    nodeVisitor.visitCtor(*this);
-}
-
-BlockNode::BlockNode(Location location, std::vector<Node*> statements)
-    : Node{ Node::BLOCK, location }, statements{ std::move(statements) }
+    llvm::ArrayRef<ParamNode*> params, BlockNode& body, ClassNode& parent)
+    : FunctionNode{ Node::CTOR, location, access, parent.getSymbol(),
+        params, parent.getType(), body }, ClassNode::Member{ parent }
 {
 }
 
-void BlockNode::accept(NodeVisitor& nodeVisitor)
+BlockNode::BlockNode(Location location, llvm::ArrayRef<Node*> statements)
+    : Node{ Node::BLOCK, location }, statements{ statements }
 {
-    nodeVisitor.visitBlock(*this);
 }
 
 llvm::ArrayRef<Node*> BlockNode::getStatements() const
@@ -376,11 +369,6 @@ EmptyNode::EmptyNode(Location location)
 {
 }
 
-void EmptyNode::accept(NodeVisitor& nodeVisitor)
-{
-    nodeVisitor.visitEmpty(*this);
-}
-
 IfNode::IfNode(Location location, ExprNode& condition, Node& thenCase,
     Node* elseCase)
     : Node{ Node::IF, location }, condition{ condition }, thenCase{ thenCase },
@@ -388,11 +376,6 @@ IfNode::IfNode(Location location, ExprNode& condition, Node& thenCase,
 {
 }
 
-void IfNode::accept(NodeVisitor& nodeVisitor)
-{
-    nodeVisitor.visitIf(*this);
-}
-
 ExprNode& IfNode::getCondition() const
 {
     return condition;
@@ -418,11 +401,6 @@ ReturnNode::ReturnNode(Location location, ExprNode* value)
 {
 }
 
-void ReturnNode::accept(NodeVisitor& nodeVisitor)
-{
-    nodeVisitor.visitReturn(*this);
-}
-
 bool ReturnNode::hasValue() const
 {
     return value;
@@ -443,17 +421,17 @@ bool ExprNode::isExpr() const
     return true;
 }
 
-IdentNode::IdentNode(Location location, llvm::StringRef name)
+IdentNode::IdentNode(Location location, Symbol name)
     : ExprNode{ Node::IDENT, location }, name{ name }
 {
 }
 
-void IdentNode::accept(NodeVisitor& nodeVisitor)
+llvm::StringRef IdentNode::getName() const
 {
-    nodeVisitor.visitIdent(*this);
+    return name.getName();
 }
 
-llvm::StringRef IdentNode::getName() const
+Symbol IdentNode::getSymbol() const
 {
     return name;
 }
@@ -463,11 +441,6 @@ LiteralNode::LiteralNode(Location location, llvm::APInt value)
 {
 }
 
-void LiteralNode::accept(NodeVisitor& nodeVisitor)
-{
-    nodeVisitor.visitLiteral(*this);
-}
-
 llvm::APInt LiteralNode::getValue() const
 {
     return value;
@@ -478,11 +451,6 @@ UnaryNode::UnaryNode(Location location, UnaryKind op, ExprNode& expr)
 {
 }
 
-void UnaryNode::accept(NodeVisitor& nodeVisitor)
-{
-    nodeVisitor.visitUnary(*this);
-}
-
 UnaryKind UnaryNode::getOp() const
 {
     return op;
@@ -504,11 +472,6 @@ BinaryNode::BinaryNode(Location location, BinaryKind op, ExprNode& left,
 {
 }
 
-void BinaryNode::accept(NodeVisitor& nodeVisitor)
-{
-    nodeVisitor.visitBinary(*this);
-}
-
 BinaryKind BinaryNode::getOp() const
 {
     return op;
@@ -536,11 +499,6 @@ TernaryNode::TernaryNode(Location location, ExprNode& condition,
 {
 }
 
-void TernaryNode::accept(NodeVisitor& nodeVisitor)
-{
-    nodeVisitor.visitTernary(*this);
-}
-
 ExprNode& TernaryNode::getCondition() const
 {
     return condition;
@@ -557,14 +515,9 @@ ExprNode& TernaryNode::getElse() const
 }
 
 CallNode::CallNode(Location location, ExprNode& callee,
-    std::vector<ArgNode*> args)
-    : CallNode{ Node::CALL, location, callee, std::move(args) }
-{
-}
-
-void CallNode::accept(NodeVisitor& nodeVisitor)
+    llvm::ArrayRef<ArgNode*> args)
+    : CallNode{ Node::CALL, location, callee, args }
 {
-    nodeVisitor.visitCall(*this);
 }
 
 ExprNode& CallNode::getCallee() const
@@ -587,20 +540,26 @@ ArgNode& CallNode::getArg(size_t i) const
     return *args[i];
 }
 
-CallNode::CallNode(Node::Kind kind, Location location, ExprNode& callee,
-    std::vector<ArgNode*> args)
-    : ExprNode{ kind, location }, callee{ callee }, args{ std::move(args) }
+bool CallNode::isStackAllocated() const
 {
+    return stackAllocated;
 }
 
-ArgNode::ArgNode(Location location, llvm::StringRef name, ExprNode& value)
-    : Node{ Node::ARG, location }, name{ name }, value{ value }
+void CallNode::setStackAllocated(bool stackAllocated)
 {
+    this->stackAllocated = stackAllocated;
 }
 
-void ArgNode::accept(NodeVisitor& nodeVisitor)
+CallNode::CallNode(Node::Kind kind, Location location, ExprNode& callee,
+    llvm::ArrayRef<ArgNode*> args)
+    : ExprNode{ kind, location }, callee{ callee }, args{ args },
+    stackAllocated{ false }
+{
+}
+
+ArgNode::ArgNode(Location location, llvm::StringRef name, ExprNode& value)
+    : Node{ Node::ARG, location }, name{ name }, value{ value }
 {
-    nodeVisitor.visitArg(*this);
 }
 
 llvm::StringRef ArgNode::getName() const
@@ -619,11 +578,6 @@ FieldAccessNode::FieldAccessNode(Location location, ExprNode& object,
 {
 }
 
-void FieldAccessNode::accept(NodeVisitor& nodeVisitor)
-{
-    nodeVisitor.visitFieldAccess(*this);
-}
-
 ExprNode& FieldAccessNode::getObject() const
 {
     return object;
@@ -635,18 +589,18 @@ llvm::StringRef FieldAccessNode::getField() const
 }
 
 MethodCallNode::MethodCallNode(Location location, ExprNode& callee,
-    llvm::StringRef method, std::vector<ArgNode*> args)
-    : CallNode{ Node::METHOD_CALL, location, callee, std::move(args) },
+    Symbol method, llvm::ArrayRef<ArgNode*> args)
+    : CallNode{ Node::METHOD_CALL, location, callee, args },
     method{ method }
 {
 }
 
-void MethodCallNode::accept(NodeVisitor& nodeVisitor)
+llvm::StringRef MethodCallNode::getMethod() const
 {
-    nodeVisitor.visitMethodCall(*this);
+    return method.getName();
 }
 
-llvm::StringRef MethodCallNode::getMethod() const
+Symbol MethodCallNode::getMethodSymbol() const
 {
     return method;
 }
@@ -655,8 +609,3 @@ SelfNode::SelfNode(Location location)
     : ExprNode{ Node::SELF, location }
 {
 }
-
-void SelfNode::accept(NodeVisitor& nodeVisitor)
-{
-    nodeVisitor.visitSelf(*this);
-}
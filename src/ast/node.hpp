@@ -41,8 +41,8 @@ enum class Access
     NONE
 };
 
-#include "ast/nodeVisitor.hpp"
 #include "ast/opKind.hpp"
+#include "ast/symbol.hpp"
 #include "ast/type.hpp"
 #include "lexer/location.hpp"
 #include "lexer/tokenKind.hpp"
@@ -52,7 +52,6 @@ enum class Access
 #include "llvm/ADT/Twine.h"
 #include "llvm/IR/GlobalValue.h"
 #include <string>
-#include <vector>
 
 /**
  * Merges two access specifiers. This is used when the grandparent scope wants
@@ -154,13 +153,12 @@ public:
      * @param location The source location.
      */
     Node(Kind kind, Location location);
-    virtual ~Node() = 0;
     /**
-     * Allows a NodeVisitor to visit this object.
+     * Gets the kind of Node this is, which NodeVisitor dispatches on.
      *
-     * @param nodeVisitor The visitor object.
+     * @returns The kind of Node this is.
      */
-    virtual void accept(NodeVisitor& nodeVisitor) = 0;
+    Kind getKind() const;
     /**
      * Verifies whether this Node represents a certain Kind.
      *
@@ -183,6 +181,14 @@ public:
      */
     virtual bool isExpr() const;
 
+protected:
+    /**
+     * Nodes live in VSLContext's arena and are never deleted through a base
+     * pointer. Keeping this non-virtual lets most Nodes be trivially
+     * destructible, so the arena can free them without running anything.
+     */
+    ~Node() = default;
+
 private:
     /** The kind of Node this is. */
     Kind kind;
@@ -235,9 +241,10 @@ public:
      * @param returnType The type that the function returns.
      */
     FuncInterfaceNode(Node::Kind kind, Location location, Access access,
-        llvm::StringRef name, std::vector<ParamNode*> params,
+        Symbol name, llvm::ArrayRef<ParamNode*> params,
         const Type* returnType);
     llvm::StringRef getName() const;
+    Symbol getSymbol() const;
     llvm::ArrayRef<ParamNode*> getParams() const;
     size_t getNumParams() const;
     ParamNode& getParam(size_t i) const;
@@ -245,9 +252,9 @@ public:
 
 private:
     /** The name of the function. */
-    llvm::StringRef name;
+    Symbol name;
     /** The function's parameters. */
-    std::vector<ParamNode*> params;
+    llvm::ArrayRef<ParamNode*> params;
     /** The function's return type. */
     const Type* returnType;
 };
@@ -268,11 +275,9 @@ public:
      * @param returnType The type that the function returns.
      * @param body The body of the function.
      */
-    FunctionNode(Location location, Access access, llvm::StringRef name,
-        std::vector<ParamNode*> params, const Type* returnType,
+    FunctionNode(Location location, Access access, Symbol name,
+        llvm::ArrayRef<ParamNode*> params, const Type* returnType,
         BlockNode& body);
-    virtual ~FunctionNode() override = default;
-    virtual void accept(NodeVisitor& nodeVisitor) override;
     BlockNode& getBody() const;
     bool isAlreadyDefined() const;
     void setAlreadyDefined(bool alreadyDefined = true);
@@ -282,7 +287,7 @@ protected:
      * Used by subclasses.
      */
     FunctionNode(Node::Kind kind, Location location, Access access,
-        llvm::StringRef name, std::vector<ParamNode*> params,
+        Symbol name, llvm::ArrayRef<ParamNode*> params,
         const Type* returnType, BlockNode& body);
 
 private:
@@ -310,11 +315,9 @@ public:
      * @param returnType The type that the function returns.
      * @param alias What this function's actual name is outside of VSL.
      */
-    ExtFuncNode(Location location, Access access, llvm::StringRef name,
-        std::vector<ParamNode*> params, const Type* returnType,
+    ExtFuncNode(Location location, Access access, Symbol name,
+        llvm::ArrayRef<ParamNode*> params, const Type* returnType,
         llvm::StringRef alias);
-    virtual ~ExtFuncNode() override = default;
-    virtual void accept(NodeVisitor& nodeVisitor) override;
     llvm::StringRef getAlias() const;
 
 private:
@@ -335,17 +338,26 @@ public:
      * @param name The name of the parameter.
      * @param type The type of the parameter.
      */
-    ParamNode(Location location, llvm::StringRef name, const Type* type);
-    virtual ~ParamNode() override = default;
-    virtual void accept(NodeVisitor& nodeVisitor) override;
+    ParamNode(Location location, Symbol name, const Type* type);
     llvm::StringRef getName() const;
+    Symbol getSymbol() const;
     const Type* getType() const;
+    /**
+     * Checks whether the function body assigns to this parameter. If not, it
+     * can be borrowed from the caller rather than owned by the callee.
+     *
+     * @returns True if reassigned, false otherwise.
+     */
+    bool isReassigned() const;
+    void setReassigned(bool reassigned = true);
 
 private:
     /** The name of the parameter. */
-    llvm::StringRef name;
+    Symbol name;
     /** The type of the parameter. */
     const Type* type;
+    /** Whether the function body assigns to this parameter. */
+    bool reassigned;
 };
 
 /**
@@ -364,34 +376,43 @@ public:
      * @param init The variable's initial value. Can be null.
      * @param constness If this variable is const or not (TODO).
      */
-    VariableNode(Location location, Access access, llvm::StringRef name,
+    VariableNode(Location location, Access access, Symbol name,
         const Type* type, ExprNode* init, bool constness);
-    virtual ~VariableNode() override = default;
-    virtual void accept(NodeVisitor& nodeVisitor) override;
     llvm::StringRef getName() const;
+    Symbol getSymbol() const;
     bool hasType() const;
     const Type* getType() const;
     void setType(const Type* type);
     bool hasInit() const;
     ExprNode& getInit() const;
     bool isConst() const;
+    /**
+     * Checks whether this is a local variable that gets assigned to after
+     * being initialized. If not, it doesn't need any storage of its own.
+     *
+     * @returns True if reassigned, false otherwise.
+     */
+    bool isReassigned() const;
+    void setReassigned(bool reassigned = true);
 
 protected:
     /**
      * Used by subclasses.
      */
     VariableNode(Node::Kind kind, Location location, Access access,
-        llvm::StringRef name, const Type* type, ExprNode* init, bool constness);
+        Symbol name, const Type* type, ExprNode* init, bool constness);
 
 private:
     /** The name of the variable. */
-    llvm::StringRef name;
+    Symbol name;
     /** The type of the variable. */
     const Type* type;
     /** The variable's initial value. */
     ExprNode* init;
     /** If this variable is const or not. */
     bool constness;
+    /** Whether this local variable is assigned to after initialization. */
+    bool reassigned;
 };
 
 /**
@@ -442,11 +463,10 @@ public:
      * underlying type.
      * @param classType Class type equivalent.
      */
-    ClassNode(Location location, Access access, llvm::StringRef name,
+    ClassNode(Location location, Access access, Symbol name,
         const NamedType* type, ClassType* classType);
-    virtual ~ClassNode() override = default;
-    virtual void accept(NodeVisitor& nodeVisitor) override;
     llvm::StringRef getName() const;
+    Symbol getSymbol() const;
     const NamedType* getType() const;
     const ClassType* getClassType() const;
     llvm::ArrayRef<FieldNode*> getFields() const;
@@ -456,30 +476,33 @@ public:
     CtorNode& getCtor() const;
     llvm::ArrayRef<MethodNode*> getMethods() const;
     /**
-     * Adds a field. This method fails and returns true if a field with the same
-     * name already exists.
-     *
-     * @param field Field to add.
+     * Sets the fields. Each field should already be registered with the class
+     * type at its index in this list.
      *
-     * @returns True if a duplicate field already exists, false otherwise.
+     * @param fields List of fields. Must be allocated by the VSLContext.
      */
-    bool addField(FieldNode& field);
+    void setFields(llvm::ArrayRef<FieldNode*> fields);
     void setCtor(CtorNode& ctor);
-    void addMethod(MethodNode& method);
+    /**
+     * Sets the instance methods.
+     *
+     * @param methods List of methods. Must be allocated by the VSLContext.
+     */
+    void setMethods(llvm::ArrayRef<MethodNode*> methods);
 
 private:
     /** Name of the class. */
-    llvm::StringRef name;
+    Symbol name;
     /** Type of the class. */
     const NamedType* type;
     /** Class type equivalent. */
     ClassType* classType;
     /** List of fields. */
-    std::vector<FieldNode*> fields;
+    llvm::ArrayRef<FieldNode*> fields;
     /** Class constructor. Can be null. */
     CtorNode* ctor;
     /** List of instance methods. */
-    std::vector<MethodNode*> methods;
+    llvm::ArrayRef<MethodNode*> methods;
 };
 
 /**
@@ -499,10 +522,8 @@ public:
      * @param constness If this field is const or not (TODO).
      * @param parent The ClassNode this FieldNode belongs to.
      */
-    FieldNode(Location location, Access access, llvm::StringRef name,
+    FieldNode(Location location, Access access, Symbol name,
         const Type* type, ExprNode* init, bool constness, ClassNode& parent);
-    virtual ~FieldNode() override = default;
-    virtual void accept(NodeVisitor& nodeVisitor) override;
 };
 
 /**
@@ -522,11 +543,9 @@ public:
      * @param body Body of the method.
      * @param parent The ClassNode this MethodNode belongs to.
      */
-    MethodNode(Location location, Access access, llvm::StringRef name,
-        std::vector<ParamNode*> params, const Type* returnType, BlockNode& body,
-        ClassNode& parent);
-    virtual ~MethodNode() override = default;
-    virtual void accept(NodeVisitor& nodeVisitor) override;
+    MethodNode(Location location, Access access, Symbol name,
+        llvm::ArrayRef<ParamNode*> params, const Type* returnType,
+        BlockNode& body, ClassNode& parent);
 };
 
 /**
@@ -547,10 +566,8 @@ public:
      * @param body Body of the method.
      * @param parent The ClassNode this CtorNode belongs to.
      */
-    CtorNode(Location location, Access access, std::vector<ParamNode*> params,
-        BlockNode& body, ClassNode& parent);
-    virtual ~CtorNode() override = default;
-    virtual void accept(NodeVisitor& nodeVisitor) override;
+    CtorNode(Location location, Access access,
+        llvm::ArrayRef<ParamNode*> params, BlockNode& body, ClassNode& parent);
 };
 
 /**
@@ -565,14 +582,12 @@ public:
      * @param location Where this BlockNode was found in the source.
      * @param statements The statements inside the block.
      */
-    BlockNode(Location location, std::vector<Node*> statements);
-    virtual ~BlockNode() override = default;
-    virtual void accept(NodeVisitor& nodeVisitor) override;
+    BlockNode(Location location, llvm::ArrayRef<Node*> statements);
     llvm::ArrayRef<Node*> getStatements() const;
 
 private:
     /** The statements inside the block. */
-    std::vector<Node*> statements;
+    llvm::ArrayRef<Node*> statements;
 };
 
 /**
@@ -587,8 +602,6 @@ public:
      * @param location Where this EmptyNode was found in the source.
      */
     EmptyNode(Location location);
-    virtual ~EmptyNode() override = default;
-    virtual void accept(NodeVisitor& nodeVisitor) override;
 };
 
 /**
@@ -607,8 +620,6 @@ public:
      */
     IfNode(Location location, ExprNode& condition, Node& thenCase,
         Node* elseCase);
-    virtual ~IfNode() override = default;
-    virtual void accept(NodeVisitor& nodeVisitor) override;
     ExprNode& getCondition() const;
     Node& getThen() const;
     bool hasElse() const;
@@ -636,8 +647,6 @@ public:
      * @param value The value to return. Can be null.
      */
     ReturnNode(Location location, ExprNode* value);
-    virtual ~ReturnNode() override = default;
-    virtual void accept(NodeVisitor& nodeVisitor) override;
     bool hasValue() const;
     ExprNode& getValue() const;
 
@@ -674,14 +683,13 @@ public:
      * @param location where this IdentNode was found in the source.
      * @param name The name of the identifier.
      */
-    IdentNode(Location location, llvm::StringRef name);
-    virtual ~IdentNode() override = default;
-    virtual void accept(NodeVisitor& nodeVisitor) override;
+    IdentNode(Location location, Symbol name);
     llvm::StringRef getName() const;
+    Symbol getSymbol() const;
 
 private:
     /** The name of the identifier. */
-    llvm::StringRef name;
+    Symbol name;
 };
 
 /**
@@ -697,8 +705,6 @@ public:
      * @param value The value of the number.
      */
     LiteralNode(Location location, llvm::APInt value);
-    virtual ~LiteralNode() override = default;
-    virtual void accept(NodeVisitor& nodeVisitor) override;
     llvm::APInt getValue() const;
 
 private:
@@ -720,8 +726,6 @@ public:
      * @param expr The expression to apply the operator to.
      */
     UnaryNode(Location location, UnaryKind op, ExprNode& expr);
-    virtual ~UnaryNode() override = default;
-    virtual void accept(NodeVisitor& nodeVisitor) override;
     UnaryKind getOp() const;
     const char* getOpSymbol() const;
     ExprNode& getExpr() const;
@@ -749,8 +753,6 @@ public:
      */
     BinaryNode(Location location, BinaryKind op, ExprNode& left,
         ExprNode& right);
-    virtual ~BinaryNode() override = default;
-    virtual void accept(NodeVisitor& nodeVisitor) override;
     BinaryKind getOp() const;
     const char* getOpSymbol() const;
     ExprNode& getLhs() const;
@@ -781,8 +783,6 @@ public:
      */
     TernaryNode(Location location, ExprNode& condition, ExprNode& thenCase,
         ExprNode& elseCase);
-    virtual ~TernaryNode() override = default;
-    virtual void accept(NodeVisitor& nodeVisitor) override;
     ExprNode& getCondition() const;
     ExprNode& getThen() const;
     ExprNode& getElse() const;
@@ -809,13 +809,20 @@ public:
      * @param callee The function to call.
      * @param args The arguments to pass to the callee.
      */
-    CallNode(Location location, ExprNode& callee, std::vector<ArgNode*> args);
-    virtual ~CallNode() override = default;
-    virtual void accept(NodeVisitor& nodeVisitor) override;
+    CallNode(Location location, ExprNode& callee,
+        llvm::ArrayRef<ArgNode*> args);
     ExprNode& getCallee() const;
     llvm::ArrayRef<ArgNode*> getArgs() const;
     size_t getNumArgs() const;
     ArgNode& getArg(size_t i) const;
+    /**
+     * Checks whether this is a constructor call whose object never escapes
+     * the calling function, so it can live on the stack.
+     *
+     * @returns True if the object can be stack allocated, false otherwise.
+     */
+    bool isStackAllocated() const;
+    void setStackAllocated(bool stackAllocated = true);
 
 protected:
     /**
@@ -828,13 +835,15 @@ protected:
      * @param args The arguments to pass to the callee.
      */
     CallNode(Node::Kind kind, Location location, ExprNode& callee,
-        std::vector<ArgNode*> args);
+        llvm::ArrayRef<ArgNode*> args);
 
 private:
     /** The function to call. */
     ExprNode& callee;
     /** The arguments to pass to the callee. */
-    std::vector<ArgNode*> args;
+    llvm::ArrayRef<ArgNode*> args;
+    /** Whether the constructed object can live on the stack. */
+    bool stackAllocated;
 };
 
 /**
@@ -851,8 +860,6 @@ public:
      * @param value The value of the argument.
      */
     ArgNode(Location location, llvm::StringRef name, ExprNode& value);
-    virtual ~ArgNode() override = default;
-    virtual void accept(NodeVisitor& nodeVisitor) override;
     llvm::StringRef getName() const;
     ExprNode& getValue() const;
 
@@ -877,8 +884,6 @@ public:
      * @param field Name of the field to access.
      */
     FieldAccessNode(Location location, ExprNode& object, llvm::StringRef field);
-    virtual ~FieldAccessNode() override = default;
-    virtual void accept(NodeVisitor& nodeVisitor) override;
     ExprNode& getObject() const;
     llvm::StringRef getField() const;
 
@@ -903,15 +908,14 @@ public:
      * @param method Name of the method.
      * @param args Arguments to pass to the callee+method.
      */
-    MethodCallNode(Location location, ExprNode& callee, llvm::StringRef method,
-        std::vector<ArgNode*> args);
-    virtual ~MethodCallNode() override = default;
-    virtual void accept(NodeVisitor& nodeVisitor) override;
+    MethodCallNode(Location location, ExprNode& callee, Symbol method,
+        llvm::ArrayRef<ArgNode*> args);
     llvm::StringRef getMethod() const;
+    Symbol getMethodSymbol() const;
 
 private:
     /** Name of the method. */
-    llvm::StringRef method;
+    Symbol method;
 };
 
 /**
@@ -926,8 +930,6 @@ public:
      * @param location Where this SelfNode was found in the source.
      */
     SelfNode(Location location);
-    virtual ~SelfNode() override = default;
-    virtual void accept(NodeVisitor& nodeVisitor) override;
 };
 
 #endif // NODE_HPP
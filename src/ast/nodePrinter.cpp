@@ -9,7 +9,7 @@ void NodePrinter::visitAST(llvm::ArrayRef<DeclNode*> ast)
 {
     for (DeclNode* decl : ast)
     {
-        decl->accept(*this);
+        visit(*decl);
         os << '\n';
     }
 }
@@ -45,7 +45,7 @@ void NodePrinter::visitVariable(VariableNode& node)
     if (node.hasInit())
     {
         os << " = ";
-        node.getInit().accept(*this);
+        visit(node.getInit());
     }
     os << ';';
 }
@@ -59,19 +59,19 @@ void NodePrinter::visitClass(ClassNode& node)
     // print fields
     for (FieldNode* field : node.getFields())
     {
-        field->accept(*this);
+        visit(*field);
         os << '\n';
     }
     // print ctor
     if (node.hasCtor())
     {
-        node.getCtor().accept(*this);
+        visit(node.getCtor());
         os << '\n';
     }
     // print methods
     for (MethodNode* method : node.getMethods())
     {
-        method->accept(*this);
+        visit(*method);
         os << '\n';
     }
     closeBlock();
@@ -127,7 +127,7 @@ void NodePrinter::visitEmpty(EmptyNode& node)
 void NodePrinter::visitIf(IfNode& node)
 {
     indent() << "if (";
-    node.getCondition().accept(*this);
+    visit(node.getCondition());
     os << ")\n";
     ++indentLevel;
     printStatement(node.getThen());
@@ -149,7 +149,7 @@ void NodePrinter::visitReturn(ReturnNode& node)
     if (node.hasValue())
     {
         os << ' ';
-        node.getValue().accept(*this);
+        visit(node.getValue());
     }
     os << ';';
 }
@@ -176,47 +176,47 @@ void NodePrinter::visitLiteral(LiteralNode& node)
 void NodePrinter::visitUnary(UnaryNode& node)
 {
     os << node.getOpSymbol() << '(';
-    node.getExpr().accept(*this);
+    visit(node.getExpr());
     os << ')';
 }
 
 void NodePrinter::visitBinary(BinaryNode& node)
 {
-    node.getLhs().accept(*this);
+    visit(node.getLhs());
     os << ' ' << node.getOpSymbol() << ' ';
-    node.getRhs().accept(*this);
+    visit(node.getRhs());
 }
 
 void NodePrinter::visitTernary(TernaryNode& node)
 {
-    node.getCondition().accept(*this);
+    visit(node.getCondition());
     os << " ? ";
-    node.getThen().accept(*this);
+    visit(node.getThen());
     os << " : ";
-    node.getElse().accept(*this);
+    visit(node.getElse());
 }
 
 void NodePrinter::visitCall(CallNode& node)
 {
-    node.getCallee().accept(*this);
+    visit(node.getCallee());
     printNodeList(node.getArgs());
 }
 
 void NodePrinter::visitArg(ArgNode& node)
 {
     os << node.getName() << ": ";
-    node.getValue().accept(*this);
+    visit(node.getValue());
 }
 
 void NodePrinter::visitFieldAccess(FieldAccessNode& node)
 {
-    node.getObject().accept(*this);
+    visit(node.getObject());
     os << '.' << node.getField();
 }
 
 void NodePrinter::visitMethodCall(MethodCallNode& node)
 {
-    node.getCallee().accept(*this);
+    visit(node.getCallee());
     os << '.' << node.getMethod();
     printNodeList(node.getArgs());
 }
@@ -253,11 +253,11 @@ void NodePrinter::printNodeList(llvm::ArrayRef<NodeT*> nodes)
     os << '(';
     if (!nodes.empty())
     {
-        nodes[0]->accept(*this);
+        visit(*nodes[0]);
         for (size_t i = 1; i < nodes.size(); ++i)
         {
             os << ", ";
-            nodes[i]->accept(*this);
+            visit(*nodes[i]);
         }
     }
     os << ')';
@@ -286,7 +286,7 @@ void NodePrinter::printStatement(Node& node)
     {
         indent();
     }
-    node.accept(*this);
+    visit(node);
     // add a semicolon after expression statements
     if (node.isExpr())
     {
@@ -9,7 +9,7 @@
 /**
  * Pretty-prints the AST.
  */
-class NodePrinter : public NodeVisitor
+class NodePrinter : public NodeVisitor<NodePrinter>
 {
 public:
     /**
@@ -18,30 +18,29 @@ public:
      * @param os Stream to print to.
      */
     NodePrinter(llvm::raw_ostream& os);
-    virtual ~NodePrinter() override = default;
-    virtual void visitAST(llvm::ArrayRef<DeclNode*> ast) override;
-    virtual void visitFunction(FunctionNode& node) override;
-    virtual void visitExtFunc(ExtFuncNode& node) override;
-    virtual void visitParam(ParamNode& node) override;
-    virtual void visitVariable(VariableNode& node) override;
-    virtual void visitClass(ClassNode& node) override;
-    virtual void visitField(FieldNode& node) override;
-    virtual void visitMethod(MethodNode& node) override;
-    virtual void visitCtor(CtorNode& node) override;
-    virtual void visitBlock(BlockNode& node) override;
-    virtual void visitEmpty(EmptyNode& node) override;
-    virtual void visitIf(IfNode& node) override;
-    virtual void visitReturn(ReturnNode& node) override;
-    virtual void visitIdent(IdentNode& node) override;
-    virtual void visitLiteral(LiteralNode& node) override;
-    virtual void visitUnary(UnaryNode& node) override;
-    virtual void visitBinary(BinaryNode& node) override;
-    virtual void visitTernary(TernaryNode& node) override;
-    virtual void visitCall(CallNode& node) override;
-    virtual void visitArg(ArgNode& node) override;
-    virtual void visitFieldAccess(FieldAccessNode& node) override;
-    virtual void visitMethodCall(MethodCallNode& node) override;
-    virtual void visitSelf(SelfNode& node) override;
+    void visitAST(llvm::ArrayRef<DeclNode*> ast);
+    void visitFunction(FunctionNode& node);
+    void visitExtFunc(ExtFuncNode& node);
+    void visitParam(ParamNode& node);
+    void visitVariable(VariableNode& node);
+    void visitClass(ClassNode& node);
+    void visitField(FieldNode& node);
+    void visitMethod(MethodNode& node);
+    void visitCtor(CtorNode& node);
+    void visitBlock(BlockNode& node);
+    void visitEmpty(EmptyNode& node);
+    void visitIf(IfNode& node);
+    void visitReturn(ReturnNode& node);
+    void visitIdent(IdentNode& node);
+    void visitLiteral(LiteralNode& node);
+    void visitUnary(UnaryNode& node);
+    void visitBinary(BinaryNode& node);
+    void visitTernary(TernaryNode& node);
+    void visitCall(CallNode& node);
+    void visitArg(ArgNode& node);
+    void visitFieldAccess(FieldAccessNode& node);
+    void visitMethodCall(MethodCallNode& node);
+    void visitSelf(SelfNode& node);
 
 private:
     /**
@@ -1,48 +1,256 @@
 #ifndef NODEVISITOR_HPP
 #define NODEVISITOR_HPP
 
-class NodeVisitor;
-
 #include "ast/node.hpp"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/Support/ErrorHandling.h"
+#include <algorithm>
+#include <cstddef>
+#include <vector>
 
 /**
- * Base class for visiting a Node, implementing the Visitor Pattern. Subclasses
- * can override the visit methods to perform some operation on a Node through
- * double dispatch.
+ * Base class for visiting a Node, implementing the Visitor Pattern through the
+ * Curiously Recurring Template Pattern. Subclasses pass themselves as the
+ * template argument and hide the visit methods that they need, and visit()
+ * switches on the Node's Kind to call them. Since the subclass is known at
+ * compile time, every visit method is called directly and can be inlined.
+ *
+ * Subclasses that don't need anything back from a child can visit it with
+ * walk() instead of visit(), which visits it only after the current visit
+ * method returns, so that expressions of any depth are traversed with an
+ * explicit stack instead of the call stack. One that does can walk itself
+ * again afterwards to pick up where it left off.
+ *
+ * @tparam Derived The subclass.
  */
+template<typename Derived>
 class NodeVisitor
 {
 public:
-    virtual ~NodeVisitor() = 0;
+    /**
+     * Visits a Node, calling the subclass' visit method for its Kind.
+     *
+     * @param node The node to visit.
+     */
+    void visit(Node& node);
     /**
      * Visits an AST.
      *
      * @param ast The list of global declarations to process.
      */
-    virtual void visitAST(llvm::ArrayRef<DeclNode*> ast);
-    virtual void visitFunction(FunctionNode& node);
-    virtual void visitExtFunc(ExtFuncNode& node);
-    virtual void visitParam(ParamNode& node);
-    virtual void visitVariable(VariableNode& node);
-    virtual void visitClass(ClassNode& node);
-    virtual void visitField(FieldNode& node);
-    virtual void visitMethod(MethodNode& node);
-    virtual void visitCtor(CtorNode& node);
-    virtual void visitBlock(BlockNode& node);
-    virtual void visitEmpty(EmptyNode& node);
-    virtual void visitIf(IfNode& node);
-    virtual void visitReturn(ReturnNode& node);
-    virtual void visitIdent(IdentNode& node);
-    virtual void visitLiteral(LiteralNode& node);
-    virtual void visitUnary(UnaryNode& node);
-    virtual void visitBinary(BinaryNode& node);
-    virtual void visitTernary(TernaryNode& node);
-    virtual void visitCall(CallNode& node);
-    virtual void visitArg(ArgNode& node);
-    virtual void visitFieldAccess(FieldAccessNode& node);
-    virtual void visitMethodCall(MethodCallNode& node);
-    virtual void visitSelf(SelfNode& node);
+    void visitAST(llvm::ArrayRef<DeclNode*> ast);
+    void visitFunction(FunctionNode& node) {}
+    void visitExtFunc(ExtFuncNode& node) {}
+    void visitParam(ParamNode& node) {}
+    void visitVariable(VariableNode& node) {}
+    void visitClass(ClassNode& node) {}
+    void visitField(FieldNode& node) {}
+    void visitMethod(MethodNode& node) {}
+    void visitCtor(CtorNode& node) {}
+    void visitBlock(BlockNode& node) {}
+    void visitEmpty(EmptyNode& node) {}
+    void visitIf(IfNode& node) {}
+    void visitReturn(ReturnNode& node) {}
+    void visitIdent(IdentNode& node) {}
+    void visitLiteral(LiteralNode& node) {}
+    void visitUnary(UnaryNode& node) {}
+    void visitBinary(BinaryNode& node) {}
+    void visitTernary(TernaryNode& node) {}
+    void visitCall(CallNode& node) {}
+    void visitArg(ArgNode& node) {}
+    void visitFieldAccess(FieldAccessNode& node) {}
+    void visitMethodCall(MethodCallNode& node) {}
+    void visitSelf(SelfNode& node) {}
+
+protected:
+    /**
+     * Visits a node in the explicit stack traversal mode. If a node is already
+     * being walked, this one is queued and visited after the current visit
+     * method returns, in the same order as it was walked. Otherwise, it's
+     * visited right away along with everything that it walks.
+     *
+     * @param node The node to visit.
+     * @param state Anything the visit methods need to know about the node,
+     * which they can get from getWalkState().
+     */
+    void walk(Node& node, unsigned state = 0);
+    /**
+     * Visits a node along with everything that it walks right away, even if
+     * a node is already being walked. That walk carries on once this one is
+     * done.
+     *
+     * @param node The node to visit.
+     * @param state Anything the visit methods need to know about the node,
+     * which they can get from getWalkState().
+     */
+    void walkNow(Node& node, unsigned state = 0);
+    /**
+     * Gets the state that the node being walked was queued with.
+     *
+     * @returns The state passed to walk().
+     */
+    unsigned getWalkState() const;
+
+private:
+    /**
+     * Gets the subclass that's doing the visiting.
+     *
+     * @returns This object as a Derived.
+     */
+    Derived& derived();
+    /**
+     * A node that was walked but not visited yet.
+     */
+    struct WalkItem
+    {
+        /** The node to visit. */
+        Node* node;
+        /** The state to visit it with. */
+        unsigned state;
+    };
+    /** Nodes waiting to be visited, the next one last. */
+    std::vector<WalkItem> walkStack;
+    /** The state of the node currently being walked. */
+    unsigned walkState = 0;
+    /** Whether walk() is currently visiting nodes. */
+    bool walking = false;
 };
 
+template<typename Derived>
+void NodeVisitor<Derived>::visit(Node& node)
+{
+    // each Kind is only ever used by one subclass of Node, so the casts are
+    //  always to the node's actual type
+    switch (node.getKind())
+    {
+    case Node::FUNCTION:
+        derived().visitFunction(static_cast<FunctionNode&>(node));
+        break;
+    case Node::EXTFUNC:
+        derived().visitExtFunc(static_cast<ExtFuncNode&>(node));
+        break;
+    case Node::PARAM:
+        derived().visitParam(static_cast<ParamNode&>(node));
+        break;
+    case Node::VARIABLE:
+        derived().visitVariable(static_cast<VariableNode&>(node));
+        break;
+    case Node::CLASS:
+        derived().visitClass(static_cast<ClassNode&>(node));
+        break;
+    case Node::FIELD:
+        derived().visitField(static_cast<FieldNode&>(node));
+        break;
+    case Node::METHOD:
+        derived().visitMethod(static_cast<MethodNode&>(node));
+        break;
+    case Node::CTOR:
+        derived().visitCtor(static_cast<CtorNode&>(node));
+        break;
+    case Node::BLOCK:
+        derived().visitBlock(static_cast<BlockNode&>(node));
+        break;
+    case Node::EMPTY:
+        derived().visitEmpty(static_cast<EmptyNode&>(node));
+        break;
+    case Node::IF:
+        derived().visitIf(static_cast<IfNode&>(node));
+        break;
+    case Node::RETURN:
+        derived().visitReturn(static_cast<ReturnNode&>(node));
+        break;
+    case Node::IDENT:
+        derived().visitIdent(static_cast<IdentNode&>(node));
+        break;
+    case Node::LITERAL:
+        derived().visitLiteral(static_cast<LiteralNode&>(node));
+        break;
+    case Node::UNARY:
+        derived().visitUnary(static_cast<UnaryNode&>(node));
+        break;
+    case Node::BINARY:
+        derived().visitBinary(static_cast<BinaryNode&>(node));
+        break;
+    case Node::TERNARY:
+        derived().visitTernary(static_cast<TernaryNode&>(node));
+        break;
+    case Node::CALL:
+        derived().visitCall(static_cast<CallNode&>(node));
+        break;
+    case Node::ARG:
+        derived().visitArg(static_cast<ArgNode&>(node));
+        break;
+    case Node::FIELD_ACCESS:
+        derived().visitFieldAccess(static_cast<FieldAccessNode&>(node));
+        break;
+    case Node::METHOD_CALL:
+        derived().visitMethodCall(static_cast<MethodCallNode&>(node));
+        break;
+    case Node::SELF:
+        derived().visitSelf(static_cast<SelfNode&>(node));
+        break;
+    default:
+        llvm_unreachable("unknown node kind");
+    }
+}
+
+template<typename Derived>
+void NodeVisitor<Derived>::visitAST(llvm::ArrayRef<DeclNode*> ast)
+{
+    for (DeclNode* decl : ast)
+    {
+        visit(*decl);
+    }
+}
+
+template<typename Derived>
+void NodeVisitor<Derived>::walk(Node& node, unsigned state)
+{
+    if (walking)
+    {
+        // the outer walk() gets to it once the current node is done
+        walkStack.push_back({ &node, state });
+        return;
+    }
+    walkNow(node, state);
+}
+
+template<typename Derived>
+void NodeVisitor<Derived>::walkNow(Node& node, unsigned state)
+{
+    // anything already on the stack belongs to an outer walk
+    size_t base = walkStack.size();
+    walkStack.push_back({ &node, state });
+    // visit methods called outside of this walk shouldn't see the state of the
+    //  last node walked, so it's restored afterwards
+    unsigned outerState = walkState;
+    bool outerWalking = walking;
+    walking = true;
+    while (walkStack.size() > base)
+    {
+        WalkItem item = walkStack.back();
+        walkStack.pop_back();
+        size_t queued = walkStack.size();
+        walkState = item.state;
+        visit(*item.node);
+        // the children were queued first to last, but the stack pops them off
+        //  last to first
+        std::reverse(walkStack.begin() + queued, walkStack.end());
+    }
+    walking = outerWalking;
+    walkState = outerState;
+}
+
+template<typename Derived>
+unsigned NodeVisitor<Derived>::getWalkState() const
+{
+    return walkState;
+}
+
+template<typename Derived>
+Derived& NodeVisitor<Derived>::derived()
+{
+    return static_cast<Derived&>(*this);
+}
+
 #endif // NODEVISITOR_HPP
@@ -0,0 +1,74 @@
+#ifndef SYMBOL_HPP
+#define SYMBOL_HPP
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+
+/**
+ * An identifier that was interned by VSLContext. Every identifier with the same
+ * name gets the same Symbol, so comparing two of them is a pointer comparison,
+ * and each has a dense integer ID that scopes can index arrays with.
+ *
+ * Symbols only point into VSLContext's symbol table, so they're cheap to copy
+ * and can be read from multiple threads once they're all interned.
+ */
+class Symbol
+{
+public:
+    /** An entry in VSLContext's symbol table, mapping a name to its ID. */
+    using Entry = llvm::StringMapEntry<unsigned>;
+    /**
+     * Creates a Symbol.
+     *
+     * @param entry The symbol table entry that was interned.
+     */
+    explicit Symbol(const Entry& entry);
+    /**
+     * Gets the name of the identifier.
+     *
+     * @returns The identifier's name, owned by the VSLContext.
+     */
+    llvm::StringRef getName() const;
+    /**
+     * Gets the ID of the identifier. IDs start at 0 and go up by one for each
+     * new identifier that's interned.
+     *
+     * @returns The identifier's ID.
+     */
+    unsigned getId() const;
+    bool operator==(Symbol other) const;
+    bool operator!=(Symbol other) const;
+
+private:
+    /** The interned entry. */
+    const Entry* entry;
+};
+
+// these are used for every name lookup, so they're kept inline
+
+inline Symbol::Symbol(const Entry& entry)
+    : entry{ &entry }
+{
+}
+
+inline llvm::StringRef Symbol::getName() const
+{
+    return entry->getKey();
+}
+
+inline unsigned Symbol::getId() const
+{
+    return entry->getValue();
+}
+
+inline bool Symbol::operator==(Symbol other) const
+{
+    return entry == other.entry;
+}
+
+inline bool Symbol::operator!=(Symbol other) const
+{
+    return entry != other.entry;
+}
+
+#endif // SYMBOL_HPP
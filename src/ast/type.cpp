@@ -1,4 +1,5 @@
 #include "ast/type.hpp"
+#include <algorithm>
 
 llvm::raw_ostream& operator<<(llvm::raw_ostream& os, const Type& type)
 {
@@ -242,6 +243,21 @@ ClassType::Field ClassType::getField(llvm::StringRef name) const
     return it->getValue();
 }
 
+std::vector<ClassType::Field> ClassType::getFields() const
+{
+    std::vector<Field> fields;
+    fields.reserve(fieldTypes.size());
+    for (const auto& entry : fieldTypes)
+    {
+        fields.push_back(entry.getValue());
+    }
+    std::sort(fields.begin(), fields.end(), [](const Field& a, const Field& b)
+        {
+            return a.index < b.index;
+        });
+    return fields;
+}
+
 bool ClassType::setField(llvm::StringRef name, const Type* type, size_t index,
     Access access)
 {
@@ -231,6 +231,12 @@ public:
      * @returns Corresponding field type, or null if nonexistent.
      */
     Field getField(llvm::StringRef name) const;
+    /**
+     * Gets every field.
+     *
+     * @returns The fields, sorted by index.
+     */
+    std::vector<Field> getFields() const;
     /**
      * Adds a new field.
      *
@@ -6,9 +6,17 @@ VSLContext::VSLContext()
 {
 }
 
-void VSLContext::addNode(std::unique_ptr<Node> node)
+VSLContext::~VSLContext()
 {
-    nodes.push_back(std::move(node));
+    for (auto it = cleanups.rbegin(); it != cleanups.rend(); ++it)
+    {
+        it->second(it->first);
+    }
+}
+
+size_t VSLContext::getArenaSize() const
+{
+    return arena.getTotalMemory();
 }
 
 void VSLContext::setGlobal(DeclNode* decl)
@@ -21,6 +29,18 @@ llvm::ArrayRef<DeclNode*> VSLContext::getGlobals() const
     return globals;
 }
 
+Symbol VSLContext::intern(llvm::StringRef name)
+{
+    // the next ID is only used if the name is new
+    auto id = static_cast<unsigned>(symbols.size());
+    return Symbol{ *symbols.try_emplace(name, id).first };
+}
+
+size_t VSLContext::getNumSymbols() const
+{
+    return symbols.size();
+}
+
 const SimpleType* VSLContext::getBoolType() const
 {
     return &boolType;
@@ -62,6 +82,13 @@ bool VSLContext::hasNamedType(llvm::StringRef name) const
     return namedTypes.find(nt) != namedTypes.end();
 }
 
+const NamedType* VSLContext::findNamedType(llvm::StringRef name) const
+{
+    NamedType nt{ name };
+    auto it = namedTypes.find(nt);
+    return it != namedTypes.end() ? &*it : nullptr;
+}
+
 const NamedType* VSLContext::getNamedType(llvm::StringRef name)
 {
     NamedType nt{ name };
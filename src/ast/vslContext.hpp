@@ -2,22 +2,34 @@
 #define VSLCONTEXT_HPP
 
 #include "ast/node.hpp"
+#include "ast/symbol.hpp"
 #include "ast/type.hpp"
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Allocator.h"
+#include <algorithm>
 #include <deque>
+#include <new>
+#include <type_traits>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 /**
  * Context object that owns and manages the AST and other objects related to it.
  * All {@link Node Nodes} and {@link Type Types} are unique so it's fine to
  * compare pointers to them for equality rather than the actual objects.
+ *
+ * Nodes and the arrays of child Nodes they refer to are bump-allocated from an
+ * arena, and are all freed at once when the VSLContext is destroyed.
  */
 class VSLContext
 {
 public:
     VSLContext();
+    VSLContext(const VSLContext&) = delete;
+    VSLContext& operator=(const VSLContext&) = delete;
+    ~VSLContext();
 
     /**
      * @name Node Getters
@@ -25,9 +37,33 @@ public:
      */
 
     /**
-     * Transfers ownership of a Node to this object.
+     * Creates a Node in the arena.
+     *
+     * @tparam NodeT The Node-derived type to instantiate.
+     * @tparam Args NodeT's constructor arguments.
+     *
+     * @param args NodeT's constructor arguments.
+     *
+     * @returns A pointer to a newly created NodeT, owned by this object.
+     */
+    template<typename NodeT, typename... Args>
+    NodeT* createNode(Args&&... args);
+    /**
+     * Copies an array of Node pointers into the arena, e.g.\ the statements of
+     * a block once they're all parsed.
+     *
+     * @param array The array to copy.
+     *
+     * @returns A copy of the array, owned by this object.
+     */
+    template<typename T>
+    llvm::ArrayRef<T*> copyArray(llvm::ArrayRef<T*> array);
+    /**
+     * Gets the amount of memory that the arena has allocated so far.
+     *
+     * @returns The size of the arena in bytes.
      */
-    void addNode(std::unique_ptr<Node> node);
+    size_t getArenaSize() const;
     /**
      * Indicate that a DeclNode is in the global scope. It's not recommended to
      * call this multiple times with the same pointer.
@@ -39,6 +75,30 @@ public:
      */
     llvm::ArrayRef<DeclNode*> getGlobals() const;
 
+    /**
+     * @}
+     * @name Symbol Getters
+     * @{
+     */
+
+    /**
+     * Interns an identifier. This isn't thread safe, so identifiers should
+     * only be interned while parsing.
+     *
+     * @param name The name of the identifier.
+     *
+     * @returns The Symbol for the given name, which is the same every time
+     * it's interned.
+     */
+    Symbol intern(llvm::StringRef name);
+    /**
+     * Gets the number of identifiers that have been interned so far, which is
+     * one more than the largest ID.
+     *
+     * @returns The number of Symbols.
+     */
+    size_t getNumSymbols() const;
+
     /**
      * @}
      * @name Type Getters
@@ -65,6 +125,15 @@ public:
      * @returns True if the type does exist, false otherwise.
      */
     bool hasNamedType(llvm::StringRef name) const;
+    /**
+     * Gets a named type without creating it. Unlike getNamedType, this doesn't
+     * modify the VSLContext, so it can be called from multiple threads.
+     *
+     * @param name Name of the type.
+     *
+     * @returns The named type, or null if nonexistent.
+     */
+    const NamedType* findNamedType(llvm::StringRef name) const;
     /**
      * Gets a named type or creates one it nonexistent.
      *
@@ -112,8 +181,24 @@ private:
      */
     static std::vector<const Type*> getParamTypes(
         const FuncInterfaceNode& node);
-    /** Owns all the Nodes. */
-    std::deque<std::unique_ptr<Node>> nodes;
+    /**
+     * Destroys a Node that isn't trivially destructible.
+     *
+     * @tparam NodeT The actual type of the Node.
+     *
+     * @param node Node to destroy.
+     */
+    template<typename NodeT>
+    static void destroyNode(Node* node);
+    /** Owns all the Nodes and the arrays they use. */
+    llvm::BumpPtrAllocator arena;
+    /**
+     * Nodes that have to be destroyed before the arena is freed, along with the
+     * function that does it.
+     */
+    std::vector<std::pair<Node*, void (*)(Node*)>> cleanups;
+    /** Maps every interned identifier to its ID. */
+    llvm::StringMap<unsigned> symbols;
     /** Contains all global declarations in order. */
     std::vector<DeclNode*> globals;
     /** Placeholder for any type errors. */
@@ -132,4 +217,38 @@ private:
     std::deque<ClassType> classTypes;
 };
 
+template<typename NodeT, typename... Args>
+NodeT* VSLContext::createNode(Args&&... args)
+{
+    static_assert(std::is_base_of<Node, NodeT>::value,
+        "VSLContext can only create Nodes");
+    void* mem = arena.Allocate(sizeof(NodeT), alignof(NodeT));
+    auto* node = new (mem) NodeT(std::forward<Args>(args)...);
+    // most Nodes only point to other things in the arena and can just be
+    //  forgotten about, but some (like LiteralNode's APInt) own heap memory
+    if (!std::is_trivially_destructible<NodeT>::value)
+    {
+        cleanups.emplace_back(node, &destroyNode<NodeT>);
+    }
+    return node;
+}
+
+template<typename T>
+llvm::ArrayRef<T*> VSLContext::copyArray(llvm::ArrayRef<T*> array)
+{
+    if (array.empty())
+    {
+        return {};
+    }
+    T** mem = arena.Allocate<T*>(array.size());
+    std::copy(array.begin(), array.end(), mem);
+    return { mem, array.size() };
+}
+
+template<typename NodeT>
+void VSLContext::destroyNode(Node* node)
+{
+    static_cast<NodeT*>(node)->~NodeT();
+}
+
 #endif // VSLCONTEXT_HPP
@@ -1,43 +1,321 @@
 #include "codegen/codegen.hpp"
+#include "codegen/objectCache.hpp"
+#include "codegen/refcountElision.hpp"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/Optional.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/Triple.h"
+#include "llvm/Analysis/TargetLibraryInfo.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/Constant.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalValue.h"
+#include "llvm/IR/Instruction.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/Support/Casting.h"
+#include "llvm/Support/Error.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Host.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Target/TargetOptions.h"
+#include "llvm/Transforms/IPO.h"
+#include "llvm/Transforms/IPO/AlwaysInliner.h"
+#include "llvm/Transforms/IPO/PassManagerBuilder.h"
 #include "llvm/Transforms/Scalar.h"
-#include "llvm/Transforms/Scalar/GVN.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/ValueMapper.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+/** Maps each global definition to the partition it belongs to. */
+using PartitionMap = llvm::DenseMap<const llvm::GlobalValue*, unsigned>;
+
+/**
+ * How many partitions a module is split into when caching object code. More
+ * partitions means less to recompile after an edit, but more objects to look
+ * up and link together.
+ */
+const unsigned cachePartitions = 64;
+
+/**
+ * Collects the partitions that a value is used from. Uses by constants, e.g.
+ * constant expressions or initializers, count as uses by whatever uses them.
+ *
+ * @param value The value to look at.
+ * @param partOf The partition of each global definition. Anything that's not
+ * in here goes to the first partition.
+ * @param parts Where to put the partitions.
+ */
+void collectUsers(const llvm::Value& value, const PartitionMap& partOf,
+    llvm::SmallVectorImpl<unsigned>& parts)
+{
+    for (const llvm::User* user : value.users())
+    {
+        if (auto* inst = llvm::dyn_cast<llvm::Instruction>(user))
+        {
+            parts.push_back(partOf.lookup(inst->getFunction()));
+        }
+        else if (auto* global = llvm::dyn_cast<llvm::GlobalValue>(user))
+        {
+            parts.push_back(partOf.lookup(global));
+        }
+        else if (llvm::isa<llvm::Constant>(user))
+        {
+            collectUsers(*user, partOf, parts);
+        }
+    }
+}
+
+/**
+ * Puts each global variable in the partition of the first function that uses
+ * it.
+ *
+ * @param module The module being split up.
+ * @param partOf The partition of each function definition. Global variables
+ * are added to this.
+ */
+void placeGlobals(const llvm::Module& module, PartitionMap& partOf)
+{
+    for (const llvm::GlobalVariable& var : module.globals())
+    {
+        llvm::SmallVector<unsigned, 4> users;
+        collectUsers(var, partOf, users);
+        if (!var.isDeclaration() && !users.empty())
+        {
+            partOf[&var] = users.front();
+        }
+    }
+}
+
+/**
+ * Divides the definitions in a module between a number of partitions.
+ * Functions are balanced by their number of instructions, which is a decent
+ * estimate of how long they take to compile, and global variables go with the
+ * first function that uses them.
+ *
+ * @param module The module to split up.
+ * @param parts The number of partitions.
+ *
+ * @returns The partition of each global definition.
+ */
+PartitionMap partitionModule(const llvm::Module& module, unsigned parts)
+{
+    std::vector<std::pair<size_t, const llvm::Function*>> funcs;
+    for (const llvm::Function& func : module)
+    {
+        if (func.isDeclaration())
+        {
+            continue;
+        }
+        size_t size = 0;
+        for (const llvm::BasicBlock& block : func)
+        {
+            size += block.size();
+        }
+        funcs.emplace_back(size, &func);
+    }
+    // biggest first, each to the partition with the least work so far
+    std::stable_sort(funcs.begin(), funcs.end(),
+        [](const std::pair<size_t, const llvm::Function*>& a,
+            const std::pair<size_t, const llvm::Function*>& b)
+        {
+            return a.first > b.first;
+        });
+    PartitionMap partOf;
+    std::vector<size_t> load(parts);
+    for (const auto& func : funcs)
+    {
+        auto least = std::min_element(load.begin(), load.end());
+        *least += func.first;
+        partOf[func.second] = static_cast<unsigned>(least - load.begin());
+    }
+    placeGlobals(module, partOf);
+    return partOf;
+}
+
+/**
+ * Divides the definitions in a module between a number of partitions, such
+ * that each function ends up in the same partition every time no matter what
+ * else is in the module. This is worse at balancing than partitionModule(),
+ * but an edit to one function only changes one partition.
+ *
+ * @param module The module to split up.
+ * @param parts The number of partitions.
+ *
+ * @returns The partition of each global definition.
+ */
+PartitionMap partitionByName(const llvm::Module& module, unsigned parts)
+{
+    PartitionMap partOf;
+    for (const llvm::Function& func : module)
+    {
+        if (!func.isDeclaration())
+        {
+            partOf[&func] = static_cast<unsigned>(
+                llvm::MD5Hash(func.getName()) % parts);
+        }
+    }
+    placeGlobals(module, partOf);
+    return partOf;
+}
+
+/**
+ * Removes the declarations that nothing in a module uses anymore, e.g. the
+ * ones that CloneModule() leaves behind for definitions that went to other
+ * partitions.
+ *
+ * @param module The module to clean up.
+ *
+ * @returns True if the module still defines anything, false otherwise.
+ */
+bool removeUnusedDecls(llvm::Module& module)
+{
+    bool hasDefs = false;
+    for (auto it = module.begin(); it != module.end();)
+    {
+        llvm::Function& func = *it++;
+        if (!func.isDeclaration())
+        {
+            hasDefs = true;
+        }
+        else if (func.use_empty())
+        {
+            func.eraseFromParent();
+        }
+    }
+    for (auto it = module.global_begin(); it != module.global_end();)
+    {
+        llvm::GlobalVariable& var = *it++;
+        if (!var.isDeclaration())
+        {
+            hasDefs = true;
+        }
+        else if (var.use_empty())
+        {
+            var.eraseFromParent();
+        }
+    }
+    return hasDefs;
+}
+
+/**
+ * Makes local symbols that are used across partitions visible to the other
+ * object files. They're renamed so they don't clash with any other module's
+ * symbols once everything gets linked together.
+ *
+ * @param module The module being split up.
+ * @param partOf The partition of each global definition.
+ */
+void externalizeLocals(llvm::Module& module, const PartitionMap& partOf)
+{
+    std::string suffix = ".split." +
+        llvm::utohexstr(llvm::MD5Hash(module.getModuleIdentifier()));
+    for (llvm::GlobalValue& value : module.global_values())
+    {
+        if (!value.hasLocalLinkage())
+        {
+            continue;
+        }
+        llvm::SmallVector<unsigned, 4> users;
+        collectUsers(value, partOf, users);
+        unsigned home = partOf.lookup(&value);
+        if (std::all_of(users.begin(), users.end(),
+                [home](unsigned part) { return part == home; }))
+        {
+            continue;
+        }
+        value.setName(value.getName() + suffix);
+        value.setLinkage(llvm::GlobalValue::ExternalLinkage);
+        value.setVisibility(llvm::GlobalValue::HiddenVisibility);
+    }
+}
+
+/**
+ * Compiles a serialized partition in its own LLVMContext, so that it can run
+ * alongside the other partitions.
+ *
+ * @param machine The machine to generate code for. Can't be shared.
+ * @param bitcode The partition to compile.
+ * @param output The stream to write the result to.
+ *
+ * @returns A description of what went wrong, or an empty string on success.
+ */
+std::string compilePartition(llvm::TargetMachine& machine,
+    llvm::MemoryBufferRef bitcode, llvm::raw_pwrite_stream& output)
+{
+    llvm::LLVMContext llvmCtx;
+    llvm::Expected<std::unique_ptr<llvm::Module>> part =
+        llvm::parseBitcodeFile(bitcode, llvmCtx);
+    if (!part)
+    {
+        return llvm::toString(part.takeError());
+    }
+    llvm::legacy::PassManager pm;
+    if (machine.addPassesToEmitFile(pm, output,
+            llvm::TargetMachine::CGFT_ObjectFile))
+    {
+        return "target machine cannot emit a file of type object";
+    }
+    pm.run(**part);
+    output.flush();
+    return {};
+}
+
+} // end anonymous namespace
 
 CodeGen::CodeGen(Diag& diag, llvm::Module& module)
-    : diag{ diag }, module{ module }, fpm{ &module }
+    : diag{ diag }, module{ module }, target{ nullptr },
+    codeGenLevel{ llvm::CodeGenOpt::Default }
 {
 }
 
-void CodeGen::configure()
+void CodeGen::configure(llvm::StringRef triple)
 {
-    // initialize target machines
-    llvm::InitializeAllTargetInfos();
-    llvm::InitializeAllTargets();
-    llvm::InitializeAllTargetMCs();
-    llvm::InitializeAllAsmParsers();
-    llvm::InitializeAllAsmPrinters();
+    // initialize the host's target machine, which is the only one that has to
+    //  be linked in
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+    llvm::InitializeNativeTargetAsmParser();
     // find out what target we're generating code for
-    std::string targetTriple{ llvm::sys::getDefaultTargetTriple() };
+    targetTriple = triple.empty() ? llvm::sys::getDefaultTargetTriple() :
+        llvm::Triple::normalize(triple);
     std::string error;
-    const llvm::Target* target = llvm::TargetRegistry::lookupTarget(
-        targetTriple, error);
+    target = llvm::TargetRegistry::lookupTarget(targetTriple, error);
+#ifdef VSL_CROSS_TARGETS
+    // registering every target takes a while, so only do it when the host's
+    //  isn't the one we need
+    if (!target)
+    {
+        llvm::InitializeAllTargetInfos();
+        llvm::InitializeAllTargets();
+        llvm::InitializeAllTargetMCs();
+        llvm::InitializeAllAsmParsers();
+        llvm::InitializeAllAsmPrinters();
+        error.clear();
+        target = llvm::TargetRegistry::lookupTarget(targetTriple, error);
+    }
+#endif // VSL_CROSS_TARGETS
     if (!target)
     {
         diag.print<Diag::CANT_FIND_TARGET>(std::move(error));
         return;
     }
     // get the target machine details
-    const char* cpu = "generic";
-    const char* features = "";
-    llvm::TargetOptions options;
-    llvm::Optional<llvm::Reloc::Model> rm;
-    machine = target->createTargetMachine(targetTriple, cpu, features,
-        options, rm);
+    machine = createMachine();
     // configure the module with this new info
     module.setDataLayout(machine->createDataLayout());
     module.setTargetTriple(targetTriple);
@@ -56,23 +334,223 @@ void CodeGen::compile(llvm::raw_pwrite_stream& output)
     output.flush();
 }
 
-void CodeGen::optimize()
+void CodeGen::compile(llvm::ArrayRef<llvm::raw_pwrite_stream*> outputs)
+{
+    if (outputs.size() == 1)
+    {
+        compile(*outputs.front());
+        return;
+    }
+    auto parts = static_cast<unsigned>(outputs.size());
+    PartitionMap partOf = partitionModule(module, parts);
+    externalizeLocals(module, partOf);
+    // all the partitions are cloned from the same LLVMContext, which can only
+    //  be used by one thread at a time, so each one is serialized first
+    std::vector<llvm::SmallVector<char, 0>> bitcode(parts);
+    for (unsigned i = 0; i < parts; ++i)
+    {
+        llvm::ValueToValueMapTy vmap;
+        std::unique_ptr<llvm::Module> part = llvm::CloneModule(&module, vmap,
+            [&partOf, i](const llvm::GlobalValue* value)
+            {
+                return partOf.lookup(value) == i;
+            });
+        llvm::raw_svector_ostream os{ bitcode[i] };
+        llvm::WriteBitcodeToFile(part.get(), os);
+    }
+    std::vector<std::unique_ptr<llvm::TargetMachine>> machines;
+    for (unsigned i = 0; i < parts; ++i)
+    {
+        machines.push_back(createMachine());
+    }
+    std::vector<std::string> errors(parts);
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < parts; ++i)
+    {
+        threads.emplace_back([&, i]
+            {
+                llvm::MemoryBufferRef buffer{
+                    llvm::StringRef{ bitcode[i].data(), bitcode[i].size() },
+                    module.getModuleIdentifier() };
+                errors[i] = compilePartition(*machines[i], buffer,
+                    *outputs[i]);
+            });
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    for (std::string& error : errors)
+    {
+        if (!error.empty())
+        {
+            diag.print<Diag::CANT_COMPILE_PARTITION>(std::move(error));
+        }
+    }
+}
+
+void CodeGen::compile(ObjectCache& cache, unsigned jobs,
+    std::vector<std::string>& objects)
 {
-    auto passes =
+    PartitionMap partOf = partitionByName(module, cachePartitions);
+    externalizeLocals(module, partOf);
+    // serialize each partition and see if it's been compiled before, where
+    //  the bitcode stands in for everything that the object code depends on
+    std::vector<size_t> misses;
+    std::vector<std::string> keys;
+    std::vector<llvm::SmallVector<char, 0>> bitcode;
+    for (unsigned i = 0; i < cachePartitions; ++i)
     {
-        llvm::createInstructionCombiningPass(),
-        llvm::createReassociatePass(),
-        llvm::createGVNPass(),
-        llvm::createCFGSimplificationPass()
-    };
-    for (const auto& pass : passes)
+        llvm::ValueToValueMapTy vmap;
+        std::unique_ptr<llvm::Module> part = llvm::CloneModule(&module, vmap,
+            [&partOf, i](const llvm::GlobalValue* value)
+            {
+                return partOf.lookup(value) == i;
+            });
+        // there has to be at least one object, even for an empty module
+        if (!removeUnusedDecls(*part) && i != 0)
+        {
+            continue;
+        }
+        llvm::SmallVector<char, 0> buffer;
+        llvm::raw_svector_ostream os{ buffer };
+        llvm::WriteBitcodeToFile(part.get(), os);
+        llvm::MD5 hash;
+        hash.update(llvm::StringRef{ buffer.data(), buffer.size() });
+        hash.update(static_cast<uint8_t>(codeGenLevel));
+        llvm::MD5::MD5Result result;
+        hash.final(result);
+        llvm::SmallString<32> key;
+        llvm::MD5::stringifyResult(result, key);
+        objects.push_back(cache.lookup(key));
+        if (objects.back().empty())
+        {
+            misses.push_back(objects.size() - 1);
+            keys.push_back(key.str().str());
+            bitcode.push_back(std::move(buffer));
+        }
+    }
+    // compile whatever's left, each thread taking the next partition until
+    //  they're all done
+    auto numThreads = static_cast<unsigned>(
+        std::min<size_t>(std::max(jobs, 1u), misses.size()));
+    std::vector<std::unique_ptr<llvm::TargetMachine>> machines;
+    for (unsigned i = 0; i < numThreads; ++i)
+    {
+        machines.push_back(createMachine());
+    }
+    std::vector<llvm::SmallVector<char, 0>> code(misses.size());
+    std::vector<std::string> errors(misses.size());
+    std::atomic<size_t> next{ 0 };
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < numThreads; ++i)
     {
-        fpm.add(pass);
+        threads.emplace_back([&, i]
+            {
+                for (size_t j = next++; j < misses.size(); j = next++)
+                {
+                    llvm::MemoryBufferRef buffer{
+                        llvm::StringRef{ bitcode[j].data(),
+                            bitcode[j].size() },
+                        module.getModuleIdentifier() };
+                    llvm::raw_svector_ostream os{ code[j] };
+                    errors[j] = compilePartition(*machines[i], buffer, os);
+                }
+            });
     }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    for (size_t j = 0; j < misses.size(); ++j)
+    {
+        if (!errors[j].empty())
+        {
+            diag.print<Diag::CANT_COMPILE_PARTITION>(std::move(errors[j]));
+            continue;
+        }
+        std::string& object = objects[misses[j]];
+        object = cache.store(keys[j],
+            llvm::StringRef{ code[j].data(), code[j].size() });
+        if (object.empty())
+        {
+            diag.print<Diag::CANT_WRITE_CACHE>();
+        }
+    }
+}
+
+void CodeGen::optimize(unsigned optLevel, unsigned sizeLevel)
+{
+    // set up the pipeline the same way clang does
+    llvm::PassManagerBuilder builder;
+    builder.OptLevel = optLevel;
+    builder.SizeLevel = sizeLevel;
+    if (optLevel > 1)
+    {
+        builder.Inliner = llvm::createFunctionInliningPass(optLevel,
+            sizeLevel, /*DisableInlineHotCallSite=*/false);
+    }
+    else
+    {
+        builder.Inliner = llvm::createAlwaysInlinerLegacyPass();
+    }
+    builder.DisableUnrollLoops = optLevel < 2;
+    builder.LoopVectorize = optLevel > 1 && sizeLevel == 0;
+    builder.SLPVectorize = optLevel > 1 && sizeLevel == 0;
+    if (optLevel > 2)
+    {
+        codeGenLevel = llvm::CodeGenOpt::Aggressive;
+        machine->setOptLevel(codeGenLevel);
+    }
+    machine->adjustPassManager(builder);
+    // the refcount increments and destructor calls that IREmitter generated
+    //  are easiest to recognize before anything else has touched them
+    builder.addExtension(llvm::PassManagerBuilder::EP_EarlyAsPossible,
+        [](const llvm::PassManagerBuilder&, llvm::legacy::PassManagerBase& pm)
+        {
+            pm.add(llvm::createPromoteMemoryToRegisterPass());
+            pm.add(createRefcountElisionPass());
+        });
+    // the vectorizers and unroller need target info to make good decisions
+    llvm::legacy::FunctionPassManager fpm{ &module };
+    fpm.add(llvm::createTargetTransformInfoWrapperPass(
+            machine->getTargetIRAnalysis()));
+    builder.populateFunctionPassManager(fpm);
+    llvm::legacy::PassManager mpm;
+    mpm.add(new llvm::TargetLibraryInfoWrapperPass{
+            llvm::Triple{ targetTriple } });
+    mpm.add(llvm::createTargetTransformInfoWrapperPass(
+            machine->getTargetIRAnalysis()));
+    builder.populateModulePassManager(mpm);
+    // function passes go first, then the rest of the pipeline
     fpm.doInitialization();
-    for (auto& function : module.functions())
+    for (llvm::Function& function : module)
     {
         fpm.run(function);
     }
     fpm.doFinalization();
+    mpm.run(module);
+}
+
+void CodeGen::promoteLocals()
+{
+    llvm::legacy::FunctionPassManager fpm{ &module };
+    fpm.add(llvm::createPromoteMemoryToRegisterPass());
+    fpm.doInitialization();
+    for (llvm::Function& function : module)
+    {
+        fpm.run(function);
+    }
+    fpm.doFinalization();
+}
+
+std::unique_ptr<llvm::TargetMachine> CodeGen::createMachine() const
+{
+    const char* cpu = "generic";
+    const char* features = "";
+    llvm::TargetOptions options;
+    llvm::Optional<llvm::Reloc::Model> rm;
+    return std::unique_ptr<llvm::TargetMachine>{ target->createTargetMachine(
+        targetTriple, cpu, features, options, rm, /*CM=*/llvm::None,
+        codeGenLevel) };
 }
@@ -1,10 +1,17 @@
 #ifndef CODEGEN_HPP
 #define CODEGEN_HPP
 
+#include "codegen/objectCache.hpp"
 #include "diag/diag.hpp"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/LegacyPassManager.h"
+#include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetMachine.h"
+#include <memory>
+#include <string>
+#include <vector>
 
 /**
  * Generates native object code from an llvm::Module.
@@ -20,9 +27,14 @@ public:
      */
     CodeGen(Diag& diag, llvm::Module& module);
     /**
-     * Configures the module with target data.
+     * Configures the module with target data. Only the host target is
+     * registered up front. Any other target has to be linked in by building
+     * with VSL_CROSS_TARGETS, and is registered the first time it's asked for.
+     *
+     * @param triple The target triple to generate code for, or empty for the
+     * host.
      */
-    void configure();
+    void configure(llvm::StringRef triple = {});
     /**
      * Compiles the module. Configure must be run before this.
      *
@@ -30,21 +42,67 @@ public:
      */
     void compile(llvm::raw_pwrite_stream& output);
     /**
-     * Runs a series of optimization passes on the module.
+     * Splits the module into one partition per output and compiles each of
+     * them to an object file on its own thread. Every output gets an object
+     * file, even if its partition ended up empty. Local symbols that are used
+     * across partitions have to be made visible to the other object files, so
+     * the module is modified along the way. Configure must be run before this.
+     *
+     * @param outputs The streams to write the results to.
      */
-    void optimize();
+    void compile(llvm::ArrayRef<llvm::raw_pwrite_stream*> outputs);
+    /**
+     * Splits the module into partitions that stay the same from one compile
+     * to the next, then compiles the ones that aren't in the cache yet on up
+     * to the given number of threads and adds them to it. Like the other
+     * overload, this modifies the module. Configure must be run before this.
+     *
+     * @param cache The cache to look up and save object code in.
+     * @param jobs The most threads to compile on.
+     * @param objects Where to put the paths of the object files that make up
+     * the module, which are all in the cache. There's always at least one.
+     */
+    void compile(ObjectCache& cache, unsigned jobs,
+        std::vector<std::string>& objects);
+    /**
+     * Runs the standard optimization pipeline for the given level on the
+     * module, e.g. inlining, SROA, LICM, loop unrolling and vectorization.
+     * Configure must be run before this.
+     *
+     * @param optLevel How hard to optimize, from 1 to 3 like -O1 to -O3.
+     * @param sizeLevel How much to favor code size, where 0 means not at all
+     * and 1 is like -Os.
+     */
+    void optimize(unsigned optLevel, unsigned sizeLevel = 0);
+    /**
+     * Promotes the variables that IREmitter put in memory to SSA registers,
+     * which is cheap enough to always do at -O0 and saves a load and store
+     * for every use. Configure must be run before this.
+     */
+    void promoteLocals();
 
 private:
+    /**
+     * Creates a new machine for the configured target. Each thread needs its
+     * own, since they aren't thread safe.
+     *
+     * @returns A new TargetMachine.
+     */
+    std::unique_ptr<llvm::TargetMachine> createMachine() const;
     /** Diagnostics manager. */
     Diag& diag;
     /** The module to compile. */
     llvm::Module& module;
     /** Handles all the module-level transformations, such as compilation. */
     llvm::legacy::PassManager pm;
-    /** Handles all the function-level transformations, such as optimization. */
-    llvm::legacy::FunctionPassManager fpm;
+    /** Target to generate code for. */
+    const llvm::Target* target;
+    /** Target triple of the module. */
+    std::string targetTriple;
+    /** How hard the target machines should optimize. */
+    llvm::CodeGenOpt::Level codeGenLevel;
     /** Machine to generate code for. */
-    llvm::TargetMachine* machine;
+    std::unique_ptr<llvm::TargetMachine> machine;
 };
 
 #endif // CODEGEN_HPP
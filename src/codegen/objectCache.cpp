@@ -0,0 +1,66 @@
+#include "codegen/objectCache.hpp"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+ObjectCache::ObjectCache(llvm::StringRef dir)
+    : dir{ dir }, hits{ 0 }, misses{ 0 }
+{
+    // if this fails, then so will every store, which reports it
+    llvm::sys::fs::create_directories(dir);
+}
+
+std::string ObjectCache::lookup(llvm::StringRef key)
+{
+    std::string path = getPath(key);
+    if (!llvm::sys::fs::exists(path))
+    {
+        ++misses;
+        return {};
+    }
+    ++hits;
+    return path;
+}
+
+std::string ObjectCache::store(llvm::StringRef key, llvm::StringRef object)
+{
+    llvm::SmallString<128> model{ dir };
+    llvm::sys::path::append(model, key + "-%%%%%%.tmp");
+    llvm::SmallString<128> tmpPath;
+    int fd;
+    if (llvm::sys::fs::createUniqueFile(model, fd, tmpPath))
+    {
+        return {};
+    }
+    llvm::raw_fd_ostream os{ fd, /*shouldClose=*/true };
+    os << object;
+    os.close();
+    // renaming is atomic, so other compiles either see the whole entry or
+    //  none of it
+    std::string path = getPath(key);
+    if (os.has_error() || llvm::sys::fs::rename(tmpPath, path))
+    {
+        os.clear_error();
+        llvm::sys::fs::remove(tmpPath);
+        return {};
+    }
+    return path;
+}
+
+size_t ObjectCache::getNumHits() const
+{
+    return hits;
+}
+
+size_t ObjectCache::getNumMisses() const
+{
+    return misses;
+}
+
+std::string ObjectCache::getPath(llvm::StringRef key) const
+{
+    llvm::SmallString<128> path{ dir };
+    llvm::sys::path::append(path, key + ".o");
+    return path.str().str();
+}
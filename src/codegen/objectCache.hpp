@@ -0,0 +1,77 @@
+#ifndef OBJECTCACHE_HPP
+#define OBJECTCACHE_HPP
+
+#include "llvm/ADT/StringRef.h"
+#include <cstddef>
+#include <string>
+
+/**
+ * On-disk cache of the object code that was generated for each partition of a
+ * module, so that code that hasn't changed since the last compile doesn't have
+ * to go through the backend again.
+ *
+ * Entries are object files named after a hash of everything that went into
+ * them, which means they never have to be invalidated and that a directory can
+ * be shared by any number of source files.
+ */
+class ObjectCache
+{
+public:
+    /**
+     * Creates an ObjectCache, creating its directory if it doesn't exist yet.
+     *
+     * @param dir The directory to keep entries in.
+     */
+    ObjectCache(llvm::StringRef dir);
+    /**
+     * Looks for an entry.
+     *
+     * @param key The hash of the entry.
+     *
+     * @returns The path of the entry's object file, or an empty string if
+     * there's no entry.
+     */
+    std::string lookup(llvm::StringRef key);
+    /**
+     * Saves an entry, replacing any existing one with the same key. The file
+     * is written under a temporary name first, so other compiles never see a
+     * partial entry.
+     *
+     * @param key The hash of the entry.
+     * @param object The object code to save.
+     *
+     * @returns The path of the entry's object file, or an empty string if it
+     * couldn't be written.
+     */
+    std::string store(llvm::StringRef key, llvm::StringRef object);
+    /**
+     * Gets the number of lookups that found an entry.
+     *
+     * @returns The number of hits.
+     */
+    size_t getNumHits() const;
+    /**
+     * Gets the number of lookups that didn't find an entry.
+     *
+     * @returns The number of misses.
+     */
+    size_t getNumMisses() const;
+
+private:
+    /**
+     * Gets the file an entry is stored in.
+     *
+     * @param key The hash of the entry.
+     *
+     * @returns The path of the entry.
+     */
+    std::string getPath(llvm::StringRef key) const;
+    /** The directory to keep entries in. */
+    std::string dir;
+    /** Number of lookups that found an entry. */
+    size_t hits;
+    /** Number of lookups that didn't find an entry. */
+    size_t misses;
+};
+
+#endif // OBJECTCACHE_HPP
@@ -0,0 +1,250 @@
+#include "codegen/refcountElision.hpp"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/InstrTypes.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Operator.h"
+#include "llvm/Support/Casting.h"
+#include "llvm/Transforms/Utils/Local.h"
+#include <algorithm>
+#include <iterator>
+
+namespace
+{
+
+/**
+ * Checks if an instruction increments an object's refcount.
+ *
+ * @param inst The instruction to check.
+ *
+ * @returns The object whose refcount is incremented, or null if this isn't an
+ * increment.
+ */
+llvm::Value* getRetainedObject(llvm::Instruction& inst)
+{
+    llvm::Value* rcPtr;
+    if (auto* store = llvm::dyn_cast<llvm::StoreInst>(&inst))
+    {
+        // looking for `store (add (load rc), 1), rc`
+        auto* add =
+            llvm::dyn_cast<llvm::BinaryOperator>(store->getValueOperand());
+        if (!add || add->getOpcode() != llvm::Instruction::Add)
+        {
+            return nullptr;
+        }
+        auto* one = llvm::dyn_cast<llvm::ConstantInt>(add->getOperand(1));
+        auto* load = llvm::dyn_cast<llvm::LoadInst>(add->getOperand(0));
+        if (!one || !one->isOne() || !load ||
+            load->getPointerOperand() != store->getPointerOperand())
+        {
+            return nullptr;
+        }
+        rcPtr = store->getPointerOperand();
+    }
+    else if (auto* rmw = llvm::dyn_cast<llvm::AtomicRMWInst>(&inst))
+    {
+        // looking for `atomicrmw add rc, 1`
+        auto* one = llvm::dyn_cast<llvm::ConstantInt>(rmw->getValOperand());
+        if (rmw->getOperation() != llvm::AtomicRMWInst::Add || !one ||
+            !one->isOne())
+        {
+            return nullptr;
+        }
+        rcPtr = rmw->getPointerOperand();
+    }
+    else if (auto* call = llvm::dyn_cast<llvm::CallInst>(&inst))
+    {
+        // looking for `call vsl_brc_retain(rc)`
+        llvm::Function* callee = call->getCalledFunction();
+        if (!callee || callee->getName() != "vsl_brc_retain" ||
+            call->getNumArgOperands() != 1)
+        {
+            return nullptr;
+        }
+        rcPtr = call->getArgOperand(0);
+    }
+    else
+    {
+        return nullptr;
+    }
+    // the refcount is the very first thing in an object
+    auto* gep = llvm::dyn_cast<llvm::GEPOperator>(rcPtr);
+    if (!gep || !gep->hasAllZeroIndices())
+    {
+        return nullptr;
+    }
+    return gep->getPointerOperand();
+}
+
+/**
+ * Removes an increment, along with anything that was only there to compute
+ * its operands.
+ *
+ * @param inst The increment to remove.
+ */
+void eraseRetain(llvm::Instruction& inst)
+{
+    // a plain increment's stored value leads back to the refcount pointer
+    //  through the load, so that gets deleted too
+    llvm::Value* operand;
+    if (auto* store = llvm::dyn_cast<llvm::StoreInst>(&inst))
+    {
+        operand = store->getValueOperand();
+    }
+    else if (auto* rmw = llvm::dyn_cast<llvm::AtomicRMWInst>(&inst))
+    {
+        operand = rmw->getPointerOperand();
+    }
+    else
+    {
+        operand = llvm::cast<llvm::CallInst>(inst).getArgOperand(0);
+    }
+    inst.eraseFromParent();
+    llvm::RecursivelyDeleteTriviallyDeadInstructions(operand);
+}
+
+/**
+ * Checks if an instruction calls an object's destructor.
+ *
+ * @param inst The instruction to check.
+ *
+ * @returns The object being destroyed, or null if this isn't a destructor
+ * call.
+ */
+llvm::Value* getReleasedObject(llvm::Instruction& inst)
+{
+    // class destructors are the only functions that take one argument and
+    //  have a name ending in `.dtor`, since vsl identifiers can't have dots
+    auto* call = llvm::dyn_cast<llvm::CallInst>(&inst);
+    if (!call || call->getNumArgOperands() != 1)
+    {
+        return nullptr;
+    }
+    llvm::Function* callee = call->getCalledFunction();
+    if (!callee || !callee->getName().endswith(".dtor"))
+    {
+        return nullptr;
+    }
+    return call->getArgOperand(0);
+}
+
+/**
+ * Checks if an instruction only writes to a local variable, which can't affect
+ * any refcounts.
+ *
+ * @param inst The instruction to check.
+ *
+ * @returns True if it only writes to the stack, false otherwise.
+ */
+bool writesToStack(llvm::Instruction& inst)
+{
+    auto* store = llvm::dyn_cast<llvm::StoreInst>(&inst);
+    return store && llvm::isa<llvm::AllocaInst>(
+        store->getPointerOperand()->stripPointerCasts());
+}
+
+/**
+ * Cancels out matching increments and destructor calls.
+ */
+class RefcountElision : public llvm::FunctionPass
+{
+public:
+    /** Identifies the pass. */
+    static char ID;
+    /**
+     * Creates a RefcountElision pass.
+     */
+    RefcountElision();
+    virtual bool runOnFunction(llvm::Function& func) override;
+    virtual void getAnalysisUsage(llvm::AnalysisUsage& au) const override;
+    virtual llvm::StringRef getPassName() const override;
+
+private:
+    /**
+     * Cancels out pairs in a single basic block.
+     *
+     * @param block The block to optimize.
+     *
+     * @returns True if anything changed, false otherwise.
+     */
+    bool runOnBlock(llvm::BasicBlock& block);
+};
+
+char RefcountElision::ID = 0;
+
+RefcountElision::RefcountElision()
+    : llvm::FunctionPass{ ID }
+{
+}
+
+bool RefcountElision::runOnFunction(llvm::Function& func)
+{
+    bool changed = false;
+    for (llvm::BasicBlock& block : func)
+    {
+        changed |= runOnBlock(block);
+    }
+    return changed;
+}
+
+void RefcountElision::getAnalysisUsage(llvm::AnalysisUsage& au) const
+{
+    au.setPreservesCFG();
+}
+
+llvm::StringRef RefcountElision::getPassName() const
+{
+    return "VSL Refcount Elision";
+}
+
+bool RefcountElision::runOnBlock(llvm::BasicBlock& block)
+{
+    bool changed = false;
+    // increments that haven't been matched with a destructor call yet
+    llvm::SmallVector<llvm::Instruction*, 8> retains;
+    for (auto it = block.begin(); it != block.end();)
+    {
+        llvm::Instruction& inst = *it++;
+        if (getRetainedObject(inst))
+        {
+            retains.push_back(&inst);
+            continue;
+        }
+        if (llvm::Value* obj = getReleasedObject(inst))
+        {
+            // match with the newest increment of the same object
+            auto match = std::find_if(retains.rbegin(), retains.rend(),
+                [obj](llvm::Instruction* retain)
+                {
+                    return getRetainedObject(*retain) == obj;
+                });
+            if (match != retains.rend())
+            {
+                llvm::Instruction* retain = *match;
+                retains.erase(std::next(match).base());
+                eraseRetain(*retain);
+                inst.eraseFromParent();
+                changed = true;
+                continue;
+            }
+        }
+        // anything else that writes to memory, like a call that destroys some
+        //  other object, could end up releasing the retained objects, which
+        //  then need their increments to stay alive
+        if (inst.mayWriteToMemory() && !writesToStack(inst))
+        {
+            retains.clear();
+        }
+    }
+    return changed;
+}
+
+} // end anonymous namespace
+
+llvm::FunctionPass* createRefcountElisionPass()
+{
+    return new RefcountElision;
+}
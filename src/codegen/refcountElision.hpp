@@ -0,0 +1,22 @@
+#ifndef REFCOUNTELISION_HPP
+#define REFCOUNTELISION_HPP
+
+#include "llvm/Pass.h"
+
+/**
+ * Creates a pass that cancels out matching refcount increments and destructor
+ * calls on the same object.
+ *
+ * An increment is whatever IREmitter generates when copying a value: a
+ * load/add/store sequence on the object's refcount, an atomicrmw add with
+ * --refcount=atomic, or a call to vsl_brc_retain with --refcount=biased. If
+ * the same object's destructor is called later in the same basic block, and
+ * nothing in between could have released any objects, then the refcount never
+ * drops to zero there and both of them can be removed. This works best after
+ * mem2reg, since loads of the same variable then turn into the same value.
+ *
+ * @returns A new RefcountElision pass.
+ */
+llvm::FunctionPass* createRefcountElisionPass();
+
+#endif // REFCOUNTELISION_HPP
@@ -1,10 +1,17 @@
 #include "diag/diag.hpp"
 
-Diag::Diag(llvm::raw_ostream& os)
-    : os { os }, errors{ 0 }, warnings{ 0 }
+Diag::Diag(llvm::raw_ostream& os, const SourceManager* srcMgr)
+    : os { os }, srcMgr{ srcMgr }, errors{ 0 }, warnings{ 0 }
 {
 }
 
+void Diag::merge(const Diag& other, llvm::StringRef text)
+{
+    os << text;
+    errors += other.errors;
+    warnings += other.warnings;
+}
+
 size_t Diag::getNumErrors() const
 {
     return errors;
@@ -15,6 +22,11 @@ size_t Diag::getNumWarnings() const
     return warnings;
 }
 
+const SourceManager* Diag::getSourceManager() const
+{
+    return srcMgr;
+}
+
 void detail::print(llvm::raw_ostream& os, DiagLevel level)
 {
     switch (level)
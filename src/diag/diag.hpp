@@ -4,6 +4,7 @@
 #include "ast/node.hpp"
 #include "ast/type.hpp"
 #include "lexer/location.hpp"
+#include "lexer/sourceManager.hpp"
 #include "lexer/token.hpp"
 #include "llvm/Support/raw_ostream.h"
 
@@ -27,8 +28,10 @@ public:
      * Creates a Diag object.
      *
      * @param os Stream to print to.
+     * @param srcMgr Used to turn Locations into line and column numbers. If
+     * null, locations are printed as `<unknown>`.
      */
-    Diag(llvm::raw_ostream& os);
+    Diag(llvm::raw_ostream& os, const SourceManager* srcMgr = nullptr);
     /**
      * Prints an error diagnostic. The parameter pack `args` changes based on
      * what you pass into `k`.
@@ -38,12 +41,23 @@ public:
      */
     template<Kind k, typename... Args>
     void print(Args&&... args);
+    /**
+     * Prints the diagnostics that another Diag has collected, e.g. one that was
+     * used on a separate thread, and adds them to the count.
+     *
+     * @param other The Diag that printed the diagnostics.
+     * @param text What the other Diag printed.
+     */
+    void merge(const Diag& other, llvm::StringRef text);
     size_t getNumErrors() const;
     size_t getNumWarnings() const;
+    const SourceManager* getSourceManager() const;
 
 private:
     /** Stream to print to. */
     llvm::raw_ostream& os;
+    /** Source code that Locations point into. */
+    const SourceManager* srcMgr;
     /** Amount of errors that have been printed. */
     size_t errors;
     /** Amount of warnings that have been printed. */
@@ -105,11 +119,13 @@ void print(llvm::raw_ostream& os, DiagLevel level);
  * Prints a diagnostic.
  *
  * @param os Stream to print to.
+ * @param srcMgr Source code that Locations point into.
  * @param level How severe the diagnostic is.
  * @param args Arguments to include in the diagnostic.
  */
 template<typename... Args>
-void diagnose(llvm::raw_ostream& os, DiagLevel level, Args&&... args)
+void diagnose(llvm::raw_ostream& os, const SourceManager* srcMgr,
+    DiagLevel level, Args&&... args)
 {
     print(os, level);
     print(os, std::forward<Args>(args)...);
@@ -119,16 +135,26 @@ void diagnose(llvm::raw_ostream& os, DiagLevel level, Args&&... args)
  * Prints a diagnostic with location info.
  *
  * @param os Stream to print to.
+ * @param srcMgr Source code that Locations point into.
  * @param level How severe the diagnostic is.
  * @param l Location info for where the diagnostic occurred.
  * @param args Arguments to include in the diagnostic.
  */
 template<typename... Args>
-void diagnose(llvm::raw_ostream& os, DiagLevel level, Location l,
-    Args&&... args)
+void diagnose(llvm::raw_ostream& os, const SourceManager* srcMgr,
+    DiagLevel level, Location l, Args&&... args)
 {
-    os.changeColor(llvm::raw_ostream::SAVEDCOLOR, true) << l << ": ";
-    diagnose(os, level, std::forward<Args>(args)...);
+    os.changeColor(llvm::raw_ostream::SAVEDCOLOR, true);
+    if (srcMgr)
+    {
+        srcMgr->print(os, l);
+    }
+    else
+    {
+        os << "<unknown>";
+    }
+    os << ": ";
+    diagnose(os, srcMgr, level, std::forward<Args>(args)...);
 }
 
 /**
@@ -149,10 +175,10 @@ struct DiagPrinter
 template<> \
 struct DiagPrinter<Diag::kind> \
 { \
-    static void print(llvm::raw_ostream& os, size_t& errors, size_t& warnings, \
-        EXPAND params) \
+    static void print(llvm::raw_ostream& os, const SourceManager* srcMgr, \
+        size_t& errors, size_t& warnings, EXPAND params) \
     { \
-        diagnose(os, DiagLevel::EXPAND values); \
+        diagnose(os, srcMgr, DiagLevel::EXPAND values); \
         PROCESS values; \
     } \
 };
@@ -174,7 +200,7 @@ struct DiagPrinter<Diag::kind> \
 template<Diag::Kind k, typename... Args>
 void Diag::print(Args&&... args)
 {
-    detail::DiagPrinter<k>::print(os, errors, warnings,
+    detail::DiagPrinter<k>::print(os, srcMgr, errors, warnings,
         std::forward<Args>(args)...);
     os << '\n';
 }
@@ -0,0 +1,115 @@
+#include "diag/timeReport.hpp"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Process.h"
+#include <sys/resource.h>
+
+TimeReport::Scope::Scope(TimeReport* report, llvm::StringRef phase)
+    : report{ report }
+{
+    if (report)
+    {
+        report->start(phase);
+    }
+}
+
+TimeReport::Scope::~Scope()
+{
+    if (report)
+    {
+        report->stop();
+    }
+}
+
+TimeReport::TimeReport()
+    : lastHeap{ 0 }, lastPeak{ 0 }
+{
+}
+
+void TimeReport::start(llvm::StringRef phase)
+{
+    llvm::TimeRecord now = llvm::TimeRecord::getCurrentTime(/*Start=*/true);
+    account(now);
+    auto inserted = phases.insert({ phase, Phase{ {}, 0, 0 } });
+    if (inserted.second)
+    {
+        order.push_back(inserted.first->getKey());
+    }
+    stack.push_back(&inserted.first->getValue());
+}
+
+void TimeReport::stop()
+{
+    llvm::TimeRecord now = llvm::TimeRecord::getCurrentTime(/*Start=*/false);
+    account(now);
+    stack.pop_back();
+}
+
+const TimeReport::Phase* TimeReport::getPhase(llvm::StringRef name) const
+{
+    auto it = phases.find(name);
+    return it != phases.end() ? &it->getValue() : nullptr;
+}
+
+void TimeReport::print(llvm::raw_ostream& os) const
+{
+    llvm::StringMap<llvm::TimeRecord> records;
+    for (const auto& phase : phases)
+    {
+        records[phase.getKey()] = phase.getValue().time;
+    }
+    llvm::TimerGroup group{ "vsl", "VSL Compile Time Report", records };
+    group.print(os);
+    os << "Peak resident memory: " << getPeakMemory() / 1024 << " KB\n";
+}
+
+void TimeReport::printJSON(llvm::raw_ostream& os) const
+{
+    os << "{\n  \"phases\": {";
+    const char* delim = "\n";
+    for (llvm::StringRef name : order)
+    {
+        const Phase& phase = phases.find(name)->getValue();
+        os << delim << "    \"" << name << "\": { \"wall\": " <<
+            llvm::format("%.6f", phase.time.getWallTime()) << ", \"user\": " <<
+            llvm::format("%.6f", phase.time.getUserTime()) << ", \"sys\": " <<
+            llvm::format("%.6f", phase.time.getSystemTime()) <<
+            ", \"heap\": " << phase.heapGrowth <<
+            ", \"peak\": " << phase.peakGrowth << " }";
+        delim = ",\n";
+    }
+    os << "\n  },\n  \"peak\": " << getPeakMemory() << "\n}\n";
+}
+
+void TimeReport::account(const llvm::TimeRecord& now)
+{
+    size_t heap = llvm::sys::Process::GetMallocUsage();
+    size_t peak = getPeakMemory();
+    if (!stack.empty())
+    {
+        llvm::TimeRecord elapsed = now;
+        elapsed -= last;
+        Phase& phase = *stack.back();
+        phase.time += elapsed;
+        phase.heapGrowth += static_cast<long long>(heap) -
+            static_cast<long long>(lastHeap);
+        phase.peakGrowth += peak > lastPeak ? peak - lastPeak : 0;
+    }
+    last = now;
+    lastHeap = heap;
+    lastPeak = peak;
+}
+
+size_t TimeReport::getPeakMemory()
+{
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage))
+    {
+        return 0;
+    }
+#ifdef __APPLE__
+    return static_cast<size_t>(usage.ru_maxrss);
+#else
+    // everyone else reports it in kilobytes
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+}
@@ -0,0 +1,124 @@
+#ifndef TIMEREPORT_HPP
+#define TIMEREPORT_HPP
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cstddef>
+#include <vector>
+
+/**
+ * Measures how much time and memory each phase of the compiler takes, for
+ * `--time-report` and `--stats-json`.
+ *
+ * Phases can be started while another one is running, e.g. the parser pulling
+ * tokens from the lexer. The running phase is paused until the new one stops,
+ * so the time of each phase only counts its own work and the phases add up to
+ * the total.
+ */
+class TimeReport
+{
+public:
+    /**
+     * Everything measured for a phase.
+     */
+    struct Phase
+    {
+        /** Wall, user and system time. */
+        llvm::TimeRecord time;
+        /** How much the heap grew, in bytes, which is negative if it shrank. */
+        long long heapGrowth;
+        /** How much the peak resident memory grew, in bytes. */
+        size_t peakGrowth;
+    };
+    /**
+     * Times a phase for as long as it's in scope.
+     */
+    class Scope
+    {
+    public:
+        /**
+         * Starts the phase.
+         *
+         * @param report The report to add to, or null to not time anything.
+         * @param phase The name of the phase.
+         */
+        Scope(TimeReport* report, llvm::StringRef phase);
+        /**
+         * Stops the phase.
+         */
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        /** The report to add to, or null. */
+        TimeReport* report;
+    };
+    /**
+     * Creates an empty TimeReport.
+     */
+    TimeReport();
+    /**
+     * Starts timing a phase, pausing the one that's running. A phase that's
+     * run more than once adds up.
+     *
+     * @param phase The name of the phase.
+     */
+    void start(llvm::StringRef phase);
+    /**
+     * Stops timing the current phase, resuming the one that it paused.
+     */
+    void stop();
+    /**
+     * Gets what was measured for a phase so far.
+     *
+     * @param name The name of the phase.
+     *
+     * @returns The phase, or null if it never started.
+     */
+    const Phase* getPhase(llvm::StringRef name) const;
+    /**
+     * Prints a table of each phase's times, like `-ftime-report` in clang.
+     *
+     * @param os The stream to print to.
+     */
+    void print(llvm::raw_ostream& os) const;
+    /**
+     * Prints each phase's times and memory usage as a JSON object, in the
+     * order the phases first started.
+     *
+     * @param os The stream to print to.
+     */
+    void printJSON(llvm::raw_ostream& os) const;
+
+private:
+    /**
+     * Adds the time and memory since the last start or stop to the current
+     * phase, if there is one.
+     *
+     * @param now The current time.
+     */
+    void account(const llvm::TimeRecord& now);
+    /**
+     * Gets the most memory that this process has had resident so far.
+     *
+     * @returns The peak resident memory, in bytes.
+     */
+    static size_t getPeakMemory();
+    /** Every phase that's been started, by name. */
+    llvm::StringMap<Phase> phases;
+    /** The names of the phases, in the order they first started. */
+    std::vector<llvm::StringRef> order;
+    /** The phases that are running or paused, innermost last. */
+    std::vector<Phase*> stack;
+    /** When the last phase started or stopped. */
+    llvm::TimeRecord last;
+    /** The size of the heap when the last phase started or stopped. */
+    size_t lastHeap;
+    /** The peak resident memory when the last phase started or stopped. */
+    size_t lastPeak;
+};
+
+#endif // TIMEREPORT_HPP
@@ -0,0 +1,147 @@
+#include "driver/compileServer.hpp"
+#include "ast/vslContext.hpp"
+#include "codegen/codegen.hpp"
+#include "driver/driver.hpp"
+#include "driver/serverProtocol.hpp"
+#include "irgen/irgen.hpp"
+#include "lexer/vslLexer.hpp"
+#include "parser/vslParser.hpp"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+CompileServer::CompileServer(Diag& diag, const char* socketPath)
+    : diag{ diag }, socketPath{ socketPath }
+{
+}
+
+int CompileServer::run()
+{
+    int sock = listen();
+    if (sock == -1)
+    {
+        return 1;
+    }
+    warmUp();
+    // each fork answers its own client, so nothing has to wait for them
+    signal(SIGCHLD, SIG_IGN);
+    while (true)
+    {
+        int conn = accept(sock, nullptr, nullptr);
+        if (conn == -1)
+        {
+            // the client might have given up already, which is fine
+            continue;
+        }
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            close(sock);
+            // linking waits on ld, which doesn't work if children are reaped
+            //  automatically
+            signal(SIGCHLD, SIG_DFL);
+            _exit(serve(conn));
+        }
+        // if the fork failed, closing the connection tells the client
+        close(conn);
+    }
+}
+
+int CompileServer::listen()
+{
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof addr);
+    addr.sun_family = AF_UNIX;
+    if (strlen(socketPath) >= sizeof addr.sun_path)
+    {
+        diag.print<Diag::CANT_START_SERVER>(socketPath,
+            "path is too long for a socket");
+        return -1;
+    }
+    strcpy(addr.sun_path, socketPath);
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock == -1)
+    {
+        diag.print<Diag::CANT_START_SERVER>(socketPath, strerror(errno));
+        return -1;
+    }
+    unlink(socketPath);
+    if (bind(sock, reinterpret_cast<sockaddr*>(&addr), sizeof addr) == -1 ||
+        ::listen(sock, SOMAXCONN) == -1)
+    {
+        diag.print<Diag::CANT_START_SERVER>(socketPath, strerror(errno));
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+void CompileServer::warmUp()
+{
+    static const char* const src =
+        "public class Box { public var v: Int; "
+        "public init(v: Int) { self.v = v; } }\n"
+        "public func f(x: Int) -> Int { let b = Box(v: x); "
+        "if (x > 1) { return f(x: x - 1) + b.v; } return b.v; }\n";
+    Diag nullDiag{ llvm::nulls() };
+    VSLContext vslCtx;
+    VSLLexer lexer{ nullDiag, src };
+    VSLParser parser{ vslCtx, lexer };
+    parser.parse();
+    llvm::LLVMContext llvmContext;
+    auto module = std::make_unique<llvm::Module>("warmup", llvmContext);
+    CodeGen codeGen{ nullDiag, *module };
+    codeGen.configure();
+    IRGen irgen{ vslCtx, nullDiag, *module };
+    irgen.run();
+    codeGen.optimize(2);
+    llvm::SmallVector<char, 0> object;
+    llvm::raw_svector_ostream os{ object };
+    codeGen.compile(os);
+}
+
+int CompileServer::serve(int conn)
+{
+    std::vector<std::string> args;
+    int fds[numRequestFds];
+    if (!receiveRequest(conn, args, fds))
+    {
+        return 1;
+    }
+    // take on the client's working directory and standard streams
+    int status = 1;
+    if (fchdir(fds[0]) == 0 && dup2(fds[1], STDIN_FILENO) != -1 &&
+        dup2(fds[2], STDOUT_FILENO) != -1 &&
+        dup2(fds[3], STDERR_FILENO) != -1)
+    {
+        for (int fd : fds)
+        {
+            close(fd);
+        }
+        std::vector<const char*> argv;
+        for (const std::string& arg : args)
+        {
+            argv.push_back(arg.c_str());
+        }
+        argv.push_back(nullptr);
+        Driver driver;
+        status = driver.main(static_cast<int>(args.size()), argv.data());
+        // the process ends with _exit, which doesn't flush anything
+        llvm::outs().flush();
+        llvm::errs().flush();
+        std::cout.flush();
+    }
+    sendStatus(conn, status);
+    return status;
+}
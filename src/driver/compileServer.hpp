@@ -0,0 +1,63 @@
+#ifndef COMPILESERVER_HPP
+#define COMPILESERVER_HPP
+
+#include "diag/diag.hpp"
+
+/**
+ * Keeps a compiler running in the background and serves compile requests from
+ * vsl-client over a Unix socket, so that builds with lots of small files don't
+ * pay for starting up and initializing LLVM every time.
+ *
+ * Everything that only has to happen once per process, like registering the
+ * targets and setting up the pass pipelines, is done before the first request
+ * comes in. Each request is then handled by a fork of the server, which
+ * starts out with all of that done already. This also lets requests run
+ * alongside each other and keeps one bad compile from bringing down the
+ * server.
+ */
+class CompileServer
+{
+public:
+    /**
+     * Creates a CompileServer.
+     *
+     * @param diag Diagnostics manager.
+     * @param socketPath Where to create the socket.
+     */
+    CompileServer(Diag& diag, const char* socketPath);
+    /**
+     * Serves requests until the process is killed.
+     *
+     * @returns 1 if the server couldn't start. Otherwise, this doesn't return.
+     */
+    int run();
+
+private:
+    /**
+     * Creates the socket and starts listening on it. Any stale socket that was
+     * left at the same path is replaced.
+     *
+     * @returns The socket, or -1 on failure.
+     */
+    int listen();
+    /**
+     * Compiles a small program through the whole pipeline, which initializes
+     * everything that LLVM sets up lazily.
+     */
+    void warmUp();
+    /**
+     * Handles a request in a forked process, as if it came from the command
+     * line of a vsl process that the client started.
+     *
+     * @param conn The connection to the client.
+     *
+     * @returns The exit status.
+     */
+    int serve(int conn);
+    /** Diagnostics manager. */
+    Diag& diag;
+    /** Where to create the socket. */
+    const char* socketPath;
+};
+
+#endif // COMPILESERVER_HPP
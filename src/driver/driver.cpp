@@ -2,14 +2,27 @@
 #include "ast/nodePrinter.hpp"
 #include "ast/vslContext.hpp"
 #include "codegen/codegen.hpp"
+#include "codegen/objectCache.hpp"
 #include "diag/diag.hpp"
+#include "diag/timeReport.hpp"
+#include "driver/compileServer.hpp"
+#include "interp/interpreter.hpp"
 #include "irgen/irgen.hpp"
+#include "jit/jit.hpp"
+#include "lexer/sourceManager.hpp"
 #include "lexer/vslLexer.hpp"
 #include "parser/vslParser.hpp"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/Triple.h"
+#include "llvm/IR/Function.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
+#include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/FileSystem.h"
-#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Program.h"
+#include <cstdint>
 #include <cstring>
 #include <iostream>
 #include <memory>
@@ -27,22 +40,28 @@ int Driver::main(int argc, const char* const* argv)
     case OptionParser::REPL_LEX:
         return repl([](const std::string& in, llvm::raw_ostream& os)
             {
-                Diag diag{ os };
-                VSLLexer lexer{ diag, in.c_str() };
+                SourceManager srcMgr;
+                srcMgr.setBuffer(in, "<stdin>");
+                Diag diag{ os, &srcMgr };
+                VSLLexer lexer{ diag, srcMgr.getBuffer() };
                 Token token;
                 do
                 {
                     token = lexer.nextToken();
-                    os << token << '\n';
+                    os << token << " at ";
+                    srcMgr.print(os, token.getLoc());
+                    os << '\n';
                 }
                 while (token.isNot(TokenKind::END));
             });
     case OptionParser::REPL_PARSE:
         return repl([](const std::string& in, llvm::raw_ostream& os)
             {
+                SourceManager srcMgr;
+                srcMgr.setBuffer(in, "<stdin>");
                 VSLContext vslCtx;
-                Diag diag{ os };
-                VSLLexer lexer{ diag, in.c_str() };
+                Diag diag{ os, &srcMgr };
+                VSLLexer lexer{ diag, srcMgr.getBuffer() };
                 VSLParser parser{ vslCtx, lexer };
                 parser.parse();
                 os << '\n';
@@ -52,29 +71,38 @@ int Driver::main(int argc, const char* const* argv)
     case OptionParser::REPL_GENERATE:
         return repl([&](const std::string& in, llvm::raw_ostream& os)
             {
+                SourceManager srcMgr;
+                srcMgr.setBuffer(in, "<stdin>");
                 VSLContext vslCtx;
-                Diag diag{ os };
-                // lex and parse the file
-                VSLLexer lexer{ diag, in.c_str() };
-                VSLParser parser{ vslCtx, lexer };
-                parser.parse();
-                // generate LLVM IR for the ast stored in vslCtx
+                Diag diag{ os, &srcMgr };
+                // configure the module
                 llvm::LLVMContext llvmContext;
                 auto module = std::make_unique<llvm::Module>("repl",
                     llvmContext);
-                // configure the module
                 CodeGen codeGen{ diag, *module };
-                codeGen.configure();
-                // generate llvm ir
-                IRGen irgen{ vslCtx, diag, *module };
+                codeGen.configure(op.targetTriple);
+                if (diag.getNumErrors())
+                {
+                    return;
+                }
+                // lex and parse the file
+                VSLLexer lexer{ diag, srcMgr.getBuffer() };
+                VSLParser parser{ vslCtx, lexer };
+                parser.parse();
+                // generate llvm ir for the ast stored in vslCtx
+                IRGen irgen{ vslCtx, diag, *module, op.irgenOptions };
                 irgen.run();
                 // possibly optimize the ir
-                if (op.optimize)
+                if (op.optLevel)
                 {
-                    codeGen.optimize();
+                    codeGen.optimize(op.optLevel, op.sizeLevel);
                 }
                 os << *module << '\n';
             });
+    case OptionParser::SERVE:
+        return serve();
+    case OptionParser::RUN:
+        return run();
     }
     return 0;
 }
@@ -83,10 +111,47 @@ int Driver::displayHelp()
 {
     llvm::outs() <<
         "Usage: vsl [options] [file]\n"
+        "       vsl run [options] [file]\n"
+        "Commands:\n"
+        "  run       JIT compile the file and run its main function instead\n"
+        "            of emitting an object file. Without a file, start a\n"
+        "            REPL that runs each line as it's entered.\n"
         "Options:\n"
         "  -h --help Display this information.\n"
         "  -o <file> Specify the output of compilation.\n"
-        "  -O<level> Set optimization level (0 or 1).\n"
+        "  -O<level> Set optimization level (0 to 3, or s for size).\n"
+        "  -j <jobs> Generate code on multiple threads.\n"
+        "  --split-objects\n"
+        "            Emit an object file for each job instead of linking\n"
+        "            them together.\n"
+        "  --alloc=<malloc|pool>\n"
+        "            Choose how objects are allocated. The pool allocator\n"
+        "            needs the program to be linked with libvslrt.\n"
+        "  --refcount=<nonatomic|atomic|biased>\n"
+        "            Choose how reference counts are updated. Objects can\n"
+        "            only be shared between threads with atomic or biased,\n"
+        "            and biased needs the program to be linked with libvslrt.\n"
+        "  --cache-dir=<dir>\n"
+        "            Reuse the object code of functions that haven't changed\n"
+        "            since an earlier compile that used the same directory.\n"
+        "  --target=<triple>\n"
+        "            Generate code for another target, e.g. for cross\n"
+        "            compiling. Only the host is supported unless vsl was\n"
+        "            built with VSL_CROSS_TARGETS. Since ld can't link\n"
+        "            other targets' objects, they can't be used with\n"
+        "            --cache-dir, or with -j without --split-objects.\n"
+        "  --jit-threshold=<calls>\n"
+        "            With run, interpret each function until it's been called\n"
+        "            this many times, then JIT compile it. 0 compiles the\n"
+        "            whole file up front. The default is 1000.\n"
+        "  --time-report\n"
+        "            Print how much time each phase of the compiler took.\n"
+        "  --stats-json=<file>\n"
+        "            Write the time and memory that each phase of the\n"
+        "            compiler took to a JSON file.\n"
+        "  --serve=<socket>\n"
+        "            Keep running and compile whatever vsl-client sends to\n"
+        "            the socket, with the same options as the command line.\n"
         "REPL Options:\n"
         "  -l        Start the lexer REPL.\n"
         "  -p        Start the parser REPL.\n"
@@ -94,52 +159,72 @@ int Driver::displayHelp()
     return 0;
 }
 
+int Driver::serve()
+{
+    Diag diag{ llvm::errs() };
+    CompileServer server{ diag, op.socketPath };
+    return server.run();
+}
+
 int Driver::compile()
 {
     // open the input file
-    Diag diag{ llvm::errs() };
+    SourceManager srcMgr;
+    Diag diag{ llvm::errs(), &srcMgr };
     if (!op.infile)
     {
         diag.print<Diag::NO_INPUT>();
         return 1;
     }
-    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> in =
-        llvm::MemoryBuffer::getFileOrSTDIN(op.infile);
-    if (std::error_code ec = in.getError())
+    // objects from each job or from the cache are combined into the output
+    //  by the host's ld, which doesn't understand other targets' objects
+    if ((op.cacheDir || (op.jobs > 1 && !op.splitObjects)) &&
+        !isHostTarget(op.targetTriple))
+    {
+        diag.print<Diag::CANT_LINK_TARGET>(op.targetTriple);
+        return 1;
+    }
+    if (std::error_code ec = srcMgr.open(op.infile))
     {
         diag.print<Diag::CANT_OPEN_FILE>(op.infile, ec.message());
         return 1;
     }
-    // lex/parse
-    VSLContext vslCtx;
-    VSLLexer lexer{ diag, in.get()->getBuffer().data() };
-    VSLParser parser{ vslCtx, lexer };
-    parser.parse();
+    if (op.timeReport || op.statsJson)
+    {
+        timeReport = std::make_unique<TimeReport>();
+    }
     // configure llvm module
     llvm::LLVMContext llvmContext;
     auto module = std::make_unique<llvm::Module>(op.infile, llvmContext);
+    VSLContext vslCtx;
     CodeGen codeGen{ diag, *module };
-    codeGen.configure();
-    // emit llvm ir
-    IRGen irgen{ vslCtx, diag, *module };
-    irgen.run();
-    // recap the amount of errors/warnings that occurred
-    if (diag.getNumErrors() > 1)
+    bool generated = generate(diag, srcMgr.getBuffer(), vslCtx, codeGen,
+        *module, op.targetTriple);
+    recap(diag);
+    if (!generated)
     {
-        llvm::errs() << diag.getNumErrors() << " errors generated\n";
+        return 1;
     }
-    if (diag.getNumWarnings() > 1)
+    optimize(codeGen);
+    int status = emit(codeGen, diag);
+    if (timeReport && !reportTime(diag))
     {
-        llvm::errs() << diag.getNumWarnings() << " warnings generated\n";
+        return 1;
     }
-    if (diag.getNumErrors())
+    return status;
+}
+
+int Driver::emit(CodeGen& codeGen, Diag& diag)
+{
+    TimeReport::Scope scope{ timeReport.get(), "compile" };
+    // emit object code, possibly split across multiple threads
+    if (op.cacheDir)
     {
-        return 1;
+        return compileCached(codeGen, diag);
     }
-    // optimize ir
-    if (op.optimize)
+    if (op.jobs > 1)
     {
-        codeGen.optimize();
+        return compileParallel(codeGen, diag);
     }
     // open output file
     std::error_code ec;
@@ -154,6 +239,311 @@ int Driver::compile()
     return diag.getNumErrors() ? 1 : 0;
 }
 
+bool Driver::reportTime(Diag& diag)
+{
+    if (op.timeReport)
+    {
+        timeReport->print(llvm::errs());
+    }
+    if (op.statsJson)
+    {
+        std::error_code ec;
+        llvm::raw_fd_ostream out{ op.statsJson, ec, llvm::sys::fs::F_Text };
+        if (ec)
+        {
+            diag.print<Diag::CANT_OPEN_FILE>(op.statsJson, ec.message());
+            return false;
+        }
+        timeReport->printJSON(out);
+    }
+    return true;
+}
+
+bool Driver::generate(Diag& diag, llvm::StringRef src, VSLContext& vslCtx,
+    CodeGen& codeGen, llvm::Module& module, llvm::StringRef triple)
+{
+    codeGen.configure(triple);
+    if (diag.getNumErrors())
+    {
+        return false;
+    }
+    // lex/parse
+    VSLLexer lexer{ diag, src };
+    VSLParser parser{ vslCtx, lexer, timeReport.get() };
+    {
+        TimeReport::Scope scope{ timeReport.get(), "parser" };
+        parser.parse();
+    }
+    // emit llvm ir
+    IRGen irgen{ vslCtx, diag, module, op.irgenOptions };
+    irgen.run(op.jobs, timeReport.get());
+    return !diag.getNumErrors();
+}
+
+void Driver::recap(const Diag& diag)
+{
+    if (diag.getNumErrors() > 1)
+    {
+        llvm::errs() << diag.getNumErrors() << " errors generated\n";
+    }
+    if (diag.getNumWarnings() > 1)
+    {
+        llvm::errs() << diag.getNumWarnings() << " warnings generated\n";
+    }
+}
+
+void Driver::optimize(CodeGen& codeGen)
+{
+    TimeReport::Scope scope{ timeReport.get(), "optimize" };
+    if (op.optLevel)
+    {
+        codeGen.optimize(op.optLevel, op.sizeLevel);
+    }
+    else
+    {
+        codeGen.promoteLocals();
+    }
+}
+
+int Driver::run()
+{
+    if (!op.infile)
+    {
+        return runRepl();
+    }
+    SourceManager srcMgr;
+    Diag diag{ llvm::errs(), &srcMgr };
+    if (std::error_code ec = srcMgr.open(op.infile))
+    {
+        diag.print<Diag::CANT_OPEN_FILE>(op.infile, ec.message());
+        return 1;
+    }
+    // the jit has to outlive the module, which it takes ownership of
+    JIT jit{ diag };
+    auto module = std::make_unique<llvm::Module>(op.infile, jit.getContext());
+    VSLContext vslCtx;
+    CodeGen codeGen{ diag, *module };
+    bool generated = generate(diag, srcMgr.getBuffer(), vslCtx, codeGen,
+        *module, /*triple=*/{});
+    recap(diag);
+    if (!generated)
+    {
+        return 1;
+    }
+    llvm::Function* main = module->getFunction("main");
+    llvm::Type* returnType = main ? main->getReturnType() : nullptr;
+    if (!main || main->isDeclaration() || !main->arg_empty() ||
+        !(returnType->isIntegerTy(32) || returnType->isVoidTy()))
+    {
+        diag.print<Diag::NO_MAIN>();
+        return 1;
+    }
+    // main can be private, but the jit still has to be able to find it
+    main->setLinkage(llvm::GlobalValue::ExternalLinkage);
+    // the module is only optimized if something actually gets compiled
+    Interpreter interpreter{ diag, jit, std::move(module),
+        [&] { optimize(codeGen); }, op.jitThreshold };
+    int32_t status;
+    if (!interpreter.init(vslCtx.getGlobals()) ||
+        !interpreter.call("main", {}, status))
+    {
+        return 1;
+    }
+    return status;
+}
+
+int Driver::runRepl()
+{
+    Diag diag{ llvm::errs() };
+    JIT jit{ diag };
+    // every line is compiled along with the declarations before it, which
+    //  the jit links to what it already has instead of compiling them again
+    std::string decls;
+    unsigned numLines = 0;
+    return repl([&](const std::string& in, llvm::raw_ostream& os)
+        {
+            llvm::StringRef line = llvm::StringRef{ in }.trim();
+            if (line.empty())
+            {
+                return;
+            }
+            // a line that starts with an access specifier declares something
+            SourceManager srcMgr;
+            srcMgr.setBuffer(line, "<stdin>");
+            Diag lexerDiag{ llvm::nulls(), &srcMgr };
+            VSLLexer lexer{ lexerDiag, srcMgr.getBuffer() };
+            if (keywordToAccess(lexer.nextToken().getKind()) != Access::NONE)
+            {
+                if (addReplInput(jit, decls + in + '\n', os))
+                {
+                    decls += in;
+                    decls += '\n';
+                }
+                return;
+            }
+            // anything else is an expression or statement, which gets wrapped
+            //  in a function that's called right away
+            line = line.rtrim(';');
+            std::string name = "replLine" + std::to_string(numLines++);
+            std::string head = decls + "private func " + name + "() -> ";
+            std::string expr = line.str();
+            if (addReplInput(jit, head + "Int { return " + expr + "; }\n",
+                    llvm::nulls()))
+            {
+                if (void* address = jit.getAddress(name))
+                {
+                    os << reinterpret_cast<int32_t (*)()>(address)() << '\n';
+                }
+            }
+            else if (addReplInput(jit, head + "Bool { return " + expr + "; }\n",
+                    llvm::nulls()))
+            {
+                if (void* address = jit.getAddress(name))
+                {
+                    // only the lowest bit of an i1 is defined
+                    bool value =
+                        reinterpret_cast<uint8_t (*)()>(address)() & 1;
+                    os << (value ? "true" : "false") << '\n';
+                }
+            }
+            // the errors for this one are shown, since it'll take anything
+            //  that's valid at all
+            else if (addReplInput(jit, head + "Void { " + expr + "; }\n", os))
+            {
+                if (void* address = jit.getAddress(name))
+                {
+                    reinterpret_cast<void (*)()>(address)();
+                }
+            }
+        });
+}
+
+bool Driver::addReplInput(JIT& jit, const std::string& input,
+    llvm::raw_ostream& os)
+{
+    SourceManager srcMgr;
+    srcMgr.setBuffer(input, "<stdin>");
+    Diag diag{ os, &srcMgr };
+    auto module = std::make_unique<llvm::Module>("repl", jit.getContext());
+    VSLContext vslCtx;
+    CodeGen codeGen{ diag, *module };
+    if (!generate(diag, srcMgr.getBuffer(), vslCtx, codeGen, *module,
+            /*triple=*/{}))
+    {
+        return false;
+    }
+    jit.linkExisting(*module);
+    optimize(codeGen);
+    return jit.addModule(std::move(module));
+}
+
+int Driver::compileParallel(CodeGen& codeGen, Diag& diag)
+{
+    // open an object file for each partition, which are either named after
+    //  the output file (e.g. a.out becomes a.0.out, a.1.out, ...) or are
+    //  temporary files that get linked into it
+    std::vector<std::string> objects;
+    std::vector<std::unique_ptr<llvm::raw_fd_ostream>> files;
+    std::vector<llvm::raw_pwrite_stream*> outputs;
+    for (unsigned i = 0; i < op.jobs; ++i)
+    {
+        llvm::SmallString<128> name;
+        std::error_code ec;
+        if (op.splitObjects)
+        {
+            name = op.outfile;
+            llvm::sys::path::replace_extension(name, "." + std::to_string(i) +
+                llvm::sys::path::extension(op.outfile));
+            files.push_back(std::make_unique<llvm::raw_fd_ostream>(name, ec,
+                    llvm::sys::fs::F_None));
+        }
+        else
+        {
+            int fd;
+            ec = llvm::sys::fs::createTemporaryFile("vsl", "o", fd, name);
+            if (!ec)
+            {
+                files.push_back(std::make_unique<llvm::raw_fd_ostream>(fd,
+                        /*shouldClose=*/true));
+            }
+        }
+        if (ec)
+        {
+            diag.print<Diag::CANT_OPEN_FILE>(name.c_str(), ec.message());
+            break;
+        }
+        objects.push_back(name.str().str());
+        outputs.push_back(files.back().get());
+    }
+    if (outputs.size() == op.jobs)
+    {
+        codeGen.compile(outputs);
+    }
+    // close the files so that everything is written out before linking
+    files.clear();
+    if (op.splitObjects)
+    {
+        return diag.getNumErrors() ? 1 : 0;
+    }
+    int status = diag.getNumErrors() ? 1 : linkObjects(diag, objects);
+    for (const std::string& object : objects)
+    {
+        llvm::sys::fs::remove(object);
+    }
+    return status;
+}
+
+int Driver::compileCached(CodeGen& codeGen, Diag& diag)
+{
+    ObjectCache cache{ op.cacheDir };
+    std::vector<std::string> objects;
+    codeGen.compile(cache, op.jobs, objects);
+    // the objects stay in the cache for next time
+    return diag.getNumErrors() ? 1 : linkObjects(diag, objects);
+}
+
+bool Driver::isHostTarget(llvm::StringRef triple)
+{
+    if (triple.empty())
+    {
+        return true;
+    }
+    // ld only cares about the architecture and the object file format
+    llvm::Triple target{ llvm::Triple::normalize(triple) };
+    llvm::Triple host{ llvm::sys::getDefaultTargetTriple() };
+    return target.getArch() == host.getArch() &&
+        target.getObjectFormat() == host.getObjectFormat();
+}
+
+int Driver::linkObjects(Diag& diag, const std::vector<std::string>& objects)
+{
+    TimeReport::Scope scope{ timeReport.get(), "link" };
+    llvm::ErrorOr<std::string> ld = llvm::sys::findProgramByName("ld");
+    if (!ld)
+    {
+        diag.print<Diag::CANT_LINK_OBJECTS>("could not find ld: " +
+            ld.getError().message());
+        return 1;
+    }
+    // a relocatable link just combines the objects into one
+    std::vector<const char*> args{ ld->c_str(), "-r", "-o", op.outfile };
+    for (const std::string& object : objects)
+    {
+        args.push_back(object.c_str());
+    }
+    args.push_back(nullptr);
+    std::string error;
+    int result = llvm::sys::ExecuteAndWait(*ld, args.data(), /*env=*/nullptr,
+        /*redirects=*/{}, /*secondsToWait=*/0, /*memoryLimit=*/0, &error);
+    if (result != 0)
+    {
+        diag.print<Diag::CANT_LINK_OBJECTS>(error.empty() ?
+            "ld exited with status " + std::to_string(result) : error);
+        return 1;
+    }
+    return 0;
+}
+
 int Driver::repl(
     std::function<void(const std::string&, llvm::raw_ostream&)> evaluator)
 {
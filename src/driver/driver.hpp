@@ -1,9 +1,19 @@
 #ifndef DRIVER_HPP
 #define DRIVER_HPP
 
+#include "ast/vslContext.hpp"
+#include "codegen/codegen.hpp"
+#include "diag/diag.hpp"
+#include "diag/timeReport.hpp"
 #include "driver/optionParser.hpp"
+#include "jit/jit.hpp"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/Module.h"
 #include "llvm/Support/raw_ostream.h"
 #include <functional>
+#include <memory>
+#include <string>
+#include <vector>
 
 /**
  * Controls the entire compilation process.
@@ -28,10 +38,129 @@ private:
      * @returns 0 on success, 1 on failure.
      */
     int displayHelp();
+    /**
+     * Runs the compile server.
+     *
+     * @returns 1 if the server couldn't start. Otherwise, this doesn't return.
+     */
+    int serve();
     /**
      * Does the standard compilation steps.
      */
     int compile();
+    /**
+     * Emits object code for the module, in whatever way the options ask for.
+     *
+     * @param codeGen Compiles the module.
+     * @param diag Diagnostics manager.
+     *
+     * @returns 0 on success, 1 on failure.
+     */
+    int emit(CodeGen& codeGen, Diag& diag);
+    /**
+     * Prints the time report and writes the stats file, if asked for.
+     *
+     * @param diag Diagnostics manager.
+     *
+     * @returns True on success, false if the stats file couldn't be written.
+     */
+    bool reportTime(Diag& diag);
+    /**
+     * Configures the module for the target, then lexes, parses, and generates
+     * LLVM IR for the source into it.
+     *
+     * @param diag Diagnostics manager.
+     * @param src The source code.
+     * @param vslCtx Where the AST goes.
+     * @param codeGen Configures the module.
+     * @param module The module to generate into.
+     * @param triple The target triple, or empty for the host.
+     *
+     * @returns True on success, false if there were errors.
+     */
+    bool generate(Diag& diag, llvm::StringRef src, VSLContext& vslCtx,
+        CodeGen& codeGen, llvm::Module& module, llvm::StringRef triple);
+    /**
+     * Prints the number of errors and warnings, if there was more than one.
+     *
+     * @param diag Diagnostics manager.
+     */
+    void recap(const Diag& diag);
+    /**
+     * Optimizes the module as much as the options ask for.
+     *
+     * @param codeGen Optimizes the module.
+     */
+    void optimize(CodeGen& codeGen);
+    /**
+     * Runs the input file, or starts the run REPL if there isn't one. The file
+     * is interpreted at first, and its functions are JIT compiled as they get
+     * hot.
+     *
+     * @returns What the program's main function returned, or 1 on failure.
+     */
+    int run();
+    /**
+     * Starts a REPL that runs each line as it's entered. Declarations are kept
+     * for the lines after them, and anything else is evaluated and printed.
+     * The JIT is reused the whole time, so each line only has to compile the
+     * code that's new.
+     *
+     * @returns 0 on success, 1 on failure.
+     */
+    int runRepl();
+    /**
+     * Compiles REPL input and adds it to the JIT.
+     *
+     * @param jit The JIT to add the input to.
+     * @param input The input, which includes the declarations from earlier
+     * lines.
+     * @param os Where diagnostics go.
+     *
+     * @returns True on success, false otherwise.
+     */
+    bool addReplInput(JIT& jit, const std::string& input,
+        llvm::raw_ostream& os);
+    /**
+     * Compiles the module into one object file per job. They're either kept
+     * as separate outputs or linked together into the output file, depending
+     * on the options.
+     *
+     * @param codeGen Compiles the module.
+     * @param diag Diagnostics manager.
+     *
+     * @returns 0 on success, 1 on failure.
+     */
+    int compileParallel(CodeGen& codeGen, Diag& diag);
+    /**
+     * Compiles the module using the object cache, only generating code for
+     * the parts that changed since an earlier compile, then links everything
+     * together into the output file.
+     *
+     * @param codeGen Compiles the module.
+     * @param diag Diagnostics manager.
+     *
+     * @returns 0 on success, 1 on failure.
+     */
+    int compileCached(CodeGen& codeGen, Diag& diag);
+    /**
+     * Checks if the system's linker can handle object files for a target.
+     *
+     * @param triple The target triple, or empty for the host.
+     *
+     * @returns True if the target's objects are like the host's, false
+     * otherwise.
+     */
+    static bool isHostTarget(llvm::StringRef triple);
+    /**
+     * Combines object files into the output file, using the system's linker.
+     *
+     * @param diag Diagnostics manager.
+     * @param objects The object files to link.
+     *
+     * @returns 0 on success, 1 on failure.
+     */
+    int linkObjects(Diag& diag, const std::vector<std::string>& objects);
     /**
      * Starts a REPL using the given evaluator function. The evaluator takes in
      * an input string reference as the first argument and an output stream
@@ -45,6 +174,8 @@ private:
         std::function<void(const std::string&, llvm::raw_ostream&)> evaluator);
     /** The option parser. */
     OptionParser op;
+    /** Measures each phase of compilation, or null if not asked for. */
+    std::unique_ptr<TimeReport> timeReport;
 };
 
 #endif // DRIVER_HPP
@@ -1,10 +1,13 @@
 #include "driver/optionParser.hpp"
 #include "llvm/Support/raw_ostream.h"
+#include <cstdlib>
 #include <cstring>
 
 OptionParser::OptionParser()
-    : action{ COMPILE }, optimize{ false }, infile { nullptr },
-    outfile{ "a.out" }
+    : action{ COMPILE }, optLevel{ 0 }, sizeLevel{ 0 }, jobs{ 1 },
+    splitObjects{ false }, cacheDir{ nullptr }, targetTriple{ "" },
+    jitThreshold{ 1000 }, timeReport{ false }, statsJson{ nullptr },
+    socketPath{ nullptr }, infile { nullptr }, outfile{ "a.out" }
 {
 }
 
@@ -13,7 +16,12 @@ void OptionParser::parse(int argc, const char* const* argv)
     for (int i = 1; i < argc; ++i)
     {
         const char* arg = argv[i];
-        if (!strcmp(arg, "-h") || !strcmp(arg, "--help"))
+        // `vsl run ...` is a command rather than a flag
+        if (i == 1 && !strcmp(arg, "run"))
+        {
+            action = RUN;
+        }
+        else if (!strcmp(arg, "-h") || !strcmp(arg, "--help"))
         {
             action = DISPLAY_HELP;
         }
@@ -40,19 +48,147 @@ void OptionParser::parse(int argc, const char* const* argv)
                 llvm::errs() << "Error: no output file given\n";
             }
         }
+        else if (!strcmp(arg, "-j"))
+        {
+            if (i + 1 >= argc)
+            {
+                llvm::errs() << "Error: no job count given\n";
+                continue;
+            }
+            const char* count = argv[++i];
+            char* end;
+            long value = strtol(count, &end, 10);
+            if (*end != '\0' || value < 1)
+            {
+                llvm::errs() << "Error: invalid job count '" << count <<
+                    "'\n";
+            }
+            else
+            {
+                jobs = static_cast<unsigned>(value);
+            }
+        }
+        else if (!strcmp(arg, "--split-objects"))
+        {
+            splitObjects = true;
+        }
+        else if (!strncmp(arg, "--alloc=", 8))
+        {
+            const char* allocator = arg + 8;
+            if (!strcmp(allocator, "malloc"))
+            {
+                irgenOptions.allocator = IRGenOptions::MALLOC;
+            }
+            else if (!strcmp(allocator, "pool"))
+            {
+                irgenOptions.allocator = IRGenOptions::POOL;
+            }
+            else
+            {
+                llvm::errs() << "Error: unknown allocator '" << allocator <<
+                    "'\n";
+            }
+        }
+        else if (!strncmp(arg, "--refcount=", 11))
+        {
+            const char* refcount = arg + 11;
+            if (!strcmp(refcount, "nonatomic"))
+            {
+                irgenOptions.refcount = IRGenOptions::NONATOMIC;
+            }
+            else if (!strcmp(refcount, "atomic"))
+            {
+                irgenOptions.refcount = IRGenOptions::ATOMIC;
+            }
+            else if (!strcmp(refcount, "biased"))
+            {
+                irgenOptions.refcount = IRGenOptions::BIASED;
+            }
+            else
+            {
+                llvm::errs() << "Error: unknown refcount mode '" << refcount <<
+                    "'\n";
+            }
+        }
+        else if (!strncmp(arg, "--cache-dir=", 12))
+        {
+            if (arg[12] == '\0')
+            {
+                llvm::errs() << "Error: no cache directory given\n";
+            }
+            else
+            {
+                cacheDir = arg + 12;
+            }
+        }
+        else if (!strncmp(arg, "--target=", 9))
+        {
+            if (arg[9] == '\0')
+            {
+                llvm::errs() << "Error: no target triple given\n";
+            }
+            else
+            {
+                targetTriple = arg + 9;
+            }
+        }
+        else if (!strncmp(arg, "--jit-threshold=", 16))
+        {
+            const char* count = arg + 16;
+            char* end;
+            long value = strtol(count, &end, 10);
+            if (*count == '\0' || *end != '\0' || value < 0)
+            {
+                llvm::errs() << "Error: invalid jit threshold '" << count <<
+                    "'\n";
+            }
+            else
+            {
+                jitThreshold = static_cast<unsigned>(value);
+            }
+        }
+        else if (!strcmp(arg, "--time-report"))
+        {
+            timeReport = true;
+        }
+        else if (!strncmp(arg, "--stats-json=", 13))
+        {
+            if (arg[13] == '\0')
+            {
+                llvm::errs() << "Error: no stats file given\n";
+            }
+            else
+            {
+                statsJson = arg + 13;
+            }
+        }
+        else if (!strncmp(arg, "--serve=", 8))
+        {
+            if (arg[8] == '\0')
+            {
+                llvm::errs() << "Error: no socket given\n";
+            }
+            else
+            {
+                action = SERVE;
+                socketPath = arg + 8;
+            }
+        }
         else if (!strncmp(arg, "-O", 2))
         {
             if (arg[2] == '\0')
             {
                 llvm::errs() << "Error: No optimization level specified.\n";
             }
-            else if (arg[2] == '0')
+            else if (arg[2] >= '0' && arg[2] <= '3' && arg[3] == '\0')
             {
-                optimize = false;
+                optLevel = arg[2] - '0';
+                sizeLevel = 0;
             }
-            else if (arg[2] == '1')
+            else if (arg[2] == 's' && arg[3] == '\0')
             {
-                optimize = true;
+                optLevel = 2;
+                sizeLevel = 1;
             }
             else
             {
@@ -1,6 +1,8 @@
 #ifndef OPTIONPARSER_HPP
 #define OPTIONPARSER_HPP
 
+#include "irgen/irgenOptions.hpp"
+
 /**
  * Parses command-line arguments.
  */
@@ -21,7 +23,11 @@ public:
         /** Emits an abstract syntax tree. */
         REPL_PARSE,
         /** Emits LLVM IR. */
-        REPL_GENERATE
+        REPL_GENERATE,
+        /** Serve compile requests from vsl-client. */
+        SERVE,
+        /** JIT compile and run a source file, or start the run REPL. */
+        RUN
     };
     /**
      * Creates an OptionParser object.
@@ -36,8 +42,37 @@ public:
     void parse(int argc, const char* const* argv);
     /** The action the compiler should take. */
     Action action;
-    /** True if the compiler should optimize the LLVM IR output. */
-    bool optimize;
+    /** How hard to optimize the LLVM IR output, from 0 to 3. */
+    unsigned optLevel;
+    /** How much to favor code size when optimizing, e.g. 1 for -Os. */
+    unsigned sizeLevel;
+    /** How many threads to generate code on. */
+    unsigned jobs;
+    /**
+     * True if each job's object file should be kept separate instead of being
+     * linked into the output file.
+     */
+    bool splitObjects;
+    /** What kind of code IRGen should emit. */
+    IRGenOptions irgenOptions;
+    /** The directory to cache object code in, or null to not use a cache. */
+    const char* cacheDir;
+    /** The target triple to generate code for, or empty for the host. */
+    const char* targetTriple;
+    /**
+     * How many times `vsl run` interprets a function before JIT compiling it,
+     * or 0 to compile everything up front.
+     */
+    unsigned jitThreshold;
+    /** True if the time each phase took should be printed. */
+    bool timeReport;
+    /**
+     * The file to write the time and memory of each phase to as JSON, or null
+     * to not write one.
+     */
+    const char* statsJson;
+    /** The socket to serve compile requests on. */
+    const char* socketPath;
     /** The file name to take input from. */
     const char* infile;
     /** The file name to emit output to. */
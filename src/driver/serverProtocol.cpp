@@ -0,0 +1,214 @@
+#include "driver/serverProtocol.hpp"
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace
+{
+
+/** The most argument data a request can have, so clients can't hog memory. */
+const uint32_t maxRequestSize = 1 << 20;
+
+/**
+ * Writes a whole buffer to a socket.
+ *
+ * @param sock The socket to write to.
+ * @param data The data to write.
+ * @param size The size of the data.
+ *
+ * @returns True on success, false otherwise.
+ */
+bool writeAll(int sock, const void* data, size_t size)
+{
+    auto* p = static_cast<const char*>(data);
+    while (size > 0)
+    {
+        ssize_t n = send(sock, p, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return false;
+        }
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+/**
+ * Fills a whole buffer from a socket.
+ *
+ * @param sock The socket to read from.
+ * @param data The buffer to fill.
+ * @param size The size of the buffer.
+ *
+ * @returns True on success, false if the socket closed first or failed.
+ */
+bool readAll(int sock, void* data, size_t size)
+{
+    auto* p = static_cast<char*>(data);
+    while (size > 0)
+    {
+        ssize_t n = recv(sock, p, size, 0);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return false;
+        }
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+/** Buffer for the descriptors that come with a request. */
+union Control
+{
+    char buf[CMSG_SPACE(sizeof(int) * numRequestFds)];
+    /** Makes sure the buffer is aligned properly. */
+    cmsghdr align;
+};
+
+} // end anonymous namespace
+
+bool sendRequest(int sock, const std::vector<std::string>& args,
+    const int (&fds)[numRequestFds])
+{
+    std::string data;
+    for (const std::string& arg : args)
+    {
+        data += arg;
+        data += '\0';
+    }
+    if (data.size() > maxRequestSize)
+    {
+        return false;
+    }
+    auto size = static_cast<uint32_t>(data.size());
+    // the descriptors go along with the size, which has to be sent in one go
+    //  so that they can't get separated
+    iovec iov;
+    iov.iov_base = &size;
+    iov.iov_len = sizeof size;
+    Control control;
+    memset(&control, 0, sizeof control);
+    msghdr msg;
+    memset(&msg, 0, sizeof msg);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof control.buf;
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof fds);
+    memcpy(CMSG_DATA(cmsg), fds, sizeof fds);
+    ssize_t n;
+    do
+    {
+        n = sendmsg(sock, &msg, MSG_NOSIGNAL);
+    }
+    while (n < 0 && errno == EINTR);
+    return n == sizeof size && writeAll(sock, data.data(), data.size());
+}
+
+bool receiveRequest(int sock, std::vector<std::string>& args,
+    int (&fds)[numRequestFds])
+{
+    uint32_t size;
+    iovec iov;
+    iov.iov_base = &size;
+    iov.iov_len = sizeof size;
+    Control control;
+    msghdr msg;
+    memset(&msg, 0, sizeof msg);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof control.buf;
+    ssize_t n;
+    do
+    {
+        n = recvmsg(sock, &msg, 0);
+    }
+    while (n < 0 && errno == EINTR);
+    if (n <= 0)
+    {
+        return false;
+    }
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if (!cmsg || cmsg->cmsg_level != SOL_SOCKET ||
+        cmsg->cmsg_type != SCM_RIGHTS)
+    {
+        return false;
+    }
+    size_t numFds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    if (numFds != numRequestFds || (msg.msg_flags & MSG_CTRUNC))
+    {
+        // whatever did come through still has to be closed
+        for (size_t i = 0; i < numFds && i < numRequestFds; ++i)
+        {
+            int fd;
+            memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof fd);
+            close(fd);
+        }
+        return false;
+    }
+    memcpy(fds, CMSG_DATA(cmsg), sizeof fds);
+    // a partial size shouldn't happen, but the rest can still be read
+    std::string data;
+    bool ok = (n == sizeof size ||
+        readAll(sock, reinterpret_cast<char*>(&size) + n,
+            sizeof size - static_cast<size_t>(n))) &&
+        size <= maxRequestSize;
+    if (ok)
+    {
+        data.resize(size);
+        ok = readAll(sock, &data[0], data.size());
+    }
+    args.clear();
+    size_t start = 0;
+    for (size_t i = 0; ok && i < data.size(); ++i)
+    {
+        if (data[i] == '\0')
+        {
+            args.push_back(data.substr(start, i - start));
+            start = i + 1;
+        }
+    }
+    if (!ok || args.empty() || start != data.size())
+    {
+        for (int fd : fds)
+        {
+            close(fd);
+        }
+        return false;
+    }
+    return true;
+}
+
+bool sendStatus(int sock, int status)
+{
+    auto value = static_cast<int32_t>(status);
+    return writeAll(sock, &value, sizeof value);
+}
+
+bool receiveStatus(int sock, int& status)
+{
+    int32_t value;
+    if (!readAll(sock, &value, sizeof value))
+    {
+        return false;
+    }
+    status = value;
+    return true;
+}
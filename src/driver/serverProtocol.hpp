@@ -0,0 +1,63 @@
+#ifndef SERVERPROTOCOL_HPP
+#define SERVERPROTOCOL_HPP
+
+#include <string>
+#include <vector>
+
+// This is shared by the compile server and vsl-client, which doesn't link
+//  against LLVM, so it can only depend on POSIX.
+//
+// A request is a 32-bit size followed by that many bytes of null-terminated
+//  arguments, starting with argv[0]. The client's working directory, stdin,
+//  stdout and stderr are passed along with the size, so the server can act
+//  just like a vsl process that the client started itself. The reply is the
+//  32-bit exit status.
+
+/** How many file descriptors come with a request. */
+const int numRequestFds = 4;
+
+/**
+ * Sends a compile request.
+ *
+ * @param sock The socket connected to the server.
+ * @param args The command line arguments, starting with argv[0].
+ * @param fds The working directory, stdin, stdout and stderr, in that order.
+ *
+ * @returns True on success, false otherwise.
+ */
+bool sendRequest(int sock, const std::vector<std::string>& args,
+    const int (&fds)[numRequestFds]);
+
+/**
+ * Receives a compile request.
+ *
+ * @param sock The socket connected to the client.
+ * @param args Where to put the command line arguments.
+ * @param fds Where to put the working directory, stdin, stdout and stderr.
+ *
+ * @returns True on success, false otherwise.
+ */
+bool receiveRequest(int sock, std::vector<std::string>& args,
+    int (&fds)[numRequestFds]);
+
+/**
+ * Sends the exit status of a compile back to the client.
+ *
+ * @param sock The socket connected to the client.
+ * @param status The exit status.
+ *
+ * @returns True on success, false otherwise.
+ */
+bool sendStatus(int sock, int status);
+
+/**
+ * Receives the exit status of a compile.
+ *
+ * @param sock The socket connected to the server.
+ * @param status Where to put the exit status.
+ *
+ * @returns True on success, false if the server went away first.
+ */
+bool receiveStatus(int sock, int& status);
+
+#endif // SERVERPROTOCOL_HPP
@@ -0,0 +1,699 @@
+#include "interp/interpreter.hpp"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/Support/DynamicLibrary.h"
+#include <cstring>
+
+/**
+ * Checks whether a function body or a global variable's initializer only uses
+ * things that the interpreter can run. Expressions are walked, so they can be
+ * nested as deeply as the parser allows.
+ */
+class Interpreter::Checker : public NodeVisitor<Checker>
+{
+public:
+    /**
+     * Creates a Checker.
+     *
+     * @param funcs Every function in the program.
+     */
+    Checker(const llvm::StringMap<Func>& funcs)
+        : funcs{ funcs }, ok{ true }
+    {
+    }
+    /**
+     * Checks a function.
+     *
+     * @param node The function to check.
+     *
+     * @returns True if the function can be interpreted, false otherwise.
+     */
+    bool check(FunctionNode& node)
+    {
+        ok = node.getReturnType()->is(Type::VOID) ||
+            isScalar(node.getReturnType());
+        for (ParamNode* param : node.getParams())
+        {
+            ok &= isScalar(param->getType());
+        }
+        visit(node.getBody());
+        return ok;
+    }
+    /**
+     * Checks an expression.
+     *
+     * @param node The expression to check.
+     *
+     * @returns True if the expression can be interpreted, false otherwise.
+     */
+    bool check(ExprNode& node)
+    {
+        ok = true;
+        walk(node);
+        return ok;
+    }
+    void visitVariable(VariableNode& node)
+    {
+        ok &= node.hasType() && isScalar(node.getType());
+        walk(node.getInit());
+    }
+    void visitBlock(BlockNode& node)
+    {
+        for (Node* statement : node.getStatements())
+        {
+            visit(*statement);
+        }
+    }
+    void visitIf(IfNode& node)
+    {
+        walk(node.getCondition());
+        visit(node.getThen());
+        if (node.hasElse())
+        {
+            visit(node.getElse());
+        }
+    }
+    void visitReturn(ReturnNode& node)
+    {
+        if (node.hasValue())
+        {
+            walk(node.getValue());
+        }
+    }
+    void visitIdent(IdentNode& node)
+    {
+        // locals and globals are always scalars by now, but functions can't be
+        //  used as values
+        ok &= !funcs.count(node.getName());
+    }
+    void visitUnary(UnaryNode& node)
+    {
+        walk(node.getExpr());
+    }
+    void visitBinary(BinaryNode& node)
+    {
+        walk(node.getLhs());
+        walk(node.getRhs());
+    }
+    void visitTernary(TernaryNode& node)
+    {
+        walk(node.getCondition());
+        walk(node.getThen());
+        walk(node.getElse());
+    }
+    void visitCall(CallNode& node)
+    {
+        // only functions can be called, e.g. not class ctors
+        if (node.getCallee().isNot(Node::IDENT))
+        {
+            ok = false;
+            return;
+        }
+        auto it = funcs.find(
+            static_cast<IdentNode&>(node.getCallee()).getName());
+        ok &= it != funcs.end() && isCallable(it->getValue());
+        for (ArgNode* arg : node.getArgs())
+        {
+            walk(*arg);
+        }
+    }
+    void visitArg(ArgNode& node)
+    {
+        walk(node.getValue());
+    }
+    void visitFieldAccess(FieldAccessNode& node)
+    {
+        ok = false;
+    }
+    void visitMethodCall(MethodCallNode& node)
+    {
+        ok = false;
+    }
+    void visitSelf(SelfNode& node)
+    {
+        ok = false;
+    }
+
+private:
+    /** Every function in the program. */
+    const llvm::StringMap<Func>& funcs;
+    /** True if everything so far can be interpreted. */
+    bool ok;
+};
+
+namespace
+{
+
+/**
+ * Calls compiled code with up to Interpreter::maxNativeArgs Int or Bool
+ * arguments.
+ *
+ * @tparam R The return type.
+ *
+ * @param code The code to call.
+ * @param args The arguments.
+ *
+ * @returns The return value.
+ */
+template <typename R>
+R callNative(void* code, llvm::ArrayRef<int32_t> args)
+{
+    using I = int32_t;
+    switch (args.size())
+    {
+    case 0:
+        return reinterpret_cast<R (*)()>(code)();
+    case 1:
+        return reinterpret_cast<R (*)(I)>(code)(args[0]);
+    case 2:
+        return reinterpret_cast<R (*)(I, I)>(code)(args[0], args[1]);
+    case 3:
+        return reinterpret_cast<R (*)(I, I, I)>(code)(args[0], args[1],
+            args[2]);
+    case 4:
+        return reinterpret_cast<R (*)(I, I, I, I)>(code)(args[0], args[1],
+            args[2], args[3]);
+    case 5:
+        return reinterpret_cast<R (*)(I, I, I, I, I)>(code)(args[0], args[1],
+            args[2], args[3], args[4]);
+    default:
+        return reinterpret_cast<R (*)(I, I, I, I, I, I)>(code)(args[0],
+            args[1], args[2], args[3], args[4], args[5]);
+    }
+}
+
+} // end anonymous namespace
+
+Interpreter::Interpreter(Diag& diag, JIT& jit,
+    std::unique_ptr<llvm::Module> module, std::function<void()> optimize,
+    unsigned threshold)
+    : diag{ diag }, jit{ jit }, module{ std::move(module) },
+    optimize{ std::move(optimize) }, threshold{ threshold },
+    compileAll{ threshold == 0 }, frameBase{ 0 }, result{ 0 },
+    resultIsBool{ false }, returning{ false }, failed{ false }
+{
+}
+
+bool Interpreter::init(llvm::ArrayRef<DeclNode*> ast)
+{
+    std::vector<VariableNode*> vars;
+    for (DeclNode* decl : ast)
+    {
+        if (decl->is(Node::FUNCTION))
+        {
+            auto& node = static_cast<FunctionNode&>(*decl);
+            funcs[node.getName()] = { &node, &node, false, 0, nullptr };
+        }
+        else if (decl->is(Node::EXTFUNC))
+        {
+            auto& node = static_cast<ExtFuncNode&>(*decl);
+            funcs[node.getName()] = { &node, nullptr, false, 0, nullptr };
+        }
+        else if (decl->is(Node::VARIABLE))
+        {
+            vars.push_back(static_cast<VariableNode*>(decl));
+        }
+    }
+    // the compiled code can only share global variables that the interpreter
+    //  can initialize
+    Checker checker{ funcs };
+    for (VariableNode* var : vars)
+    {
+        compileAll |= !isScalar(var->getType()) ||
+            !checker.check(var->getInit());
+    }
+    if (compileAll)
+    {
+        return addModule();
+    }
+    for (auto& entry : funcs)
+    {
+        Func& func = entry.getValue();
+        func.interpretable = func.body && checker.check(*func.body);
+    }
+    // initialize the global variables in order, like the global ctors would
+    for (VariableNode* var : vars)
+    {
+        frameBase = locals.size();
+        walkNow(var->getInit());
+        if (failed)
+        {
+            return false;
+        }
+        Global& global = globals[var->getName()];
+        global.type = var->getType();
+        store(global, result);
+    }
+    return true;
+}
+
+bool Interpreter::call(llvm::StringRef name, llvm::ArrayRef<int32_t> args,
+    int32_t& value)
+{
+    auto it = funcs.find(name);
+    if (it == funcs.end())
+    {
+        return false;
+    }
+    return callFunc(it->getValue(), args, value);
+}
+
+void Interpreter::walkOperand(Node& operand, Node& node, Step next)
+{
+    // the operand is evaluated first, along with everything that it walks
+    walk(operand);
+    walk(node, next);
+}
+
+size_t Interpreter::getNumCompiled() const
+{
+    size_t numCompiled = 0;
+    for (const auto& entry : funcs)
+    {
+        if (entry.getValue().body && entry.getValue().code)
+        {
+            ++numCompiled;
+        }
+    }
+    return numCompiled;
+}
+
+void Interpreter::visitVariable(VariableNode& node)
+{
+    walkNow(node.getInit());
+    locals.push_back({ node.getSymbol(), result,
+        node.getType()->is(Type::BOOL) });
+}
+
+void Interpreter::visitBlock(BlockNode& node)
+{
+    // variables go out of scope at the end of the block
+    size_t numLocals = locals.size();
+    for (Node* statement : node.getStatements())
+    {
+        walkNow(*statement);
+        if (returning)
+        {
+            break;
+        }
+    }
+    locals.erase(locals.begin() + numLocals, locals.end());
+}
+
+void Interpreter::visitEmpty(EmptyNode& node)
+{
+}
+
+void Interpreter::visitIf(IfNode& node)
+{
+    walkNow(node.getCondition());
+    if (returning)
+    {
+        return;
+    }
+    if (result)
+    {
+        walkNow(node.getThen());
+    }
+    else if (node.hasElse())
+    {
+        walkNow(node.getElse());
+    }
+}
+
+void Interpreter::visitReturn(ReturnNode& node)
+{
+    if (node.hasValue())
+    {
+        walkNow(node.getValue());
+    }
+    returning = true;
+}
+
+void Interpreter::visitIdent(IdentNode& node)
+{
+    if (Local* local = findLocal(node.getSymbol()))
+    {
+        result = local->value;
+        resultIsBool = local->isBool;
+        return;
+    }
+    const Global& global = globals.find(node.getName())->getValue();
+    result = load(global);
+    resultIsBool = global.type->is(Type::BOOL);
+}
+
+void Interpreter::visitLiteral(LiteralNode& node)
+{
+    llvm::APInt value = node.getValue();
+    resultIsBool = value.getBitWidth() == 1;
+    result = static_cast<int32_t>(resultIsBool ? value.getZExtValue() :
+        value.getSExtValue());
+}
+
+void Interpreter::visitUnary(UnaryNode& node)
+{
+    if (getWalkState() == START)
+    {
+        walkOperand(node.getExpr(), node, AFTER_OPERAND);
+        return;
+    }
+    switch (node.getOp())
+    {
+    case UnaryKind::MINUS:
+        // a Bool is a 1-bit int, which is its own negative
+        if (!resultIsBool)
+        {
+            result = static_cast<int32_t>(0u - static_cast<uint32_t>(result));
+        }
+        break;
+    case UnaryKind::NOT:
+        result = !result;
+        break;
+    default:
+        break;
+    }
+}
+
+void Interpreter::visitBinary(BinaryNode& node)
+{
+    // special case: variable assignment
+    if (node.getOp() == BinaryKind::ASSIGN)
+    {
+        if (getWalkState() == START)
+        {
+            walkOperand(node.getRhs(), node, AFTER_RHS);
+            return;
+        }
+        auto& lhs = static_cast<IdentNode&>(node.getLhs());
+        if (Local* local = findLocal(lhs.getSymbol()))
+        {
+            local->value = result;
+        }
+        else
+        {
+            store(globals.find(lhs.getName())->getValue(), result);
+        }
+        return;
+    }
+    // special case: short-circuiting boolean operations
+    if (node.getOp() == BinaryKind::AND || node.getOp() == BinaryKind::OR)
+    {
+        if (getWalkState() == START)
+        {
+            walkOperand(node.getLhs(), node, AFTER_LHS);
+        }
+        else if (returning || !result != (node.getOp() == BinaryKind::AND))
+        {
+            // the rhs decides the result by itself
+            walk(node.getRhs());
+        }
+        return;
+    }
+    switch (getWalkState())
+    {
+    case START:
+        walkOperand(node.getLhs(), node, AFTER_LHS);
+        return;
+    case AFTER_LHS:
+        pendingValues.push_back(result);
+        walkOperand(node.getRhs(), node, AFTER_RHS);
+        return;
+    default:
+        break;
+    }
+    int32_t lhs = pendingValues.back();
+    pendingValues.pop_back();
+    int32_t rhs = result;
+    // Int math wraps around like the compiled code does
+    auto ulhs = static_cast<uint32_t>(lhs);
+    auto urhs = static_cast<uint32_t>(rhs);
+    resultIsBool = true;
+    switch (node.getOp())
+    {
+    case BinaryKind::STAR:
+        result = static_cast<int32_t>(ulhs * urhs);
+        resultIsBool = false;
+        break;
+    case BinaryKind::SLASH:
+        result = static_cast<int32_t>(static_cast<int64_t>(lhs) / rhs);
+        resultIsBool = false;
+        break;
+    case BinaryKind::PERCENT:
+        result = static_cast<int32_t>(static_cast<int64_t>(lhs) % rhs);
+        resultIsBool = false;
+        break;
+    case BinaryKind::PLUS:
+        result = static_cast<int32_t>(ulhs + urhs);
+        resultIsBool = false;
+        break;
+    case BinaryKind::MINUS:
+        result = static_cast<int32_t>(ulhs - urhs);
+        resultIsBool = false;
+        break;
+    case BinaryKind::GREATER:
+        result = lhs > rhs;
+        break;
+    case BinaryKind::GREATER_EQUAL:
+        result = lhs >= rhs;
+        break;
+    case BinaryKind::LESS:
+        result = lhs < rhs;
+        break;
+    case BinaryKind::LESS_EQUAL:
+        result = lhs <= rhs;
+        break;
+    case BinaryKind::EQUAL:
+        result = lhs == rhs;
+        break;
+    case BinaryKind::NOT_EQUAL:
+        result = lhs != rhs;
+        break;
+    default:
+        break;
+    }
+}
+
+void Interpreter::visitTernary(TernaryNode& node)
+{
+    if (getWalkState() == START)
+    {
+        walkOperand(node.getCondition(), node, AFTER_CONDITION);
+    }
+    else if (result)
+    {
+        walk(node.getThen());
+    }
+    else
+    {
+        walk(node.getElse());
+    }
+}
+
+void Interpreter::visitCall(CallNode& node)
+{
+    if (getWalkState() == START)
+    {
+        pendingCalls.push_back(pendingValues.size());
+    }
+    else
+    {
+        pendingValues.push_back(result);
+    }
+    size_t argsBase = pendingCalls.back();
+    size_t numArgs = pendingValues.size() - argsBase;
+    if (numArgs < node.getNumArgs())
+    {
+        walkOperand(node.getArg(numArgs), node, AFTER_ARG);
+        return;
+    }
+    // the callee can walk expressions of its own, so the arguments are moved
+    //  off the stack first
+    llvm::SmallVector<int32_t, maxNativeArgs> args{
+        pendingValues.begin() + argsBase, pendingValues.end() };
+    pendingValues.resize(argsBase);
+    pendingCalls.pop_back();
+    Func& func = funcs.find(
+        static_cast<IdentNode&>(node.getCallee()).getName())->getValue();
+    if (failed || !callFunc(func, args, result))
+    {
+        // unwind everything
+        failed = true;
+        returning = true;
+        return;
+    }
+    resultIsBool = func.node->getReturnType()->is(Type::BOOL);
+}
+
+void Interpreter::visitArg(ArgNode& node)
+{
+    walk(node.getValue());
+}
+
+bool Interpreter::callFunc(Func& func, llvm::ArrayRef<int32_t> args,
+    int32_t& value)
+{
+    // a function that's hot enough is compiled from then on, if it can be
+    //  called that way
+    if (!func.code && func.interpretable && ++func.calls == threshold &&
+        args.size() <= maxNativeArgs && !compile(func))
+    {
+        return false;
+    }
+    if (func.code)
+    {
+        value = callCode(func, args);
+        return true;
+    }
+    if (func.interpretable)
+    {
+        return interpret(func, args, value);
+    }
+    // can't be interpreted at all, so it has to be compiled right away
+    if (!compile(func))
+    {
+        return false;
+    }
+    value = callCode(func, args);
+    return true;
+}
+
+bool Interpreter::interpret(Func& func, llvm::ArrayRef<int32_t> args,
+    int32_t& value)
+{
+    size_t oldFrameBase = frameBase;
+    frameBase = locals.size();
+    for (size_t i = 0; i < args.size(); ++i)
+    {
+        const ParamNode& param = func.node->getParam(i);
+        locals.push_back({ param.getSymbol(), args[i],
+            param.getType()->is(Type::BOOL) });
+    }
+    result = 0;
+    visit(func.body->getBody());
+    value = func.node->getReturnType()->is(Type::VOID) ? 0 : result;
+    locals.erase(locals.begin() + frameBase, locals.end());
+    frameBase = oldFrameBase;
+    returning = failed;
+    return !failed;
+}
+
+int32_t Interpreter::callCode(const Func& func, llvm::ArrayRef<int32_t> args)
+{
+    const Type* returnType = func.node->getReturnType();
+    if (returnType->is(Type::VOID))
+    {
+        callNative<void>(func.code, args);
+        return 0;
+    }
+    if (returnType->is(Type::BOOL))
+    {
+        // only the lowest bit of an i1 is defined
+        return callNative<uint8_t>(func.code, args) & 1;
+    }
+    return callNative<int32_t>(func.code, args);
+}
+
+bool Interpreter::compile(Func& func)
+{
+    if (!func.body)
+    {
+        auto& ext = static_cast<ExtFuncNode&>(*func.node);
+        func.code = llvm::sys::DynamicLibrary::SearchForAddressOfSymbol(
+            ext.getAlias().str());
+        if (!func.code)
+        {
+            diag.print<Diag::CANT_FIND_SYMBOL>(ext.getAlias());
+            return false;
+        }
+        return true;
+    }
+    if (module && !addModule())
+    {
+        return false;
+    }
+    func.code = jit.getAddress(func.node->getName());
+    return func.code != nullptr;
+}
+
+bool Interpreter::addModule()
+{
+    if (!compileAll)
+    {
+        // the interpreter already initialized the global variables
+        if (llvm::GlobalVariable* ctors =
+                module->getNamedGlobal("llvm.global_ctors"))
+        {
+            ctors->eraseFromParent();
+        }
+        for (auto& entry : globals)
+        {
+            llvm::GlobalVariable* var = module->getNamedGlobal(entry.getKey());
+            var->setInitializer(nullptr);
+            var->setLinkage(llvm::GlobalValue::ExternalLinkage);
+            jit.addSymbol(entry.getKey(), &entry.getValue().storage);
+        }
+    }
+    // any function could end up being compiled, so none of them can be
+    //  optimized away
+    jit.linkExisting(*module);
+    optimize();
+    return jit.addModule(std::move(module));
+}
+
+Interpreter::Local* Interpreter::findLocal(Symbol name)
+{
+    // the innermost variable shadows the rest
+    for (size_t i = locals.size(); i > frameBase; --i)
+    {
+        if (locals[i - 1].name == name)
+        {
+            return &locals[i - 1];
+        }
+    }
+    return nullptr;
+}
+
+int32_t Interpreter::load(const Global& global)
+{
+    if (global.type->is(Type::BOOL))
+    {
+        uint8_t value;
+        std::memcpy(&value, &global.storage, sizeof value);
+        return value & 1;
+    }
+    return global.storage;
+}
+
+void Interpreter::store(Global& global, int32_t value)
+{
+    if (global.type->is(Type::BOOL))
+    {
+        auto byte = static_cast<uint8_t>(value);
+        std::memcpy(&global.storage, &byte, sizeof byte);
+        return;
+    }
+    global.storage = value;
+}
+
+bool Interpreter::isScalar(const Type* type)
+{
+    return type->is(Type::INT) || type->is(Type::BOOL);
+}
+
+bool Interpreter::isCallable(const Func& func)
+{
+    const Type* returnType = func.node->getReturnType();
+    if (!returnType->is(Type::VOID) && !isScalar(returnType))
+    {
+        return false;
+    }
+    for (const ParamNode* param : func.node->getParams())
+    {
+        if (!isScalar(param->getType()))
+        {
+            return false;
+        }
+    }
+    return func.node->getNumParams() <= maxNativeArgs;
+}
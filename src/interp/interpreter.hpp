@@ -0,0 +1,289 @@
+#ifndef INTERPRETER_HPP
+#define INTERPRETER_HPP
+
+#include "ast/node.hpp"
+#include "ast/nodeVisitor.hpp"
+#include "ast/symbol.hpp"
+#include "ast/type.hpp"
+#include "diag/diag.hpp"
+#include "jit/jit.hpp"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/Module.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/**
+ * Runs a VSL program by walking its AST, which starts running much sooner than
+ * compiling it would. Calls to each function are counted, and once a function
+ * gets hot it's compiled with the JIT and its compiled code is called from then
+ * on. VSL doesn't have loops, so calls are the only way code can run more than
+ * once.
+ *
+ * Only Int and Bool values are interpreted. Functions that use anything else,
+ * e.g. objects, are compiled the first time they're called instead, and use the
+ * interpreter's global variables. Programs with global variables that can't be
+ * interpreted are compiled up front.
+ *
+ * Expressions are walked with an explicit stack, so they can be nested as
+ * deeply as the parser allows. Statements, and the bodies of the functions
+ * that an expression calls, are walked right away with walkNow().
+ *
+ * The AST has to have gone through IRGen first, which checks it for errors and
+ * generates the module that functions are compiled from.
+ */
+class Interpreter : public NodeVisitor<Interpreter>
+{
+public:
+    /**
+     * Creates an Interpreter.
+     *
+     * @param diag Diagnostics manager.
+     * @param jit Compiles the hot functions.
+     * @param module The module that IRGen generated for the AST.
+     * @param optimize Optimizes the module, right before it's first compiled.
+     * @param threshold How many calls it takes for a function to be compiled,
+     * or 0 to compile everything up front.
+     */
+    Interpreter(Diag& diag, JIT& jit, std::unique_ptr<llvm::Module> module,
+        std::function<void()> optimize, unsigned threshold);
+    /**
+     * Gets the program ready to run, and initializes its global variables.
+     *
+     * @param ast The program's global declarations.
+     *
+     * @returns True on success, false otherwise.
+     */
+    bool init(llvm::ArrayRef<DeclNode*> ast);
+    /**
+     * Calls a function, interpreting it or calling its compiled code.
+     *
+     * @param name The name of the function.
+     * @param args The arguments, with Bools as 0 or 1.
+     * @param value Where to put the return value, which is 0 for Void.
+     *
+     * @returns True on success, false otherwise.
+     */
+    bool call(llvm::StringRef name, llvm::ArrayRef<int32_t> args,
+        int32_t& value);
+    /**
+     * Gets the number of functions that have been compiled so far.
+     *
+     * @returns The number of compiled functions.
+     */
+    size_t getNumCompiled() const;
+    void visitVariable(VariableNode& node);
+    void visitBlock(BlockNode& node);
+    void visitEmpty(EmptyNode& node);
+    void visitIf(IfNode& node);
+    void visitReturn(ReturnNode& node);
+    void visitIdent(IdentNode& node);
+    void visitLiteral(LiteralNode& node);
+    void visitUnary(UnaryNode& node);
+    void visitBinary(BinaryNode& node);
+    void visitTernary(TernaryNode& node);
+    void visitCall(CallNode& node);
+    void visitArg(ArgNode& node);
+
+    /** The most arguments that compiled code can be called with. */
+    static constexpr size_t maxNativeArgs = 6;
+
+private:
+    /** Decides what can be interpreted. */
+    class Checker;
+    /**
+     * What an expression does next when it's walked, which it gets from
+     * getWalkState().
+     */
+    enum Step : unsigned
+    {
+        /** Nothing has been evaluated yet. */
+        START,
+        /** The operand of a unary operation is done. */
+        AFTER_OPERAND,
+        /** The lhs of a binary operation is done. */
+        AFTER_LHS,
+        /** The rhs of a binary operation is done. */
+        AFTER_RHS,
+        /** The condition of a ternary is done. */
+        AFTER_CONDITION,
+        /** The next argument of a call is done. */
+        AFTER_ARG
+    };
+    /**
+     * A function that can be called.
+     */
+    struct Func
+    {
+        /** The function's declaration. */
+        FuncInterfaceNode* node;
+        /** The function's body, or null if it's external. */
+        FunctionNode* body;
+        /** True if the body can be interpreted. */
+        bool interpretable;
+        /** Number of times the function was interpreted. */
+        unsigned calls;
+        /** Address of the compiled code, or null if not compiled yet. */
+        void* code;
+    };
+    /**
+     * A local variable or parameter.
+     */
+    struct Local
+    {
+        /** The variable's name. */
+        Symbol name;
+        /** The variable's value. */
+        int32_t value;
+        /** True if the variable is a Bool, false if it's an Int. */
+        bool isBool;
+    };
+    /**
+     * A global variable.
+     */
+    struct Global
+    {
+        /** The variable's type, either Int or Bool. */
+        const Type* type;
+        /**
+         * The variable's storage, which compiled code uses as well. A Bool
+         * only uses the first byte.
+         */
+        int32_t storage;
+    };
+    /**
+     * Calls a function, compiling it first if it's hot or can't be
+     * interpreted.
+     *
+     * @param func The function to call.
+     * @param args The arguments.
+     * @param value Where to put the return value.
+     *
+     * @returns True on success, false otherwise.
+     */
+    bool callFunc(Func& func, llvm::ArrayRef<int32_t> args, int32_t& value);
+    /**
+     * Interprets a function's body.
+     *
+     * @param func The function to interpret.
+     * @param args The arguments.
+     * @param value Where to put the return value.
+     *
+     * @returns True on success, false otherwise.
+     */
+    bool interpret(Func& func, llvm::ArrayRef<int32_t> args, int32_t& value);
+    /**
+     * Calls a function's compiled code.
+     *
+     * @param func The function to call.
+     * @param args The arguments.
+     *
+     * @returns The return value.
+     */
+    int32_t callCode(const Func& func, llvm::ArrayRef<int32_t> args);
+    /**
+     * Compiles a function, or finds it in the process if it's external.
+     *
+     * @param func The function to compile.
+     *
+     * @returns True on success, false otherwise.
+     */
+    bool compile(Func& func);
+    /**
+     * Optimizes the module and adds it to the JIT. Unless everything is
+     * compiled, global variables are linked to the interpreter's storage
+     * instead of being initialized again.
+     *
+     * @returns True on success, false otherwise.
+     */
+    bool addModule();
+    /**
+     * Evaluates an operand of an expression, and then walks the expression
+     * again once it's done.
+     *
+     * @param operand The operand to evaluate.
+     * @param node The expression that it belongs to.
+     * @param next The step that the expression continues with.
+     */
+    void walkOperand(Node& operand, Node& node, Step next);
+    /**
+     * Finds a local variable of the current function.
+     *
+     * @param name The name of the variable.
+     *
+     * @returns The variable, or null if there isn't one by that name.
+     */
+    Local* findLocal(Symbol name);
+    /**
+     * Gets the value of a global variable.
+     *
+     * @param global The variable.
+     *
+     * @returns The variable's value.
+     */
+    static int32_t load(const Global& global);
+    /**
+     * Assigns a global variable.
+     *
+     * @param global The variable.
+     * @param value The value to assign.
+     */
+    static void store(Global& global, int32_t value);
+    /**
+     * Checks if a type can be interpreted.
+     *
+     * @param type The type to check.
+     *
+     * @returns True if the type is Int or Bool, false otherwise.
+     */
+    static bool isScalar(const Type* type);
+    /**
+     * Checks if the interpreter can call a function at all, by interpreting it
+     * or calling compiled code.
+     *
+     * @param func The function to check.
+     *
+     * @returns True if the function can be called, false otherwise.
+     */
+    static bool isCallable(const Func& func);
+    /** Diagnostics manager. */
+    Diag& diag;
+    /** Compiles the hot functions. */
+    JIT& jit;
+    /** The module to compile from, or null if it was added to the JIT. */
+    std::unique_ptr<llvm::Module> module;
+    /** Optimizes the module. */
+    std::function<void()> optimize;
+    /** How many calls it takes for a function to be compiled. */
+    unsigned threshold;
+    /** True if the whole program is compiled instead of interpreted. */
+    bool compileAll;
+    /** Every function in the program. */
+    llvm::StringMap<Func> funcs;
+    /** Every global variable in the program. */
+    llvm::StringMap<Global> globals;
+    /** The local variables of every function being interpreted. */
+    std::vector<Local> locals;
+    /** Where the current function's locals start. */
+    size_t frameBase;
+    /**
+     * Operands that expressions being walked still need, including the
+     * arguments of calls.
+     */
+    std::vector<int32_t> pendingValues;
+    /** Where the arguments of each call being walked start, innermost last. */
+    std::vector<size_t> pendingCalls;
+    /** The value of the last expression, or the return value. */
+    int32_t result;
+    /** True if the result is a Bool, false if it's an Int. */
+    bool resultIsBool;
+    /** True if a return statement is unwinding the current function. */
+    bool returning;
+    /** True if something went wrong, which unwinds the whole program. */
+    bool failed;
+};
+
+#endif // INTERPRETER_HPP
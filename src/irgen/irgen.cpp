@@ -1,27 +1,358 @@
 #include "irgen/irgen.hpp"
+#include "irgen/passes/escapeAnalyzer/escapeAnalyzer.hpp"
 #include "irgen/passes/funcResolver/funcResolver.hpp"
+#include "irgen/passes/ownershipAnalyzer/ownershipAnalyzer.hpp"
 #include "irgen/passes/typeResolver/typeResolver.hpp"
 #include "irgen/passes/irEmitter/irEmitter.hpp"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Verifier.h"
+#include "llvm/Linker/Linker.h"
+#include "llvm/Support/Casting.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
-IRGen::IRGen(VSLContext& vslCtx, Diag& diag, llvm::Module& module)
-    : vslCtx{ vslCtx }, diag{ diag }, module{ module },
-    converter{ module.getContext() }
+namespace
 {
+
+/**
+ * Emits some of the global declarations into a separate LLVMContext, so that
+ * it can run alongside other Workers.
+ */
+class Worker
+{
+public:
+    /** The name of a global and the linkage it was emitted with. */
+    using Linkage = std::pair<std::string, llvm::GlobalValue::LinkageTypes>;
+    /**
+     * Creates a Worker.
+     *
+     * @param vslCtx Context object for VSL stuff.
+     * @param srcMgr Used to print diagnostics.
+     * @param mainModule The module that will get the result. Its target info
+     * is copied.
+     * @param options What kind of code to emit.
+     * @param mainGlobal The main module's global scope, which already has all
+     * the global variables.
+     * @param begin Index of the first global declaration to emit.
+     * @param end Index one past the last global declaration to emit.
+     */
+    Worker(VSLContext& vslCtx, const SourceManager* srcMgr,
+        const llvm::Module& mainModule, const IRGenOptions& options,
+        const GlobalScope& mainGlobal, size_t begin, size_t end);
+    /**
+     * Declares all the types and functions in the Worker's own module. This
+     * isn't thread safe since it can modify the AST.
+     */
+    void declare();
+    /**
+     * Emits the declarations and serializes the module. This can run alongside
+     * other Workers.
+     */
+    void emit();
+    /**
+     * Gets the emitted module, serialized as bitcode.
+     *
+     * @returns The serialized module.
+     */
+    llvm::MemoryBufferRef getBitcode() const;
+    /**
+     * Gets the original linkage of every function that had to be made
+     * external so it could be linked with the other modules.
+     *
+     * @returns The functions' names and linkages.
+     */
+    llvm::ArrayRef<Linkage> getLinkages() const;
+    /**
+     * Passes on all the diagnostics that were printed.
+     *
+     * @param mainDiag Where to print them.
+     */
+    void flushDiags(Diag& mainDiag);
+
+private:
+    /**
+     * Declares a global variable that was emitted into the main module, if it
+     * was valid.
+     *
+     * @param node The global variable.
+     */
+    void declareVar(const VariableNode& node);
+    /** Context object for VSL stuff. */
+    VSLContext& vslCtx;
+    /** What kind of code to emit. */
+    const IRGenOptions& options;
+    /** The main module's global scope. */
+    const GlobalScope& mainGlobal;
+    /** Index of the first global declaration to emit. */
+    size_t begin;
+    /** Index one past the last global declaration to emit. */
+    size_t end;
+    /** Diagnostics are buffered here until the Worker is done. */
+    std::string diagText;
+    /** Writes to diagText. */
+    llvm::raw_string_ostream diagStream;
+    /** Diagnostics manager. */
+    Diag diag;
+    /** Separate context so the Worker doesn't interfere with the others. */
+    llvm::LLVMContext llvmCtx;
+    /** Where to emit LLVM IR. */
+    std::unique_ptr<llvm::Module> module;
+    /** Function scope manager. */
+    FuncScope func;
+    /** Global scope manager. */
+    GlobalScope global;
+    /** VSL to LLVM type converter. */
+    TypeConverter converter;
+    /** The module, once it's been emitted. */
+    llvm::SmallVector<char, 0> bitcode;
+    /** Functions that were made external, to be restored after linking. */
+    std::vector<Linkage> linkages;
+};
+
+Worker::Worker(VSLContext& vslCtx, const SourceManager* srcMgr,
+    const llvm::Module& mainModule, const IRGenOptions& options,
+    const GlobalScope& mainGlobal, size_t begin, size_t end)
+    : vslCtx{ vslCtx }, options{ options }, mainGlobal{ mainGlobal },
+    begin{ begin }, end{ end }, diagStream{ diagText },
+    diag{ diagStream, srcMgr },
+    module{ std::make_unique<llvm::Module>(mainModule.getName(), llvmCtx) },
+    converter{ llvmCtx, options }
+{
+    module->setDataLayout(mainModule.getDataLayout());
+    module->setTargetTriple(mainModule.getTargetTriple());
 }
 
-void IRGen::run()
+void Worker::declare()
 {
-    // resolve type declarations
-    TypeResolver typeResolver{ vslCtx, converter, module };
+    // resolve everything the same way as the main module, except that any
+    //  errors have already been reported there
+    Diag quiet{ llvm::nulls() };
+    TypeResolver typeResolver{ vslCtx, converter, *module };
     typeResolver.visitAST(vslCtx.getGlobals());
-    // resolve global functions
-    FuncResolver funcResolver{ vslCtx, diag, global, converter, module };
+    FuncResolver funcResolver{ vslCtx, quiet, global, converter, *module };
     funcResolver.visitAST(vslCtx.getGlobals());
+}
+
+void Worker::emit()
+{
+    IREmitter irEmitter{ vslCtx, diag, func, global, converter, *module,
+        options };
+    llvm::ArrayRef<DeclNode*> globals = vslCtx.getGlobals();
+    for (size_t i = 0; i < end; ++i)
+    {
+        // global variables are only visible after they're declared, so they're
+        //  added to the scope in order
+        if (globals[i]->is(Node::VARIABLE))
+        {
+            declareVar(static_cast<const VariableNode&>(*globals[i]));
+        }
+        else if (i >= begin)
+        {
+            irEmitter.visit(*globals[i]);
+        }
+    }
+    // functions defined here may be called from other modules and vice versa,
+    //  which the linker only allows between external symbols
+    // internal ones keep their linkage in the end, so it's saved for later
+    for (llvm::Function& f : *module)
+    {
+        if (f.hasLocalLinkage())
+        {
+            linkages.emplace_back(f.getName().str(), f.getLinkage());
+        }
+        if (!f.isIntrinsic())
+        {
+            f.setLinkage(llvm::GlobalValue::ExternalLinkage);
+        }
+    }
+    llvm::raw_svector_ostream os{ bitcode };
+    llvm::WriteBitcodeToFile(module.get(), os);
+}
+
+void Worker::declareVar(const VariableNode& node)
+{
+    Value var = mainGlobal.get(node.getSymbol());
+    if (global.get(node.getSymbol()) || !var.isVar() ||
+        !llvm::isa<llvm::GlobalVariable>(var.getLLVMValue()))
+    {
+        // already reported by the main module
+        return;
+    }
+    auto* llvmVar = new llvm::GlobalVariable{ *module,
+        converter.convert(var.getVSLType()), /*isConstant=*/false,
+        llvm::GlobalValue::ExternalLinkage, /*Initializer=*/nullptr,
+        node.getName() };
+    global.setVar(node.getSymbol(), var.getVSLType(), llvmVar);
+}
+
+llvm::MemoryBufferRef Worker::getBitcode() const
+{
+    return { llvm::StringRef{ bitcode.data(), bitcode.size() },
+        module->getName() };
+}
+
+llvm::ArrayRef<Worker::Linkage> Worker::getLinkages() const
+{
+    return linkages;
+}
+
+void Worker::flushDiags(Diag& mainDiag)
+{
+    mainDiag.merge(diag, diagStream.str());
+}
+
+} // end anonymous namespace
+
+IRGen::IRGen(VSLContext& vslCtx, Diag& diag, llvm::Module& module,
+    const IRGenOptions& options)
+    : vslCtx{ vslCtx }, diag{ diag }, module{ module }, options{ options },
+    converter{ module.getContext(), options }
+{
+}
+
+void IRGen::run(unsigned jobs, TimeReport* timeReport)
+{
+    // resolve type declarations
+    {
+        TimeReport::Scope scope{ timeReport, "typeResolver" };
+        TypeResolver typeResolver{ vslCtx, converter, module };
+        typeResolver.visitAST(vslCtx.getGlobals());
+    }
+    // resolve global functions
+    {
+        TimeReport::Scope scope{ timeReport, "funcResolver" };
+        FuncResolver funcResolver{ vslCtx, diag, global, converter, module };
+        funcResolver.visitAST(vslCtx.getGlobals());
+    }
+    // find out which parameters can be borrowed
+    {
+        TimeReport::Scope scope{ timeReport, "ownershipAnalyzer" };
+        OwnershipAnalyzer ownershipAnalyzer;
+        ownershipAnalyzer.visitAST(vslCtx.getGlobals());
+    }
+    // find out which objects can be allocated on the stack
+    {
+        TimeReport::Scope scope{ timeReport, "escapeAnalyzer" };
+        EscapeAnalyzer escapeAnalyzer;
+        escapeAnalyzer.visitAST(vslCtx.getGlobals());
+    }
     // emit code for global functions
-    IREmitter irEmitter{ vslCtx, diag, func, global, converter, module };
-    irEmitter.visitAST(vslCtx.getGlobals());
+    {
+        TimeReport::Scope scope{ timeReport, "irEmitter" };
+        if (jobs > 1)
+        {
+            emitParallel(jobs);
+        }
+        else
+        {
+            IREmitter irEmitter{ vslCtx, diag, func, global, converter, module,
+                options };
+            irEmitter.visitAST(vslCtx.getGlobals());
+        }
+    }
     // the module should be valid after all this
+    TimeReport::Scope scope{ timeReport, "verify" };
+    verify();
+}
+
+void IRGen::emitParallel(unsigned jobs)
+{
+    llvm::ArrayRef<DeclNode*> globals = vslCtx.getGlobals();
+    // global variables all add to the same global ctor function, so they're
+    //  emitted here first
+    std::vector<size_t> bodies;
+    IREmitter irEmitter{ vslCtx, diag, func, global, converter, module,
+        options };
+    for (size_t i = 0; i < globals.size(); ++i)
+    {
+        if (globals[i]->is(Node::VARIABLE))
+        {
+            irEmitter.visit(*globals[i]);
+        }
+        else if (globals[i]->isNot(Node::EXTFUNC))
+        {
+            bodies.push_back(i);
+        }
+    }
+    // split the rest into contiguous chunks, so the diagnostics come out in
+    //  the same order as they would have otherwise
+    jobs = static_cast<unsigned>(std::min<size_t>(jobs, bodies.size()));
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (unsigned i = 0; i < jobs; ++i)
+    {
+        size_t begin = bodies[bodies.size() * i / jobs];
+        size_t end = bodies[bodies.size() * (i + 1) / jobs - 1] + 1;
+        workers.push_back(std::make_unique<Worker>(vslCtx,
+            diag.getSourceManager(), module, options, global, begin, end));
+        workers.back()->declare();
+    }
+    std::vector<std::thread> threads;
+    for (std::unique_ptr<Worker>& worker : workers)
+    {
+        threads.emplace_back([&worker] { worker->emit(); });
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    // the linker only resolves declarations against external symbols, so the
+    //  original linkage is saved and restored afterwards
+    // declarations get replaced by the linker, so this goes by name
+    std::vector<Worker::Linkage> linkages;
+    for (llvm::GlobalValue& value : module.global_values())
+    {
+        if (value.hasLocalLinkage())
+        {
+            linkages.emplace_back(value.getName().str(), value.getLinkage());
+            value.setLinkage(llvm::GlobalValue::ExternalLinkage);
+        }
+    }
+    for (std::unique_ptr<Worker>& worker : workers)
+    {
+        worker->flushDiags(diag);
+        // the workers' modules belong to different LLVMContexts, so they have
+        //  to be loaded into this one first
+        llvm::Expected<std::unique_ptr<llvm::Module>> part =
+            llvm::parseBitcodeFile(worker->getBitcode(), module.getContext());
+        if (!part)
+        {
+            diag.print<Diag::LLVM_LINK_ERROR>(
+                llvm::toString(part.takeError()));
+            continue;
+        }
+        if (llvm::Linker::linkModules(module, std::move(*part)))
+        {
+            diag.print<Diag::LLVM_LINK_ERROR>(
+                std::string{ "conflicting symbols" });
+        }
+        // the worker had to make its own internal functions external too
+        llvm::ArrayRef<Worker::Linkage> workerLinkages = worker->getLinkages();
+        linkages.insert(linkages.end(), workerLinkages.begin(),
+            workerLinkages.end());
+    }
+    for (auto& linkage : linkages)
+    {
+        if (llvm::GlobalValue* value = module.getNamedValue(linkage.first))
+        {
+            value->setLinkage(linkage.second);
+        }
+    }
+}
+
+void IRGen::verify()
+{
     std::string s;
     llvm::raw_string_ostream sos{ s };
     if (llvm::verifyModule(module, &sos))
@@ -3,6 +3,8 @@
 
 #include "ast/vslContext.hpp"
 #include "diag/diag.hpp"
+#include "diag/timeReport.hpp"
+#include "irgen/irgenOptions.hpp"
 #include "irgen/scope/funcScope.hpp"
 #include "irgen/scope/globalScope.hpp"
 #include "irgen/typeConverter/typeConverter.hpp"
@@ -21,21 +23,41 @@ public:
      * @param vslCtx Context object for VSL stuff.
      * @param diag Diagnostics manager.
      * @param module Where to emit LLVM IR.
+     * @param options What kind of code to emit.
      */
-    IRGen(VSLContext& vslCtx, Diag& diag, llvm::Module& module);
+    IRGen(VSLContext& vslCtx, Diag& diag, llvm::Module& module,
+        const IRGenOptions& options = {});
     /**
      * Runs all the AST passes, converting the AST stored in the VSLContext to
      * LLVM IR in the Module.
+     *
+     * @param jobs How many threads to emit function bodies on. If more than
+     * one, each thread emits into its own LLVMContext and the results are then
+     * linked into the Module.
+     * @param timeReport Where to add the time each pass takes, or null.
      */
-    void run();
+    void run(unsigned jobs = 1, TimeReport* timeReport = nullptr);
 
 private:
+    /**
+     * Emits function bodies on multiple threads. Types, function declarations
+     * and global variables must already be in the Module.
+     *
+     * @param jobs How many threads to use.
+     */
+    void emitParallel(unsigned jobs);
+    /**
+     * Verifies the Module, printing a diagnostic if something's wrong.
+     */
+    void verify();
     /** Context object for VSL stuff. */
     VSLContext& vslCtx;
     /** Diagnostics manager. */
     Diag& diag;
     /** Where to emit LLVM IR. */
     llvm::Module& module;
+    /** What kind of code to emit. */
+    IRGenOptions options;
     /** Function scope manager. */
     FuncScope func;
     /** Global scope manager. */
@@ -0,0 +1,52 @@
+#ifndef IRGENOPTIONS_HPP
+#define IRGENOPTIONS_HPP
+
+/**
+ * Options that change the kind of code that IRGen emits.
+ */
+struct IRGenOptions
+{
+    /**
+     * Ways that class objects can be allocated.
+     */
+    enum Allocator
+    {
+        /** Use malloc and free from libc. */
+        MALLOC,
+        /**
+         * Use the size-class pool allocator from the VSL runtime, which has to
+         * be linked into the program. Objects too big for any size class
+         * still use malloc.
+         */
+        POOL
+    };
+    /** How class objects get allocated. */
+    Allocator allocator = MALLOC;
+    /**
+     * Ways that reference counts can be updated.
+     */
+    enum Refcount
+    {
+        /**
+         * Use plain loads and stores, which is fastest but means objects can't
+         * be shared between threads.
+         */
+        NONATOMIC,
+        /**
+         * Use atomic instructions, with relaxed increments and acq_rel
+         * decrements, so any object can be shared between threads.
+         */
+        ATOMIC,
+        /**
+         * Use biased reference counting from the VSL runtime, which has to be
+         * linked into the program. The thread that created an object can
+         * update its refcount without atomics, and any other thread uses an
+         * atomic counter of its own.
+         */
+        BIASED
+    };
+    /** How reference counts get updated. */
+    Refcount refcount = NONATOMIC;
+};
+
+#endif // IRGENOPTIONS_HPP
@@ -0,0 +1,276 @@
+#include "ast/opKind.hpp"
+#include "irgen/passes/escapeAnalyzer/escapeAnalyzer.hpp"
+
+EscapeAnalyzer::EscapeAnalyzer()
+    : changed{ false }, func{ nullptr }
+{
+}
+
+void EscapeAnalyzer::visitAST(llvm::ArrayRef<DeclNode*> ast)
+{
+    // find everything that can be called
+    for (DeclNode* decl : ast)
+    {
+        if (decl->is(Node::FUNCTION) || decl->is(Node::EXTFUNC))
+        {
+            auto* f = static_cast<FuncInterfaceNode*>(decl);
+            funcs.try_emplace(f->getName(), f);
+        }
+        else if (decl->is(Node::CLASS))
+        {
+            auto* c = static_cast<ClassNode*>(decl);
+            if (c->hasCtor())
+            {
+                funcs.try_emplace(c->getName(), &c->getCtor());
+            }
+            for (MethodNode* method : c->getMethods())
+            {
+                methods[method->getName()].push_back(method);
+            }
+        }
+    }
+    // things only ever start escaping, so this has to stop eventually
+    do
+    {
+        changed = false;
+        NodeVisitor::visitAST(ast);
+    }
+    while (changed);
+}
+
+void EscapeAnalyzer::visitFunction(FunctionNode& node)
+{
+    func = &node;
+    visit(node.getBody());
+    // objects stored in variables can only stay on the stack if the variable
+    //  doesn't escape
+    for (auto& local : locals)
+    {
+        if (escapingNames.count(local.second))
+        {
+            local.first->setStackAllocated(false);
+        }
+    }
+    locals.clear();
+    escapingNames.clear();
+    func = nullptr;
+}
+
+void EscapeAnalyzer::visitVariable(VariableNode& node)
+{
+    if (func && node.getInit().is(Node::CALL))
+    {
+        // the object lives in the variable, which decides whether it escapes
+        visitExpr(node.getInit(), false);
+        locals.emplace_back(static_cast<CallNode*>(&node.getInit()),
+            node.getName());
+    }
+    else
+    {
+        // anything else is copied into the variable, which is as good as
+        //  escaping since the variable isn't tracked any further
+        visitExpr(node.getInit(), true);
+    }
+}
+
+void EscapeAnalyzer::visitClass(ClassNode& node)
+{
+    if (node.hasCtor())
+    {
+        visit(node.getCtor());
+    }
+    for (MethodNode* method : node.getMethods())
+    {
+        visit(*method);
+    }
+}
+
+void EscapeAnalyzer::visitMethod(MethodNode& node)
+{
+    visitFunction(node);
+}
+
+void EscapeAnalyzer::visitCtor(CtorNode& node)
+{
+    visitFunction(node);
+}
+
+void EscapeAnalyzer::visitBlock(BlockNode& node)
+{
+    for (Node* statement : node.getStatements())
+    {
+        if (statement->isExpr())
+        {
+            // the value of an expression statement is discarded right away
+            visitExpr(static_cast<ExprNode&>(*statement), false);
+        }
+        else
+        {
+            visit(*statement);
+        }
+    }
+}
+
+void EscapeAnalyzer::visitIf(IfNode& node)
+{
+    visitExpr(node.getCondition(), false);
+    visit(node.getThen());
+    if (node.hasElse())
+    {
+        visit(node.getElse());
+    }
+}
+
+void EscapeAnalyzer::visitReturn(ReturnNode& node)
+{
+    if (node.hasValue())
+    {
+        visitExpr(node.getValue(), true);
+    }
+}
+
+void EscapeAnalyzer::visitIdent(IdentNode& node)
+{
+    if (!getWalkState() || !func)
+    {
+        return;
+    }
+    escapingNames.insert(node.getName());
+    for (const ParamNode* param : func->getParams())
+    {
+        if (param->getSymbol() == node.getSymbol())
+        {
+            changed |= escapingParams.insert(param).second;
+        }
+    }
+}
+
+void EscapeAnalyzer::visitUnary(UnaryNode& node)
+{
+    visitExpr(node.getExpr(), false);
+}
+
+void EscapeAnalyzer::visitBinary(BinaryNode& node)
+{
+    if (node.getOp() != BinaryKind::ASSIGN)
+    {
+        visitExpr(node.getLhs(), false);
+        visitExpr(node.getRhs(), false);
+        return;
+    }
+    // whatever was in a reassigned variable gets destroyed, which can't be
+    //  done to a stack object
+    if (node.getLhs().is(Node::IDENT))
+    {
+        escapingNames.insert(static_cast<IdentNode&>(node.getLhs()).getName());
+    }
+    visitExpr(node.getLhs(), false);
+    visitExpr(node.getRhs(), true);
+}
+
+void EscapeAnalyzer::visitTernary(TernaryNode& node)
+{
+    // the result is a phi node, which the emitter can't tell is a stack object
+    //  when destroying it, so both sides are treated as escaping
+    visitExpr(node.getCondition(), false);
+    visitExpr(node.getThen(), true);
+    visitExpr(node.getElse(), true);
+}
+
+void EscapeAnalyzer::visitCall(CallNode& node)
+{
+    bool resultEscapes = getWalkState();
+    // resolve the callee
+    const FuncInterfaceNode* callee = nullptr;
+    if (node.getCallee().is(Node::IDENT))
+    {
+        auto it = funcs.find(
+            static_cast<IdentNode&>(node.getCallee()).getName());
+        if (it != funcs.end())
+        {
+            callee = it->getValue();
+        }
+    }
+    else
+    {
+        visitExpr(node.getCallee(), true);
+    }
+    // a constructed object stays on the stack if neither the caller nor the
+    //  constructor lets it escape
+    // this is decided again every round, so the last one has the final say
+    if (callee && callee->is(Node::CTOR))
+    {
+        node.setStackAllocated(!resultEscapes && !escapingSelves.count(
+                static_cast<const CtorNode*>(callee)));
+    }
+    for (size_t i = 0; i < node.getNumArgs(); ++i)
+    {
+        visitExpr(node.getArg(i).getValue(), argEscapes(callee, i));
+    }
+}
+
+void EscapeAnalyzer::visitArg(ArgNode& node)
+{
+    visitExpr(node.getValue(), getWalkState());
+}
+
+void EscapeAnalyzer::visitFieldAccess(FieldAccessNode& node)
+{
+    visitExpr(node.getObject(), false);
+}
+
+void EscapeAnalyzer::visitMethodCall(MethodCallNode& node)
+{
+    auto it = methods.find(node.getMethod());
+    if (it == methods.end())
+    {
+        // unknown method, so everything escapes
+        visitExpr(node.getCallee(), true);
+        for (ArgNode* arg : node.getArgs())
+        {
+            visitExpr(arg->getValue(), true);
+        }
+        return;
+    }
+    // any method with this name could be the one being called
+    bool selfEscapes = false;
+    for (const MethodNode* method : it->getValue())
+    {
+        selfEscapes |= escapingSelves.count(method) != 0;
+    }
+    visitExpr(node.getCallee(), selfEscapes);
+    for (size_t i = 0; i < node.getNumArgs(); ++i)
+    {
+        bool escapes = false;
+        for (const MethodNode* method : it->getValue())
+        {
+            escapes |= argEscapes(method, i);
+        }
+        visitExpr(node.getArg(i).getValue(), escapes);
+    }
+}
+
+void EscapeAnalyzer::visitSelf(SelfNode& node)
+{
+    if (getWalkState() && func)
+    {
+        changed |= escapingSelves.insert(func).second;
+    }
+}
+
+void EscapeAnalyzer::visitExpr(ExprNode& node, bool escapes)
+{
+    walk(node, escapes);
+}
+
+bool EscapeAnalyzer::argEscapes(const FuncInterfaceNode* callee,
+    size_t i) const
+{
+    // external functions could do anything with their arguments
+    if (!callee || callee->is(Node::EXTFUNC))
+    {
+        return true;
+    }
+    return i >= callee->getNumParams() ||
+        escapingParams.count(callee->getParams()[i]);
+}
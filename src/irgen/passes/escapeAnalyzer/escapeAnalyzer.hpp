@@ -0,0 +1,95 @@
+#ifndef ESCAPEANALYZER_HPP
+#define ESCAPEANALYZER_HPP
+
+#include "ast/node.hpp"
+#include "ast/nodeVisitor.hpp"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringSet.h"
+#include <utility>
+#include <vector>
+
+/**
+ * Finds the constructor calls whose objects never escape the calling function,
+ * so that they can be allocated on the stack instead of the heap.
+ *
+ * An object escapes if it's returned, stored anywhere, or passed to a
+ * parameter that escapes. Functions are summarized by which of their
+ * parameters (including `self`) escape, which is iterated until nothing
+ * changes so that recursive functions work out. External functions and
+ * anything that can't be resolved are assumed to let everything escape.
+ * Since the AST isn't typed yet, a method call is assumed to call any method
+ * with the same name.
+ */
+class EscapeAnalyzer : public NodeVisitor<EscapeAnalyzer>
+{
+public:
+    /**
+     * Creates an EscapeAnalyzer.
+     */
+    EscapeAnalyzer();
+    void visitAST(llvm::ArrayRef<DeclNode*> ast);
+    void visitFunction(FunctionNode& node);
+    void visitVariable(VariableNode& node);
+    void visitClass(ClassNode& node);
+    void visitMethod(MethodNode& node);
+    void visitCtor(CtorNode& node);
+    void visitBlock(BlockNode& node);
+    void visitIf(IfNode& node);
+    void visitReturn(ReturnNode& node);
+    void visitIdent(IdentNode& node);
+    void visitUnary(UnaryNode& node);
+    void visitBinary(BinaryNode& node);
+    void visitTernary(TernaryNode& node);
+    void visitCall(CallNode& node);
+    void visitArg(ArgNode& node);
+    void visitFieldAccess(FieldAccessNode& node);
+    void visitMethodCall(MethodCallNode& node);
+    void visitSelf(SelfNode& node);
+
+private:
+    /**
+     * Visits an expression, with an explicit stack so that arbitrarily deep
+     * ones can be analyzed. The visit methods get whether the expression they
+     * visit escapes from getWalkState().
+     *
+     * @param node The expression to visit.
+     * @param escapes Whether the expression's value could escape.
+     */
+    void visitExpr(ExprNode& node, bool escapes);
+    /**
+     * Checks whether an argument could escape through a callee.
+     *
+     * @param callee The function being called, or null if unknown.
+     * @param i Index of the argument.
+     *
+     * @returns True if it could escape, false otherwise.
+     */
+    bool argEscapes(const FuncInterfaceNode* callee, size_t i) const;
+    /** Functions and constructors that can be called by name. */
+    llvm::StringMap<FuncInterfaceNode*> funcs;
+    /** Methods of every class, by name. */
+    llvm::StringMap<std::vector<MethodNode*>> methods;
+    /** Parameters that could escape their function. */
+    llvm::DenseSet<const ParamNode*> escapingParams;
+    /** Methods and constructors whose `self` could escape. */
+    llvm::DenseSet<const FunctionNode*> escapingSelves;
+    /** Whether anything new was found to escape in the current round. */
+    bool changed;
+    /** The function being analyzed, or null if in the global scope. */
+    const FunctionNode* func;
+    /**
+     * Names in the current function that escape or are reassigned. Shadowing
+     * is ignored, which can only make this more conservative.
+     */
+    llvm::StringSet<> escapingNames;
+    /**
+     * Constructor calls that initialize a local variable, which can only be
+     * stack allocated if that variable doesn't escape either.
+     */
+    std::vector<std::pair<CallNode*, llvm::StringRef>> locals;
+};
+
+#endif // ESCAPEANALYZER_HPP
@@ -23,7 +23,7 @@ void FuncResolver::visitFunction(FunctionNode& node)
     const FunctionType* ft = vslCtx.getFunctionType(node);
     llvm::Function* llvmFunc = createFunc(node.getAccess(), ft, node.getName());
     // add to global scope
-    global.setFunc(node.getName(), ft, llvmFunc);
+    global.setFunc(node.getSymbol(), ft, llvmFunc);
 }
 
 void FuncResolver::visitExtFunc(ExtFuncNode& node)
@@ -40,7 +40,7 @@ void FuncResolver::visitExtFunc(ExtFuncNode& node)
     // add to global scope using the function name
     // the function is referred to by its real name in VSL and by its alias name
     //  in the LLVM IR or everywhere else that isn't VSL.
-    global.setFunc(node.getName(), ft, llvmFunc);
+    global.setFunc(node.getSymbol(), ft, llvmFunc);
 }
 
 void FuncResolver::visitClass(ClassNode& node)
@@ -48,12 +48,12 @@ void FuncResolver::visitClass(ClassNode& node)
     // declare constructor
     if (node.hasCtor())
     {
-        node.getCtor().accept(*this);
+        visit(node.getCtor());
     }
     // declare methods
     for (MethodNode* method : node.getMethods())
     {
-        method->accept(*this);
+        visit(*method);
     }
     // declare destructor
     declareDtor(node);
@@ -84,13 +84,13 @@ void FuncResolver::visitMethod(MethodNode& node)
         mergeAccess(parent.getAccess(), node.getAccess()), ft,
         llvm::Twine{ parent.getName() } + llvm::Twine{ '.' } + node.getName());
     // register the method in the global scope
-    global.setMethod(parent.getType(), node.getName(), ft, llvmFunc,
+    global.setMethod(parent.getType(), node.getSymbol(), ft, llvmFunc,
         node.getAccess());
 }
 
 bool FuncResolver::verifyFuncName(const FuncInterfaceNode& node) const
 {
-    if (global.get(node.getName()))
+    if (global.get(node.getSymbol()))
     {
         diag.print<Diag::FUNC_ALREADY_DEFINED>(node);
         return true;
@@ -14,7 +14,7 @@
  * Resolves functions in the global scope to allow calling them without stuff
  * like C's forward declarations.
  */
-class FuncResolver : public NodeVisitor
+class FuncResolver : public NodeVisitor<FuncResolver>
 {
 public:
     /**
@@ -28,12 +28,11 @@ public:
      */
     FuncResolver(VSLContext& vslCtx, Diag& diag, GlobalScope& global,
         TypeConverter& converter, llvm::Module& module);
-    virtual ~FuncResolver() override = default;
-    virtual void visitFunction(FunctionNode& node) override;
-    virtual void visitExtFunc(ExtFuncNode& node) override;
-    virtual void visitClass(ClassNode& node) override;
-    virtual void visitCtor(CtorNode& node) override;
-    virtual void visitMethod(MethodNode& node) override;
+    void visitFunction(FunctionNode& node);
+    void visitExtFunc(ExtFuncNode& node);
+    void visitClass(ClassNode& node);
+    void visitCtor(CtorNode& node);
+    void visitMethod(MethodNode& node);
 
 private:
     /**
@@ -1,8 +1,10 @@
 #include "ast/opKind.hpp"
 #include "irgen/passes/irEmitter/irEmitter.hpp"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/IR/BasicBlock.h"
 #include "llvm/IR/Function.h"
 #include "llvm/Support/Casting.h"
+#include "vslrt.h"
 #include <cassert>
 #include <initializer_list>
 #include <iterator>
@@ -12,18 +14,26 @@
 #include <vector>
 
 IREmitter::IREmitter(VSLContext& vslCtx, Diag& diag, FuncScope& func,
-    GlobalScope& global, TypeConverter& converter, llvm::Module& module)
+    GlobalScope& global, TypeConverter& converter, llvm::Module& module,
+    const IRGenOptions& options)
     : vslCtx{ vslCtx }, diag{ diag }, func{ func }, global{ global },
     converter{ converter }, module{ module }, llvmCtx{ module.getContext() },
-    builder{ llvmCtx }, allocaInsertPoint{ nullptr }, vslCtor{ nullptr },
-    vslDtor{ nullptr }
+    options{ options }, builder{ llvmCtx }, allocaInsertPoint{ nullptr },
+    vslCtor{ nullptr }, vslDtor{ nullptr }
 {
 }
 
+void IREmitter::walkOperand(Node& operand, Node& node, Step next)
+{
+    // the operand is visited first, along with everything that it walks
+    walk(operand);
+    walk(node, next);
+}
+
 void IREmitter::visitFunction(FunctionNode& node)
 {
     // setup parameters/scope and stuff
-    Value funcVal = global.get(node.getName());
+    Value funcVal = global.get(node.getSymbol());
     setupFuncBody(node, funcVal);
     func.setReturnType(node.getReturnType());
     // generate the function body
@@ -51,7 +61,16 @@ void IREmitter::visitVariable(VariableNode& node)
         builder.SetInsertPoint(&ctor->back());
     }
     // generate initialization code
-    node.getInit().accept(*this);
+    walk(node.getInit());
+    // a variable can only own a new object, never a copy of another variable
+    bool ownsStackObject = result.isExpr() && isStackObject(result);
+    // a copy of a borrowed parameter would be the same SSA value, which makes
+    //  it look borrowed too, so it needs storage of its own to be destroyed
+    bool copiesBorrowed = result.isLet() &&
+        borrowedParams.count(result.getLLVMValue());
+    // variables that are never reassigned can just use the value of the
+    //  initializer directly instead of going through memory
+    bool isLet = !isGlobal() && !node.isReassigned() && !copiesBorrowed;
     Value init = copyValue(result);
     result = Value::getNull();
     // validate the initializer expression
@@ -95,7 +114,7 @@ void IREmitter::visitVariable(VariableNode& node)
         {
             // create the global variable
             llvm::GlobalVariable* var = genGlobalVar(node.getAccess(),
-                node.getType(), llvmType, node.getName());
+                node.getType(), llvmType, node.getSymbol());
             llvmValue = var;
             if (!var)
             {
@@ -114,6 +133,22 @@ void IREmitter::visitVariable(VariableNode& node)
                 builder.restoreIP(ip);
             }
         }
+        else if (isLet)
+        {
+            llvmValue = init.getLLVMValue();
+            if (llvm::isa<llvm::Instruction>(llvmValue) &&
+                !llvmValue->hasName())
+            {
+                llvmValue->setName(node.getName());
+            }
+            if (func.set(node.getSymbol(), Value::getLet(node.getType(),
+                        llvmValue)))
+            {
+                // variable was already defined!
+                diag.print<Diag::VAR_ALREADY_DEFINED>(node);
+                valid = false;
+            }
+        }
         else
         {
             // local vars only need to use an alloca instruction
@@ -121,7 +156,7 @@ void IREmitter::visitVariable(VariableNode& node)
                 node.getName());
             llvmValue = inst;
             // add to current scope
-            if (func.set(node.getName(), Value::getVar(node.getType(), inst)))
+            if (func.set(node.getSymbol(), Value::getVar(node.getType(), inst)))
             {
                 // variable was already defined!
                 diag.print<Diag::VAR_ALREADY_DEFINED>(node);
@@ -132,7 +167,16 @@ void IREmitter::visitVariable(VariableNode& node)
         // store the variable if everything's still fine
         if (valid)
         {
-            storeValue(init, Value::getVar(node.getType(), llvmValue));
+            if (!isLet)
+            {
+                storeValue(init, Value::getVar(node.getType(), llvmValue));
+            }
+            if (ownsStackObject)
+            {
+                // the variable owns the object, so it has to be destroyed
+                //  without freeing it
+                stackVars.insert(llvmValue);
+            }
         }
     }
     // post-init code
@@ -149,12 +193,12 @@ void IREmitter::visitClass(ClassNode& node)
     // generate constructor
     if (node.hasCtor())
     {
-        node.getCtor().accept(*this);
+        visit(node.getCtor());
     }
     // generate methods
     for (MethodNode* method : node.getMethods())
     {
-        method->accept(*this);
+        visit(*method);
     }
     // generate destructor
     generateDtor(node);
@@ -164,7 +208,7 @@ void IREmitter::visitMethod(MethodNode& node)
 {
     ClassNode& parent = node.getParent();
     // setup the body
-    Value funcVal = global.getMethod(parent.getType(), node.getName()).first;
+    Value funcVal = global.getMethod(parent.getType(), node.getSymbol()).first;
     if (!funcVal)
     {
         // something bad happened
@@ -214,7 +258,7 @@ void IREmitter::visitBlock(BlockNode& node)
             diag.print<Diag::UNREACHABLE>(*statement);
             break;
         }
-        statement->accept(*this);
+        visit(*statement);
         // check if this block is returning
         if (statement->is(Node::RETURN))
         {
@@ -246,7 +290,7 @@ void IREmitter::visitIf(IfNode& node)
     }
     // setup the condition
     func.enter();
-    node.getCondition().accept(*this);
+    walk(node.getCondition());
     if (!result)
     {
         return;
@@ -287,7 +331,7 @@ void IREmitter::visitIf(IfNode& node)
     func.enter();
     thenBlock->insertInto(currentFunc);
     builder.SetInsertPoint(thenBlock);
-    node.getThen().accept(*this);
+    visit(node.getThen());
     // cleanup
     destroyValue(result);
     if (node.getThen().isNot(Node::RETURN))
@@ -303,7 +347,7 @@ void IREmitter::visitIf(IfNode& node)
         func.enter();
         elseBlock->insertInto(currentFunc);
         builder.SetInsertPoint(elseBlock);
-        node.getElse().accept(*this);
+        visit(node.getElse());
         // cleanup
         destroyValue(result);
         if (node.getElse().isNot(Node::RETURN))
@@ -347,13 +391,19 @@ void IREmitter::visitReturn(ReturnNode& node)
         return;
     }
     // validate the return value
-    node.getValue().accept(*this);
+    size_t numErrors = diag.getNumErrors();
+    walk(node.getValue());
     Value value = copyValue(result);
     result = Value::getNull();
     // cleanup
     destroyAllVars();
     // type checking
-    if (value)
+    if (!value && diag.getNumErrors() == numErrors)
+    {
+        // e.g. an assignment, which doesn't have a value but isn't an error
+        diag.print<Diag::CANT_RETURN_VOID_VALUE>(node);
+    }
+    else if (value)
     {
         if (value.getVSLType() != func.getReturnType())
         {
@@ -407,12 +457,19 @@ void IREmitter::visitLiteral(LiteralNode& node)
 
 void IREmitter::visitUnary(UnaryNode& node)
 {
-    // verify the contained expression
-    node.getExpr().accept(*this);
-    if (!result)
+    if (getWalkState() == START)
     {
-        return;
+        walkOperand(node.getExpr(), node, AFTER_OPERAND);
     }
+    else if (result)
+    {
+        genUnaryOp(node);
+    }
+}
+
+void IREmitter::genUnaryOp(UnaryNode& node)
+{
+    // the contained expression was already generated
     Value value = result;
     Value loaded = loadValue(value);
     // choose the appropriate operator to generate code for
@@ -420,12 +477,11 @@ void IREmitter::visitUnary(UnaryNode& node)
     {
     case UnaryKind::NOT:
         // should only be valid on booleans
-        if (value.getVSLType() != vslCtx.getBoolType())
-        {
-            result = Value::getNull();
-            break;
-        }
-        // fallthrough
+        result = value.getVSLType() == vslCtx.getBoolType() ?
+            Value::getExpr(value.getVSLType(),
+                builder.CreateNot(loaded.getLLVMValue(), "not")) :
+            Value::getNull();
+        break;
     case UnaryKind::MINUS:
         genNeg(loaded);
         break;
@@ -443,27 +499,44 @@ void IREmitter::visitUnary(UnaryNode& node)
 
 void IREmitter::visitBinary(BinaryNode& node)
 {
-    // special case: variable assignment
-    if (node.getOp() == BinaryKind::ASSIGN)
+    switch (node.getOp())
     {
+    // special case: variable assignment
+    case BinaryKind::ASSIGN:
         genAssign(node);
-        return;
-    }
+        break;
     // special case: short-circuiting boolean operations
-    if (node.getOp() == BinaryKind::AND || node.getOp() == BinaryKind::OR)
-    {
+    case BinaryKind::AND:
+    case BinaryKind::OR:
         genShortCircuit(node);
-        return;
+        break;
+    default:
+        genBinaryOp(node);
     }
-    // verify the left and right expressions
-    node.getLhs().accept(*this);
-    if (!result)
+}
+
+void IREmitter::genBinaryOp(BinaryNode& node)
+{
+    switch (getWalkState())
     {
+    case START:
+        walkOperand(node.getLhs(), node, AFTER_LHS);
+        return;
+    case AFTER_LHS:
+        if (result)
+        {
+            // the lhs is loaded before any of the rhs code
+            pendingValues.push_back(result);
+            pendingValues.push_back(loadValue(result));
+            walkOperand(node.getRhs(), node, AFTER_RHS);
+        }
         return;
+    default:
+        break;
     }
-    Value lhs = result;
-    Value loadedLhs = loadValue(lhs);
-    node.getRhs().accept(*this);
+    // both operands were already generated
+    Value loadedLhs = pendingValues.pop_back_val();
+    Value lhs = pendingValues.pop_back_val();
     if (!result)
     {
         destroyValue(lhs);
@@ -530,108 +603,169 @@ void IREmitter::visitBinary(BinaryNode& node)
 
 void IREmitter::visitTernary(TernaryNode& node)
 {
-    // generate condition and make sure its a bool
-    node.getCondition().accept(*this);
-    if (!result)
+    switch (getWalkState())
     {
-        return;
+    case START:
+    {
+        // ternaries usually chain down the else case, e.g.
+        //  `a ? b : c ? d : e`, so the whole chain is emitted with one cont
+        //  block and phi node, walking the head of the chain each time
+        pendingTernaries.emplace_back();
+        PendingTernary& pending = pendingTernaries.back();
+        pending.chain.push_back(&node);
+        while (pending.chain.back()->getElse().is(Node::TERNARY))
+        {
+            pending.chain.push_back(
+                &static_cast<TernaryNode&>(pending.chain.back()->getElse()));
+        }
+        pending.contBlock = llvm::BasicBlock::Create(llvmCtx, "ternary.cont");
+        walkOperand(node.getCondition(), node, AFTER_CONDITION);
+        break;
     }
-    if (result.getVSLType() != vslCtx.getBoolType())
+    case AFTER_CONDITION:
     {
-        diag.print<Diag::CANNOT_CONVERT>(node.getCondition(),
-            *result.getVSLType(), *vslCtx.getBoolType());
-        return;
+        PendingTernary& pending = pendingTernaries.back();
+        TernaryNode& ternary = *pending.chain[pending.cases.size()];
+        // make sure the condition is a bool
+        if (!result)
+        {
+            finishTernary();
+            break;
+        }
+        if (result.getVSLType() != vslCtx.getBoolType())
+        {
+            diag.print<Diag::CANNOT_CONVERT>(ternary.getCondition(),
+                *result.getVSLType(), *vslCtx.getBoolType());
+            finishTernary();
+            break;
+        }
+        Value condition = result;
+        pending.conditions.push_back(condition);
+        // setup blocks
+        llvm::Function* currFunc = builder.GetInsertBlock()->getParent();
+        auto* thenBlock = llvm::BasicBlock::Create(llvmCtx, "ternary.then");
+        pending.elseBlock = llvm::BasicBlock::Create(llvmCtx, "ternary.else");
+        // branch based on the condition
+        builder.CreateCondBr(loadValue(condition).getLLVMValue(), thenBlock,
+            pending.elseBlock);
+        // generate then
+        thenBlock->insertInto(currFunc);
+        builder.SetInsertPoint(thenBlock);
+        walkOperand(ternary.getThen(), node, AFTER_THEN);
+        break;
     }
-    Value condition = result;
-    // setup blocks
-    llvm::BasicBlock* currBlock = builder.GetInsertBlock();
-    llvm::Function* currFunc = currBlock->getParent();
-    auto* thenBlock = llvm::BasicBlock::Create(llvmCtx, "ternary.then");
-    auto* elseBlock = llvm::BasicBlock::Create(llvmCtx, "ternary.else");
-    auto* contBlock = llvm::BasicBlock::Create(llvmCtx, "ternary.cont");
-    // branch based on the condition
-    builder.CreateCondBr(loadValue(condition).getLLVMValue(), thenBlock,
-        elseBlock);
-    // generate then
-    thenBlock->insertInto(currFunc);
-    builder.SetInsertPoint(thenBlock);
-    node.getThen().accept(*this);
-    Value thenCase = copyValue(result);
-    // make sure thenCase is valid before continuing
-    if (!thenCase)
+    case AFTER_THEN:
     {
-        // something bad happened
-        delete contBlock;
-        return;
+        PendingTernary& pending = pendingTernaries.back();
+        Value thenCase = copyValue(result);
+        // the else block is already branched to, so it goes in the function
+        //  either way
+        pending.elseBlock->insertInto(builder.GetInsertBlock()->getParent());
+        if (!thenCase)
+        {
+            finishTernary();
+            break;
+        }
+        pending.cases.emplace_back(thenCase, builder.GetInsertBlock());
+        branchTo(pending.contBlock);
+        // the next ternary in the chain, or the last else case, goes here
+        builder.SetInsertPoint(pending.elseBlock);
+        if (pending.cases.size() < pending.chain.size())
+        {
+            walkOperand(pending.chain[pending.cases.size()]->getCondition(),
+                node, AFTER_CONDITION);
+        }
+        else
+        {
+            walkOperand(pending.chain.back()->getElse(), node, AFTER_ELSE);
+        }
+        break;
     }
-    // we get a reference to the current block after generating code because an
-    //  expression can span multiple basic blocks, e.g. a ternary such as this
-    llvm::BasicBlock* thenEnd = builder.GetInsertBlock();
-    branchTo(contBlock);
-    // generate else
-    elseBlock->insertInto(currFunc);
-    builder.SetInsertPoint(elseBlock);
-    node.getElse().accept(*this);
-    Value elseCase = copyValue(result);
-    // make sure elseCase is valid before continuing
-    if (!elseCase)
+    default:
+    {
+        PendingTernary& pending = pendingTernaries.back();
+        Value elseCase = copyValue(result);
+        if (elseCase)
+        {
+            pending.cases.emplace_back(elseCase, builder.GetInsertBlock());
+            branchTo(pending.contBlock);
+        }
+        finishTernary();
+    }
+    }
+}
+
+void IREmitter::finishTernary()
+{
+    PendingTernary pending = std::move(pendingTernaries.back());
+    pendingTernaries.pop_back();
+    const llvm::SmallVectorImpl<TernaryNode*>& chain = pending.chain;
+    llvm::BasicBlock* contBlock = pending.contBlock;
+    llvm::Function* currFunc = builder.GetInsertBlock()->getParent();
+    // make sure every case is valid before continuing
+    if (pending.cases.size() != chain.size() + 1)
     {
+        // something bad happened
+        result = Value::getNull();
+        if (contBlock->use_empty())
+        {
+            delete contBlock;
+            return;
+        }
+        contBlock->insertInto(currFunc);
+        builder.SetInsertPoint(contBlock);
         return;
     }
-    llvm::BasicBlock* elseEnd = builder.GetInsertBlock();
-    branchTo(contBlock);
     // setup cont block for code that comes after
     contBlock->insertInto(currFunc);
     builder.SetInsertPoint(contBlock);
-    // do type checking to make sure everything's fine
-    if (thenCase.getVSLType() != elseCase.getVSLType())
+    // do type checking to make sure everything's fine, from the innermost
+    //  ternary outwards
+    const auto& cases = pending.cases;
+    const Type* type = cases.back().first.getVSLType();
+    for (size_t i = chain.size(); i-- > 0;)
     {
-        diag.print<Diag::TERNARY_TYPE_MISMATCH>(node, *thenCase.getVSLType(),
-            *elseCase.getVSLType());
-        result = Value::getNull();
-        return;
+        if (cases[i].first.getVSLType() != type)
+        {
+            diag.print<Diag::TERNARY_TYPE_MISMATCH>(*chain[i],
+                *cases[i].first.getVSLType(), *type);
+            result = Value::getNull();
+            return;
+        }
     }
     // bring it all together with a phi node
-    auto* phi = builder.CreatePHI(thenCase.getLLVMValue()->getType(), 2,
-        "ternary.phi");
-    phi->addIncoming(thenCase.getLLVMValue(), thenEnd);
-    phi->addIncoming(elseCase.getLLVMValue(), elseEnd);
-    result = Value::getExpr(thenCase.getVSLType(), phi);
+    auto* phi = builder.CreatePHI(cases.back().first.getLLVMValue()->getType(),
+        cases.size(), "ternary.phi");
+    for (const std::pair<Value, llvm::BasicBlock*>& c : cases)
+    {
+        phi->addIncoming(c.first.getLLVMValue(), c.second);
+    }
+    result = Value::getExpr(type, phi);
     // teardown
-    destroyValue(condition);
+    for (Value condition : pending.conditions)
+    {
+        destroyValue(condition);
+    }
 }
 
 void IREmitter::visitCall(CallNode& node)
 {
-    // make sure the callee is an actual function
-    node.getCallee().accept(*this);
-    if (!result)
-    {
-        return;
-    }
-    Value callee = result;
-    if (!callee.isFunc())
-    {
-        diag.print<Diag::NOT_A_FUNCTION>(node.getCallee(),
-            *callee.getVSLType());
-        result = Value::getNull();
-        return;
-    }
-    // call the function
-    createCall(node, loadValue(callee));
-    // teardown
-    destroyValue(callee);
+    genCall(node);
 }
 
 void IREmitter::visitArg(ArgNode& node)
 {
-    node.getValue().accept(*this);
+    walk(node.getValue());
 }
 
 void IREmitter::visitFieldAccess(FieldAccessNode& node)
 {
     // evaluate the object
-    node.getObject().accept(*this);
+    if (getWalkState() == START)
+    {
+        walkOperand(node.getObject(), node, AFTER_OPERAND);
+        return;
+    }
     if (!result)
     {
         // something bad happened while trying to resolve the object
@@ -698,36 +832,7 @@ void IREmitter::visitFieldAccess(FieldAccessNode& node)
 
 void IREmitter::visitMethodCall(MethodCallNode& node)
 {
-    // get the object to use as the self parameter
-    node.getCallee().accept(*this);
-    if (!result)
-    {
-        return;
-    }
-    Value selfArg = result;
-    // lookup the method
-    Value methodFunc;
-    Access access;
-    std::tie(methodFunc, access) =
-        global.getMethod(selfArg.getVSLType(), node.getMethod());
-    if (!methodFunc)
-    {
-        // method can't be found
-        diag.print<Diag::UNKNOWN_METHOD>(node, *selfArg.getVSLType());
-        result = Value::getNull();
-        return;
-    }
-    if (!canAccessMember(selfArg.getVSLType(), access))
-    {
-        // method can't be accessed
-        diag.print<Diag::PRIVATE_METHOD>(node, *selfArg.getVSLType());
-        result = Value::getNull();
-        return;
-    }
-    // call the method in a similar manner to CallNode except with the self arg
-    createCall(node, methodFunc, loadValue(selfArg));
-    // teardown
-    destroyValue(selfArg);
+    genCall(node);
 }
 
 void IREmitter::visitSelf(SelfNode& node)
@@ -751,14 +856,25 @@ void IREmitter::genAssign(BinaryNode& node)
 {
     ExprNode& lhs = node.getLhs();
     ExprNode& rhs = node.getRhs();
-    // evaluate rhs first
-    rhs.accept(*this);
-    Value rhsVal = result;
-    // copy first to separate lhs and rhs code
-    Value rhsCopy = copyValue(rhsVal);
-    result = Value::getNull();
-    // then try to evaluate lhs
-    lhs.accept(*this);
+    switch (getWalkState())
+    {
+    case START:
+        // evaluate rhs first
+        walkOperand(rhs, node, AFTER_RHS);
+        return;
+    case AFTER_RHS:
+        // copy first to separate lhs and rhs code
+        pendingValues.push_back(result);
+        pendingValues.push_back(copyValue(result));
+        result = Value::getNull();
+        // then try to evaluate lhs
+        walkOperand(lhs, node, AFTER_LHS);
+        return;
+    default:
+        break;
+    }
+    Value rhsCopy = pendingValues.pop_back_val();
+    Value rhsVal = pendingValues.pop_back_val();
     Value lhsVal = result;
     result = Value::getNull();
     // verify the lhs
@@ -805,50 +921,67 @@ void IREmitter::genShortCircuit(BinaryNode& node)
      * br cont
      *
      * cont:
-     * phi [false, currBlock], [cond2, longCheck] // if and
-     * phi [true, currBlock], [cond2, longCheck] // if or
+     * phi [false, currBlock], [cond2, longEnd] // if and
+     * phi [true, currBlock], [cond2, longEnd] // if or
+     *
+     * where longEnd is the block that longCheck ends up in, which is longCheck
+     * itself unless cond2 has control flow of its own
      */
-    // generate code to calculate cond1 (lhs)
     ExprNode& lhs = node.getLhs();
-    lhs.accept(*this);
-    if (!result)
+    ExprNode& rhs = node.getRhs();
+    llvm::Twine name = (node.getOp() == BinaryKind::AND) ? "and" : "or";
+    if (getWalkState() == START)
     {
+        // generate code to calculate cond1 (lhs)
+        walkOperand(lhs, node, AFTER_LHS);
         return;
     }
-    Value cond1 = result;
-    Value cond1Loaded = loadValue(cond1);
-    // of course, lhs has to be a bool for this to work
-    if (cond1.getVSLType() != vslCtx.getBoolType())
+    if (getWalkState() == AFTER_LHS)
     {
-        diag.print<Diag::CANNOT_CONVERT>(lhs, *cond1.getVSLType(),
-            *vslCtx.getBoolType());
-        result = Value::getNull();
-        destroyValue(cond1);
+        Value cond1 = result;
+        if (!cond1)
+        {
+            return;
+        }
+        Value cond1Loaded = loadValue(cond1);
+        // of course, lhs has to be a bool for this to work
+        if (cond1.getVSLType() != vslCtx.getBoolType())
+        {
+            diag.print<Diag::CANNOT_CONVERT>(lhs, *cond1.getVSLType(),
+                *vslCtx.getBoolType());
+            result = Value::getNull();
+            destroyValue(cond1);
+            return;
+        }
+        // helper variables so i don't have to type as much
+        auto* currBlock = builder.GetInsertBlock();
+        llvm::Function* currFunc = currBlock->getParent();
+        // setup blocks
+        auto* longCheck = llvm::BasicBlock::Create(llvmCtx, name + ".long");
+        auto* cont = llvm::BasicBlock::Create(llvmCtx, name + ".cont");
+        // create the branch
+        if (node.getOp() == BinaryKind::AND)
+        {
+            builder.CreateCondBr(cond1Loaded.getLLVMValue(), longCheck, cont);
+        }
+        else // or
+        {
+            builder.CreateCondBr(cond1Loaded.getLLVMValue(), cont, longCheck);
+        }
+        // the long check is when the operation did not short circuit, and
+        //  depends on the value of rhs to fully determine the result
+        longCheck->insertInto(currFunc);
+        builder.SetInsertPoint(longCheck);
+        // generate code to calculate cond2 (rhs)
+        pendingValues.push_back(cond1);
+        pendingBlocks.push_back(currBlock);
+        pendingBlocks.push_back(cont);
+        walkOperand(rhs, node, AFTER_RHS);
         return;
     }
-    // helper variables so i don't have to type as much
-    auto* currBlock = builder.GetInsertBlock();
-    llvm::Function* currFunc = currBlock->getParent();
-    // setup blocks
-    llvm::Twine name = (node.getOp() == BinaryKind::AND) ? "and" : "or";
-    auto* longCheck = llvm::BasicBlock::Create(llvmCtx, name + ".long");
-    auto* cont = llvm::BasicBlock::Create(llvmCtx, name + ".cont");
-    // create the branch
-    if (node.getOp() == BinaryKind::AND)
-    {
-        builder.CreateCondBr(cond1Loaded.getLLVMValue(), longCheck, cont);
-    }
-    else // or
-    {
-        builder.CreateCondBr(cond1Loaded.getLLVMValue(), cont, longCheck);
-    }
-    // the long check is when the operation did not short circuit, and depends
-    //  on the value of rhs to fully determine the result
-    longCheck->insertInto(currFunc);
-    builder.SetInsertPoint(longCheck);
-    // generate code to calculate cond2 (rhs)
-    ExprNode& rhs = node.getRhs();
-    rhs.accept(*this);
+    llvm::BasicBlock* cont = pendingBlocks.pop_back_val();
+    llvm::BasicBlock* currBlock = pendingBlocks.pop_back_val();
+    Value cond1 = pendingValues.pop_back_val();
     Value cond2 = result;
     if (!cond2)
     {
@@ -856,9 +989,11 @@ void IREmitter::genShortCircuit(BinaryNode& node)
         return;
     }
     Value cond2Loaded = loadValue(cond2);
+    // rhs can span multiple basic blocks if it short circuits too
+    llvm::BasicBlock* longEnd = builder.GetInsertBlock();
     // setup the cont block
     branchTo(cont);
-    cont->insertInto(currFunc);
+    cont->insertInto(longEnd->getParent());
     builder.SetInsertPoint(cont);
     // of course, rhs has to be a bool for this to work
     // the check happens later so that the cont block is neither a memory leak
@@ -878,7 +1013,7 @@ void IREmitter::genShortCircuit(BinaryNode& node)
     phi->addIncoming(builder.getInt1(node.getOp() == BinaryKind::OR),
         currBlock);
     // if it came from longCheck, then the result is determined by rhs
-    phi->addIncoming(cond2Loaded.getLLVMValue(), longCheck);
+    phi->addIncoming(cond2Loaded.getLLVMValue(), longEnd);
     // teardown
     destroyValue(cond1);
     destroyValue(cond2);
@@ -1003,7 +1138,7 @@ bool IREmitter::isGlobal() const
 }
 
 llvm::GlobalVariable* IREmitter::genGlobalVar(Access access,
-    const Type* vslType, llvm::Type* llvmType, llvm::StringRef name)
+    const Type* vslType, llvm::Type* llvmType, Symbol name)
 {
     // determine the linkage type
     llvm::GlobalValue::LinkageTypes linkage = accessToLinkage(access);
@@ -1011,7 +1146,7 @@ llvm::GlobalVariable* IREmitter::genGlobalVar(Access access,
     llvm::Constant* initializer = llvm::Constant::getNullValue(llvmType);
     // create the variable
     auto* var = new llvm::GlobalVariable{ module, llvmType,
-        /*isConstant=*/false, linkage, initializer, name };
+        /*isConstant=*/false, linkage, initializer, name.getName() };
     // add to global scope
     if (global.setVar(name, vslType, var))
     {
@@ -1081,12 +1216,10 @@ void IREmitter::addGlobalCall(llvm::Function* f, bool startOrEnd)
     auto* funcType = llvm::FunctionType::get(builder.getVoidTy(),
         /*isVarArg=*/false);
     llvm::BasicBlock* insertBlock;
-    // select the function to create
-    llvm::Function* globalFunc;
-    llvm::StringRef name;
-    std::tie(globalFunc, name) = startOrEnd ?
-        std::forward_as_tuple(vslCtor, "ctors") :
-        std::forward_as_tuple(vslDtor, "dtors");
+    // select the function to create, which is kept so that every global
+    //  variable gets added to the same one
+    llvm::Function*& globalFunc = startOrEnd ? vslCtor : vslDtor;
+    llvm::StringRef name = startOrEnd ? "ctors" : "dtors";
     if (globalFunc)
     {
         // global ctor/dtor func already exists
@@ -1133,7 +1266,7 @@ void IREmitter::addGlobalCall(llvm::Function* f, bool startOrEnd)
     builder.CreateCall(f);
 }
 
-llvm::Value* IREmitter::createMalloc(const Type* type)
+llvm::Value* IREmitter::createMalloc(const Type* type, bool onStack)
 {
     const Type* newType = type;
     llvm::StringRef name;
@@ -1153,43 +1286,36 @@ llvm::Value* IREmitter::createMalloc(const Type* type)
     // do something special for mallocing a class
     if (newType->is(Type::CLASS))
     {
-        return createMalloc(static_cast<const ClassType*>(newType), name);
+        return createMalloc(static_cast<const ClassType*>(newType), name,
+            onStack);
     }
     // or not if it isn't a class
     return createMalloc(converter.convert(newType), name);
 }
 
 llvm::Value* IREmitter::createMalloc(const ClassType* type,
-    llvm::StringRef name)
+    llvm::StringRef name, bool onStack)
 {
     // get the pointer type of the object
     llvm::PointerType* objPtrType = converter.convert(type);
     // object type to allocate
     auto* objType = llvm::cast<llvm::StructType>(objPtrType->getElementType());
-    // create the malloc call
-    llvm::Value* obj = createMalloc(objType, llvm::Twine{ "obj." } + name);
+    // create the malloc call, or an alloca if the object doesn't escape
+    llvm::Value* obj;
+    if (onStack && builder.GetInsertBlock())
+    {
+        obj = createEntryAlloca(objType, llvm::Twine{ "obj." } + name);
+    }
+    else
+    {
+        obj = createMalloc(objType, llvm::Twine{ "obj." } + name);
+    }
     if (!obj)
     {
         return nullptr;
     }
-    // get the type of a getelementptr index
-    llvm::IntegerType* indexType =
-        module.getDataLayout().getIntPtrType(llvmCtx);
-    // create list of getelementptr indexes
-    std::initializer_list<llvm::Value*> indexes
-    {
-        // index as array
-        llvm::ConstantInt::get(indexType, 0),
-        // index as struct (for the refcount): %A* -> i32*
-        // after the index, only i32 constants are allowed
-        builder.getInt32(0)
-    };
-    // get a pointer to the object's reference count
-    llvm::Value* refcount = builder.CreateGEP(objType, obj, indexes,
-        llvm::Twine{ "obj." } + name + ".refcount");
-    // initialize the refcount with a 1, so the object is now live and ready to
-    //  be initialized
-    builder.CreateStore(builder.getInt32(1), refcount);
+    // the object is now live and ready to be initialized
+    createInitRefcount(obj);
     return obj;
 }
 
@@ -1200,6 +1326,18 @@ llvm::Value* IREmitter::createMalloc(llvm::Type* type, const llvm::Twine& name)
         // builder not able to insert any instructions!
         return nullptr;
     }
+    // small objects can come from the runtime's pools instead
+    uint32_t sizeClass;
+    if (getSizeClass(type, sizeClass))
+    {
+        llvm::Function* allocFunc = getRuntimeFunc("vsl_alloc",
+            llvm::FunctionType::get(builder.getInt8PtrTy(),
+                { builder.getInt32Ty() }, /*isVarArg=*/false));
+        allocFunc->setReturnDoesNotAlias();
+        llvm::Value* block = builder.CreateCall(allocFunc,
+            { builder.getInt32(sizeClass) });
+        return builder.CreateBitCast(block, type->getPointerTo(), name);
+    }
     // int type large enough to hold a pointer
     llvm::IntegerType* intPtrType = builder.getIntPtrTy(module.getDataLayout());
     // compute the size of the struct type
@@ -1219,18 +1357,126 @@ llvm::Value* IREmitter::createMalloc(llvm::Type* type, const llvm::Twine& name)
             /*ArraySize=*/nullptr, /*MallocF=*/nullptr), name);
 }
 
+void IREmitter::createFree(llvm::Value* ptr)
+{
+    uint32_t sizeClass;
+    if (getSizeClass(ptr->getType()->getPointerElementType(), sizeClass))
+    {
+        llvm::Function* freeFunc = getRuntimeFunc("vsl_free",
+            llvm::FunctionType::get(builder.getVoidTy(),
+                { builder.getInt8PtrTy(), builder.getInt32Ty() },
+                /*isVarArg=*/false));
+        builder.CreateCall(freeFunc,
+            { builder.CreateBitCast(ptr, builder.getInt8PtrTy()),
+                builder.getInt32(sizeClass) });
+        return;
+    }
+    builder.Insert(llvm::CallInst::CreateFree(ptr, builder.GetInsertBlock()));
+}
+
+bool IREmitter::getSizeClass(llvm::Type* type, uint32_t& sizeClass) const
+{
+    if (options.allocator != IRGenOptions::POOL)
+    {
+        return false;
+    }
+    uint64_t size = module.getDataLayout().getTypeAllocSize(type);
+    if (size > VSL_MAX_POOLED_SIZE)
+    {
+        return false;
+    }
+    // size class n holds objects of up to (n + 1) * step bytes
+    sizeClass =
+        static_cast<uint32_t>(size ? (size - 1) / VSL_SIZE_CLASS_STEP : 0);
+    return true;
+}
+
+llvm::Function* IREmitter::getRuntimeFunc(llvm::StringRef name,
+    llvm::FunctionType* type)
+{
+    llvm::Function* f = module.getFunction(name);
+    if (!f)
+    {
+        f = llvm::Function::Create(type, llvm::GlobalValue::ExternalLinkage,
+            name, &module);
+        f->setDoesNotThrow();
+    }
+    return f;
+}
+
+bool IREmitter::isAssignedIn(Value var, llvm::ArrayRef<ArgNode*> args)
+{
+    // search the arguments with an explicit stack since they can be nested
+    //  arbitrarily deep
+    llvm::SmallVector<Node*, 16> nodes{ args.begin(), args.end() };
+    while (!nodes.empty())
+    {
+        Node* node = nodes.pop_back_val();
+        switch (node->getKind())
+        {
+        case Node::UNARY:
+            nodes.push_back(&static_cast<UnaryNode*>(node)->getExpr());
+            break;
+        case Node::BINARY:
+        {
+            auto* binary = static_cast<BinaryNode*>(node);
+            if (binary->getOp() == BinaryKind::ASSIGN &&
+                binary->getLhs().is(Node::IDENT))
+            {
+                auto& lhs = static_cast<IdentNode&>(binary->getLhs());
+                Value assigned = func.get(lhs.getSymbol());
+                if (assigned.isVar() &&
+                    assigned.getLLVMVar() == var.getLLVMVar())
+                {
+                    return true;
+                }
+            }
+            nodes.push_back(&binary->getLhs());
+            nodes.push_back(&binary->getRhs());
+            break;
+        }
+        case Node::TERNARY:
+        {
+            auto* ternary = static_cast<TernaryNode*>(node);
+            nodes.push_back(&ternary->getCondition());
+            nodes.push_back(&ternary->getThen());
+            nodes.push_back(&ternary->getElse());
+            break;
+        }
+        case Node::CALL:
+        case Node::METHOD_CALL:
+        {
+            auto* call = static_cast<CallNode*>(node);
+            nodes.push_back(&call->getCallee());
+            nodes.append(call->getArgs().begin(), call->getArgs().end());
+            break;
+        }
+        case Node::ARG:
+            nodes.push_back(&static_cast<ArgNode*>(node)->getValue());
+            break;
+        case Node::FIELD_ACCESS:
+            nodes.push_back(&static_cast<FieldAccessNode*>(node)->getObject());
+            break;
+        default:
+            // identifiers, literals and self don't contain other expressions
+            break;
+        }
+    }
+    return false;
+}
+
 Value IREmitter::lookupIdent(IdentNode& node)
 {
     // try to get it from the function scope first
-    Value value = func.get(node.getName());
+    Value value = func.get(node.getSymbol());
     if (!value)
     {
         // maybe global scope?
-        value = global.get(node.getName());
+        value = global.get(node.getSymbol());
         if (!value)
         {
             // maybe constructor?
-            const NamedType* selfType = vslCtx.getNamedType(node.getName());
+            const NamedType* selfType = vslCtx.findNamedType(node.getName());
             Access access;
             std::tie(value, access) = global.getCtor(selfType);
             if (!value)
@@ -1287,19 +1533,35 @@ void IREmitter::setupFuncBody(FunctionNode& node, Value funcVal)
         // get the vsl and llvm parameter representation
         const ParamNode& param = node.getParam(i);
         llvm::Argument* llvmParam = &*argIt;
+        llvmParam->setName(param.getName());
+        if (!param.isReassigned())
+        {
+            // the parameter can be used directly, and since the caller still
+            //  owns the argument, it's borrowed
+            func.set(param.getSymbol(), Value::getLet(param.getType(),
+                    llvmParam));
+            borrowedParams.insert(llvmParam);
+            continue;
+        }
         // load the parameter into a runtime variable
         llvm::Value* alloca = createEntryAlloca(llvmParam->getType(),
             param.getName());
         builder.CreateStore(llvmParam, alloca);
         // add that variable to function scope
-        func.set(param.getName(), Value::getVar(param.getType(), alloca));
+        Value var = Value::getVar(param.getType(), alloca);
+        func.set(param.getSymbol(), var);
+        // the callee has to copy the argument before it can be overwritten
+        if (toClassType(param.getType()))
+        {
+            copyValue(var);
+        }
     }
 }
 
 void IREmitter::genFuncBody(FunctionNode& node)
 {
     // generate the body
-    node.getBody().accept(*this);
+    visit(node.getBody());
 }
 
 void IREmitter::cleanupFuncBody(FunctionNode& node)
@@ -1324,6 +1586,8 @@ void IREmitter::cleanupFuncBody(FunctionNode& node)
     builder.ClearInsertionPoint();
     // exit the current scope
     func.exit();
+    borrowedParams.clear();
+    stackVars.clear();
     // erase the alloca point because nobody needs to see it
     if (allocaInsertPoint)
     {
@@ -1333,102 +1597,203 @@ void IREmitter::cleanupFuncBody(FunctionNode& node)
     result = Value::getNull();
 }
 
-void IREmitter::createCall(CallNode& node, Value funcVal, Value selfArg)
+void IREmitter::genCall(CallNode& node)
 {
-    const FunctionType* calleeType = funcVal.getVSLFunc();
+    switch (getWalkState())
+    {
+    case START:
+        walkOperand(node.getCallee(), node, AFTER_CALLEE);
+        return;
+    case AFTER_CALLEE:
+        pendingCalls.emplace_back();
+        if (!startCall(node, pendingCalls.back()))
+        {
+            // the call is invalid, which makes its value invalid too
+            pendingCalls.pop_back();
+            result = Value::getNull();
+            return;
+        }
+        break;
+    default:
+        addCallArg(pendingCalls.back());
+        break;
+    }
+    PendingCall& call = pendingCalls.back();
+    if (call.numArgs < node.getNumArgs())
+    {
+        walkOperand(node.getArg(call.numArgs), node, AFTER_ARG);
+        return;
+    }
+    finishCall(call);
+    pendingCalls.pop_back();
+}
+
+bool IREmitter::startCall(CallNode& node, PendingCall& call)
+{
+    call.node = &node;
+    if (!result)
+    {
+        return false;
+    }
+    call.callee = result;
+    Value selfArg;
+    if (node.is(Node::METHOD_CALL))
+    {
+        // the callee is the object to use as the self parameter, so lookup the
+        //  method
+        auto& methodCall = static_cast<MethodCallNode&>(node);
+        Access access;
+        std::tie(call.funcVal, access) = global.getMethod(
+            call.callee.getVSLType(), methodCall.getMethodSymbol());
+        if (!call.funcVal)
+        {
+            // method can't be found
+            diag.print<Diag::UNKNOWN_METHOD>(methodCall,
+                *call.callee.getVSLType());
+            return false;
+        }
+        if (!canAccessMember(call.callee.getVSLType(), access))
+        {
+            // method can't be accessed
+            diag.print<Diag::PRIVATE_METHOD>(methodCall,
+                *call.callee.getVSLType());
+            return false;
+        }
+        // if an argument reassigns the variable that self came from, the old
+        //  object has to be kept alive until the call is done
+        if (call.callee.isVar() && isAssignedIn(call.callee, node.getArgs()))
+        {
+            call.callee = copyValue(call.callee);
+        }
+        selfArg = loadValue(call.callee);
+    }
+    else
+    {
+        // make sure the callee is an actual function
+        if (!call.callee.isFunc())
+        {
+            diag.print<Diag::NOT_A_FUNCTION>(node.getCallee(),
+                *call.callee.getVSLType());
+            return false;
+        }
+        call.funcVal = loadValue(call.callee);
+    }
+    const FunctionType* calleeType = call.funcVal.getVSLFunc();
     // make sure the right amount of arguments is used
     if (calleeType->getNumParams() != node.getNumArgs())
     {
         diag.print<Diag::MISMATCHING_ARG_COUNT>(node.getLoc(),
             node.getNumArgs(), calleeType->getNumParams());
-        result = Value::getNull();
-        return;
+        destroyValue(call.callee);
+        return false;
     }
-    const Type* retType = calleeType->getReturnType();
-    llvm::Function* func = funcVal.getLLVMFunc();
-    // setup vsl arguments list
-    std::vector<Value> vslArgs;
-    vslArgs.reserve(calleeType->getNumParams());
+    call.vslArgs.reserve(calleeType->getNumParams());
     // setup llvm arguments list
-    std::vector<llvm::Value*> llvmArgs;
-    llvm::Value* llvmSelfArg = nullptr;
+    call.llvmSelfArg = nullptr;
     if (calleeType->hasSelfType())
     {
         // add the implicit self parameter
         if (calleeType->isCtor())
         {
-            // ctors require the caller to malloc the object first
-            llvmSelfArg = createMalloc(calleeType->getSelfType());
+            // ctors require the caller to allocate the object first
+            call.llvmSelfArg = createMalloc(calleeType->getSelfType(),
+                node.isStackAllocated());
         }
         else if (calleeType->isMethod())
         {
             // methods just require the self argument
             assert(selfArg.getVSLType() == calleeType->getSelfType() &&
                 "invalid self param!");
-            llvmSelfArg = selfArg.getLLVMValue();
+            call.llvmSelfArg = selfArg.getLLVMValue();
         }
         // reserve a space for the self parameter
-        llvmArgs.reserve(calleeType->getNumParams() + 1);
-        llvmArgs.push_back(llvmSelfArg);
+        call.llvmArgs.reserve(calleeType->getNumParams() + 1);
+        call.llvmArgs.push_back(call.llvmSelfArg);
     }
     else
     {
         // reserve the normal amount of memory
-        llvmArgs.reserve(calleeType->getNumParams());
+        call.llvmArgs.reserve(calleeType->getNumParams());
     }
-    // verify each argument
-    bool valid = true;
-    for (size_t i = 0; i < calleeType->getNumParams(); ++i)
+    call.numArgs = 0;
+    call.valid = true;
+    return true;
+}
+
+void IREmitter::addCallArg(PendingCall& call)
+{
+    size_t i = call.numArgs++;
+    const Type* paramType = call.funcVal.getVSLFunc()->getParamType(i);
+    // check that the types match
+    if (result.getVSLType() == paramType)
     {
-        const Type* paramType = calleeType->getParamType(i);
-        ArgNode& arg = node.getArg(i);
-        arg.accept(*this);
-        // save the argument for destruction later
-        vslArgs.push_back(result);
-        // check that the types match
-        if (result.getVSLType() == paramType)
+        if (result == self || result.isLet() || (result.isVar() &&
+                llvm::isa<llvm::AllocaInst>(result.getLLVMVar()) &&
+                !isAssignedIn(result, call.node->getArgs().drop_front(i + 1))))
         {
-            llvmArgs.push_back(copyValue(result).getLLVMValue());
+            // the callee can't overwrite these, so they can be borrowed
+            // locals that a later argument reassigns are copied instead,
+            //  since that would destroy the object before the call
+            call.llvmArgs.push_back(loadValue(result).getLLVMValue());
         }
         else
         {
-            // print error diagnostics as long as the argument itself isn't the
-            //  source of error
-            if (result)
-            {
-                diag.print<Diag::CANNOT_CONVERT>(arg.getValue(),
-                    *result.getVSLType(), *paramType);
-            }
-            valid = false;
+            // the callee borrows the copy, which is destroyed afterwards
+            // temporaries are just moved here
+            Value copy = copyValue(result);
+            call.llvmArgs.push_back(copy.getLLVMValue());
+            call.vslArgs.push_back(copy);
+        }
+    }
+    else
+    {
+        // save the argument for destruction later
+        call.vslArgs.push_back(result);
+        // print error diagnostics as long as the argument itself isn't the
+        //  source of error
+        if (result)
+        {
+            diag.print<Diag::CANNOT_CONVERT>(call.node->getArg(i).getValue(),
+                *result.getVSLType(), *paramType);
         }
+        call.valid = false;
     }
+}
+
+void IREmitter::finishCall(PendingCall& call)
+{
+    const FunctionType* calleeType = call.funcVal.getVSLFunc();
     // create the call instruction if everything's valid
-    if (valid)
+    if (call.valid)
     {
-        llvm::Value* llvmVal = builder.CreateCall(func, llvmArgs);
+        llvm::Value* llvmVal = builder.CreateCall(call.funcVal.getLLVMFunc(),
+            call.llvmArgs);
         if (calleeType->isCtor())
         {
-            if (!llvmSelfArg)
+            if (!call.llvmSelfArg)
             {
                 // something bad happened
                 result = Value::getNull();
+                destroyValue(call.callee);
                 return;
             }
             // self object was malloc'd previously since this is a constructor
             // use this as the actual result, not the call instruction
-            llvmVal = llvmSelfArg;
+            llvmVal = call.llvmSelfArg;
         }
-        result = Value::getExpr(retType, llvmVal);
+        result = Value::getExpr(calleeType->getReturnType(), llvmVal);
     }
     else
     {
         result = Value::getNull();
     }
     // destroy each argument now that they've been used already
-    for (Value argValue : vslArgs)
+    for (Value argValue : call.vslArgs)
     {
         destroyValue(argValue);
     }
+    // teardown
+    destroyValue(call.callee);
 }
 
 bool IREmitter::canAccessMember(const Type* objType, Access access) const
@@ -1445,32 +1810,147 @@ void IREmitter::generateDtor(const ClassNode& node)
     auto* entry = llvm::BasicBlock::Create(llvmCtx, "entry", llvmFunc);
     builder.SetInsertPoint(entry);
     llvm::Value* objPtr = &*llvmFunc->arg_begin(); // first arg is always `self`
-    // get the refcount
-    std::initializer_list<llvm::Value*> indexes
+    // the runtime may have to destroy the object itself
+    llvm::Function* destroyFunc = nullptr;
+    if (options.refcount == IRGenOptions::BIASED)
     {
-        // array index: %A* -> %A*
-        createGEPIndex(objPtr->getType(), 0),
-        // refcount index: %A* -> i32*
-        builder.getInt32(0)
-    };
-    llvm::Value* rcPtr = builder.CreateGEP(objPtr, indexes,
-        node.getName() + ".refcount");
-    llvm::Value* rc = builder.CreateLoad(rcPtr);
-    // subtract 1 from the refcount
-    rc = builder.CreateSub(rc, builder.getInt32(1));
+        destroyFunc = generateDestroy(node);
+        builder.SetInsertPoint(entry);
+    }
     // branch if the refcount is zero
     auto* dead = llvm::BasicBlock::Create(llvmCtx, "dead", llvmFunc);
     auto* alive = llvm::BasicBlock::Create(llvmCtx, "alive", llvmFunc);
-    llvm::Value* isDead = builder.CreateICmpEQ(rc, builder.getInt32(0),
-        "is_dead");
+    llvm::Value* isDead = createRelease(objPtr, destroyFunc);
     builder.CreateCondBr(isDead, dead, alive);
-    // if so, call the destructor of every field
+    // if so, destroy the object
     builder.SetInsertPoint(dead);
-    for (size_t i = 0; i < node.getNumFields(); ++i)
+    if (destroyFunc)
+    {
+        builder.CreateCall(destroyFunc,
+            { builder.CreateBitCast(objPtr, builder.getInt8PtrTy()) });
+    }
+    else
+    {
+        // call the destructor of every field, then free the allocated memory
+        destroyFields(objPtr, node.getClassType());
+        createFree(objPtr);
+    }
+    builder.CreateRetVoid();
+    // if the refcount isn't zero, then just return
+    builder.SetInsertPoint(alive);
+    builder.CreateRetVoid();
+}
+
+llvm::Function* IREmitter::generateDestroy(const ClassNode& node)
+{
+    auto* ft = llvm::FunctionType::get(builder.getVoidTy(),
+        { builder.getInt8PtrTy() }, /*isVarArg=*/false);
+    auto* llvmFunc = llvm::Function::Create(ft,
+        llvm::GlobalValue::InternalLinkage, node.getName() + ".destroy",
+        &module);
+    auto* entry = llvm::BasicBlock::Create(llvmCtx, "entry", llvmFunc);
+    builder.SetInsertPoint(entry);
+    llvm::Value* objPtr = builder.CreateBitCast(&*llvmFunc->arg_begin(),
+        converter.convert(node.getClassType()), "self");
+    destroyFields(objPtr, node.getClassType());
+    createFree(objPtr);
+    builder.CreateRetVoid();
+    return llvmFunc;
+}
+
+llvm::Value* IREmitter::createHeaderGEP(llvm::Value* objPtr)
+{
+    std::initializer_list<llvm::Value*> indexes
+    {
+        // array index: %A* -> %A*
+        createGEPIndex(objPtr->getType(), 0),
+        // header index: %A* -> <header type>*
+        builder.getInt32(0)
+    };
+    return builder.CreateGEP(objPtr, indexes, "refcount");
+}
+
+void IREmitter::createInitRefcount(llvm::Value* objPtr)
+{
+    llvm::Value* header = createHeaderGEP(objPtr);
+    if (options.refcount == IRGenOptions::BIASED)
+    {
+        builder.CreateCall(getRuntimeFunc("vsl_brc_init",
+                llvm::FunctionType::get(builder.getVoidTy(),
+                    { header->getType() }, /*isVarArg=*/false)),
+            { header });
+        return;
+    }
+    // nothing else can see the object yet, so this doesn't need to be atomic
+    builder.CreateStore(builder.getInt32(1), header);
+}
+
+void IREmitter::createRetain(llvm::Value* objPtr)
+{
+    llvm::Value* header = createHeaderGEP(objPtr);
+    switch (options.refcount)
+    {
+    case IRGenOptions::NONATOMIC:
+    {
+        llvm::Value* rc = builder.CreateLoad(header);
+        rc = builder.CreateAdd(rc, builder.getInt32(1));
+        builder.CreateStore(rc, header);
+        break;
+    }
+    case IRGenOptions::ATOMIC:
+        // whoever gave us the reference already made sure the object is
+        //  visible to us, so there's nothing to synchronize with here
+        builder.CreateAtomicRMW(llvm::AtomicRMWInst::Add, header,
+            builder.getInt32(1), llvm::AtomicOrdering::Monotonic);
+        break;
+    case IRGenOptions::BIASED:
+        builder.CreateCall(getRuntimeFunc("vsl_brc_retain",
+                llvm::FunctionType::get(builder.getVoidTy(),
+                    { header->getType() }, /*isVarArg=*/false)),
+            { header });
+        break;
+    }
+}
+
+llvm::Value* IREmitter::createRelease(llvm::Value* objPtr,
+    llvm::Function* destroyFunc)
+{
+    llvm::Value* header = createHeaderGEP(objPtr);
+    switch (options.refcount)
+    {
+    case IRGenOptions::NONATOMIC:
+    {
+        llvm::Value* rc = builder.CreateLoad(header);
+        rc = builder.CreateSub(rc, builder.getInt32(1));
+        builder.CreateStore(rc, header);
+        return builder.CreateICmpEQ(rc, builder.getInt32(0), "is_dead");
+    }
+    case IRGenOptions::ATOMIC:
+    {
+        // releasing publishes our writes to the object, and acquiring makes
+        //  sure that whoever destroys it sees everyone else's
+        llvm::Value* rc = builder.CreateAtomicRMW(llvm::AtomicRMWInst::Sub,
+            header, builder.getInt32(1), llvm::AtomicOrdering::AcquireRelease);
+        return builder.CreateICmpEQ(rc, builder.getInt32(1), "is_dead");
+    }
+    default:
+        break;
+    }
+    // biased refcounting leaves it up to the runtime
+    llvm::Value* dead = builder.CreateCall(getRuntimeFunc("vsl_brc_release",
+            llvm::FunctionType::get(builder.getInt32Ty(),
+                { header->getType(), destroyFunc->getType() },
+                /*isVarArg=*/false)),
+        { header, destroyFunc });
+    return builder.CreateICmpNE(dead, builder.getInt32(0), "is_dead");
+}
+
+void IREmitter::destroyFields(llvm::Value* objPtr, const ClassType* type)
+{
+    for (const ClassType::Field& field : type->getFields())
     {
         // lookup the field's destructor
-        const FieldNode& field = node.getField(i);
-        llvm::Function* dtorFunc = global.getDtor(field.getType());
+        llvm::Function* dtorFunc = global.getDtor(field.type);
         if (!dtorFunc)
         {
             // destructor doesn't exist so this can be skipped
@@ -1484,22 +1964,14 @@ void IREmitter::generateDtor(const ClassNode& node)
             // struct index: %A* -> %struct.A*
             builder.getInt32(1),
             // field index: %struct.A* -> <field type>*
-            builder.getInt32(i)
+            builder.getInt32(field.index)
         };
         llvm::Value* fieldPtr = builder.CreateGEP(objPtr, fieldIndexes,
-            node.getName() + llvm::Twine{ '.' } + field.getName());
+            "field");
         llvm::Value* fieldValue = builder.CreateLoad(fieldPtr);
         // call the destructor
         builder.CreateCall(dtorFunc, { fieldValue });
     }
-    // then, after destroying every field, free the allocated memory and return
-    builder.Insert(llvm::CallInst::CreateFree(objPtr,
-            builder.GetInsertBlock()));
-    builder.CreateRetVoid();
-    // if the refcount isn't zero, then update the refcount field and return
-    builder.SetInsertPoint(alive);
-    builder.CreateStore(rc, rcPtr);
-    builder.CreateRetVoid();
 }
 
 const ClassType* IREmitter::toClassType(const Type* type)
@@ -1522,34 +1994,20 @@ const ClassType* IREmitter::toClassType(const Type* type)
 
 Value IREmitter::copyValue(Value value)
 {
-    // only assignable values (lvalues) can be copied
+    // only variables and fields (lvalues) can be copied
     // exprs (rvalues) are temporaries and can just be moved without doing
-    //  anything else
-    if (!value || !value.isAssignable())
+    //  anything else, but self is only borrowed so it still needs a copy
+    if (!value || (!value.isVar() && !value.isField() && value != self))
     {
         return value;
     }
-    // note that since this is assignable, we have a pointer to the object
-    //  reference, therefore we need to load it first
+    // if this is assignable, we have a pointer to the object reference,
+    //  therefore we need to load it first
     Value loaded = loadValue(value);
     // see if we have an object, since objects need to increment their refcount
     if (toClassType(value.getVSLType()))
     {
-        llvm::Value* objPtr = loaded.getLLVMValue();
-        // get the refcount
-        std::initializer_list<llvm::Value*> rcIndexes
-        {
-            // array index: %A* -> %A*
-            createGEPIndex(objPtr->getType(), 0),
-            // refcount index: %A* -> i32*
-            builder.getInt32(0)
-        };
-        llvm::Value* rcPtr = builder.CreateGEP(objPtr, rcIndexes, "refcount");
-        // increment it
-        llvm::Value* rc = builder.CreateLoad(rcPtr);
-        rc = builder.CreateAdd(rc, builder.getInt32(1));
-        // store the result
-        builder.CreateStore(rc, rcPtr);
+        createRetain(loaded.getLLVMValue());
     }
     // do any cleanup if needed
     if (value.isField() && value.shouldDestroyBase())
@@ -1564,7 +2022,12 @@ Value IREmitter::copyValue(Value value)
 Value IREmitter::loadValue(Value value)
 {
     // only assignable Values need to be loaded since they are pointers
-    // regular expr Values can just be passed normally
+    // lets already hold their value, and regular expr Values can just be
+    //  passed normally
+    if (value.isLet())
+    {
+        return Value::getExpr(value.getVSLType(), value.getLLVMValue());
+    }
     if (!value.isAssignable())
     {
         return value;
@@ -1589,13 +2052,19 @@ void IREmitter::storeValue(Value from, Value to)
 
 void IREmitter::destroyValue(Value value)
 {
-    // only destroy expr/field Values
-    if (!value || value.isVar())
+    // only destroy expr/field Values, other than the borrowed self
+    if (!value || value.isVar() || value == self)
     {
         return;
     }
-    if (value.isField() && value.shouldDestroyBase())
+    if (value.isField())
     {
+        // fields are owned by their base object, which was never copied, so
+        //  there's nothing to destroy unless the base is a temporary
+        if (!value.shouldDestroyBase())
+        {
+            return;
+        }
         // if we just destroy the field, the base object could potentially be a
         //  memory leak
         // since the base object's destructor should destroy all of its fields
@@ -1607,6 +2076,14 @@ void IREmitter::destroyValue(Value value)
 
 void IREmitter::destroyValueImpl(Value value)
 {
+    // stack objects don't escape, so their refcount would drop to zero here
+    //  anyway, but they only need their fields destroyed
+    if (isStackObject(value))
+    {
+        destroyFields(loadValue(value).getLLVMValue(),
+            toClassType(value.getVSLType()));
+        return;
+    }
     // see if we actually have a destructor to call
     llvm::Function* llvmFunc = global.getDtor(value.getVSLType());
     if (!llvmFunc)
@@ -1619,14 +2096,25 @@ void IREmitter::destroyValueImpl(Value value)
 
 void IREmitter::destroyVar(Value value)
 {
-    // only destroy variable Values
-    if (!value.isVar())
+    // only destroy variable Values that aren't borrowed
+    if (!value.isVar() || borrowedParams.count(value.getLLVMVar()))
     {
         return;
     }
     destroyValueImpl(value);
 }
 
+bool IREmitter::isStackObject(Value value) const
+{
+    if (value.isVar())
+    {
+        return stackVars.count(value.getLLVMVar());
+    }
+    // objects are otherwise only ever referenced through a pointer that was
+    //  loaded or returned from somewhere
+    return value.isExpr() && llvm::isa<llvm::AllocaInst>(value.getLLVMValue());
+}
+
 void IREmitter::destroyVars()
 {
     // go through the current scope to destroy vars
@@ -5,20 +5,33 @@
 #include "ast/nodeVisitor.hpp"
 #include "ast/vslContext.hpp"
 #include "diag/diag.hpp"
+#include "irgen/irgenOptions.hpp"
 #include "irgen/scope/funcScope.hpp"
 #include "irgen/scope/globalScope.hpp"
 #include "irgen/typeConverter/typeConverter.hpp"
 #include "irgen/value/value.hpp"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Value.h"
+#include <cstddef>
 #include <cstdint>
+#include <utility>
+#include <vector>
 
 /**
  * Generates LLVM IR by visiting a Node.
+ *
+ * Expressions are generated with walk() instead of recursion, so they can be
+ * nested as deeply as the parser allows. An expression walks its next operand
+ * followed by itself again with the Step that comes after it, and picks up
+ * the operand's Value from `result` then. Anything it still needs in the
+ * meantime is kept on one of the pending stacks below. Since a walk only
+ * handles expressions, statements must never be visited during one.
  */
-class IREmitter : public NodeVisitor
+class IREmitter : public NodeVisitor<IREmitter>
 {
 public:
     /**
@@ -30,41 +43,84 @@ public:
      * @param global Global scope manager.
      * @param converter VSL to LLVM type converter.
      * @param module The module to emit LLVM IR into.
+     * @param options What kind of code to emit.
      */
     IREmitter(VSLContext& vslCtx, Diag& diag, FuncScope& func,
-        GlobalScope& global, TypeConverter& converter, llvm::Module& module);
+        GlobalScope& global, TypeConverter& converter, llvm::Module& module,
+        const IRGenOptions& options);
     /**
      * Destroys an IREmitter object.
      */
-    virtual ~IREmitter() override = default;
-    virtual void visitFunction(FunctionNode& node) override;
-    virtual void visitExtFunc(ExtFuncNode& node) override;
-    virtual void visitParam(ParamNode& node) override;
-    virtual void visitVariable(VariableNode& node) override;
-    virtual void visitClass(ClassNode& node) override;
-    virtual void visitMethod(MethodNode& node) override;
-    virtual void visitCtor(CtorNode& node) override;
-    virtual void visitBlock(BlockNode& node) override;
-    virtual void visitEmpty(EmptyNode& node) override;
-    virtual void visitIf(IfNode& node) override;
-    virtual void visitReturn(ReturnNode& node) override;
-    virtual void visitIdent(IdentNode& node) override;
-    virtual void visitLiteral(LiteralNode& node) override;
-    virtual void visitUnary(UnaryNode& node) override;
-    virtual void visitBinary(BinaryNode& node) override;
-    virtual void visitTernary(TernaryNode& node) override;
-    virtual void visitCall(CallNode& node) override;
-    virtual void visitArg(ArgNode& node) override;
-    virtual void visitFieldAccess(FieldAccessNode& node) override;
-    virtual void visitMethodCall(MethodCallNode& node) override;
-    virtual void visitSelf(SelfNode& node) override;
+    void visitFunction(FunctionNode& node);
+    void visitExtFunc(ExtFuncNode& node);
+    void visitParam(ParamNode& node);
+    void visitVariable(VariableNode& node);
+    void visitClass(ClassNode& node);
+    void visitMethod(MethodNode& node);
+    void visitCtor(CtorNode& node);
+    void visitBlock(BlockNode& node);
+    void visitEmpty(EmptyNode& node);
+    void visitIf(IfNode& node);
+    void visitReturn(ReturnNode& node);
+    void visitIdent(IdentNode& node);
+    void visitLiteral(LiteralNode& node);
+    void visitUnary(UnaryNode& node);
+    void visitBinary(BinaryNode& node);
+    void visitTernary(TernaryNode& node);
+    void visitCall(CallNode& node);
+    void visitArg(ArgNode& node);
+    void visitFieldAccess(FieldAccessNode& node);
+    void visitMethodCall(MethodCallNode& node);
+    void visitSelf(SelfNode& node);
 
 private:
+    /**
+     * What an expression does next when it's walked, which it gets from
+     * getWalkState().
+     */
+    enum Step : unsigned
+    {
+        /** Nothing has been generated yet. */
+        START,
+        /** The operand of a unary operation or field access is done. */
+        AFTER_OPERAND,
+        /** The lhs of a binary operation is done. */
+        AFTER_LHS,
+        /** The rhs of a binary operation is done. */
+        AFTER_RHS,
+        /** The condition of the current ternary in a chain is done. */
+        AFTER_CONDITION,
+        /** The then case of the current ternary in a chain is done. */
+        AFTER_THEN,
+        /** The else case of the last ternary in a chain is done. */
+        AFTER_ELSE,
+        /** The callee of a call is done. */
+        AFTER_CALLEE,
+        /** The next argument of a call is done. */
+        AFTER_ARG
+    };
+    /**
+     * Generates an operand of an expression, and then walks the expression
+     * again once it's done.
+     *
+     * @param operand The operand to generate.
+     * @param node The expression that it belongs to.
+     * @param next The step that the expression continues with.
+     */
+    void walkOperand(Node& operand, Node& node, Step next);
+
     /**
      * @name Unary operations
      * @{
      */
 
+    /**
+     * Generates a unary operation after its operand.
+     *
+     * @param node The expression to generate code for. Its operand must
+     * already be in `result`.
+     */
+    void genUnaryOp(UnaryNode& node);
     /**
      * Generates a unary negation.
      *
@@ -79,15 +135,16 @@ private:
      */
 
     /**
-     * Generates a variable assignment.
+     * Generates the next step of a variable assignment. The rhs is generated
+     * before the lhs.
      *
      * @param node The expression to generate code for.
      */
     void genAssign(BinaryNode& node);
     /**
-     * Generates a short-circuiting boolean operation, i.e., and/or. Don't call
-     * this method if `node.getOp()` is anything but TokenKind::AND or
-     * TokenKind::OR.
+     * Generates the next step of a short-circuiting boolean operation, i.e.,
+     * and/or. Don't call this method if `node.getOp()` is anything but
+     * TokenKind::AND or TokenKind::OR.
      *
      * @param node The expression to generate code for.
      */
@@ -99,6 +156,13 @@ private:
      * @{
      */
 
+    /**
+     * Generates the next step of an arithmetic or comparison operation, i.e.\
+     * anything but an assignment or a short-circuiting one.
+     *
+     * @param node The expression to generate code for.
+     */
+    void genBinaryOp(BinaryNode& node);
     /**
      * Generates a binary add instruction.
      *
@@ -243,7 +307,7 @@ private:
      */
     // FIXME: should this return a var value?
     llvm::GlobalVariable* genGlobalVar(Access access, const Type* vslType,
-        llvm::Type* llvmType, llvm::StringRef name);
+        llvm::Type* llvmType, Symbol name);
     /**
      * Creates a global variable's constructor function. The function is left
      * only with its entry block generated so that the user can fill in the
@@ -289,20 +353,25 @@ private:
      * Allocates enough memory to hold an object of the given type.
      *
      * @param type Type to allocate.
+     * @param onStack Whether to allocate the object on the stack instead, if
+     * it's a class object.
      *
      * @returns A call to malloc and a bitcast to the appropriate LLVM type.
      */
-    llvm::Value* createMalloc(const Type* type);
+    llvm::Value* createMalloc(const Type* type, bool onStack = false);
     /**
      * Allocates enough memory to hold an object of the given type. Its
      * reference count will also be initialized.
      *
      * @param type Object type to allocate.
      * @param name Named of the type.
+     * @param onStack Whether to allocate the object on the stack instead.
      *
-     * @returns A call to malloc and a bitcast to the appropriate LLVM type.
+     * @returns A call to malloc and a bitcast to the appropriate LLVM type, or
+     * an alloca if on the stack.
      */
-    llvm::Value* createMalloc(const ClassType* type, llvm::StringRef name);
+    llvm::Value* createMalloc(const ClassType* type, llvm::StringRef name,
+        bool onStack = false);
     /**
      * Mallocs an object.
      *
@@ -312,6 +381,33 @@ private:
      * @returns A call to malloc and a bitcast to the appropriate LLVM type.
      */
     llvm::Value* createMalloc(llvm::Type* type, const llvm::Twine& name = "");
+    /**
+     * Frees memory that was allocated by createMalloc.
+     *
+     * @param ptr Pointer to the memory. Its pointee type determines how it was
+     * allocated.
+     */
+    void createFree(llvm::Value* ptr);
+    /**
+     * Gets the pool size class that an object should be allocated from.
+     *
+     * @param type LLVM type to allocate.
+     * @param sizeClass Set to the size class, if there is one.
+     *
+     * @returns True if the object should come from a pool, or false if it
+     * should be malloc'd.
+     */
+    bool getSizeClass(llvm::Type* type, uint32_t& sizeClass) const;
+    /**
+     * Gets a function from the VSL runtime, declaring it if needed.
+     *
+     * @param name Name of the function.
+     * @param type Type of the function.
+     *
+     * @returns The function.
+     */
+    llvm::Function* getRuntimeFunc(llvm::StringRef name,
+        llvm::FunctionType* type);
     /**
      * Looks up an identifier. Returns null if it doesn't exist. Emits error
      * diagnostics as usual.
@@ -352,16 +448,103 @@ private:
      */
     void cleanupFuncBody(FunctionNode& node);
     /**
-     * Creates a call to a function or method with the given arguments. The
-     * `result` field will contain the return value. Emits error diagnostics as
-     * usual.
+     * A function or method call whose arguments are still being generated.
+     */
+    struct PendingCall
+    {
+        /** The call being generated. */
+        CallNode* node;
+        /** Function or method to call. */
+        Value funcVal;
+        /**
+         * The function, or the object to call a method on, which is destroyed
+         * once the call is done.
+         */
+        Value callee;
+        /** The LLVM arguments so far, starting with `self` if there is one. */
+        std::vector<llvm::Value*> llvmArgs;
+        /** Arguments that need to be destroyed after the call. */
+        std::vector<Value> vslArgs;
+        /** The `self` argument, or null if there isn't one. */
+        llvm::Value* llvmSelfArg;
+        /** How many of the call's arguments were generated so far. */
+        size_t numArgs;
+        /** Whether all of those arguments were valid. */
+        bool valid;
+    };
+    /**
+     * Generates the next step of a call to a function or method. The `result`
+     * field will contain the return value once it's done. Emits error
+     * diagnostics as usual.
+     *
+     * Arguments are passed at +0. Temporaries, local variables and `self` are
+     * already kept alive by the caller, so they're borrowed as is, but globals
+     * and fields are copied first in case the callee overwrites them, as are
+     * local variables that a later argument assigns to.
+     *
+     * @param node The call to generate code for.
+     */
+    void genCall(CallNode& node);
+    /**
+     * Sets up the `self` argument of a call once its callee is generated,
+     * before any of its arguments are.
+     *
+     * @param node The call to generate code for. Its callee must already be in
+     * `result`.
+     * @param call Set to the call's state.
+     *
+     * @returns True if the call can go ahead, false if it's invalid.
+     */
+    bool startCall(CallNode& node, PendingCall& call);
+    /**
+     * Adds the next argument of a call, once it's been generated.
+     *
+     * @param call The call to add it to. The argument must already be in
+     * `result`.
+     */
+    void addCallArg(PendingCall& call);
+    /**
+     * Creates the call instruction once all of a call's arguments have been
+     * added.
      *
-     * @param node Contains the function arguments. Callee doesn't matter here.
-     * @param funcVal Function or method to call.
-     * @param selfArg Optional `self` argument. Applies to methods only.
+     * @param call The call to finish.
      */
-    void createCall(CallNode& node, Value funcVal,
-        Value selfArg = Value::getNull());
+    void finishCall(PendingCall& call);
+    /**
+     * A chain of ternaries like `a ? b : c ? d : e` that's still being
+     * generated. The whole chain shares one cont block and phi node.
+     */
+    struct PendingTernary
+    {
+        /** The ternaries in the chain, outermost first. */
+        llvm::SmallVector<TernaryNode*, 8> chain;
+        /** The conditions so far, which are destroyed once it's done. */
+        std::vector<Value> conditions;
+        /**
+         * The value of each case so far, along with the block that it ends up
+         * in since an expression can span multiple basic blocks, e.g. a
+         * ternary such as this.
+         */
+        llvm::SmallVector<std::pair<Value, llvm::BasicBlock*>, 8> cases;
+        /** Where every case branches to once it's done. */
+        llvm::BasicBlock* contBlock;
+        /** The else block of the ternary whose then case is being generated. */
+        llvm::BasicBlock* elseBlock;
+    };
+    /**
+     * Generates the phi node that brings a chain of ternaries together, once
+     * all of its cases are done or one of them turned out to be invalid.
+     */
+    void finishTernary();
+    /**
+     * Checks if any of the given arguments assigns to a local variable.
+     *
+     * @param var The variable to look for.
+     * @param args The arguments to search through.
+     *
+     * @returns True if the variable is assigned to, false otherwise.
+     */
+    bool isAssignedIn(Value var, llvm::ArrayRef<ArgNode*> args);
     /**
      * Checks if the current scope can access a member of an object.
      *
@@ -378,6 +561,54 @@ private:
      * @param node Class to create a destructor for.
      */
     void generateDtor(const ClassNode& node);
+    /**
+     * Calls the destructor of every field of an object.
+     *
+     * @param objPtr Pointer to the object.
+     * @param type Type of the object.
+     */
+    void destroyFields(llvm::Value* objPtr, const ClassType* type);
+    /**
+     * Generates a function that destroys an object of the given class without
+     * looking at its refcount, for the runtime to call when it finds out that
+     * the object is dead. Only used for biased refcounting.
+     *
+     * @param node The class.
+     *
+     * @returns The function, which takes the object as an i8*.
+     */
+    llvm::Function* generateDestroy(const ClassNode& node);
+    /**
+     * Gets a pointer to the header of an object, which holds its refcount.
+     *
+     * @param objPtr Pointer to the object.
+     *
+     * @returns A pointer to the header.
+     */
+    llvm::Value* createHeaderGEP(llvm::Value* objPtr);
+    /**
+     * Initializes the refcount of a new object to 1.
+     *
+     * @param objPtr Pointer to the object.
+     */
+    void createInitRefcount(llvm::Value* objPtr);
+    /**
+     * Increments the refcount of an object.
+     *
+     * @param objPtr Pointer to the object.
+     */
+    void createRetain(llvm::Value* objPtr);
+    /**
+     * Decrements the refcount of an object.
+     *
+     * @param objPtr Pointer to the object.
+     * @param destroyFunc The function from generateDestroy(), if using biased
+     * refcounting.
+     *
+     * @returns An i1 that's true if the object is now dead.
+     */
+    llvm::Value* createRelease(llvm::Value* objPtr,
+        llvm::Function* destroyFunc);
     /**
      * Attempts to convert a Type to a ClassType. This method returns null if
      * the type can't be resolved to a ClassType.
@@ -389,8 +620,8 @@ private:
     static const ClassType* toClassType(const Type* type);
     /**
      * Loads and copies a Value if it's a variable or field access. Expr copies
-     * are elided because they're just temporaries. When copying objects, the
-     * reference count is incremented.
+     * are elided because they're just temporaries, except for `self` which is
+     * only borrowed. When copying objects, the reference count is incremented.
      *
      * This is useful in dealing with passing values to/from functions.
      *
@@ -422,7 +653,7 @@ private:
      * Possibly generates instructions to destroy a value if it's an expression.
      * For objects, this calls its destructor. Variable values are ignored here
      * because they should've been loaded first, but fields are fine since their
-     * base objects may be expr Values.
+     * base objects may be expr Values. `self` is borrowed, so it's ignored too.
      *
      * @param value Value to destroy. Must be an expr or field Value.
      */
@@ -434,12 +665,21 @@ private:
      */
     void destroyValueImpl(Value value);
     /**
-     * Destroys a variable Value. If the value doesn't have a destructor, this
-     * is a no-op.
+     * Destroys a variable Value. If the value doesn't have a destructor or is
+     * a borrowed parameter, this is a no-op.
      *
      * @param value Value to destroy. Must be a variable Value.
      */
     void destroyVar(Value value);
+    /**
+     * Checks whether a Value refers to an object that was allocated on the
+     * stack, because it was found to never escape.
+     *
+     * @param value Value to check.
+     *
+     * @returns True if on the stack, false otherwise.
+     */
+    bool isStackObject(Value value) const;
     /**
      * Destroys all variables in the current function scope. Useful when exiting
      * a scope.
@@ -467,6 +707,8 @@ private:
     llvm::Module& module;
     /** Context object that owns most dynamic LLVM data structures. */
     llvm::LLVMContext& llvmCtx;
+    /** What kind of code to emit. */
+    const IRGenOptions& options;
     /** Used to build the IR. */
     llvm::IRBuilder<> builder;
     /** Points to the instruction where allocas should be inserted before. */
@@ -483,6 +725,21 @@ private:
     Value result;
     /** Represents the `self` parameter of constructors and methods. */
     Value self;
+    /**
+     * Parameters of the current function that are borrowed from the caller,
+     * so they must not be destroyed.
+     */
+    llvm::SmallPtrSet<const llvm::Value*, 8> borrowedParams;
+    /** Variables of the current function that own a stack object. */
+    llvm::SmallPtrSet<const llvm::Value*, 8> stackVars;
+    /** Operands that expressions being walked still need. */
+    llvm::SmallVector<Value, 16> pendingValues;
+    /** Basic blocks that expressions being walked still need. */
+    llvm::SmallVector<llvm::BasicBlock*, 16> pendingBlocks;
+    /** Chains of ternaries being walked, the innermost last. */
+    std::vector<PendingTernary> pendingTernaries;
+    /** Calls being walked, the innermost last. */
+    std::vector<PendingCall> pendingCalls;
 };
 
 #endif // IREMITTER_HPP
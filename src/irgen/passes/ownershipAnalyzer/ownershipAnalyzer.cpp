@@ -0,0 +1,132 @@
+#include "ast/opKind.hpp"
+#include "irgen/passes/ownershipAnalyzer/ownershipAnalyzer.hpp"
+
+void OwnershipAnalyzer::visitFunction(FunctionNode& node)
+{
+    params = node.getParams();
+    inFunc = true;
+    visit(node.getBody());
+    params = {};
+    locals.clear();
+    inFunc = false;
+}
+
+void OwnershipAnalyzer::visitVariable(VariableNode& node)
+{
+    walk(node.getInit());
+    if (inFunc)
+    {
+        locals.push_back(&node);
+    }
+}
+
+void OwnershipAnalyzer::visitClass(ClassNode& node)
+{
+    if (node.hasCtor())
+    {
+        visit(node.getCtor());
+    }
+    for (MethodNode* method : node.getMethods())
+    {
+        visit(*method);
+    }
+}
+
+void OwnershipAnalyzer::visitMethod(MethodNode& node)
+{
+    visitFunction(node);
+}
+
+void OwnershipAnalyzer::visitCtor(CtorNode& node)
+{
+    visitFunction(node);
+}
+
+void OwnershipAnalyzer::visitBlock(BlockNode& node)
+{
+    for (Node* statement : node.getStatements())
+    {
+        visit(*statement);
+    }
+}
+
+void OwnershipAnalyzer::visitIf(IfNode& node)
+{
+    walk(node.getCondition());
+    visit(node.getThen());
+    if (node.hasElse())
+    {
+        visit(node.getElse());
+    }
+}
+
+void OwnershipAnalyzer::visitReturn(ReturnNode& node)
+{
+    if (node.hasValue())
+    {
+        walk(node.getValue());
+    }
+}
+
+void OwnershipAnalyzer::visitUnary(UnaryNode& node)
+{
+    walk(node.getExpr());
+}
+
+void OwnershipAnalyzer::visitBinary(BinaryNode& node)
+{
+    if (node.getOp() == BinaryKind::ASSIGN &&
+        node.getLhs().is(Node::IDENT))
+    {
+        // a local variable could shadow the parameter or another local, but
+        //  assuming that both are reassigned is always safe, just a bit slower
+        auto& ident = static_cast<IdentNode&>(node.getLhs());
+        for (ParamNode* param : params)
+        {
+            if (param->getSymbol() == ident.getSymbol())
+            {
+                param->setReassigned();
+            }
+        }
+        for (VariableNode* local : locals)
+        {
+            if (local->getSymbol() == ident.getSymbol())
+            {
+                local->setReassigned();
+            }
+        }
+    }
+    walk(node.getLhs());
+    walk(node.getRhs());
+}
+
+void OwnershipAnalyzer::visitTernary(TernaryNode& node)
+{
+    walk(node.getCondition());
+    walk(node.getThen());
+    walk(node.getElse());
+}
+
+void OwnershipAnalyzer::visitCall(CallNode& node)
+{
+    walk(node.getCallee());
+    for (ArgNode* arg : node.getArgs())
+    {
+        walk(*arg);
+    }
+}
+
+void OwnershipAnalyzer::visitArg(ArgNode& node)
+{
+    walk(node.getValue());
+}
+
+void OwnershipAnalyzer::visitFieldAccess(FieldAccessNode& node)
+{
+    walk(node.getObject());
+}
+
+void OwnershipAnalyzer::visitMethodCall(MethodCallNode& node)
+{
+    visitCall(node);
+}
@@ -0,0 +1,58 @@
+#ifndef OWNERSHIPANALYZER_HPP
+#define OWNERSHIPANALYZER_HPP
+
+#include "ast/node.hpp"
+#include "ast/nodeVisitor.hpp"
+#include "llvm/ADT/ArrayRef.h"
+#include <vector>
+
+/**
+ * Finds the function parameters that have to be owned by the callee.
+ *
+ * Parameters are passed at +0, meaning that the caller keeps ownership of the
+ * arguments and the callee only borrows them, so that passing an object to a
+ * function doesn't have to touch its refcount. That only works as long as the
+ * callee never overwrites the parameter, so this pass marks the ones that are
+ * reassigned, which the callee then takes ownership of by copying them on
+ * entry.
+ *
+ * The same goes for local variables, which only need storage of their own if
+ * they're reassigned. Everything else that isn't reassigned is emitted as an
+ * SSA value instead.
+ *
+ * Expressions are walked with an explicit stack, so that arbitrarily deep ones
+ * can be analyzed.
+ */
+class OwnershipAnalyzer : public NodeVisitor<OwnershipAnalyzer>
+{
+public:
+    /**
+     * Creates an OwnershipAnalyzer.
+     */
+    OwnershipAnalyzer() = default;
+    void visitFunction(FunctionNode& node);
+    void visitVariable(VariableNode& node);
+    void visitClass(ClassNode& node);
+    void visitMethod(MethodNode& node);
+    void visitCtor(CtorNode& node);
+    void visitBlock(BlockNode& node);
+    void visitIf(IfNode& node);
+    void visitReturn(ReturnNode& node);
+    void visitUnary(UnaryNode& node);
+    void visitBinary(BinaryNode& node);
+    void visitTernary(TernaryNode& node);
+    void visitCall(CallNode& node);
+    void visitArg(ArgNode& node);
+    void visitFieldAccess(FieldAccessNode& node);
+    void visitMethodCall(MethodCallNode& node);
+
+private:
+    /** Parameters of the function currently being analyzed. */
+    llvm::ArrayRef<ParamNode*> params;
+    /** Local variables declared so far in the current function. */
+    std::vector<VariableNode*> locals;
+    /** Whether a function is being analyzed. */
+    bool inFunc = false;
+};
+
+#endif // OWNERSHIPANALYZER_HPP
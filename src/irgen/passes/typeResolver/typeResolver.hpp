@@ -13,7 +13,7 @@
  * Gathers information on type declarations to resolve {@link UnresolvedType
  * UnresolvedTypes}.
  */
-class TypeResolver : public NodeVisitor
+class TypeResolver : public NodeVisitor<TypeResolver>
 {
 public:
     /**
@@ -25,9 +25,8 @@ public:
      */
     TypeResolver(VSLContext& vslCtx, TypeConverter& converter,
         llvm::Module& module);
-    virtual ~TypeResolver() override = default;
-    virtual void visitAST(llvm::ArrayRef<DeclNode*> ast) override;
-    virtual void visitClass(ClassNode& node) override;
+    void visitAST(llvm::ArrayRef<DeclNode*> ast);
+    void visitClass(ClassNode& node);
 
 private:
     /**
@@ -5,61 +5,73 @@ FuncScope::FuncScope()
 {
 }
 
-Value FuncScope::get(llvm::StringRef name) const
+Value FuncScope::get(Symbol name) const
 {
-    // go through each scope, starting at the most recent one
-    for (auto it = vars.rbegin(); it != vars.rend(); ++it)
+    unsigned id = name.getId();
+    if (id >= newest.size() || !newest[id])
     {
-        // if the variable was found, return it
-        if (Value value = it->lookup(name))
-        {
-            return value;
-        }
+        // not defined in any scope
+        return Value::getNull();
     }
-    // otherwise, return a null Value
-    return Value::getNull();
+    return vars[newest[id] - 1].second;
 }
 
-bool FuncScope::set(llvm::StringRef name, Value value)
+bool FuncScope::set(Symbol name, Value value)
 {
-    // insert returns a pair<iterator, bool> where bool is true if successful,
-    //  but we want the opposite of that according to our docs
-    return !vars.back().insert(std::make_pair(name, value)).second;
+    unsigned id = name.getId();
+    if (id >= newest.size())
+    {
+        newest.resize(id + 1);
+    }
+    // variables in older scopes can be shadowed, but not in the current one
+    if (newest[id] > scopes.back())
+    {
+        return true;
+    }
+    shadowed.push_back(newest[id]);
+    vars.emplace_back(name, value);
+    newest[id] = vars.size();
+    return false;
 }
 
 void FuncScope::enter()
 {
-    vars.emplace_back();
+    scopes.push_back(vars.size());
 }
 
 void FuncScope::exit()
 {
-    vars.pop_back();
+    // bring back whatever the variables in this scope shadowed
+    while (vars.size() > scopes.back())
+    {
+        newest[vars.back().first.getId()] = shadowed.back();
+        vars.pop_back();
+        shadowed.pop_back();
+    }
+    scopes.pop_back();
 }
 
 llvm::ArrayRef<FuncScope::VarItem> FuncScope::getVars() const
 {
-    const SymbolTable& table = vars.back();
-    // mapvector iterators are guaranteed to be its vector type's iterator
-    // since it's a std::vector, we can safely lower these to pointers because
-    //  it has contiguous storage
-    return llvm::makeArrayRef(&*table.begin(), &*table.end());
+    return llvm::makeArrayRef(vars).drop_front(scopes.back());
 }
 
 std::vector<llvm::ArrayRef<FuncScope::VarItem>> FuncScope::getAllVars() const
 {
-    std::vector<llvm::ArrayRef<VarItem>> scopes;
-    scopes.reserve(vars.size());
-    for (const SymbolTable& table : vars)
+    std::vector<llvm::ArrayRef<VarItem>> allVars;
+    allVars.reserve(scopes.size());
+    for (size_t i = 0; i < scopes.size(); ++i)
     {
-        scopes.emplace_back(&*table.begin(), &*table.end());
+        size_t end = i + 1 < scopes.size() ? scopes[i + 1] : vars.size();
+        allVars.push_back(llvm::makeArrayRef(vars).slice(scopes[i],
+            end - scopes[i]));
     }
-    return scopes;
+    return allVars;
 }
 
 bool FuncScope::empty() const
 {
-    return vars.empty();
+    return scopes.empty();
 }
 
 const Type* FuncScope::getReturnType() const
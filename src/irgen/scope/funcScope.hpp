@@ -1,16 +1,20 @@
 #ifndef FUNCSCOPE_HPP
 #define FUNCSCOPE_HPP
 
+#include "ast/symbol.hpp"
 #include "ast/type.hpp"
 #include "irgen/value/value.hpp"
-#include "llvm/ADT/MapVector.h"
-#include "llvm/ADT/StringMap.h"
-#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/ArrayRef.h"
 #include <utility>
 #include <vector>
 
 /**
  * Manages the multiple scopes in a function body.
+ *
+ * Variables are looked up by Symbol ID in a flat array that points to the
+ * newest variable with each name, so a lookup doesn't depend on how many scopes
+ * or variables there are. Each variable remembers the one it shadows, which
+ * takes its place again once its scope is exited.
  */
 class FuncScope
 {
@@ -19,7 +23,7 @@ public:
      * Represents a variable. Contains its name and Value (guaranteed to be a
      * variable Value).
      */
-    using VarItem = std::pair<llvm::StringRef, Value>;
+    using VarItem = std::pair<Symbol, Value>;
 
     /**
      * Creates a FuncScope.
@@ -34,7 +38,7 @@ public:
      *
      * @returns The Value associated with the given variable name.
      */
-    Value get(llvm::StringRef name) const;
+    Value get(Symbol name) const;
     /**
      * Sets a name to be associated with a variable.
      *
@@ -43,7 +47,7 @@ public:
      *
      * @returns False if the operation succeeded, true otherwise.
      */
-    bool set(llvm::StringRef name, Value value);
+    bool set(Symbol name, Value value);
     /**
      * Enters a new scope. The return type is the same as the last scope's
      * return type.
@@ -91,15 +95,20 @@ public:
     void setReturnType(const Type* returnType);
 
 private:
+    /** Every variable in scope, oldest first. */
+    std::vector<VarItem> vars;
     /**
-     * Represents a symbol table. This is a MapVector so that insertion order is
-     * kept when deleting variables when exiting the scope.
+     * For each variable in `vars`, one more than the index of the variable
+     * that it shadows, or 0 if it doesn't shadow anything.
      */
-    using SymbolTable = llvm::MapVector<llvm::StringRef, Value,
-        llvm::StringMap<unsigned>, std::vector<VarItem>>;
-
-    /** List of symbol tables in a scope, managed like a stack. */
-    std::vector<SymbolTable> vars;
+    std::vector<size_t> shadowed;
+    /**
+     * One more than the index in `vars` of the newest variable with each
+     * Symbol ID, or 0 if there isn't one. Grows as higher IDs are set.
+     */
+    std::vector<size_t> newest;
+    /** Where each scope starts in `vars`, managed like a stack. */
+    std::vector<size_t> scopes;
     /** The type that this function is supposed to return. */
     const Type* returnType;
 };
@@ -1,8 +1,13 @@
 #include "irgen/scope/globalScope.hpp"
 
-Value GlobalScope::get(llvm::StringRef name) const
+Value GlobalScope::get(Symbol name) const
 {
-    return symtab.lookup(name);
+    unsigned id = name.getId();
+    if (id >= symtab.size())
+    {
+        return Value::getNull();
+    }
+    return symtab[id];
 }
 
 std::pair<Value, Access> GlobalScope::getCtor(const Type* type) const
@@ -17,7 +22,7 @@ std::pair<Value, Access> GlobalScope::getCtor(const Type* type) const
 }
 
 std::pair<Value, Access> GlobalScope::getMethod(const Type* type,
-    llvm::StringRef name) const
+    Symbol name) const
 {
     auto it = methods.find(type);
     if (it == methods.end())
@@ -26,7 +31,12 @@ std::pair<Value, Access> GlobalScope::getMethod(const Type* type,
         return { Value::getNull(), Access::NONE };
     }
     // lookup the method
-    return it->second.lookup(name);
+    auto methodIt = it->second.find(name.getId());
+    if (methodIt == it->second.end())
+    {
+        return { Value::getNull(), Access::NONE };
+    }
+    return methodIt->second;
 }
 
 llvm::Function* GlobalScope::getDtor(const Type* type) const
@@ -39,18 +49,15 @@ llvm::Function* GlobalScope::getDtor(const Type* type) const
     return it->second;
 }
 
-bool GlobalScope::setFunc(llvm::StringRef name, const FunctionType* type,
+bool GlobalScope::setFunc(Symbol name, const FunctionType* type,
     llvm::Function* func)
 {
-    // try_emplace returns pair<iterator, bool> where bool is true if successful
-    // we want the opposite of that bool
-    return !symtab.try_emplace(name, Value::getFunc(type, func)).second;
+    return set(name, Value::getFunc(type, func));
 }
 
-bool GlobalScope::setVar(llvm::StringRef name, const Type* type,
-    llvm::Value* var)
+bool GlobalScope::setVar(Symbol name, const Type* type, llvm::Value* var)
 {
-    return !symtab.try_emplace(name, Value::getVar(type, var)).second;
+    return set(name, Value::getVar(type, var));
 }
 
 bool GlobalScope::setCtor(const Type* type, const FunctionType* vslFunc,
@@ -61,11 +68,13 @@ bool GlobalScope::setCtor(const Type* type, const FunctionType* vslFunc,
         std::make_pair(Value::getFunc(vslFunc, llvmFunc), access)).second;
 }
 
-bool GlobalScope::setMethod(const Type* type, llvm::StringRef name,
+bool GlobalScope::setMethod(const Type* type, Symbol name,
     const FunctionType* vslFunc, llvm::Function* llvmFunc, Access access)
 {
     assert(vslFunc->isMethod() && "not a method!");
-    return !methods[type].try_emplace(name,
+    // try_emplace returns pair<iterator, bool> where bool is true if successful
+    // we want the opposite of that bool
+    return !methods[type].try_emplace(name.getId(),
         Value::getFunc(vslFunc, llvmFunc), access).second;
 }
 
@@ -73,3 +82,19 @@ bool GlobalScope::setDtor(const Type* type, llvm::Function* llvmFunc)
 {
     return !dtors.emplace(type, llvmFunc).second;
 }
+
+bool GlobalScope::set(Symbol name, Value value)
+{
+    unsigned id = name.getId();
+    if (id >= symtab.size())
+    {
+        symtab.resize(id + 1);
+    }
+    if (symtab[id])
+    {
+        // already exists
+        return true;
+    }
+    symtab[id] = value;
+    return false;
+}
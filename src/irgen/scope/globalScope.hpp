@@ -2,16 +2,18 @@
 #define GLOBALSCOPE_HPP
 
 #include "ast/node.hpp"
+#include "ast/symbol.hpp"
 #include "ast/type.hpp"
 #include "irgen/value/value.hpp"
-#include "llvm/ADT/StringMap.h"
-#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/IR/Function.h"
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 /**
- * Manages objects in the the global scope, like functions and what not.
+ * Manages objects in the the global scope, like functions and what not. Names
+ * are looked up by their Symbol ID rather than by hashing the name.
  */
 class GlobalScope
 {
@@ -29,7 +31,7 @@ public:
      *
      * @returns The Value associated with the given object name.
      */
-    Value get(llvm::StringRef name) const;
+    Value get(Symbol name) const;
     /**
      * Gets the ctor associated with a type. If it can't be found, a pair
      * containing a null Value and `Access::NONE` is constructed and returned.
@@ -51,8 +53,7 @@ public:
      * @returns The method Value associated with the given object name along
      * with its access specifier.
      */
-    std::pair<Value, Access> getMethod(const Type* type,
-        llvm::StringRef method) const;
+    std::pair<Value, Access> getMethod(const Type* type, Symbol method) const;
     /**
      * Gets the destructor associated with a type. If it can't be found, null is
      * returned.
@@ -79,7 +80,7 @@ public:
      *
      * @returns False if the operation succeeded, true otherwise.
      */
-    bool setFunc(llvm::StringRef name, const FunctionType* type,
+    bool setFunc(Symbol name, const FunctionType* type,
         llvm::Function* func);
     /**
      * Sets a name to be associated with a variable.
@@ -90,8 +91,7 @@ public:
      *
      * @returns False if the operation succeeded, true otherwise.
      */
-    bool setVar(llvm::StringRef name, const Type* type,
-        llvm::Value* var);
+    bool setVar(Symbol name, const Type* type, llvm::Value* var);
     /**
      * Sets the constructor for the given type. This method returns true if the
      * constructor is already set.
@@ -117,7 +117,7 @@ public:
      *
      * @returns False if successful, true if the method already exists.
      */
-    bool setMethod(const Type* type, llvm::StringRef name,
+    bool setMethod(const Type* type, Symbol name,
         const FunctionType* vslFunc, llvm::Function* llvmFunc, Access access);
     /**
      * Sets the destructor function of a given type. The function should take
@@ -134,13 +134,27 @@ public:
     /** @} */
 
 private:
-    /** Symbol table of all the global objects. */
-    llvm::StringMap<Value> symtab;
+    /**
+     * Sets a name to be associated with a global object.
+     *
+     * @param name Name of the object.
+     * @param value The object's Value.
+     *
+     * @returns False if the operation succeeded, true otherwise.
+     */
+    bool set(Symbol name, Value value);
+    /**
+     * Symbol table of all the global objects, indexed by Symbol ID. Grows as
+     * higher IDs are set.
+     */
+    std::vector<Value> symtab;
     /** Constructors defined for every type. */
     std::unordered_map<const Type*, std::pair<Value, Access>> ctors;
-    /** Methods defined for each type along with access specifier. */
+    /**
+     * Methods defined for each type along with access specifier, by Symbol ID.
+     */
     std::unordered_map<const Type*,
-        llvm::StringMap<std::pair<Value, Access>>> methods;
+        llvm::DenseMap<unsigned, std::pair<Value, Access>>> methods;
     /** Destructor defined for every type. */
     std::unordered_map<const Type*, llvm::Function*> dtors;
 };
@@ -1,8 +1,20 @@
 #include "irgen/typeConverter/typeConverter.hpp"
 
-TypeConverter::TypeConverter(llvm::LLVMContext& llvmCtx)
+TypeConverter::TypeConverter(llvm::LLVMContext& llvmCtx,
+    const IRGenOptions& options)
     : llvmCtx{ llvmCtx }
 {
+    llvm::Type* i32 = llvm::Type::getInt32Ty(llvmCtx);
+    if (options.refcount == IRGenOptions::BIASED)
+    {
+        // biased count, shared count, owner thread
+        headerType = llvm::StructType::get(i32, i32,
+            llvm::Type::getInt8PtrTy(llvmCtx));
+    }
+    else
+    {
+        headerType = i32;
+    }
 }
 
 llvm::Type* TypeConverter::convert(const Type* type) const
@@ -101,8 +113,7 @@ void TypeConverter::addClassType(llvm::StringRef name, const ClassType* vslType,
     llvm::StructType* structType)
 {
     // structType equivalent but with a reference count in the front
-    auto* rcType = llvm::StructType::create(name,
-        llvm::Type::getInt32Ty(llvmCtx), structType);
+    auto* rcType = llvm::StructType::create(name, headerType, structType);
     // pointer to the reference-counted structType
     auto* refType = llvm::PointerType::getUnqual(rcType);
     // insert the class/reference types (result is pair<iterator, bool>)
@@ -111,6 +122,11 @@ void TypeConverter::addClassType(llvm::StringRef name, const ClassType* vslType,
     assert(pair.second && "Class already exists");
 }
 
+llvm::Type* TypeConverter::getHeaderType() const
+{
+    return headerType;
+}
+
 llvm::StructType* TypeConverter::getOpaqueType() const
 {
     return llvm::StructType::get(llvmCtx);
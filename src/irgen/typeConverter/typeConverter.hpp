@@ -2,6 +2,7 @@
 #define TYPECONVERTER_HPP
 
 #include "ast/vslContext.hpp"
+#include "irgen/irgenOptions.hpp"
 #include "irgen/scope/globalScope.hpp"
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/LLVMContext.h"
@@ -17,8 +18,10 @@ public:
      * Creates a TypeConverter.
      *
      * @param llvmCtx LLVM context object.
+     * @param options Decides what the object header looks like.
      */
-    TypeConverter(llvm::LLVMContext& llvmCtx);
+    TypeConverter(llvm::LLVMContext& llvmCtx,
+        const IRGenOptions& options = {});
     /**
      * Converts a type. This returns the LLVM opaque type if no type exists that
      * could represent the given VSL type.
@@ -49,6 +52,14 @@ public:
      */
     void addClassType(llvm::StringRef name, const ClassType* vslType,
         llvm::StructType* structType);
+    /**
+     * Gets the type of the header that every object starts with. Normally this
+     * is just the reference count, but biased reference counting needs the
+     * layout of struct vsl_brc from the runtime.
+     *
+     * @returns The object header type.
+     */
+    llvm::Type* getHeaderType() const;
 
 private:
     /**
@@ -59,6 +70,8 @@ private:
     llvm::StructType* getOpaqueType() const;
     /** LLVM context object. */
     llvm::LLVMContext& llvmCtx;
+    /** Type of the object header. */
+    llvm::Type* headerType;
     /** Maps VSL class types to LLVM references. */
     std::unordered_map<const ClassType*, llvm::PointerType*> classes;
 };
@@ -45,6 +45,11 @@ Value Value::getVar(const Type* vslType, llvm::Value* llvmVar)
     return { Kind::VAR, vslType, llvmVar };
 }
 
+Value Value::getLet(const Type* vslType, llvm::Value* llvmValue)
+{
+    return { Kind::LET, vslType, llvmValue };
+}
+
 Value Value::getField(Value base, const Type* vslField, llvm::Value* llvmField,
     bool destroyBase)
 {
@@ -76,7 +81,7 @@ Value::operator bool() const
 
 bool Value::isAssignable() const
 {
-    return isVar() || isField();
+    return kind == Kind::VAR || isField();
 }
 
 bool Value::isExpr() const
@@ -96,7 +101,12 @@ llvm::Value* Value::getLLVMValue() const
 
 bool Value::isVar() const
 {
-    return kind == Kind::VAR;
+    return kind == Kind::VAR || isLet();
+}
+
+bool Value::isLet() const
+{
+    return kind == Kind::LET;
 }
 
 const Type* Value::getVSLVar() const
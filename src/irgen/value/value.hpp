@@ -31,6 +31,17 @@ public:
     static Value getNull();
     static Value getExpr(const Type* vslType, llvm::Value* llvmValue);
     static Value getVar(const Type* vslType, llvm::Value* llvmVar);
+    /**
+     * Creates a local variable or parameter that's never reassigned, called
+     * a let here. These don't need any storage, so the LLVM value is the value
+     * of the variable itself instead of a pointer to it.
+     *
+     * @param vslType VSL type of the variable.
+     * @param llvmValue LLVM value of the variable.
+     *
+     * @returns A let value.
+     */
+    static Value getLet(const Type* vslType, llvm::Value* llvmValue);
     /**
      * Creates a field value.
      *
@@ -72,9 +83,9 @@ public:
      */
     operator bool() const;
     /**
-     * Checks whether this value is a variable or field. If true, the LLVM value
-     * is guaranteed to be a pointer to the actual value, so a load instruction
-     * must be used first to get to it.
+     * Checks whether this value is a variable that isn't a let, or a field. If
+     * true, the LLVM value is guaranteed to be a pointer to the actual value,
+     * so a load instruction must be used first to get to it.
      */
     bool isAssignable() const;
     bool isExpr() const;
@@ -95,11 +106,20 @@ public:
      * @{
      */
 
+    /**
+     * Checks whether this is a local or global variable, including lets.
+     */
     bool isVar() const;
+    /**
+     * Checks whether this is a variable that can't be reassigned. These aren't
+     * assignable.
+     */
+    bool isLet() const;
     const Type* getVSLVar() const;
     /**
-     * Guaranteed to have a pointer type. A load instruction must be created
-     * using this value to get the value of the variable.
+     * Guaranteed to have a pointer type, unless this is a let. A load
+     * instruction must be created using this value to get the value of the
+     * variable.
      */
     llvm::Value* getLLVMVar() const;
 
@@ -149,8 +169,10 @@ private:
         INVALID,
         /** Expression. */
         EXPR,
-        /** Local variable. */
+        /** Variable. */
         VAR,
+        /** Variable that can't be reassigned. */
+        LET,
         /** Field access. */
         FIELD,
         /** Function. */
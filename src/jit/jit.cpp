@@ -0,0 +1,290 @@
+#include "jit/jit.hpp"
+#include "vslrt.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ExecutionEngine/ExecutionEngine.h"
+#include "llvm/ExecutionEngine/JITSymbol.h"
+#include "llvm/ExecutionEngine/Orc/LambdaResolver.h"
+#include "llvm/ExecutionEngine/RTDyldMemoryManager.h"
+#include "llvm/ExecutionEngine/SectionMemoryManager.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Mangler.h"
+#include "llvm/Support/Casting.h"
+#include "llvm/Support/DynamicLibrary.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <cstdint>
+#include <set>
+
+namespace
+{
+
+/**
+ * Creates a machine for the host, which the JIT has to be able to run code
+ * on.
+ *
+ * @returns A new TargetMachine.
+ */
+std::unique_ptr<llvm::TargetMachine> createHostMachine()
+{
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+    llvm::InitializeNativeTargetAsmParser();
+    return std::unique_ptr<llvm::TargetMachine>{
+        llvm::EngineBuilder{}.selectTarget() };
+}
+
+/**
+ * Gets the functions that a module calls at startup or exit.
+ *
+ * @param module The module to look in.
+ * @param listName The name of the list, e.g. `llvm.global_ctors`.
+ * @param funcs Where to put the functions, in order.
+ */
+void getGlobalCalls(llvm::Module& module, llvm::StringRef listName,
+    llvm::SmallVectorImpl<llvm::Function*>& funcs)
+{
+    llvm::GlobalVariable* list = module.getNamedGlobal(listName);
+    if (!list || !list->hasInitializer())
+    {
+        return;
+    }
+    // an empty list is a zeroinitializer instead of an array
+    auto* entries = llvm::dyn_cast<llvm::ConstantArray>(list->getInitializer());
+    if (!entries)
+    {
+        return;
+    }
+    for (llvm::Value* entry : entries->operands())
+    {
+        auto* fields = llvm::cast<llvm::ConstantStruct>(entry);
+        if (auto* func = llvm::dyn_cast<llvm::Function>(
+                fields->getOperand(1)->stripPointerCasts()))
+        {
+            funcs.push_back(func);
+        }
+    }
+}
+
+} // end anonymous namespace
+
+JIT::JIT(Diag& diag)
+    : diag{ diag }, machine{ createHostMachine() },
+    dataLayout{ machine->createDataLayout() },
+    objectLayer{ []
+        {
+            return std::make_shared<llvm::SectionMemoryManager>();
+        } },
+    compileLayer{ objectLayer, llvm::orc::SimpleCompiler{ *machine } },
+    callbackManager{ llvm::orc::createLocalCompileCallbackManager(
+            machine->getTargetTriple(), /*ErrorHandlerAddress=*/0) },
+    lazyLayer{ compileLayer,
+        // each function gets compiled on its own, the first time it's called
+        [](llvm::Function& func) { return std::set<llvm::Function*>{ &func }; },
+        *callbackManager,
+        llvm::orc::createLocalIndirectStubsManagerBuilder(
+            machine->getTargetTriple()) },
+    numModules{ 0 }
+{
+    // external functions can be anything in this process, e.g. libc
+    llvm::sys::DynamicLibrary::LoadLibraryPermanently(nullptr);
+    // the runtime is linked in, but its symbols aren't exported for the jit
+    //  to find on its own
+    llvm::sys::DynamicLibrary::AddSymbol("vsl_alloc",
+        reinterpret_cast<void*>(&vsl_alloc));
+    llvm::sys::DynamicLibrary::AddSymbol("vsl_free",
+        reinterpret_cast<void*>(&vsl_free));
+    llvm::sys::DynamicLibrary::AddSymbol("vsl_brc_init",
+        reinterpret_cast<void*>(&vsl_brc_init));
+    llvm::sys::DynamicLibrary::AddSymbol("vsl_brc_retain",
+        reinterpret_cast<void*>(&vsl_brc_retain));
+    llvm::sys::DynamicLibrary::AddSymbol("vsl_brc_release",
+        reinterpret_cast<void*>(&vsl_brc_release));
+}
+
+JIT::~JIT()
+{
+    for (auto it = dtors.rbegin(); it != dtors.rend(); ++it)
+    {
+        if (void* dtor = getAddress(*it))
+        {
+            reinterpret_cast<void (*)()>(dtor)();
+        }
+    }
+}
+
+llvm::LLVMContext& JIT::getContext()
+{
+    return llvmContext;
+}
+
+void JIT::linkExisting(llvm::Module& module)
+{
+    // the functions called at startup and exit are specific to each module,
+    //  and get taken care of when it's added
+    llvm::SmallVector<llvm::Function*, 2> globalCalls;
+    getGlobalCalls(module, "llvm.global_ctors", globalCalls);
+    getGlobalCalls(module, "llvm.global_dtors", globalCalls);
+    for (llvm::GlobalValue& value : module.global_values())
+    {
+        if (value.isDeclaration() || value.hasPrivateLinkage() ||
+            std::find(globalCalls.begin(), globalCalls.end(), &value) !=
+                globalCalls.end())
+        {
+            continue;
+        }
+        if (defined.count(value.getName()))
+        {
+            // use the existing definition instead of this one
+            if (auto* func = llvm::dyn_cast<llvm::Function>(&value))
+            {
+                func->deleteBody();
+            }
+            else if (auto* var = llvm::dyn_cast<llvm::GlobalVariable>(&value))
+            {
+                var->setInitializer(nullptr);
+            }
+        }
+        value.setLinkage(llvm::GlobalValue::ExternalLinkage);
+    }
+    // the existing global variables were already initialized, and shouldn't
+    //  be destroyed twice either
+    for (llvm::Function* func : globalCalls)
+    {
+        for (llvm::BasicBlock& block : *func)
+        {
+            for (auto it = block.begin(); it != block.end();)
+            {
+                auto* call = llvm::dyn_cast<llvm::CallInst>(&*it++);
+                llvm::Function* callee = call ? call->getCalledFunction() :
+                    nullptr;
+                if (callee && callee->isDeclaration() &&
+                    defined.count(callee->getName()))
+                {
+                    call->eraseFromParent();
+                }
+            }
+        }
+    }
+}
+
+bool JIT::addModule(std::unique_ptr<llvm::Module> module)
+{
+    std::vector<std::string> ctors;
+    std::vector<std::string> newDtors;
+    takeGlobalCalls(*module, "llvm.global_ctors", ctors);
+    takeGlobalCalls(*module, "llvm.global_dtors", newDtors);
+    // the lazy layer makes local symbols external so that each function can
+    //  still get to them once it's split off, so they need unique names
+    std::string suffix = ".jit" + std::to_string(numModules);
+    ++numModules;
+    for (llvm::GlobalValue& value : module->global_values())
+    {
+        if (value.hasLocalLinkage())
+        {
+            value.setName(value.getName() + suffix);
+        }
+        else if (!value.isDeclaration())
+        {
+            defined.insert(value.getName());
+        }
+    }
+    // symbols are looked up in the jit first, so that later modules can use
+    //  the earlier ones, then in the rest of the process
+    auto resolver = llvm::orc::createLambdaResolver(
+        [this](const std::string& name)
+        {
+            auto it = symbols.find(name);
+            if (it != symbols.end())
+            {
+                return llvm::JITSymbol{ it->getValue(),
+                    llvm::JITSymbolFlags::Exported };
+            }
+            return lazyLayer.findSymbol(name, /*ExportedSymbolsOnly=*/false);
+        },
+        [](const std::string& name)
+        {
+            if (llvm::JITTargetAddress address =
+                    llvm::RTDyldMemoryManager::getSymbolAddressInProcess(name))
+            {
+                return llvm::JITSymbol{ address,
+                    llvm::JITSymbolFlags::Exported };
+            }
+            return llvm::JITSymbol{ nullptr };
+        });
+    llvm::Expected<LazyLayer::ModuleHandleT> handle =
+        lazyLayer.addModule(std::move(module), std::move(resolver));
+    if (!handle)
+    {
+        diag.print<Diag::CANT_JIT>(llvm::toString(handle.takeError()));
+        return false;
+    }
+    for (const std::string& name : ctors)
+    {
+        if (void* ctor = getAddress(name))
+        {
+            reinterpret_cast<void (*)()>(ctor)();
+        }
+    }
+    dtors.insert(dtors.end(), newDtors.begin(), newDtors.end());
+    return true;
+}
+
+void* JIT::getAddress(llvm::StringRef name)
+{
+    llvm::JITSymbol symbol = lazyLayer.findSymbol(mangle(name),
+        /*ExportedSymbolsOnly=*/false);
+    if (!symbol)
+    {
+        if (llvm::Error error = symbol.takeError())
+        {
+            diag.print<Diag::CANT_JIT>(llvm::toString(std::move(error)));
+        }
+        return nullptr;
+    }
+    llvm::Expected<llvm::JITTargetAddress> address = symbol.getAddress();
+    if (!address)
+    {
+        diag.print<Diag::CANT_JIT>(llvm::toString(address.takeError()));
+        return nullptr;
+    }
+    return reinterpret_cast<void*>(static_cast<uintptr_t>(*address));
+}
+
+void JIT::addSymbol(llvm::StringRef name, void* address)
+{
+    symbols[mangle(name)] = static_cast<llvm::JITTargetAddress>(
+        reinterpret_cast<uintptr_t>(address));
+}
+
+void JIT::takeGlobalCalls(llvm::Module& module, llvm::StringRef listName,
+    std::vector<std::string>& names)
+{
+    llvm::SmallVector<llvm::Function*, 1> funcs;
+    getGlobalCalls(module, listName, funcs);
+    // e.g. vsl.jit.ctors.3.0 for the first ctor of the fourth module
+    std::string prefix = "vsl.jit." + listName.drop_front(12).str() + "." +
+        std::to_string(numModules) + ".";
+    for (llvm::Function* func : funcs)
+    {
+        func->setName(prefix + std::to_string(names.size()));
+        func->setLinkage(llvm::GlobalValue::ExternalLinkage);
+        names.push_back(func->getName().str());
+    }
+    if (llvm::GlobalVariable* list = module.getNamedGlobal(listName))
+    {
+        list->eraseFromParent();
+    }
+}
+
+std::string JIT::mangle(llvm::StringRef name) const
+{
+    std::string mangled;
+    llvm::raw_string_ostream os{ mangled };
+    llvm::Mangler::getNameWithPrefix(os, name, dataLayout);
+    return os.str();
+}
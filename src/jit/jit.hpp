@@ -0,0 +1,140 @@
+#ifndef JIT_HPP
+#define JIT_HPP
+
+#include "diag/diag.hpp"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/ExecutionEngine/JITSymbol.h"
+#include "llvm/ExecutionEngine/Orc/CompileOnDemandLayer.h"
+#include "llvm/ExecutionEngine/Orc/CompileUtils.h"
+#include "llvm/ExecutionEngine/Orc/IRCompileLayer.h"
+#include "llvm/ExecutionEngine/Orc/IndirectionUtils.h"
+#include "llvm/ExecutionEngine/Orc/RTDyldObjectLinkingLayer.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Target/TargetMachine.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Runs VSL code in the compiler's own process using LLVM's ORC JIT. Modules
+ * are added one after another, and later modules can use anything from the
+ * earlier ones, which is what the run REPL needs.
+ *
+ * Functions are only compiled the first time they're called, so a big module
+ * only pays for what actually runs. Global variables are initialized as each
+ * module is added, and destroyed along with the JIT.
+ */
+class JIT
+{
+public:
+    /**
+     * Creates a JIT for the host.
+     *
+     * @param diag Diagnostics manager.
+     */
+    JIT(Diag& diag);
+    /**
+     * Destroys the global variables of every module, newest first.
+     */
+    ~JIT();
+    /**
+     * Gets the context that modules have to be created in, which lives as
+     * long as the JIT does.
+     *
+     * @returns The LLVMContext.
+     */
+    llvm::LLVMContext& getContext();
+    /**
+     * Links a module against what the JIT already has. This has to be done
+     * before the module is optimized, so that nothing the later modules need
+     * gets optimized away. Internal symbols become external, and any definition
+     * that's already in the JIT becomes a declaration of the existing one,
+     * which is what happens to everything in a REPL line that came from the
+     * earlier lines.
+     *
+     * @param module The module that's about to be added.
+     */
+    void linkExisting(llvm::Module& module);
+    /**
+     * Adds a module and initializes its global variables.
+     *
+     * @param module The module to add.
+     *
+     * @returns True on success, false otherwise.
+     */
+    bool addModule(std::unique_ptr<llvm::Module> module);
+    /**
+     * Gets the address of a function or variable that was added, compiling it
+     * if needed.
+     *
+     * @param name The name of the symbol.
+     *
+     * @returns The address of the symbol, or null if it doesn't exist.
+     */
+    void* getAddress(llvm::StringRef name);
+    /**
+     * Defines a symbol that lives outside the JIT, which modules added later
+     * can link against by declaring it.
+     *
+     * @param name The name of the symbol.
+     * @param address The address of the symbol.
+     */
+    void addSymbol(llvm::StringRef name, void* address);
+
+private:
+    /** Compiles modules into the object layer. */
+    using CompileLayer = llvm::orc::IRCompileLayer<
+        llvm::orc::RTDyldObjectLinkingLayer, llvm::orc::SimpleCompiler>;
+    /** Splits modules into functions that are compiled on their first call. */
+    using LazyLayer = llvm::orc::CompileOnDemandLayer<CompileLayer>;
+    /**
+     * Takes the global ctor or dtor functions out of a module, so they can be
+     * called directly. They get unique names so they don't clash with any
+     * other module's.
+     *
+     * @param module The module to take them from.
+     * @param listName The name of the list, e.g. `llvm.global_ctors`.
+     * @param names Where to put the names of the functions, in order.
+     */
+    void takeGlobalCalls(llvm::Module& module, llvm::StringRef listName,
+        std::vector<std::string>& names);
+    /**
+     * Mangles a name the way the target does, e.g. with a leading underscore
+     * on MachO.
+     *
+     * @param name The name to mangle.
+     *
+     * @returns The mangled name.
+     */
+    std::string mangle(llvm::StringRef name) const;
+    /** Diagnostics manager. */
+    Diag& diag;
+    /** Context that all the modules are created in. */
+    llvm::LLVMContext llvmContext;
+    /** Machine to generate code for. */
+    std::unique_ptr<llvm::TargetMachine> machine;
+    /** Data layout of the machine. */
+    const llvm::DataLayout dataLayout;
+    /** Loads and links object code into memory. */
+    llvm::orc::RTDyldObjectLinkingLayer objectLayer;
+    /** Compiles IR into object code. */
+    CompileLayer compileLayer;
+    /** Creates the stubs that compile functions on their first call. */
+    std::unique_ptr<llvm::orc::JITCompileCallbackManager> callbackManager;
+    /** Compiles functions lazily. */
+    LazyLayer lazyLayer;
+    /** Names of everything that's been defined so far. */
+    llvm::StringSet<> defined;
+    /** Symbols defined outside the JIT, by mangled name. */
+    llvm::StringMap<llvm::JITTargetAddress> symbols;
+    /** Names of the global dtor functions of every module, in order. */
+    std::vector<std::string> dtors;
+    /** Number of modules added so far, used to name the ctors and dtors. */
+    unsigned numModules;
+};
+
+#endif // JIT_HPP
@@ -0,0 +1,249 @@
+#include "lexer/charInfo.hpp"
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include <cstdint>
+
+constexpr CharClassTable charClassTable;
+
+namespace
+{
+
+#if defined(__AVX2__)
+
+/** A vector of characters. */
+using Vec = __m256i;
+/** Bitmask with one bit per character in a Vec. */
+using Mask = uint32_t;
+/** Number of characters in a Vec. */
+constexpr int vecSize = 32;
+
+inline Vec load(const char* p)
+{
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+inline Vec splat(char c)
+{
+    return _mm256_set1_epi8(c);
+}
+
+inline Vec cmpEq(Vec a, Vec b)
+{
+    return _mm256_cmpeq_epi8(a, b);
+}
+
+inline Vec cmpGt(Vec a, Vec b)
+{
+    return _mm256_cmpgt_epi8(a, b);
+}
+
+inline Vec vecOr(Vec a, Vec b)
+{
+    return _mm256_or_si256(a, b);
+}
+
+inline Vec vecAnd(Vec a, Vec b)
+{
+    return _mm256_and_si256(a, b);
+}
+
+inline Mask toMask(Vec v)
+{
+    return static_cast<Mask>(_mm256_movemask_epi8(v));
+}
+
+#elif defined(__SSE2__)
+
+/** A vector of characters. */
+using Vec = __m128i;
+/** Bitmask with one bit per character in a Vec. */
+using Mask = uint32_t;
+/** Number of characters in a Vec. */
+constexpr int vecSize = 16;
+
+inline Vec load(const char* p)
+{
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+inline Vec splat(char c)
+{
+    return _mm_set1_epi8(c);
+}
+
+inline Vec cmpEq(Vec a, Vec b)
+{
+    return _mm_cmpeq_epi8(a, b);
+}
+
+inline Vec cmpGt(Vec a, Vec b)
+{
+    return _mm_cmpgt_epi8(a, b);
+}
+
+inline Vec vecOr(Vec a, Vec b)
+{
+    return _mm_or_si128(a, b);
+}
+
+inline Vec vecAnd(Vec a, Vec b)
+{
+    return _mm_and_si128(a, b);
+}
+
+inline Mask toMask(Vec v)
+{
+    return static_cast<Mask>(_mm_movemask_epi8(v));
+}
+
+#endif
+
+#if defined(__AVX2__) || defined(__SSE2__)
+
+/** Has a bit set for every character in a Vec. */
+constexpr Mask fullMask =
+    vecSize == 32 ? ~Mask{ 0 } : (Mask{ 1 } << vecSize) - 1;
+
+/**
+ * Tests which characters are within an inclusive range. The comparisons are
+ * signed, so characters above 127 are never in range.
+ */
+inline Vec inRange(Vec v, char lo, char hi)
+{
+    return vecAnd(cmpGt(v, splat(lo - 1)), cmpGt(splat(hi + 1), v));
+}
+
+inline Vec spaceMask(Vec v)
+{
+    return vecOr(cmpEq(v, splat(' ')), inRange(v, '\t', '\r'));
+}
+
+inline Vec digitMask(Vec v)
+{
+    return inRange(v, '0', '9');
+}
+
+inline Vec alnumMask(Vec v)
+{
+    // setting the 0x20 bit maps uppercase letters onto lowercase ones without
+    //  mapping anything else into a-z
+    return vecOr(digitMask(v), inRange(vecOr(v, splat(0x20)), 'a', 'z'));
+}
+
+/**
+ * Skips characters while they match a predicate, a Vec at a time.
+ *
+ * @tparam Pred Gets the characters of a Vec that should be skipped.
+ *
+ * @returns The first character that wasn't skipped, or a position near the end
+ * of the buffer where the caller should continue a character at a time.
+ */
+template<Vec (*Pred)(Vec)>
+inline const char* skipVec(const char* p, const char* end)
+{
+    while (end - p >= vecSize)
+    {
+        Mask stop = ~toMask(Pred(load(p))) & fullMask;
+        if (stop)
+        {
+            return p + __builtin_ctz(stop);
+        }
+        p += vecSize;
+    }
+    return p;
+}
+
+#endif
+
+} // end anonymous namespace
+
+const char* skipSpaces(const char* p, const char* end)
+{
+#if defined(__AVX2__) || defined(__SSE2__)
+    // most runs of whitespace are a single space, which isn't worth the setup
+    if (!isSpace(*p))
+    {
+        return p;
+    }
+    p = skipVec<spaceMask>(p, end);
+#endif
+    while (isSpace(*p))
+    {
+        ++p;
+    }
+    return p;
+}
+
+const char* skipAlnums(const char* p, const char* end)
+{
+#if defined(__AVX2__) || defined(__SSE2__)
+    p = skipVec<alnumMask>(p, end);
+#endif
+    while (isAlnum(*p))
+    {
+        ++p;
+    }
+    return p;
+}
+
+const char* skipDigits(const char* p, const char* end)
+{
+#if defined(__AVX2__) || defined(__SSE2__)
+    p = skipVec<digitMask>(p, end);
+#endif
+    while (isDigit(*p))
+    {
+        ++p;
+    }
+    return p;
+}
+
+const char* findLineEnd(const char* p, const char* end)
+{
+#if defined(__AVX2__) || defined(__SSE2__)
+    while (end - p >= vecSize)
+    {
+        Vec v = load(p);
+        Mask stop =
+            toMask(vecOr(cmpEq(v, splat('\n')), cmpEq(v, splat('\0'))));
+        if (stop)
+        {
+            return p + __builtin_ctz(stop);
+        }
+        p += vecSize;
+    }
+#endif
+    while (*p != '\n' && *p != '\0')
+    {
+        ++p;
+    }
+    return p;
+}
+
+const char* findBlockCommentStop(const char* p, const char* end)
+{
+#if defined(__AVX2__) || defined(__SSE2__)
+    // the second load looks one character ahead, which can at most reach the
+    //  null terminator
+    while (end - p >= vecSize)
+    {
+        Vec v = load(p);
+        Vec next = load(p + 1);
+        Vec here = vecOr(cmpEq(v, splat('*')), cmpEq(v, splat('\0')));
+        Mask stop = toMask(vecOr(here, cmpEq(next, splat('/'))));
+        if (stop)
+        {
+            return p + __builtin_ctz(stop);
+        }
+        p += vecSize;
+    }
+#endif
+    while (*p != '\0' && *p != '*' && p[1] != '/')
+    {
+        ++p;
+    }
+    return p;
+}
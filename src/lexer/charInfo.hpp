@@ -0,0 +1,151 @@
+#ifndef CHARINFO_HPP
+#define CHARINFO_HPP
+
+/**
+ * The classes that a character can belong to. Unlike the functions in
+ * `<cctype>`, these only consider ASCII characters and don't depend on the
+ * current locale.
+ */
+enum CharClass : unsigned char
+{
+    /** Not in any class. */
+    CHAR_NONE = 0,
+    /** Whitespace, as in `isspace`. */
+    CHAR_SPACE = 1 << 0,
+    /** Letters, as in `isalpha`. */
+    CHAR_ALPHA = 1 << 1,
+    /** Decimal digits, as in `isdigit`. */
+    CHAR_DIGIT = 1 << 2
+};
+
+/**
+ * Maps every possible character to its CharClass flags.
+ */
+struct CharClassTable
+{
+    /**
+     * Fills in the table. This is done at compile time.
+     */
+    constexpr CharClassTable();
+    /** The class flags of each character. */
+    unsigned char classes[256];
+};
+
+constexpr CharClassTable::CharClassTable()
+    : classes{}
+{
+    for (int c = 0; c < 256; ++c)
+    {
+        unsigned char flags = CHAR_NONE;
+        if (c == ' ' || (c >= '\t' && c <= '\r'))
+        {
+            flags |= CHAR_SPACE;
+        }
+        if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))
+        {
+            flags |= CHAR_ALPHA;
+        }
+        if (c >= '0' && c <= '9')
+        {
+            flags |= CHAR_DIGIT;
+        }
+        classes[c] = flags;
+    }
+}
+
+/** The table used by the character classification functions. */
+extern const CharClassTable charClassTable;
+
+/**
+ * Tests if a character belongs to any of the given classes.
+ *
+ * @param c The character to test.
+ * @param flags The CharClass flags to test for.
+ *
+ * @returns True if c is in one of the classes, false otherwise.
+ */
+inline bool isCharClass(char c, unsigned char flags)
+{
+    return charClassTable.classes[static_cast<unsigned char>(c)] & flags;
+}
+
+inline bool isSpace(char c)
+{
+    return isCharClass(c, CHAR_SPACE);
+}
+
+inline bool isAlpha(char c)
+{
+    return isCharClass(c, CHAR_ALPHA);
+}
+
+inline bool isDigit(char c)
+{
+    return isCharClass(c, CHAR_DIGIT);
+}
+
+inline bool isAlnum(char c)
+{
+    return isCharClass(c, CHAR_ALPHA | CHAR_DIGIT);
+}
+
+/**
+ * @name Scanning
+ * These find the end of a run of characters, checking 16 or 32 of them at a
+ * time when SSE2 or AVX2 is available. `end` must point to the null terminator
+ * at the end of the buffer, and a null character always stops the scan.
+ *
+ * @{
+ */
+
+/**
+ * Skips whitespace.
+ *
+ * @param p Where to start scanning.
+ * @param end The null terminator at the end of the buffer.
+ *
+ * @returns The first non-whitespace character at or after p.
+ */
+const char* skipSpaces(const char* p, const char* end);
+/**
+ * Skips letters and digits, the body of an identifier.
+ *
+ * @param p Where to start scanning.
+ * @param end The null terminator at the end of the buffer.
+ *
+ * @returns The first non-alphanumeric character at or after p.
+ */
+const char* skipAlnums(const char* p, const char* end);
+/**
+ * Skips decimal digits.
+ *
+ * @param p Where to start scanning.
+ * @param end The null terminator at the end of the buffer.
+ *
+ * @returns The first non-digit character at or after p.
+ */
+const char* skipDigits(const char* p, const char* end);
+/**
+ * Finds the end of the current line.
+ *
+ * @param p Where to start scanning.
+ * @param end The null terminator at the end of the buffer.
+ *
+ * @returns The first newline or null character at or after p.
+ */
+const char* findLineEnd(const char* p, const char* end);
+/**
+ * Finds where a block comment could end, which is the first `*` or the first
+ * character followed by a `/`.
+ *
+ * @param p Where to start scanning.
+ * @param end The null terminator at the end of the buffer.
+ *
+ * @returns The first such character at or after p, or the first null
+ * character.
+ */
+const char* findBlockCommentStop(const char* p, const char* end);
+
+/** @} */
+
+#endif // CHARINFO_HPP
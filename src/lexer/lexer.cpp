@@ -7,6 +7,14 @@ Lexer::Lexer(Diag& diag)
 
 Lexer::~Lexer() = default;
 
+void Lexer::nextTokens(llvm::MutableArrayRef<Token> tokens)
+{
+    for (Token& token : tokens)
+    {
+        token = nextToken();
+    }
+}
+
 Diag& Lexer::getDiag() const
 {
     return diag;
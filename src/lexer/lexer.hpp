@@ -3,6 +3,7 @@
 
 #include "diag/diag.hpp"
 #include "lexer/token.hpp"
+#include "llvm/ADT/ArrayRef.h"
 #include <memory>
 
 /**
@@ -24,6 +25,14 @@ public:
      * @returns The next token.
      */
     virtual Token nextToken() = 0;
+    /**
+     * Gets a batch of tokens at once, which saves a virtual call per token.
+     * Once the end of the input is reached, the rest of the batch is filled
+     * with eof tokens.
+     *
+     * @param tokens Where to put the tokens.
+     */
+    virtual void nextTokens(llvm::MutableArrayRef<Token> tokens);
     /**
      * Tests if this Lexer is all out of tokens.
      *
@@ -1,11 +1,21 @@
 #include "lexer/location.hpp"
 
-llvm::raw_ostream& operator<<(llvm::raw_ostream& os, const Location& location)
+Location::Location()
+    : ptr{ nullptr }
 {
-    return os << "file:" << location.line << ':' << location.col;
 }
 
-Location::Location(size_t line, size_t col)
-    : line{ line }, col{ col }
+Location::Location(const char* ptr)
+    : ptr{ ptr }
 {
 }
+
+const char* Location::getPointer() const
+{
+    return ptr;
+}
+
+bool Location::isValid() const
+{
+    return ptr;
+}
@@ -1,43 +1,43 @@
 #ifndef LOCATION_HPP
 #define LOCATION_HPP
 
-#include "llvm/Support/raw_ostream.h"
-#include <cstddef>
-
-class Location;
-
-/**
- * Allows a Location to be printed to an output stream.
- *
- * @param os The stream to print to.
- * @param location The location to print.
- *
- * @returns The given output stream.
- */
-llvm::raw_ostream& operator<<(llvm::raw_ostream& os, const Location& location);
-
 /**
  * Represents the location of an object in the source code of a program. Used
  * in error messages and the like.
+ *
+ * This is only a pointer into the source code owned by the SourceManager,
+ * which is what turns it into a line and column number, and only when a
+ * diagnostic actually needs to be printed.
  */
 class Location
 {
 public:
     /**
-     * Creates a Location.
+     * Creates an invalid Location.
      */
-    Location() = default;
+    Location();
     /**
      * Creates a Location.
      *
-     * @param line The line number.
-     * @param col The column number.
+     * @param ptr The character in the source code that this points to.
+     */
+    explicit Location(const char* ptr);
+    /**
+     * Gets the character in the source code that this Location points to.
+     *
+     * @returns A pointer into the source code.
      */
-    Location(size_t line, size_t col);
-    /** The line number. */
-    size_t line;
-    /** The column number. */
-    size_t col;
+    const char* getPointer() const;
+    /**
+     * Checks if this Location actually points to something.
+     *
+     * @returns True if valid, false otherwise.
+     */
+    bool isValid() const;
+
+private:
+    /** The character in the source code that this points to. */
+    const char* ptr;
 };
 
 #endif // LOCATION_HPP
@@ -0,0 +1,108 @@
+#include "lexer/sourceManager.hpp"
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#include <algorithm>
+#include <cstring>
+
+std::error_code SourceManager::open(llvm::StringRef filename)
+{
+    // requiring a null terminator still lets llvm mmap the file as long as its
+    //  size isn't a multiple of the page size, since the rest of the last page
+    //  is zero-filled by the OS
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> file =
+        llvm::MemoryBuffer::getFileOrSTDIN(filename, -1,
+            /*RequiresNullTerminator=*/true);
+    if (std::error_code ec = file.getError())
+    {
+        return ec;
+    }
+    buffer = std::move(file.get());
+    lineStarts.clear();
+    adviseSequential();
+    return {};
+}
+
+void SourceManager::setBuffer(llvm::StringRef text, llvm::StringRef name)
+{
+    buffer = llvm::MemoryBuffer::getMemBuffer(text, name,
+        /*RequiresNullTerminator=*/true);
+    lineStarts.clear();
+}
+
+llvm::StringRef SourceManager::getBuffer() const
+{
+    return buffer ? buffer->getBuffer() : "";
+}
+
+llvm::StringRef SourceManager::getName() const
+{
+    return buffer ? buffer->getBufferIdentifier() : "";
+}
+
+bool SourceManager::contains(Location loc) const
+{
+    llvm::StringRef text = getBuffer();
+    // the null terminator counts too, since that's where eof tokens are
+    return loc.getPointer() >= text.begin() && loc.getPointer() <= text.end();
+}
+
+std::pair<unsigned, unsigned> SourceManager::getLineAndCol(Location loc) const
+{
+    std::lock_guard<std::mutex> lock{ lineStartsMutex };
+    buildLineTable();
+    auto offset = static_cast<uint32_t>(loc.getPointer() -
+        getBuffer().begin());
+    // find the last line that starts at or before the offset
+    auto it = std::upper_bound(lineStarts.begin(), lineStarts.end(), offset);
+    auto line = static_cast<unsigned>(it - lineStarts.begin());
+    return { line, offset - *(it - 1) + 1 };
+}
+
+void SourceManager::print(llvm::raw_ostream& os, Location loc) const
+{
+    if (!contains(loc))
+    {
+        os << "<unknown>";
+        return;
+    }
+    std::pair<unsigned, unsigned> lineAndCol = getLineAndCol(loc);
+    os << getName() << ':' << lineAndCol.first << ':' << lineAndCol.second;
+}
+
+void SourceManager::adviseSequential() const
+{
+#if defined(__unix__) || defined(__APPLE__)
+    if (buffer->getBufferKind() != llvm::MemoryBuffer::MemoryBuffer_MMap)
+    {
+        return;
+    }
+    // madvise wants a page-aligned address, so round the start down
+    auto pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    auto start = reinterpret_cast<uintptr_t>(buffer->getBufferStart());
+    auto end = reinterpret_cast<uintptr_t>(buffer->getBufferEnd());
+    auto begin = start & ~(pageSize - 1);
+    auto* addr = reinterpret_cast<void*>(begin);
+    // these are only hints, so failure isn't worth reporting
+    madvise(addr, end - begin, MADV_SEQUENTIAL);
+    madvise(addr, end - begin, MADV_WILLNEED);
+#endif
+}
+
+void SourceManager::buildLineTable() const
+{
+    if (!lineStarts.empty())
+    {
+        return;
+    }
+    llvm::StringRef text = getBuffer();
+    lineStarts.push_back(0);
+    const char* p = text.begin();
+    while (auto* newline = static_cast<const char*>(
+            std::memchr(p, '\n', text.end() - p)))
+    {
+        p = newline + 1;
+        lineStarts.push_back(static_cast<uint32_t>(p - text.begin()));
+    }
+}
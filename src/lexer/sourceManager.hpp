@@ -0,0 +1,106 @@
+#ifndef SOURCEMANAGER_HPP
+#define SOURCEMANAGER_HPP
+
+#include "lexer/location.hpp"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+/**
+ * Owns the source code of a program. Tokens and AST nodes refer directly into
+ * the buffer held by this object, so it must outlive them.
+ *
+ * Files are memory-mapped when they're large enough for it to pay off, which
+ * means that the source is never copied and is only paged in as the lexer gets
+ * to it. Either way, the buffer is always followed by a null terminator that
+ * the lexer uses as a sentinel.
+ */
+class SourceManager
+{
+public:
+    /**
+     * Creates an empty SourceManager.
+     */
+    SourceManager() = default;
+    /**
+     * Opens a source file.
+     *
+     * @param filename The file to open, or "-" for stdin.
+     *
+     * @returns An error code describing what went wrong, if anything.
+     */
+    std::error_code open(llvm::StringRef filename);
+    /**
+     * Uses source code that's already in memory, e.g. from the REPL. The text
+     * is not copied.
+     *
+     * @param text The source code. Must be followed by a null terminator.
+     * @param name What to call the buffer in diagnostics.
+     */
+    void setBuffer(llvm::StringRef text, llvm::StringRef name = "<input>");
+    /**
+     * Gets the source code. The character just past the end of the returned
+     * StringRef is guaranteed to be a null terminator.
+     *
+     * @returns The source code.
+     */
+    llvm::StringRef getBuffer() const;
+    /**
+     * Gets the name of the buffer, usually the file it came from.
+     *
+     * @returns The name of the buffer.
+     */
+    llvm::StringRef getName() const;
+    /**
+     * Checks if a Location points into the source code.
+     *
+     * @param loc The location to check.
+     *
+     * @returns True if it does, false otherwise.
+     */
+    bool contains(Location loc) const;
+    /**
+     * Computes the line and column number of a Location. This is safe to call
+     * from multiple threads at once.
+     *
+     * @param loc The location to look up. Must be contained in the buffer.
+     *
+     * @returns The line and column number, both starting at 1.
+     */
+    std::pair<unsigned, unsigned> getLineAndCol(Location loc) const;
+    /**
+     * Prints a Location in the form `name:line:col`.
+     *
+     * @param os The stream to print to.
+     * @param loc The location to print.
+     */
+    void print(llvm::raw_ostream& os, Location loc) const;
+
+private:
+    /**
+     * Tells the OS that the buffer will be read front to back, so it can start
+     * reading ahead instead of faulting in one page at a time.
+     */
+    void adviseSequential() const;
+    /**
+     * Fills in the line table, if it hasn't been already.
+     */
+    void buildLineTable() const;
+    /** The source code. */
+    std::unique_ptr<llvm::MemoryBuffer> buffer;
+    /**
+     * Offset of the first character of each line. Built on demand by
+     * buildLineTable().
+     */
+    mutable std::vector<uint32_t> lineStarts;
+    /** Guards lineStarts while it's being built. */
+    mutable std::mutex lineStartsMutex;
+};
+
+#endif // SOURCEMANAGER_HPP
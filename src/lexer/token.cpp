@@ -1,19 +1,21 @@
 #include "lexer/token.hpp"
-#include <utility>
+
+static_assert(sizeof(Token) <= 16, "Token should stay small");
 
 llvm::raw_ostream& operator<<(llvm::raw_ostream& os, const Token& token)
 {
-    return os << tokenKindDebugName(token.kind) << " '" << token.text.str() <<
-        '\'' << " at " << token.location;
+    return os << tokenKindDebugName(token.kind) << " '" << token.getText() <<
+        '\'';
 }
 
 Token::Token()
-    : kind{ TokenKind::UNKNOWN }
+    : ptr{ nullptr }, length{ 0 }, kind{ TokenKind::UNKNOWN }
 {
 }
 
-Token::Token(TokenKind kind, llvm::StringRef text, Location location)
-    : kind{ kind }, text{ text }, location{ location }
+Token::Token(TokenKind kind, llvm::StringRef text)
+    : ptr{ text.data() }, length{ static_cast<uint32_t>(text.size()) },
+    kind{ kind }
 {
 }
 
@@ -39,10 +41,10 @@ const char* Token::getKindName() const
 
 llvm::StringRef Token::getText() const
 {
-    return text;
+    return { ptr, length };
 }
 
 Location Token::getLoc() const
 {
-    return location;
+    return Location{ ptr };
 }
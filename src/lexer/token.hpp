@@ -5,14 +5,14 @@
 #include "lexer/tokenKind.hpp"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/raw_ostream.h"
-#include <cstddef>
-#include <string>
-#include <unordered_map>
+#include <cstdint>
 
 class Token;
 
 /**
- * Represents a lexer token.
+ * Represents a lexer token. Tokens are kept small (16 bytes) since the parser
+ * buffers a lot of them, so the location is derived from where the text
+ * starts rather than being stored separately.
  */
 class Token
 {
@@ -27,10 +27,10 @@ public:
      * Creates a Token.
      *
      * @param kind The kind of Token this is.
-     * @param text Tbe text that was found in the Token.
-     * @param location Where this Token was found in the source.
+     * @param text The text that was found in the Token. Must point into the
+     * source code, and be less than 4GB long.
      */
-    Token(TokenKind kind, llvm::StringRef text, Location location);
+    Token(TokenKind kind, llvm::StringRef text);
     /**
      * Gets the TokenKind that this Token represents.
      *
@@ -67,12 +67,12 @@ public:
     Location getLoc() const;
 
 private:
+    /** Where the text of this Token starts in the source. */
+    const char* ptr;
+    /** The length of the text. */
+    uint32_t length;
     /** The kind of Token this is. */
     TokenKind kind;
-    /** The text that was found in the Token. */
-    llvm::StringRef text;
-    /** Where this Token was found in the source. */
-    Location location;
 };
 
 #endif // TOKEN_HPP
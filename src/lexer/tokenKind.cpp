@@ -1,15 +1,97 @@
 #include "lexer/tokenKind.hpp"
-#include "llvm/ADT/StringMap.h"
+#include <cstddef>
 
-/** Internal map of all keywords. */
-static const llvm::StringMap<TokenKind> keywords
+namespace
+{
+
+/**
+ * A keyword along with the TokenKind that it represents.
+ */
+struct Keyword
+{
+    /** The spelling of the keyword. */
+    const char* name;
+    /** The length of the name. */
+    size_t length;
+    /** The corresponding TokenKind. */
+    TokenKind kind;
+};
+
+/** Every keyword in `lexer/tokenKind.def`. */
+constexpr Keyword keywords[] =
 {
     /** @cond */
-#define KEYWORD(kind, name) { name, TokenKind::KW_ ## kind },
+#define KEYWORD(kind, name) { name, sizeof(name) - 1, TokenKind::KW_ ## kind },
     /** @endcond */
 #include "lexer/tokenKind.def"
 };
 
+/** Number of slots in the keyword table. Must be a power of 2. */
+constexpr size_t keywordTableSize = 32;
+
+/**
+ * Hashes a possible keyword using its length and its first and last
+ * characters. The multipliers are picked so that no two keywords share a slot,
+ * which KeywordTable checks at compile time.
+ *
+ * @param s The string to hash. Must not be empty.
+ * @param length The length of the string.
+ *
+ * @returns The slot in the keyword table that s would be in.
+ */
+constexpr size_t hashKeyword(const char* s, size_t length)
+{
+    return (static_cast<unsigned char>(s[0]) * 5 +
+            static_cast<unsigned char>(s[length - 1]) * 12 + length) &
+        (keywordTableSize - 1);
+}
+
+/**
+ * Perfect hash table of all the keywords, built at compile time.
+ */
+struct KeywordTable
+{
+    /**
+     * Fills in the table.
+     */
+    constexpr KeywordTable();
+    /**
+     * Each keyword in the slot that hashKeyword() puts it in. Empty slots have
+     * a length of zero, so they never match anything.
+     */
+    Keyword slots[keywordTableSize];
+    /** The length of the longest keyword. */
+    size_t maxLength;
+    /** Whether two keywords hashed to the same slot. */
+    bool hasCollision;
+};
+
+constexpr KeywordTable::KeywordTable()
+    : slots{}, maxLength{ 0 }, hasCollision{ false }
+{
+    for (const Keyword& keyword : keywords)
+    {
+        Keyword& slot = slots[hashKeyword(keyword.name, keyword.length)];
+        if (slot.length)
+        {
+            hasCollision = true;
+        }
+        slot = keyword;
+        if (keyword.length > maxLength)
+        {
+            maxLength = keyword.length;
+        }
+    }
+}
+
+constexpr KeywordTable keywordTable;
+
+static_assert(!keywordTable.hasCollision,
+    "keywords collide in the keyword table, change the hashKeyword() "
+    "multipliers");
+
+} // end anonymous namespace
+
 const char* tokenKindName(TokenKind k)
 {
     switch (k)
@@ -39,11 +121,16 @@ const char* tokenKindDebugName(TokenKind k)
 
 TokenKind getKeywordKind(llvm::StringRef s)
 {
-    auto it = keywords.find(s);
-    if (it != keywords.end())
+    if (s.empty() || s.size() > keywordTable.maxLength)
+    {
+        return TokenKind::IDENTIFIER;
+    }
+    const Keyword& keyword = keywordTable.slots[hashKeyword(s.data(),
+            s.size())];
+    if (s == llvm::StringRef{ keyword.name, keyword.length })
     {
         // the keyword was found
-        return (*it).getValue();
+        return keyword.kind;
     }
     // the keyword was not found, assume identifier
     return TokenKind::IDENTIFIER;
@@ -1,8 +1,8 @@
 #include "lexer/vslLexer.hpp"
-#include <cctype>
+#include "lexer/charInfo.hpp"
 
-VSLLexer::VSLLexer(Diag& diag, const char* src)
-    : Lexer{ diag }, text{ src, 1 }, location{ 1, 1 }
+VSLLexer::VSLLexer(Diag& diag, llvm::StringRef src)
+    : Lexer{ diag }, start{ src.begin() }, pos{ src.begin() }, end{ src.end() }
 {
 }
 
@@ -28,14 +28,13 @@ Token VSLLexer::nextToken()
             {
             case '/':
                 lexLineComment();
-                break;
+                continue;
             case '*':
                 lexBlockComment();
-                break;
+                continue;
             default:
                 return createToken(TokenKind::SLASH);
             }
-            break;
         case '%':
             return createToken(TokenKind::PERCENT);
         case '=':
@@ -88,7 +87,7 @@ Token VSLLexer::nextToken()
                 next();
                 return createToken(TokenKind::AND);
             }
-            diag.print<Diag::UNKNOWN_SYMBOL>(location, current());
+            diag.print<Diag::UNKNOWN_SYMBOL>(Location{ pos }, current());
             break;
         case '|':
             if (peek() == '|')
@@ -96,29 +95,40 @@ Token VSLLexer::nextToken()
                 next();
                 return createToken(TokenKind::OR);
             }
-            diag.print<Diag::UNKNOWN_SYMBOL>(location, current());
+            diag.print<Diag::UNKNOWN_SYMBOL>(Location{ pos }, current());
             break;
         case '.':
             return createToken(TokenKind::DOT);
         default:
-            if (isalpha(current()))
+            if (isAlpha(current()))
             {
                 return lexIdentOrKeyword();
             }
-            if (isdigit(current()))
+            if (isDigit(current()))
             {
                 return lexNumber();
             }
-            if (!isspace(current()))
+            if (isSpace(current()))
             {
-                diag.print<Diag::UNKNOWN_SYMBOL>(location, current());
+                skipTo(skipSpaces(pos, end));
+                continue;
             }
+            diag.print<Diag::UNKNOWN_SYMBOL>(Location{ pos }, current());
         }
         resetBuffer();
     }
     return createToken(TokenKind::END);
 }
 
+void VSLLexer::nextTokens(llvm::MutableArrayRef<Token> tokens)
+{
+    for (Token& token : tokens)
+    {
+        // qualified so it doesn't go through the vtable
+        token = VSLLexer::nextToken();
+    }
+}
+
 bool VSLLexer::empty() const
 {
     return current() == '\0';
@@ -126,28 +136,26 @@ bool VSLLexer::empty() const
 
 char VSLLexer::current() const
 {
-    return text.back();
+    return *pos;
 }
 
-char VSLLexer::next()
+void VSLLexer::next()
 {
-    text = { text.begin(), text.size() + 1 };
-    return text[0];
+    ++pos;
 }
 
 void VSLLexer::resetBuffer()
 {
-    // handle newlines
-    if (current() == '\n')
+    if (current() != '\0')
     {
-        ++location.line;
-        location.col = 0;
+        ++pos;
     }
-    else
-    {
-        location.col += text.size();
-    }
-    text = { text.end(), 1 };
+    start = pos;
+}
+
+void VSLLexer::skipTo(const char* p)
+{
+    start = pos = p;
 }
 
 char VSLLexer::peek() const
@@ -157,51 +165,47 @@ char VSLLexer::peek() const
     {
         return c;
     }
-    return *text.end();
+    return pos[1];
+}
+
+llvm::StringRef VSLLexer::getText() const
+{
+    return { start, static_cast<size_t>(pos - start + 1) };
 }
 
 Token VSLLexer::createToken(TokenKind kind)
 {
-    Token t{ kind, text, location };
+    Token t{ kind, getText() };
     resetBuffer();
     return t;
 }
 
 Token VSLLexer::lexIdentOrKeyword()
 {
-    while (isalnum(peek()))
-    {
-        next();
-    }
-    return createToken(getKeywordKind(text));
+    pos = skipAlnums(pos + 1, end) - 1;
+    return createToken(getKeywordKind(getText()));
 }
 
 Token VSLLexer::lexNumber()
 {
-    while (isdigit(peek()))
-    {
-        next();
-    }
+    pos = skipDigits(pos + 1, end) - 1;
     return createToken(TokenKind::NUMBER);
 }
 
 void VSLLexer::lexLineComment()
 {
-    do
-    {
-        next();
-    }
-    while (peek() != '\n' && peek() != '\0');
-    resetBuffer();
+    // the newline is left to be lexed as whitespace
+    skipTo(findLineEnd(pos + 2, end));
 }
 
 void VSLLexer::lexBlockComment()
 {
-    resetBuffer();
-    do
+    // skip the opening "/*"
+    skipTo(findBlockCommentStop(pos + 2, end));
+    if (current() != '\0')
     {
+        // consume the closing "*/"
+        next();
         resetBuffer();
     }
-    while (current() != '\0' && current() != '*' && peek() != '/');
-    next();
 }
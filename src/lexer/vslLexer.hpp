@@ -3,7 +3,6 @@
 
 #include "diag/diag.hpp"
 #include "lexer/lexer.hpp"
-#include "lexer/location.hpp"
 #include "lexer/token.hpp"
 #include "llvm/ADT/StringRef.h"
 
@@ -17,52 +16,59 @@ public:
      * Creates a VSLLexer.
      *
      * @param diag Diagnostics manager.
-     * @param src The source code to lex.
+     * @param src The source code to lex. The character just past the end of
+     * this buffer must be a null terminator.
      */
-    VSLLexer(Diag& diag, const char* src);
+    VSLLexer(Diag& diag, llvm::StringRef src);
     /**
      * Destroys a VSLLexer.
      */
     virtual ~VSLLexer() override = default;
     virtual Token nextToken() override;
+    virtual void nextTokens(llvm::MutableArrayRef<Token> tokens) override;
     virtual bool empty() const override;
 
 private:
     /**
-     * Gets the newest (last) character from the text buffer.
+     * Gets the newest (last) character of the current token.
      *
      * @returns The current character.
      */
     char current() const;
     /**
-     * Gets the next character, adding it to the text buffer.
-     *
-     * @returns The next character.
+     * Adds the next character to the current token.
      */
-    char next();
+    void next();
     /**
-     * Resets the text buffer so that it points to the character after where it
-     * was pointing to previously. This should be done before and after creating
-     * a Token.
+     * Resets the current token so that it starts at the character after the
+     * current one. This should be done before and after creating a Token. The
+     * lexer never moves past the null terminator.
      */
     void resetBuffer();
+    /**
+     * Skips every character up to (but not including) the given one, which
+     * becomes the start of the next token.
+     *
+     * @param p The character to skip to.
+     */
+    void skipTo(const char* p);
     /**
      * Gets the character after the current one, without consuming any.
      *
      * @returns The character after the current one.
      */
     char peek() const;
+    /**
+     * Gets the text of the current token.
+     *
+     * @returns The text of the current token.
+     */
+    llvm::StringRef getText() const;
     /**
      * Creates a token with the specified TokenKind. Before returning,
      * this method will also setup the lexer for getting the next token.
      */
     Token createToken(TokenKind kind);
-    /**
-     * Creates a symbol token.
-     *
-     * @returns A symbol token.
-     */
-    Token lexSymbol();
     /**
      * Creates either an identifier or keyword token.
      *
@@ -83,10 +89,12 @@ private:
      * Consumes a block comment.
      */
     void lexBlockComment();
-    /** The current buffer of text to insert into the next Token. */
-    llvm::StringRef text;
-    /** The location of the current character. */
-    Location location;
+    /** The first character of the current token. */
+    const char* start;
+    /** The current character, the last one in the current token. */
+    const char* pos;
+    /** The null terminator at the end of the source code. */
+    const char* end;
 };
 
 #endif // VSLLEXER_HPP
@@ -1,8 +1,11 @@
 #include "parser/vslParser.hpp"
 #include "ast/opKind.hpp"
+#include "llvm/ADT/SmallVector.h"
 
-VSLParser::VSLParser(VSLContext& vslCtx, Lexer& lexer)
-    : vslCtx{ vslCtx }, lexer{ lexer }, diag{ lexer.getDiag() }
+VSLParser::VSLParser(VSLContext& vslCtx, Lexer& lexer,
+    TimeReport* timeReport)
+    : vslCtx{ vslCtx }, lexer{ lexer }, diag{ lexer.getDiag() },
+    timeReport{ timeReport }, head{ 0 }, tail{ 0 }
 {
 }
 
@@ -21,14 +24,8 @@ void VSLParser::parse()
 
 Token VSLParser::consume()
 {
-    if (cache.empty())
-    {
-        // shortcut: take a token directly from the lexer
-        return lexer.nextToken();
-    }
-    // remove a token from the cache
-    Token t = std::move(cache.front());
-    cache.pop_front();
+    Token t = current();
+    ++head;
     return t;
 }
 
@@ -39,21 +36,29 @@ const Token& VSLParser::current()
 
 const Token& VSLParser::peek(size_t depth)
 {
-    // make sure enough tokens are already cached
-    if (depth >= cache.size())
+    // make sure enough tokens are already buffered
+    while (tail - head <= depth)
     {
-        // needs (depth-cache.size()+1) more tokens
-        for (size_t i = cache.size(); i <= depth; ++i)
-        {
-            cache.emplace_back(lexer.nextToken());
-        }
+        fillTokens();
     }
-    return cache[depth];
+    return tokens[(head + depth) % tokens.size()];
+}
+
+bool VSLParser::empty()
+{
+    // the token buffer is padded with eof tokens once the lexer runs out, so
+    //  it's never actually empty
+    return current().is(TokenKind::END);
 }
 
-bool VSLParser::empty() const
+void VSLParser::fillTokens()
 {
-    return cache.empty() && lexer.empty();
+    // tail is always a multiple of batchSize, so the batch can't wrap around
+    //  the end of the buffer, and since there are less than batchSize tokens
+    //  left when this is called, it won't overwrite any of them either
+    TimeReport::Scope scope{ timeReport, "lexer" };
+    lexer.nextTokens({ &tokens[tail % tokens.size()], batchSize });
+    tail += batchSize;
 }
 
 void VSLParser::errorExpected(const char* s)
@@ -125,8 +130,8 @@ FuncInterfaceNode* VSLParser::parseFunction(Access access)
             return nullptr;
         }
         consume();
-        return makeNode<ExtFuncNode>(data.location, access, data.name,
-            std::move(data.params), data.returnType, alias);
+        return makeNode<ExtFuncNode>(data.location, access,
+            vslCtx.intern(data.name), data.params, data.returnType, alias);
     }
     // parse a normal function
     BlockNode* body = parseBlock();
@@ -134,8 +139,8 @@ FuncInterfaceNode* VSLParser::parseFunction(Access access)
     {
         return nullptr;
     }
-    return makeNode<FunctionNode>(data.location, access, data.name,
-        std::move(data.params), data.returnType, *body);
+    return makeNode<FunctionNode>(data.location, access,
+        vslCtx.intern(data.name), data.params, data.returnType, *body);
 }
 
 VSLParser::FuncData VSLParser::parseFuncData()
@@ -173,9 +178,9 @@ VSLParser::FuncData VSLParser::parseFuncData()
 }
 
 // params -> lparen param* rparen
-std::vector<ParamNode*> VSLParser::parseParams()
+llvm::ArrayRef<ParamNode*> VSLParser::parseParams()
 {
-    std::vector<ParamNode*> params;
+    llvm::SmallVector<ParamNode*, 4> params;
     if (current().isNot(TokenKind::LPAREN))
     {
         errorExpected("'('");
@@ -208,7 +213,7 @@ std::vector<ParamNode*> VSLParser::parseParams()
     {
         consume();
     }
-    return params;
+    return vslCtx.copyArray<ParamNode>(params);
 }
 
 // param -> identifier ':' type
@@ -237,7 +242,7 @@ ParamNode* VSLParser::parseParam()
         diag.print<Diag::INVALID_PARAM_TYPE>(location, *type);
         return nullptr;
     }
-    return makeNode<ParamNode>(location, name, type);
+    return makeNode<ParamNode>(location, vslCtx.intern(name), type);
 }
 
 // variable -> access? (var | let) identifier colon type assign expr semicolon
@@ -249,8 +254,8 @@ VariableNode* VSLParser::parseVariable(Access access)
     {
         return nullptr;
     }
-    return makeNode<VariableNode>(data.location, access, data.name, data.type,
-        data.init, data.constness);
+    return makeNode<VariableNode>(data.location, access,
+        vslCtx.intern(data.name), data.type, data.init, data.constness);
 }
 
 VSLParser::VarData VSLParser::parseVarData()
@@ -360,8 +365,9 @@ ClassNode* VSLParser::parseClass(Access access)
     ClassType* classType = vslCtx.createClassType();
     type->setUnderlyingType(classType);
     // create the ClassNode and build its body
-    auto* node = makeNode<ClassNode>(location, access, name, type, classType);
-    parseMembers(*node);
+    auto* node = makeNode<ClassNode>(location, access, vslCtx.intern(name),
+        type, classType);
+    parseMembers(*node, *classType);
     // parse closing curly brace
     if (current().isNot(TokenKind::RBRACE))
     {
@@ -376,8 +382,10 @@ ClassNode* VSLParser::parseClass(Access access)
 
 // members -> member*
 // member -> field | ctor | method
-void VSLParser::parseMembers(ClassNode& parent)
+void VSLParser::parseMembers(ClassNode& parent, ClassType& classType)
 {
+    llvm::SmallVector<FieldNode*, 8> fields;
+    llvm::SmallVector<MethodNode*, 8> methods;
     while (current().isNot(TokenKind::RBRACE) &&
         current().isNot(TokenKind::END))
     {
@@ -390,11 +398,16 @@ void VSLParser::parseMembers(ClassNode& parent)
         case TokenKind::KW_VAR:
             if (FieldNode* field = parseField(access, parent))
             {
-                if (parent.addField(*field))
+                if (classType.setField(field->getName(), field->getType(),
+                        fields.size(), field->getAccess()))
                 {
                     // field already exists
                     diag.print<Diag::DUPLICATE_FIELD>(*field);
                 }
+                else
+                {
+                    fields.push_back(field);
+                }
             }
             break;
         case TokenKind::KW_INIT:
@@ -407,7 +420,7 @@ void VSLParser::parseMembers(ClassNode& parent)
         case TokenKind::KW_FUNC:
             if (MethodNode* method = parseMethod(access, parent))
             {
-                parent.addMethod(*method);
+                methods.push_back(method);
             }
             break;
         default:
@@ -415,6 +428,8 @@ void VSLParser::parseMembers(ClassNode& parent)
             consume();
         }
     }
+    parent.setFields(vslCtx.copyArray<FieldNode>(fields));
+    parent.setMethods(vslCtx.copyArray<MethodNode>(methods));
 }
 
 // field -> variable
@@ -440,8 +455,8 @@ FieldNode* VSLParser::parseField(Access access, ClassNode& parent)
         diag.print<Diag::NO_FIELD_INITS>(data.location);
         return nullptr;
     }
-    return makeNode<FieldNode>(data.location, access, data.name, data.type,
-        data.init, data.constness, parent);
+    return makeNode<FieldNode>(data.location, access,
+        vslCtx.intern(data.name), data.type, data.init, data.constness, parent);
 }
 
 // ctor -> access init params body
@@ -455,15 +470,14 @@ CtorNode* VSLParser::parseCtor(Access access, ClassNode& parent)
     }
     Location location = consume().getLoc();
     // parse parameters
-    std::vector<ParamNode*> params = parseParams();
+    llvm::ArrayRef<ParamNode*> params = parseParams();
     // parse body
     BlockNode* body = parseBlock();
     if (!body)
     {
         return nullptr;
     }
-    return makeNode<CtorNode>(location, access, std::move(params), *body,
-        parent);
+    return makeNode<CtorNode>(location, access, params, *body, parent);
 }
 
 // method -> function
@@ -481,14 +495,14 @@ MethodNode* VSLParser::parseMethod(Access access, ClassNode& parent)
     {
         return nullptr;
     }
-    return makeNode<MethodNode>(data.location, access, data.name,
-        std::move(data.params), data.returnType, *body, parent);
+    return makeNode<MethodNode>(data.location, access,
+        vslCtx.intern(data.name), data.params, data.returnType, *body, parent);
 }
 
 // statements -> statement*
-std::vector<Node*> VSLParser::parseStatements()
+llvm::ArrayRef<Node*> VSLParser::parseStatements()
 {
-    std::vector<Node*> statements;
+    llvm::SmallVector<Node*, 8> statements;
     while (current().isNot(TokenKind::RBRACE) &&
         current().isNot(TokenKind::END))
     {
@@ -498,7 +512,7 @@ std::vector<Node*> VSLParser::parseStatements()
             statements.push_back(statement);
         }
     }
-    return statements;
+    return vslCtx.copyArray<Node>(statements);
 }
 
 // statement -> variable | return | conditional | exprstmt | block | empty
@@ -546,14 +560,14 @@ BlockNode* VSLParser::parseBlock()
         return nullptr;
     }
     Location location = consume().getLoc();
-    std::vector<Node*> statements = parseStatements();
+    llvm::ArrayRef<Node*> statements = parseStatements();
     if (current().isNot(TokenKind::RBRACE))
     {
         errorExpected("'}'");
         return nullptr;
     }
     consume();
-    return makeNode<BlockNode>(location, std::move(statements));
+    return makeNode<BlockNode>(location, statements);
 }
 
 // conditional -> if lparen expr rparen statement (else statement)?
@@ -647,121 +661,288 @@ ExprNode* VSLParser::parseExprStmt()
     return expr;
 }
 
-// top down operator precedence (tdop) is used for expressions
+// expr -> unaryexpr | binaryexpr | ternary | call | member | primary
+//       | lparen expr rparen
+// unaryexpr -> (minus | not) expr(minPrec = call-1)
+// binaryexpr -> expr (star | slash | percent | plus | minus | greater
+//                    | greater_equal | less | less_equal | equal | not_equal
+//                    | and | or | assign) expr
+// ternary -> expr question expr colon expr
+// call -> expr lparen (arg (comma arg)*)? rparen
+// member -> expr dot ident | expr dot ident lparen (arg (comma arg)*)? rparen
+// arg -> ident colon expr
+// precedence climbing is used for expressions, where each operator on the
+//  stack is waiting for an operand to its right
 ExprNode* VSLParser::parseExpr(int minPrec)
 {
-    ExprNode* lhs = parseUnaryOp();
-    while (lhs && minPrec < getPrec(current().getKind()))
-    {
-        lhs = parseBinaryOp(*lhs);
+    llvm::SmallVector<PendingOp, 16> ops;
+    // arguments of the calls on the stack that were already parsed
+    llvm::SmallVector<ArgNode*, 16> args;
+    // the operand being parsed, or null if the next token starts a new one
+    ExprNode* expr = nullptr;
+    while (true)
+    {
+        if (!expr)
+        {
+            // unary operators and parens come before their operand
+            Token t = consume();
+            PendingOp op{};
+            op.location = t.getLoc();
+            op.token = t.getKind();
+            switch (t.getKind())
+            {
+            case TokenKind::MINUS:
+            case TokenKind::NOT:
+                // only expression that can be parsed before unary is a call
+                op.kind = PendingOp::UNARY;
+                op.minPrec = getPrec(TokenKind::LPAREN) - 1;
+                ops.push_back(op);
+                break;
+            case TokenKind::LPAREN:
+                op.kind = PendingOp::PAREN;
+                op.minPrec = 0;
+                ops.push_back(op);
+                break;
+            default:
+                expr = parsePrimary(t);
+                if (!expr)
+                {
+                    return nullptr;
+                }
+            }
+            continue;
+        }
+        // see if the next operator binds tighter than the one waiting for
+        //  this operand, which would make the operand its lhs instead
+        TokenKind k = current().getKind();
+        if ((ops.empty() ? minPrec : ops.back().minPrec) < getPrec(k))
+        {
+            PendingOp op{};
+            op.location = current().getLoc();
+            op.token = k;
+            op.lhs = expr;
+            switch (k)
+            {
+                // the ternary/call operators aren't actually binary operators,
+                //  but they come after an expression so that's good enough
+            case TokenKind::QUESTION:
+                consume();
+                op.kind = PendingOp::TERNARY_THEN;
+                op.minPrec = getPrec(TokenKind::QUESTION) - 1;
+                ops.push_back(op);
+                expr = nullptr;
+                continue;
+            case TokenKind::LPAREN:
+                op.kind = PendingOp::CALL;
+                break;
+            case TokenKind::DOT:
+                consume();
+                if (current().isNot(TokenKind::IDENTIFIER))
+                {
+                    errorExpected("identifier");
+                    return nullptr;
+                }
+                op.method = consume().getText();
+                // are we accessing a field or calling a method?
+                if (current().isNot(TokenKind::LPAREN))
+                {
+                    expr = makeNode<FieldAccessNode>(op.location, *expr,
+                        op.method);
+                    continue;
+                }
+                op.kind = PendingOp::METHOD_CALL;
+                break;
+            default:
+                {
+                    Token t = consume();
+                    BinaryKind binary = tokenKindToBinary(k);
+                    if (binary == BinaryKind::UNKNOWN)
+                    {
+                        diag.print<Diag::NOT_A_BINARY_OP>(t);
+                        return nullptr;
+                    }
+                    op.kind = PendingOp::BINARY;
+                    op.minPrec = getPrec(k);
+                    // assignment is right associative, the rest are left
+                    if (binary == BinaryKind::ASSIGN)
+                    {
+                        --op.minPrec;
+                    }
+                    ops.push_back(op);
+                    expr = nullptr;
+                    continue;
+                }
+            }
+            // only calls make it here, which wait for each of their args
+            consume();
+            op.argsBegin = args.size();
+            if (current().is(TokenKind::RPAREN) || !parseArgName(op))
+            {
+                expr = finishCall(op, args);
+                continue;
+            }
+            op.minPrec = 0;
+            ops.push_back(op);
+            expr = nullptr;
+            continue;
+        }
+        // otherwise, the operand is finished and so is the operator waiting
+        //  for it
+        if (ops.empty())
+        {
+            return expr;
+        }
+        PendingOp op = ops.pop_back_val();
+        switch (op.kind)
+        {
+        case PendingOp::PAREN:
+            if (current().isNot(TokenKind::RPAREN))
+            {
+                errorExpected("')'");
+            }
+            consume();
+            break;
+        case PendingOp::TERNARY_THEN:
+            if (current().isNot(TokenKind::COLON))
+            {
+                errorExpected("':'");
+                return nullptr;
+            }
+            consume();
+            op.kind = PendingOp::TERNARY_ELSE;
+            op.thenCase = expr;
+            ops.push_back(op);
+            expr = nullptr;
+            break;
+        case PendingOp::CALL:
+        case PendingOp::METHOD_CALL:
+            args.push_back(makeNode<ArgNode>(op.argLocation, op.argName,
+                *expr));
+            if (current().is(TokenKind::COMMA))
+            {
+                consume();
+                if (parseArgName(op))
+                {
+                    ops.push_back(op);
+                    expr = nullptr;
+                    break;
+                }
+            }
+            expr = finishCall(op, args);
+            break;
+        default:
+            expr = finishOp(op, *expr);
+        }
     }
-    return lhs;
 }
 
-// unaryop -> ident | number | true | false | unaryexpr | lparen expr rparen
-// unaryexpr -> (minus | not) expr(minPrec = call-1)
-// only expression that can be parsed before unary is a function call
-ExprNode* VSLParser::parseUnaryOp()
+// primary -> ident | number | true | false | self
+ExprNode* VSLParser::parsePrimary(const Token& token)
 {
-    Token t = consume();
-    switch (t.getKind())
+    switch (token.getKind())
     {
     case TokenKind::IDENTIFIER:
-        return makeNode<IdentNode>(t.getLoc(), t.getText());
+        return makeNode<IdentNode>(token.getLoc(),
+            vslCtx.intern(token.getText()));
     case TokenKind::NUMBER:
-        return parseNumber(t);
+        return parseNumber(token);
     case TokenKind::KW_TRUE:
-        return makeNode<LiteralNode>(t.getLoc(), llvm::APInt{ 1, 1 });
+        return makeNode<LiteralNode>(token.getLoc(), llvm::APInt{ 1, 1 });
     case TokenKind::KW_FALSE:
-        return makeNode<LiteralNode>(t.getLoc(), llvm::APInt{ 1, 0 });
-    case TokenKind::MINUS:
-    case TokenKind::NOT:
+        return makeNode<LiteralNode>(token.getLoc(), llvm::APInt{ 1, 0 });
+    case TokenKind::KW_SELF:
+        return makeNode<SelfNode>(token.getLoc());
+    default:
+        errorExpected("expression");
+        return nullptr;
+    }
+}
+
+bool VSLParser::parseArgName(PendingOp& call)
+{
+    while (true)
+    {
+        if (current().isNot(TokenKind::IDENTIFIER))
+        {
+            errorExpected("identifier");
+        }
+        else
         {
-            ExprNode* expr = parseExpr(getPrec(TokenKind::LPAREN) - 1);
-            if (!expr)
+            call.argName = current().getText();
+            call.argLocation = consume().getLoc();
+            if (current().is(TokenKind::COLON))
             {
-                return nullptr;
+                consume();
+                return true;
             }
-            return makeNode<UnaryNode>(t.getLoc(),
-                tokenKindToUnary(t.getKind()), *expr);
+            errorExpected("':'");
         }
-    case TokenKind::LPAREN:
+        // skip the rest of the bad argument, so the next one can still be
+        //  parsed
+        unsigned depth = 0;
+        while (current().isNot(TokenKind::SEMICOLON) &&
+            current().isNot(TokenKind::END) &&
+            (depth || (current().isNot(TokenKind::COMMA) &&
+                current().isNot(TokenKind::RPAREN))))
         {
-            ExprNode* expr = parseExpr();
-            if (current().isNot(TokenKind::RPAREN))
+            if (current().is(TokenKind::LPAREN))
             {
-                errorExpected("')'");
+                ++depth;
+            }
+            else if (current().is(TokenKind::RPAREN))
+            {
+                --depth;
             }
             consume();
-            return expr;
         }
-    case TokenKind::KW_SELF:
-        return makeNode<SelfNode>(t.getLoc());
+        if (current().isNot(TokenKind::COMMA))
+        {
+            return false;
+        }
+        consume();
+    }
+}
+
+ExprNode* VSLParser::finishOp(const PendingOp& op, ExprNode& rhs)
+{
+    switch (op.kind)
+    {
+    case PendingOp::UNARY:
+        return makeNode<UnaryNode>(op.location, tokenKindToUnary(op.token),
+            rhs);
+    case PendingOp::BINARY:
+        return makeNode<BinaryNode>(op.location, tokenKindToBinary(op.token),
+            *op.lhs, rhs);
+    case PendingOp::TERNARY_ELSE:
+        return makeNode<TernaryNode>(op.location, *op.lhs, *op.thenCase, rhs);
     default:
-        errorExpected("expression");
-        return nullptr;
+        // parens don't make a node of their own, and calls are finished by
+        //  finishCall
+        return &rhs;
     }
 }
 
-// binaryop -> binaryexpr | ternary | call
-ExprNode* VSLParser::parseBinaryOp(ExprNode& lhs)
+ExprNode* VSLParser::finishCall(const PendingOp& call,
+    llvm::SmallVectorImpl<ArgNode*>& args)
 {
-    const Token& t = current();
-    switch (t.getKind())
+    if (current().isNot(TokenKind::RPAREN))
     {
-        // the ternary/call operators aren't actually binary operators, but they
-        //  come after an expression so that's good enough
-    case TokenKind::QUESTION:
-        return parseTernary(lhs);
-    case TokenKind::LPAREN:
-        return parseCall(lhs);
-    case TokenKind::DOT:
-        return parseMemberAccess(lhs);
-    default:
-        return parseBinaryExpr(lhs);
-    }
-}
-
-// binaryexpr -> lhs (star | slash | percent | plus | minus | greater
-//                   | greater_equal | less | less_equal | equal | not_equal
-//                   | and | or | assign) expr
-BinaryNode* VSLParser::parseBinaryExpr(ExprNode& lhs)
-{
-    Token t = consume();
-    TokenKind k = t.getKind();
-    BinaryKind op = tokenKindToBinary(k);
-    int minPrec = getPrec(k);
-    switch (op)
-    {
-    case BinaryKind::STAR:
-    case BinaryKind::SLASH:
-    case BinaryKind::PERCENT:
-    case BinaryKind::PLUS:
-    case BinaryKind::MINUS:
-    case BinaryKind::GREATER:
-    case BinaryKind::GREATER_EQUAL:
-    case BinaryKind::LESS:
-    case BinaryKind::LESS_EQUAL:
-    case BinaryKind::EQUAL:
-    case BinaryKind::NOT_EQUAL:
-    case BinaryKind::AND:
-    case BinaryKind::OR:
-        // left associative
-        break;
-    case BinaryKind::ASSIGN:
-        // right associative
-        --minPrec;
-        break;
-    default:
-        diag.print<Diag::NOT_A_BINARY_OP>(t);
-        return nullptr;
+        errorExpected("')'");
     }
-    ExprNode* rhs = parseExpr(minPrec);
-    if (!rhs)
+    else
     {
-        return nullptr;
+        consume();
+    }
+    // the call's arguments are the last ones parsed
+    llvm::ArrayRef<ArgNode*> callArgs = vslCtx.copyArray(
+        llvm::makeArrayRef(args).drop_front(call.argsBegin));
+    args.resize(call.argsBegin);
+    if (call.kind == PendingOp::METHOD_CALL)
+    {
+        return makeNode<MethodCallNode>(call.location, *call.lhs,
+            vslCtx.intern(call.method), callArgs);
     }
-    return makeNode<BinaryNode>(t.getLoc(), op, lhs, *rhs);
+    return makeNode<CallNode>(call.location, *call.lhs, callArgs);
 }
 
 int VSLParser::getPrec(TokenKind k)
@@ -798,142 +979,6 @@ int VSLParser::getPrec(TokenKind k)
     }
 }
 
-// ternary -> condition question thenCase colon elseCase
-// condition provided by caller
-TernaryNode* VSLParser::parseTernary(ExprNode& condition)
-{
-    if (current().isNot(TokenKind::QUESTION))
-    {
-        errorExpected("'?'");
-        return nullptr;
-    }
-    Token question = consume();
-    Location location = question.getLoc();
-    ExprNode* thenCase = parseExpr(getPrec(TokenKind::QUESTION) - 1);
-    if (!thenCase)
-    {
-        return nullptr;
-    }
-    if (current().isNot(TokenKind::COLON))
-    {
-        errorExpected("':'");
-        return nullptr;
-    }
-    consume();
-    ExprNode* elseCase = parseExpr(getPrec(TokenKind::QUESTION) - 1);
-    if (!elseCase)
-    {
-        return nullptr;
-    }
-    return makeNode<TernaryNode>(location, condition, *thenCase, *elseCase);
-}
-
-// call -> callee args
-// callee provided by caller
-CallNode* VSLParser::parseCall(ExprNode& callee)
-{
-    if (current().isNot(TokenKind::LPAREN))
-    {
-        errorExpected("'('");
-        return nullptr;
-    }
-    Location location = current().getLoc();
-    // parse argument list
-    std::vector<ArgNode*> args = parseCallArgs();
-    return makeNode<CallNode>(location, callee, std::move(args));
-}
-
-// args -> lparen arg (comma arg)* rparen
-std::vector<ArgNode*> VSLParser::parseCallArgs()
-{
-    std::vector<ArgNode*> args;
-    if (current().isNot(TokenKind::LPAREN))
-    {
-        errorExpected("'('");
-        return args;
-    }
-    consume();
-    if (current().isNot(TokenKind::RPAREN))
-    {
-        while (true)
-        {
-            ArgNode* arg = parseCallArg();
-            if (arg)
-            {
-                args.push_back(arg);
-            }
-            if (current().isNot(TokenKind::COMMA))
-            {
-                break;
-            }
-            consume();
-        }
-    }
-    if (current().isNot(TokenKind::RPAREN))
-    {
-        errorExpected("')'");
-    }
-    else
-    {
-        consume();
-    }
-    return args;
-}
-
-// arg -> identifier ':' expr
-ArgNode* VSLParser::parseCallArg()
-{
-    llvm::StringRef name;
-    if (current().isNot(TokenKind::IDENTIFIER))
-    {
-        errorExpected("identifier");
-        return nullptr;
-    }
-    name = current().getText();
-    Location location = consume().getLoc();
-    if (consume().isNot(TokenKind::COLON))
-    {
-        errorExpected("':'");
-        return nullptr;
-    }
-    ExprNode* value = parseExpr();
-    if (!value)
-    {
-        return nullptr;
-    }
-    return makeNode<ArgNode>(location, name, *value);
-}
-
-// member -> fieldaccess | methodcall
-// fieldaccess -> expr dot ident
-// methodcall -> expr dot call
-// call defined earlier above parseCall
-ExprNode* VSLParser::parseMemberAccess(ExprNode& obj)
-{
-    if (current().isNot(TokenKind::DOT))
-    {
-        errorExpected("'.'");
-        return nullptr;
-    }
-    Location location = consume().getLoc();
-    // parse member name
-    if (current().isNot(TokenKind::IDENTIFIER))
-    {
-        errorExpected("identifier");
-        return nullptr;
-    }
-    llvm::StringRef member = consume().getText();
-    // are we accessing a field or calling a method?
-    if (current().is(TokenKind::LPAREN))
-    {
-        // method call, parse call args
-        std::vector<ArgNode*> args = parseCallArgs();
-        return makeNode<MethodCallNode>(location, obj, member, std::move(args));
-    }
-    // field access, not much else to do
-    return makeNode<FieldAccessNode>(location, obj, member);
-}
-
 LiteralNode* VSLParser::parseNumber(const Token& token)
 {
     const Location& location = token.getLoc();
@@ -998,8 +1043,5 @@ template<typename NodeT, typename... Args>
 typename std::enable_if<std::is_base_of<Node, NodeT>::value, NodeT*>::type
 VSLParser::makeNode(Args&&... args) const
 {
-    auto node = std::make_unique<NodeT>(std::forward<Args>(args)...);
-    NodeT* nodePtr = node.get();
-    vslCtx.addNode(std::move(node));
-    return nodePtr;
+    return vslCtx.createNode<NodeT>(std::forward<Args>(args)...);
 }
@@ -4,9 +4,12 @@
 #include "ast/node.hpp"
 #include "ast/vslContext.hpp"
 #include "diag/diag.hpp"
+#include "diag/timeReport.hpp"
 #include "lexer/lexer.hpp"
 #include "lexer/token.hpp"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
+#include <array>
 #include <cstddef>
 #include <memory>
 #include <type_traits>
@@ -22,8 +25,10 @@ public:
      *
      * @param vslCtx The VSLContext object to be used.
      * @param lexer The Lexer to get the tokens from.
+     * @param timeReport Where to add the time spent lexing, or null.
      */
-    VSLParser(VSLContext& vslCtx, Lexer& lexer);
+    VSLParser(VSLContext& vslCtx, Lexer& lexer,
+        TimeReport* timeReport = nullptr);
     /**
      * Parses the program. The AST is stored in the VSLContext.
      */
@@ -58,13 +63,65 @@ private:
         /** The name of the function. */
         llvm::StringRef name;
         /** The function's parameters. */
-        std::vector<ParamNode*> params;
+        llvm::ArrayRef<ParamNode*> params;
         /** The function's return type. */
         const Type* returnType;
         /** If this FuncData is malformed or not. */
         bool errored;
     };
 
+    /**
+     * An operator in an expression that's still waiting for its right hand
+     * side, e.g.\ the `+` in `1+` while `5*(3+4)` is being parsed.
+     */
+    struct PendingOp
+    {
+        /** The kinds of operators that can have a right hand side. */
+        enum Kind
+        {
+            /** A unary operator, e.g.\ `-`. */
+            UNARY,
+            /** A binary operator, e.g.\ `+`. */
+            BINARY,
+            /** An opening paren, which only waits for the closing paren. */
+            PAREN,
+            /** The then case of a ternary. */
+            TERNARY_THEN,
+            /** The else case of a ternary. */
+            TERNARY_ELSE,
+            /** An argument of a function call. */
+            CALL,
+            /** An argument of a method call. */
+            METHOD_CALL
+        };
+        /** The kind of operator. */
+        Kind kind;
+        /** Where the operator was found in the source. */
+        Location location;
+        /** The operator's token, for unary and binary operators. */
+        TokenKind token;
+        /**
+         * Operators that come after this one are only part of its right hand
+         * side if they have a higher precedence than this.
+         */
+        int minPrec;
+        /**
+         * The left hand side of a binary operator, the condition of a ternary,
+         * or the callee of a call.
+         */
+        ExprNode* lhs;
+        /** The then case of a ternary, once it's been parsed. */
+        ExprNode* thenCase;
+        /** The name of the method being called. */
+        llvm::StringRef method;
+        /** The name of the argument being parsed. */
+        llvm::StringRef argName;
+        /** Where the argument being parsed was found in the source. */
+        Location argLocation;
+        /** Where the arguments of this call start in the argument stack. */
+        size_t argsBegin;
+    };
+
     /**
      * @name Token Operations
      * @{
@@ -87,18 +144,23 @@ private:
     /**
      * Look `depth` tokens ahead of the current token without consuming them.
      *
-     * @param depth The amount of tokens to look ahead.
+     * @param depth The amount of tokens to look ahead. Must be less than
+     * `batchSize`.
      *
      * @returns The next token without consuming it.
      */
     const Token& peek(size_t depth = 1);
     /**
-     * Checks if both the lexer and the token cache are empty. When this is
-     * true, all new tokens created by the lexer will typically be eof tokens.
+     * Checks if every token has been consumed, i.e.\ if the current token is
+     * the eof token.
      *
      * @returns True if empty, false otherwise.
      */
-    bool empty() const;
+    bool empty();
+    /**
+     * Lexes another batch of tokens into the token buffer.
+     */
+    void fillTokens();
 
     /**
      * @}
@@ -153,7 +215,7 @@ private:
      *
      * @returns A parameter list.
      */
-    std::vector<ParamNode*> parseParams();
+    llvm::ArrayRef<ParamNode*> parseParams();
     /**
      * Parses a function parameter, e.g.\ `x: Int`.
      *
@@ -194,8 +256,9 @@ private:
      * Parses the members of a class.
      *
      * @param node The ClassNode that the members belong to.
+     * @param classType The class type to add the fields to.
      */
-    void parseMembers(ClassNode& node);
+    void parseMembers(ClassNode& node, ClassType& classType);
     /**
      * Parses a field.
      *
@@ -237,7 +300,7 @@ private:
      *
      * @returns A sequence of statements.
      */
-    std::vector<Node*> parseStatements();
+    llvm::ArrayRef<Node*> parseStatements();
     /**
      * Parses a statement within a function scope. It is assumed that this is
      * within a function scope, therefore functions are not allowed here.
@@ -279,79 +342,65 @@ private:
     /**
      * Parses an expression, e.g.\ `1+5*(3+4)-6/2`.
      *
+     * This uses precedence climbing, but the operators that are still waiting
+     * for their right hand side are kept on an explicit stack instead of the
+     * call stack, so that arbitrarily deep expressions can't overflow it.
+     *
      * @param minPrec Minimum precedence allowed when parsing binary operators.
      *
      * @returns An expression.
      */
     ExprNode* parseExpr(int minPrec = 0);
     /**
-     * Parses the current token when there is no expression of higher precedence
-     * to the left of it.
-     *
-     * @returns A unary expression, literal, identifier, or paren group.
-     */
-    ExprNode* parseUnaryOp();
-    /**
-     * Parses the current token when there is an expression of higher precedence
-     * to the left of it. This expression is passed as a parameter.
-     *
-     * @param lhs Left hand side of the expression.
-     *
-     * @returns A binary, ternary, or call expression.
-     */
-    ExprNode* parseBinaryOp(ExprNode& lhs);
-    /**
-     * Parses a binary expression.
+     * Parses an expression that doesn't have any operators, e.g.\ an
+     * identifier or a literal.
      *
-     * @param lhs Already parsed left hand side.
+     * @param token The token to parse, which was already consumed.
      *
-     * @returns A binary expression.
+     * @returns An identifier, literal, or self expression.
      */
-    BinaryNode* parseBinaryExpr(ExprNode& lhs);
+    ExprNode* parsePrimary(const Token& token);
     /**
-     * Gets the precedence of a binary (or ternary/kind) operator.
+     * Parses the name of a function argument, e.g.\ the `x:` in `x: 1`. If
+     * it's invalid, the rest of that argument is skipped and the next one's
+     * name is parsed instead.
      *
-     * @param k The kind of operator to use.
+     * @param call The call to store the name and location in.
      *
-     * @returns The precedence of the given operator.
+     * @returns True if a valid name was found, false if there are no
+     * arguments left.
      */
-    static int getPrec(TokenKind k);
+    bool parseArgName(PendingOp& call);
     /**
-     * Parses a ternary expression, e.g.\ `c ? x : y`.
+     * Finishes a unary, binary or ternary operator now that its right hand
+     * side has been parsed.
      *
-     * @param condition Condition that was already parsed.
+     * @param op The operator to finish.
+     * @param rhs Its right hand side.
      *
-     * @returns A ternary expression.
+     * @returns The operator's expression.
      */
-    TernaryNode* parseTernary(ExprNode& condition);
+    ExprNode* finishOp(const PendingOp& op, ExprNode& rhs);
     /**
-     * Parses a function call, e.g.\ `f(x: 1)`.
-     *
-     * @param callee The function to call.
+     * Finishes a function or method call once all of its arguments have been
+     * parsed, which includes the closing paren.
      *
-     * @returns A function call.
-     */
-    CallNode* parseCall(ExprNode& callee);
-    /**
-     * Parses a function argument list wrapped in parentheses.
+     * @param call The call to finish.
+     * @param args The arguments parsed so far, which end with the call's.
+     * They're removed once the call has them.
      *
-     * @returns A function argument list.
+     * @returns A function call or method call.
      */
-    std::vector<ArgNode*> parseCallArgs();
+    ExprNode* finishCall(const PendingOp& call,
+        llvm::SmallVectorImpl<ArgNode*>& args);
     /**
-     * Parses a function argument, e.g.\ `x: 1`.
-     *
-     * @returns A function argument.
-     */
-    ArgNode* parseCallArg();
-    /**
-     * Parses a field access or method call, e.g.\ `obj.x` or `obj.f(x: 1)`.
+     * Gets the precedence of a binary (or ternary/kind) operator.
      *
-     * @param obj The object to access a member of.
+     * @param k The kind of operator to use.
      *
-     * @returns A member access.
+     * @returns The precedence of the given operator.
      */
-    ExprNode* parseMemberAccess(ExprNode& obj);
+    static int getPrec(TokenKind k);
     /**
      * Parses a number, e.g.\ `1337`.
      *
@@ -402,8 +451,19 @@ private:
     Lexer& lexer;
     /** Diagnostics manager. */
     Diag& diag;
-    /** Cache of tokens used in lookahead. */
-    std::deque<Token> cache;
+    /** Where to add the time spent lexing, or null. */
+    TimeReport* timeReport;
+    /** Amount of tokens to get from the lexer at a time. */
+    static constexpr size_t batchSize = 256;
+    /**
+     * Ring buffer of tokens used in lookahead. Batches are always lexed into
+     * one contiguous half of it while the other half holds the lookahead.
+     */
+    std::array<Token, 2 * batchSize> tokens;
+    /** Amount of tokens consumed so far. The current token is at this index. */
+    size_t head;
+    /** Amount of tokens lexed so far. */
+    size_t tail;
 };
 
 #endif // VSLPARSER_HPP
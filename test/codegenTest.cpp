@@ -0,0 +1,428 @@
+#include "ast/vslContext.hpp"
+#include "codegen/codegen.hpp"
+#include "codegen/objectCache.hpp"
+#include "diag/diag.hpp"
+#include "irgen/irgen.hpp"
+#include "lexer/vslLexer.hpp"
+#include "parser/vslParser.hpp"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/Casting.h"
+#include "llvm/Support/FileSystem.h"
+#include "gtest/gtest.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+// generates code for some source, returning null if it's invalid
+static std::unique_ptr<llvm::Module> generate(llvm::LLVMContext& llvmContext,
+    const std::string& src, const IRGenOptions& options = {})
+{
+    VSLContext vslCtx;
+    Diag diag{ llvm::nulls() };
+    VSLLexer lexer{ diag, src };
+    VSLParser parser{ vslCtx, lexer };
+    parser.parse();
+    auto module = std::make_unique<llvm::Module>("test", llvmContext);
+    CodeGen codeGen{ diag, *module };
+    codeGen.configure();
+    IRGen irgen{ vslCtx, diag, *module, options };
+    irgen.run();
+    if (diag.getNumErrors())
+    {
+        return nullptr;
+    }
+    return module;
+}
+
+// counts the calls from one function to another
+static size_t countCalls(const llvm::Module& module, llvm::StringRef caller,
+    llvm::StringRef callee)
+{
+    size_t calls = 0;
+    for (const llvm::BasicBlock& block : *module.getFunction(caller))
+    {
+        for (const llvm::Instruction& inst : block)
+        {
+            auto* call = llvm::dyn_cast<llvm::CallInst>(&inst);
+            if (call && call->getCalledFunction() &&
+                call->getCalledFunction()->getName() == callee)
+            {
+                ++calls;
+            }
+        }
+    }
+    return calls;
+}
+
+// boxes made by make() escape, so they stay on the heap
+static const char* const boxClass = "public class Box { public var v: Int; "
+    "public init(v: Int) { self.v = v; } }\n"
+    "public func make(v: Int) -> Box { return Box(v: v); }\n";
+
+TEST(CodeGenTest, Parallel)
+{
+    // private functions and globals used all over the place, so that some of
+    //  them have to cross partitions
+    std::string src = "private var counter: Int = 0;\n";
+    for (int i = 0; i < 16; ++i)
+    {
+        std::string n = std::to_string(i);
+        std::string prev = std::to_string(i ? i - 1 : 15);
+        src += "private func f" + n + "(x: Int) -> Int "
+            "{ counter = counter + 1; return x > 0 ? f" + prev +
+            "(x: x - 1) : x; }\n";
+    }
+    src += "public func g(x: Int) -> Int { return f15(x: x); }\n";
+    llvm::LLVMContext llvmContext;
+    std::unique_ptr<llvm::Module> module = generate(llvmContext, src);
+    ASSERT_NE(module, nullptr);
+    Diag diag{ llvm::nulls() };
+    CodeGen codeGen{ diag, *module };
+    codeGen.configure();
+    // one object per output, even the empty ones
+    std::vector<llvm::SmallVector<char, 0>> objects(20);
+    std::vector<std::unique_ptr<llvm::raw_svector_ostream>> streams;
+    std::vector<llvm::raw_pwrite_stream*> outputs;
+    for (llvm::SmallVector<char, 0>& object : objects)
+    {
+        streams.push_back(std::make_unique<llvm::raw_svector_ostream>(object));
+        outputs.push_back(streams.back().get());
+    }
+    codeGen.compile(outputs);
+    EXPECT_EQ(diag.getNumErrors(), 0u);
+    for (const llvm::SmallVector<char, 0>& object : objects)
+    {
+        EXPECT_FALSE(object.empty());
+    }
+    // public symbols keep their names, while private ones that cross
+    //  partitions become hidden
+    llvm::Function* g = module->getFunction("g");
+    ASSERT_NE(g, nullptr);
+    EXPECT_EQ(g->getVisibility(), llvm::GlobalValue::DefaultVisibility);
+    for (const llvm::Function& func : *module)
+    {
+        if (func.getName().startswith("f"))
+        {
+            EXPECT_TRUE(func.hasLocalLinkage() ||
+                func.hasHiddenVisibility());
+        }
+    }
+}
+
+TEST(CodeGenTest, BorrowedParams)
+{
+    llvm::LLVMContext llvmContext;
+    std::unique_ptr<llvm::Module> module = generate(llvmContext,
+        std::string{ boxClass } +
+        "public func use(b: Box) -> Int { return b.v; }\n"
+        "public func swap(b: Box, c: Box) -> Int { b = c; return b.v; }\n"
+        "public func caller() -> Int "
+        "{ let b = make(v: 1); return use(b: b) + use(b: make(v: 2)); }\n");
+    ASSERT_NE(module, nullptr);
+    // parameters are borrowed unless they're reassigned
+    EXPECT_EQ(countCalls(*module, "use", "Box.dtor"), 0u);
+    EXPECT_EQ(countCalls(*module, "swap", "Box.dtor"), 2u);
+    // the caller destroys the temporary and the variable exactly once each
+    EXPECT_EQ(countCalls(*module, "caller", "Box.dtor"), 2u);
+}
+
+TEST(CodeGenTest, ReassignedArg)
+{
+    llvm::LLVMContext llvmContext;
+    std::unique_ptr<llvm::Module> module = generate(llvmContext,
+        std::string{ boxClass } +
+        "public func pair(a: Box, b: Box) -> Int { return a.v + b.v; }\n"
+        "public func caller() -> Int { var x = make(v: 1); "
+        "var y = make(v: 2); pair(a: x, b: x = y); return 0; }\n");
+    ASSERT_NE(module, nullptr);
+    // x's old object is copied for the first argument, since the second one
+    //  destroys it, so the copy is destroyed along with the old object, y and
+    //  x
+    EXPECT_EQ(countCalls(*module, "caller", "Box.dtor"), 4u);
+}
+
+TEST(CodeGenTest, RefcountElision)
+{
+    llvm::LLVMContext llvmContext;
+    std::unique_ptr<llvm::Module> module = generate(llvmContext,
+        std::string{ boxClass } +
+        "public func f(b: Box) -> Box { let c = b; return c; }\n"
+        "public func g(b: Box) -> Int "
+        "{ let c = b; let d = make(v: 1); return d.v; }\n");
+    ASSERT_NE(module, nullptr);
+    EXPECT_EQ(countCalls(*module, "f", "Box.dtor"), 1u);
+    EXPECT_EQ(countCalls(*module, "g", "Box.dtor"), 2u);
+    Diag diag{ llvm::nulls() };
+    CodeGen codeGen{ diag, *module };
+    codeGen.configure();
+    codeGen.optimize(1);
+    // copying into c and returning it cancel out, leaving one increment
+    EXPECT_EQ(countCalls(*module, "f", "Box.dtor"), 0u);
+    // destroying d could release something else, so c has to stay
+    EXPECT_EQ(countCalls(*module, "g", "Box.dtor"), 2u);
+}
+
+TEST(CodeGenTest, FieldReceiver)
+{
+    llvm::LLVMContext llvmContext;
+    std::unique_ptr<llvm::Module> module = generate(llvmContext,
+        "public class Box { public var v: Int; "
+        "public init(v: Int) { self.v = v; } "
+        "public func get() -> Int { return self.v; } }\n"
+        "public class Pair { public var a: Box; "
+        "public init(a: Box) { self.a = a; } "
+        "public func sum() -> Int { return self.a.get(); } }\n"
+        "public func get(p: Pair) -> Int { return p.a.get(); }\n"
+        "public func make() -> Pair { return Pair(a: Box(v: 1)); }\n"
+        "public func temp() -> Int { return make().a.get(); }\n");
+    ASSERT_NE(module, nullptr);
+    // methods borrow self, so calling one on a field doesn't release it
+    EXPECT_EQ(countCalls(*module, "Pair.sum", "Box.dtor"), 0u);
+    EXPECT_EQ(countCalls(*module, "get", "Box.dtor"), 0u);
+    // unless it belongs to a temporary, which is destroyed as a whole
+    EXPECT_EQ(countCalls(*module, "temp", "Box.dtor"), 0u);
+    EXPECT_EQ(countCalls(*module, "temp", "Pair.dtor"), 1u);
+}
+
+TEST(CodeGenTest, LetsAreSSA)
+{
+    llvm::LLVMContext llvmContext;
+    std::unique_ptr<llvm::Module> module = generate(llvmContext,
+        "public func f(a: Int, b: Int) -> Int "
+        "{ var c = a + b; var d = c; d = d + a; let e = d; e = e * b; "
+        "return e; }\n"
+        "public func g(a: Int) -> Int { a = a + 1; return a; }\n");
+    ASSERT_NE(module, nullptr);
+    // counts the allocas in a function
+    auto countAllocas = [&module](llvm::StringRef func)
+    {
+        size_t allocas = 0;
+        for (const llvm::Instruction& inst :
+            module->getFunction(func)->getEntryBlock())
+        {
+            allocas += llvm::isa<llvm::AllocaInst>(inst);
+        }
+        return allocas;
+    };
+    // only the reassigned locals and params need memory, whether they were
+    //  declared with var or let
+    EXPECT_EQ(countAllocas("f"), 2u);
+    EXPECT_EQ(countAllocas("g"), 1u);
+    Diag diag{ llvm::nulls() };
+    CodeGen codeGen{ diag, *module };
+    codeGen.configure();
+    codeGen.promoteLocals();
+    EXPECT_EQ(countAllocas("f"), 0u);
+    EXPECT_EQ(countAllocas("g"), 0u);
+}
+
+TEST(CodeGenTest, PoolAllocator)
+{
+    IRGenOptions options;
+    options.allocator = IRGenOptions::POOL;
+    llvm::LLVMContext llvmContext;
+    std::unique_ptr<llvm::Module> module = generate(llvmContext,
+        boxClass, options);
+    ASSERT_NE(module, nullptr);
+    EXPECT_EQ(countCalls(*module, "make", "vsl_alloc"), 1u);
+    EXPECT_EQ(countCalls(*module, "make", "malloc"), 0u);
+    EXPECT_EQ(countCalls(*module, "Box.dtor", "vsl_free"), 1u);
+    EXPECT_EQ(countCalls(*module, "Box.dtor", "free"), 0u);
+    // the size class is known ahead of time: an i32 refcount and an i32 field
+    //  fit in the first one
+    for (const llvm::Instruction& inst : module->getFunction("make")->front())
+    {
+        auto* call = llvm::dyn_cast<llvm::CallInst>(&inst);
+        if (call && call->getCalledFunction()->getName() == "vsl_alloc")
+        {
+            auto* sizeClass =
+                llvm::dyn_cast<llvm::ConstantInt>(call->getArgOperand(0));
+            ASSERT_NE(sizeClass, nullptr);
+            EXPECT_EQ(sizeClass->getZExtValue(), 0u);
+        }
+    }
+}
+
+TEST(CodeGenTest, StackAllocation)
+{
+    llvm::LLVMContext llvmContext;
+    std::unique_ptr<llvm::Module> module = generate(llvmContext,
+        std::string{ boxClass } +
+        "public class Pair { public var box: Box; "
+        "public init(box: Box) { self.box = box; } "
+        "public func get() -> Int { return self.box.v; } "
+        "public func me() -> Pair { return self; } }\n"
+        "public func use(b: Box) -> Int { return b.v; }\n"
+        "public func keep(b: Box) -> Box { return b; }\n"
+        "public func loop(b: Box, n: Int) -> Int "
+        "{ if (n == 0) return b.v; return loop(b: b, n: n - 1); }\n"
+        "public func local() -> Int { let a = Box(v: 1); "
+        "return a.v + use(b: Box(v: 2)) + loop(b: a, n: 3) + Box(v: 3).v; }\n"
+        "public func escaping() -> Int { let a = Box(v: 1); var b = Box(v: 2); "
+        "b = a; return keep(b: Box(v: 3)).v; }\n"
+        "public func fields() -> Int "
+        "{ let p = Pair(box: make(v: 1)); return p.get(); }\n"
+        "public func method() -> Int "
+        "{ return Pair(box: make(v: 1)).me().get(); }\n");
+    ASSERT_NE(module, nullptr);
+    // objects that are only used locally or borrowed by callees that don't let
+    //  them escape live on the stack, so they don't need a destructor either
+    EXPECT_EQ(countCalls(*module, "local", "malloc"), 0u);
+    EXPECT_EQ(countCalls(*module, "local", "Box.dtor"), 0u);
+    // returned, stored, reassigned or passed to something that escapes
+    EXPECT_EQ(countCalls(*module, "escaping", "malloc"), 3u);
+    // a stack object still has to destroy its fields
+    EXPECT_EQ(countCalls(*module, "fields", "malloc"), 0u);
+    EXPECT_EQ(countCalls(*module, "fields", "Pair.dtor"), 0u);
+    EXPECT_GE(countCalls(*module, "fields", "Box.dtor"), 1u);
+    // methods can let self escape too
+    EXPECT_EQ(countCalls(*module, "method", "malloc"), 1u);
+}
+
+TEST(CodeGenTest, DiscardedObject)
+{
+    llvm::LLVMContext llvmContext;
+    std::unique_ptr<llvm::Module> module = generate(llvmContext,
+        std::string{ boxClass } +
+        "public func discard() -> Int { Box(v: 2); return 0; }\n");
+    ASSERT_NE(module, nullptr);
+    // the object in an expression statement doesn't escape, even right after
+    //  a function that returned one
+    EXPECT_EQ(countCalls(*module, "discard", "malloc"), 0u);
+}
+
+TEST(CodeGenTest, AtomicRefcount)
+{
+    IRGenOptions options;
+    options.refcount = IRGenOptions::ATOMIC;
+    llvm::LLVMContext llvmContext;
+    std::unique_ptr<llvm::Module> module = generate(llvmContext,
+        std::string{ boxClass } +
+        "public func f(b: Box) -> Box { let c = b; return c; }\n", options);
+    ASSERT_NE(module, nullptr);
+    // counts the atomic refcount updates in a function
+    auto countRMWs = [&module](llvm::StringRef func,
+        llvm::AtomicRMWInst::BinOp op, llvm::AtomicOrdering ordering)
+    {
+        size_t rmws = 0;
+        for (const llvm::BasicBlock& block : *module->getFunction(func))
+        {
+            for (const llvm::Instruction& inst : block)
+            {
+                auto* rmw = llvm::dyn_cast<llvm::AtomicRMWInst>(&inst);
+                if (rmw && rmw->getOperation() == op &&
+                    rmw->getOrdering() == ordering)
+                {
+                    ++rmws;
+                }
+            }
+        }
+        return rmws;
+    };
+    EXPECT_EQ(countRMWs("f", llvm::AtomicRMWInst::Add,
+            llvm::AtomicOrdering::Monotonic), 2);
+    EXPECT_EQ(countRMWs("Box.dtor", llvm::AtomicRMWInst::Sub,
+            llvm::AtomicOrdering::AcquireRelease), 1);
+    Diag diag{ llvm::nulls() };
+    CodeGen codeGen{ diag, *module };
+    codeGen.configure();
+    codeGen.optimize(1);
+    // atomic increments cancel out with destructor calls just the same
+    EXPECT_EQ(countRMWs("f", llvm::AtomicRMWInst::Add,
+            llvm::AtomicOrdering::Monotonic), 1);
+    EXPECT_EQ(countCalls(*module, "f", "Box.dtor"), 0u);
+}
+
+TEST(CodeGenTest, BiasedRefcount)
+{
+    IRGenOptions options;
+    options.refcount = IRGenOptions::BIASED;
+    llvm::LLVMContext llvmContext;
+    std::unique_ptr<llvm::Module> module = generate(llvmContext,
+        std::string{ boxClass } +
+        "public func f(b: Box) -> Box { let c = b; return c; }\n", options);
+    ASSERT_NE(module, nullptr);
+    EXPECT_EQ(countCalls(*module, "make", "vsl_brc_init"), 1u);
+    EXPECT_EQ(countCalls(*module, "f", "vsl_brc_retain"), 2u);
+    EXPECT_EQ(countCalls(*module, "Box.dtor", "vsl_brc_release"), 1u);
+    // the runtime can destroy objects too, so that has a function of its own
+    EXPECT_EQ(countCalls(*module, "Box.dtor", "Box.destroy"), 1u);
+    EXPECT_EQ(countCalls(*module, "Box.destroy", "free"), 1u);
+    Diag diag{ llvm::nulls() };
+    CodeGen codeGen{ diag, *module };
+    codeGen.configure();
+    codeGen.optimize(1);
+    EXPECT_EQ(countCalls(*module, "f", "vsl_brc_retain"), 1u);
+    EXPECT_EQ(countCalls(*module, "f", "Box.dtor"), 0u);
+}
+
+TEST(CodeGenTest, ObjectCache)
+{
+    llvm::SmallString<128> dir;
+    ASSERT_FALSE(llvm::sys::fs::createUniqueDirectory("vsl-cache", dir));
+    ObjectCache cache{ dir };
+    // compiles some source, returning the number of new entries
+    auto compile = [&cache](const std::string& src, unsigned optLevel = 0)
+    {
+        llvm::LLVMContext llvmContext;
+        std::unique_ptr<llvm::Module> module = generate(llvmContext, src);
+        EXPECT_NE(module, nullptr);
+        Diag diag{ llvm::nulls() };
+        CodeGen codeGen{ diag, *module };
+        codeGen.configure();
+        if (optLevel)
+        {
+            codeGen.optimize(optLevel);
+        }
+        size_t misses = cache.getNumMisses();
+        std::vector<std::string> objects;
+        codeGen.compile(cache, /*jobs=*/2, objects);
+        EXPECT_EQ(diag.getNumErrors(), 0u);
+        EXPECT_FALSE(objects.empty());
+        for (const std::string& object : objects)
+        {
+            EXPECT_TRUE(llvm::sys::fs::exists(object));
+        }
+        return cache.getNumMisses() - misses;
+    };
+    std::string src = "private func f(x: Int) -> Int { return x + 1; }\n";
+    for (int i = 0; i < 8; ++i)
+    {
+        src += "public func g" + std::to_string(i) + "(x: Int) -> Int "
+            "{ return f(x: x) * " + std::to_string(i) + "; }\n";
+    }
+    size_t parts = compile(src);
+    EXPECT_GT(parts, 1u);
+    // nothing changed
+    size_t hits = cache.getNumHits();
+    EXPECT_EQ(compile(src), 0u);
+    EXPECT_EQ(cache.getNumHits() - hits, parts);
+    // only the partitions with an edited or new function are compiled again
+    EXPECT_EQ(compile(src + "public func h() -> Int { return 1; }\n"), 1u);
+    std::string edited = src;
+    edited.replace(edited.find("* 3"), 3, "* 4");
+    EXPECT_EQ(compile(edited), 1u);
+    // optimizing changes the code, so it needs new entries
+    EXPECT_GT(compile(src, 1), 0u);
+    llvm::sys::fs::remove_directories(dir);
+}
+
+TEST(CodeGenTest, GlobalCtors)
+{
+    llvm::LLVMContext llvmContext;
+    std::unique_ptr<llvm::Module> module = generate(llvmContext,
+        "public var x: Int = 1;\n"
+        "public var y: Int = x + 1;\n");
+    ASSERT_NE(module, nullptr);
+    // every global variable is initialized by the same function
+    EXPECT_NE(module->getNamedGlobal("llvm.global_ctors"), nullptr);
+    EXPECT_EQ(countCalls(*module, "vsl.ctors", "x.ctor"), 1u);
+    EXPECT_EQ(countCalls(*module, "vsl.ctors", "y.ctor"), 1u);
+}
@@ -0,0 +1,49 @@
+#include "driver/driver.hpp"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+#include <initializer_list>
+#include <string>
+#include <system_error>
+#include <vector>
+
+TEST(DriverTest, RejectsForeignObjectLinking)
+{
+    llvm::SmallString<128> dir;
+    ASSERT_FALSE(llvm::sys::fs::createUniqueDirectory("vsl-driver", dir));
+    std::string src = (dir + "/a.vsl").str();
+    std::string out = (dir + "/a.o").str();
+    std::string cacheDir = "--cache-dir=" + (dir + "/cache").str();
+    {
+        std::error_code ec;
+        llvm::raw_fd_ostream os{ src, ec, llvm::sys::fs::F_Text };
+        ASSERT_FALSE(ec);
+        os << "public func f(x: Int) -> Int { return x; }\n";
+    }
+    // runs the driver, returning what it printed
+    auto compile = [&](std::initializer_list<const char*> flags)
+    {
+        std::vector<const char*> argv{ "vsl" };
+        argv.insert(argv.end(), flags);
+        argv.insert(argv.end(), { "-o", out.c_str(), src.c_str() });
+        testing::internal::CaptureStderr();
+        Driver driver;
+        driver.main(static_cast<int>(argv.size()), argv.data());
+        return testing::internal::GetCapturedStderr();
+    };
+    // ld would have to combine the other target's objects
+    const char* target = "--target=sparc-unknown-linux-gnu";
+    EXPECT_NE(compile({ target, "-j", "2" }).find("with ld"),
+        std::string::npos);
+    EXPECT_NE(compile({ target, cacheDir.c_str() }).find("with ld"),
+        std::string::npos);
+    EXPECT_NE(compile({ target, "-j", "2", "--split-objects",
+            cacheDir.c_str() }).find("with ld"), std::string::npos);
+    EXPECT_FALSE(llvm::sys::fs::exists(out));
+    // split objects are never linked, so only the missing target is an error
+    //  unless vsl was built for cross compiling
+    EXPECT_EQ(compile({ target, "-j", "2", "--split-objects" }).find("with ld"),
+        std::string::npos);
+    llvm::sys::fs::remove_directories(dir);
+}
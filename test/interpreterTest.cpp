@@ -0,0 +1,196 @@
+#include "ast/vslContext.hpp"
+#include "codegen/codegen.hpp"
+#include "diag/diag.hpp"
+#include "interp/interpreter.hpp"
+#include "irgen/irgen.hpp"
+#include "jit/jit.hpp"
+#include "lexer/vslLexer.hpp"
+#include "parser/vslParser.hpp"
+#include "llvm/IR/Module.h"
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// runs the interpreter on some source, which has to outlive it along with the
+//  other arguments
+class InterpreterTest : public ::testing::Test
+{
+protected:
+    InterpreterTest()
+        : diag{ llvm::nulls() }, jit{ diag }
+    {
+    }
+    // generates code for the source and gets the interpreter ready to run it
+    std::unique_ptr<Interpreter> create(const std::string& src,
+        unsigned threshold)
+    {
+        this->src = src;
+        VSLLexer lexer{ diag, this->src };
+        VSLParser parser{ vslCtx, lexer };
+        parser.parse();
+        auto module = std::make_unique<llvm::Module>("test",
+            jit.getContext());
+        CodeGen codeGen{ diag, *module };
+        codeGen.configure();
+        IRGen irgen{ vslCtx, diag, *module };
+        irgen.run();
+        if (diag.getNumErrors())
+        {
+            return nullptr;
+        }
+        auto interpreter = std::make_unique<Interpreter>(diag, jit,
+            std::move(module), [] {}, threshold);
+        if (!interpreter->init(vslCtx.getGlobals()))
+        {
+            return nullptr;
+        }
+        return interpreter;
+    }
+    Diag diag;
+    JIT jit;
+    VSLContext vslCtx;
+    std::string src;
+};
+
+// the same results have to come out whether it's interpreted or compiled
+static const char* const mathSrc =
+    "public func f(x: Int, b: Bool) -> Int\n"
+    "{\n"
+    "    var y: Int = x * 3 - 7;\n"
+    "    if (!b && y > 0) { y = -y; }\n"
+    "    return y / 2 + y % 5 + (b ? 1 : 0);\n"
+    "}\n"
+    "public func g(x: Int) -> Bool { return x == 3 || !(x < 10); }\n";
+
+static void checkMath(Interpreter& interpreter)
+{
+    int32_t value;
+    ASSERT_TRUE(interpreter.call("f", { 5, 0 }, value));
+    EXPECT_EQ(value, -4 + -3);
+    ASSERT_TRUE(interpreter.call("f", { -4, 1 }, value));
+    EXPECT_EQ(value, -9 + -4 + 1);
+    ASSERT_TRUE(interpreter.call("g", { 3 }, value));
+    EXPECT_EQ(value, 1);
+    ASSERT_TRUE(interpreter.call("g", { 5 }, value));
+    EXPECT_EQ(value, 0);
+    ASSERT_TRUE(interpreter.call("g", { 12 }, value));
+    EXPECT_EQ(value, 1);
+}
+
+TEST_F(InterpreterTest, Interprets)
+{
+    std::unique_ptr<Interpreter> interpreter = create(mathSrc,
+        /*threshold=*/1000);
+    ASSERT_NE(interpreter, nullptr);
+    checkMath(*interpreter);
+    EXPECT_EQ(interpreter->getNumCompiled(), 0u);
+}
+
+TEST_F(InterpreterTest, CompilesEverything)
+{
+    std::unique_ptr<Interpreter> interpreter = create(mathSrc,
+        /*threshold=*/0);
+    ASSERT_NE(interpreter, nullptr);
+    checkMath(*interpreter);
+    EXPECT_EQ(interpreter->getNumCompiled(), 2u);
+}
+
+TEST_F(InterpreterTest, CompilesHotFunctions)
+{
+    std::unique_ptr<Interpreter> interpreter = create(
+        "public func fib(n: Int) -> Int\n"
+        "{\n"
+        "    return n < 2 ? n : fib(n: n - 1) + fib(n: n - 2);\n"
+        "}\n"
+        "public func main() -> Int { return fib(n: 20); }\n",
+        /*threshold=*/10);
+    ASSERT_NE(interpreter, nullptr);
+    int32_t value;
+    ASSERT_TRUE(interpreter->call("main", {}, value));
+    EXPECT_EQ(value, 6765);
+    // main is only called once, but fib gets hot
+    EXPECT_EQ(interpreter->getNumCompiled(), 1u);
+}
+
+TEST_F(InterpreterTest, SharesGlobals)
+{
+    std::unique_ptr<Interpreter> interpreter = create(
+        "public var x: Int = 2 + 3;\n"
+        "public var b: Bool = x > 4;\n"
+        "public func f() -> Int { x = x + 1; return b ? x : 0; }\n",
+        /*threshold=*/2);
+    ASSERT_NE(interpreter, nullptr);
+    int32_t value;
+    // the first call is interpreted and the rest are compiled, which use the
+    //  same variables
+    for (int32_t i = 6; i < 9; ++i)
+    {
+        ASSERT_TRUE(interpreter->call("f", {}, value));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_EQ(interpreter->getNumCompiled(), 1u);
+}
+
+TEST_F(InterpreterTest, CompilesObjects)
+{
+    std::unique_ptr<Interpreter> interpreter = create(
+        "public class A\n"
+        "{\n"
+        "    public var x: Int;\n"
+        "    public init(x: Int) { self.x = x; }\n"
+        "}\n"
+        "public func f(y: Int) -> Int { var a: A = A(x: y); return a.x; }\n"
+        "public func g() -> Int { return f(y: 3) + 4; }\n",
+        /*threshold=*/1000);
+    ASSERT_NE(interpreter, nullptr);
+    int32_t value;
+    // f can't be interpreted, but g can still call it
+    ASSERT_TRUE(interpreter->call("g", {}, value));
+    EXPECT_EQ(value, 7);
+    EXPECT_EQ(interpreter->getNumCompiled(), 1u);
+}
+
+TEST_F(InterpreterTest, DeepExpressions)
+{
+    // deep enough to overflow the stack if each level was a recursive call
+    const size_t depth = 100000;
+    std::string src = "public func id(x: Int) -> Int { return x; }\n"
+        "public func sum(x: Int) -> Int { return x";
+    for (size_t i = 0; i < depth; ++i)
+    {
+        src += " + x";
+    }
+    src += "; }\npublic func nested(x: Int) -> Int { return ";
+    for (size_t i = 0; i < depth; ++i)
+    {
+        src += "x - (";
+    }
+    src += "x" + std::string(depth, ')') + "; }\n"
+        "public func negated(x: Int) -> Int { return ";
+    for (size_t i = 0; i < depth; ++i)
+    {
+        src += "-(x + ";
+    }
+    src += "x" + std::string(depth, ')') + "; }\n"
+        "public func calls(x: Int) -> Int { return ";
+    for (size_t i = 0; i < depth; ++i)
+    {
+        src += "1 + id(x: ";
+    }
+    src += "x" + std::string(depth, ')') + "; }\n";
+    std::unique_ptr<Interpreter> interpreter = create(src,
+        /*threshold=*/2 * depth);
+    ASSERT_NE(interpreter, nullptr);
+    int32_t value;
+    ASSERT_TRUE(interpreter->call("sum", { 2 }, value));
+    EXPECT_EQ(value, static_cast<int32_t>(2 * (depth + 1)));
+    // each pair of levels cancels out
+    ASSERT_TRUE(interpreter->call("nested", { 3 }, value));
+    EXPECT_EQ(value, 3);
+    ASSERT_TRUE(interpreter->call("negated", { 3 }, value));
+    EXPECT_EQ(value, 3);
+    ASSERT_TRUE(interpreter->call("calls", { 3 }, value));
+    EXPECT_EQ(value, static_cast<int32_t>(3 + depth));
+    EXPECT_EQ(interpreter->getNumCompiled(), 0u);
+}
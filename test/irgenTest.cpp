@@ -3,13 +3,17 @@
 #include "irgen/irgen.hpp"
 #include "lexer/vslLexer.hpp"
 #include "parser/vslParser.hpp"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
 #include "gtest/gtest.h"
+#include <string>
 
 #define valid(src) EXPECT_TRUE(validate(src))
 #define invalid(src) EXPECT_FALSE(validate(src))
 
 // returns true if semantically valid, false otherwise
-static bool validate(const char* src)
+static bool validate(const char* src, unsigned jobs = 1)
 {
     VSLContext vslCtx;
     Diag diag{ llvm::nulls() };
@@ -19,7 +23,7 @@ static bool validate(const char* src)
     llvm::LLVMContext llvmContext;
     auto module = std::make_unique<llvm::Module>("test", llvmContext);
     IRGen irgen{ vslCtx, diag, *module };
-    irgen.run();
+    irgen.run(jobs);
     return !diag.getNumErrors();
 }
 
@@ -36,6 +40,8 @@ TEST(IRGenTest, Functions)
     invalid("public func f(x: Void) -> Void { return x; }");
     // can't return a void expression
     invalid("public func f() -> Void { return f(); }");
+    // or an assignment, which doesn't have a value
+    invalid("public func f(x: Int) -> Int { return x = 1; }");
     // able to call a function ahead of its definition
     valid("public func f() -> Void { g(); } private func g() -> Void {}");
     // can't call non-functions
@@ -74,6 +80,9 @@ TEST(IRGenTest, Conditionals)
     valid("public func f(x: Int) -> Int { return x == 4 ? "
         "x == 3 ? x : x + 1 :"
             "x == 2 ? x + 2 : x + 3; }");
+    // short circuits can be nested on both sides too
+    valid("public func f(x: Int) -> Bool "
+        "{ return (x > 1 && x < 5) || (x < -1 && !(x == -5)); }");
 }
 
 TEST(IRGenTest, Variables)
@@ -139,3 +148,119 @@ TEST(IRGenTest, MemberAccess)
     invalid("public class A { private func f() -> Void {} } "
         "public func f(a: A) -> Void { a.f(); }");
 }
+
+TEST(IRGenTest, Parallel)
+{
+    // calls between functions and classes emitted on different threads
+    const char* src = "public var y: Int = 2; "
+        "public class A { public var x: Int; "
+        "public init(x: Int) { self.x = f(x: x); } "
+        "public func get() -> Int { return self.x; } } "
+        "public func f(x: Int) -> Int { return g(x: x) + y; } "
+        "private func g(x: Int) -> Int { return A(x: x).get(); } "
+        "public func h() -> A { return A(x: y); }";
+    valid(src);
+    EXPECT_TRUE(validate(src, 3));
+    // more threads than functions
+    EXPECT_TRUE(validate("public func f() -> Void {}", 8));
+    // global variables still can't be used before they're declared
+    EXPECT_FALSE(validate("public func f() -> Int { return x; } "
+        "public var x: Int = 1; public func g() -> Int { return x; }", 2));
+}
+
+TEST(IRGenTest, ParallelLinkage)
+{
+    VSLContext vslCtx;
+    Diag diag{ llvm::nulls() };
+    VSLLexer lexer{ diag, "public class A { public var x: Int; "
+        "public init(x: Int) { self.x = x; } } "
+        "public func f() -> A { return A(x: 1); } "
+        "private func g() -> Int { return f().x; }" };
+    VSLParser parser{ vslCtx, lexer };
+    parser.parse();
+    llvm::LLVMContext llvmContext;
+    llvm::Module module{ "test", llvmContext };
+    IRGenOptions options;
+    options.refcount = IRGenOptions::BIASED;
+    IRGen irgen{ vslCtx, diag, module, options };
+    irgen.run(2);
+    ASSERT_EQ(diag.getNumErrors(), 0u);
+    // functions that were internal in the workers' modules stay internal
+    //  after they're linked into the main one
+    for (const char* name : { "A.destroy", "g" })
+    {
+        llvm::Function* func = module.getFunction(name);
+        ASSERT_NE(func, nullptr) << name;
+        EXPECT_TRUE(func->hasLocalLinkage()) << name;
+    }
+    EXPECT_FALSE(module.getFunction("f")->hasLocalLinkage());
+}
+
+TEST(IRGenTest, DeepExpressions)
+{
+    // deep enough to overflow the stack if each level was a recursive call
+    const size_t depth = 100000;
+    std::string src = "public func f(x: Int) -> Int { return x";
+    for (size_t i = 0; i < depth; ++i)
+    {
+        src += " + x";
+    }
+    valid((src + "; }").c_str());
+    src = "public func f(x: Int) -> Int { return " + std::string(depth, '-') +
+        "x; }";
+    valid(src.c_str());
+    src = "public func f(x: Bool) -> Bool { return x";
+    for (size_t i = 0; i < depth; ++i)
+    {
+        src += i % 2 ? " && x" : " || x";
+    }
+    valid((src + "; }").c_str());
+    src = "public func f(x: Int) -> Int { return ";
+    for (size_t i = 0; i < depth; ++i)
+    {
+        src += "x == " + std::to_string(i) + " ? x : ";
+    }
+    valid((src + "x; }").c_str());
+    src = "public func f(x: Int) -> Int { ";
+    for (size_t i = 0; i < depth; ++i)
+    {
+        src += "f(x: ";
+    }
+    valid((src + "x" + std::string(depth, ')') + "; return x; }").c_str());
+    // assignment is right associative, so this chains down the rhs
+    src = "public func f(x: Int) -> Int { ";
+    for (size_t i = 0; i < depth; ++i)
+    {
+        src += "x = ";
+    }
+    valid((src + "1; return x; }").c_str());
+    // operators nested down the rhs, as generated code tends to parenthesize
+    src = "public func f(x: Int) -> Int { return ";
+    for (size_t i = 0; i < depth; ++i)
+    {
+        src += "x - (";
+    }
+    valid((src + "x" + std::string(depth, ')') + "; }").c_str());
+    // unary and binary operators nested in each other
+    src = "public func f(x: Int) -> Int { return ";
+    for (size_t i = 0; i < depth; ++i)
+    {
+        src += "-(x + ";
+    }
+    valid((src + "x" + std::string(depth, ')') + "; }").c_str());
+    // calls inside operators inside arguments
+    src = "public func f(x: Int) -> Int { return ";
+    for (size_t i = 0; i < depth; ++i)
+    {
+        src += "1 + f(x: ";
+    }
+    valid((src + "x" + std::string(depth, ')') + "; }").c_str());
+    // ternaries nested in the conditions of others
+    src = "public func f(x: Bool) -> Bool { return " + std::string(depth, '(') +
+        "x";
+    for (size_t i = 0; i < depth; ++i)
+    {
+        src += " ? x : x)";
+    }
+    valid((src + "; }").c_str());
+}
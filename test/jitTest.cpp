@@ -0,0 +1,73 @@
+#include "ast/vslContext.hpp"
+#include "codegen/codegen.hpp"
+#include "diag/diag.hpp"
+#include "irgen/irgen.hpp"
+#include "jit/jit.hpp"
+#include "lexer/vslLexer.hpp"
+#include "parser/vslParser.hpp"
+#include "llvm/IR/Module.h"
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// generates code for some source in the jit's context, returning null if it's
+//  invalid
+static std::unique_ptr<llvm::Module> generate(JIT& jit, const std::string& src)
+{
+    VSLContext vslCtx;
+    Diag diag{ llvm::nulls() };
+    VSLLexer lexer{ diag, src };
+    VSLParser parser{ vslCtx, lexer };
+    parser.parse();
+    auto module = std::make_unique<llvm::Module>("test", jit.getContext());
+    CodeGen codeGen{ diag, *module };
+    codeGen.configure();
+    IRGen irgen{ vslCtx, diag, *module };
+    irgen.run();
+    if (diag.getNumErrors())
+    {
+        return nullptr;
+    }
+    return module;
+}
+
+TEST(JITTest, RunsFunctions)
+{
+    Diag diag{ llvm::nulls() };
+    JIT jit{ diag };
+    std::unique_ptr<llvm::Module> module = generate(jit,
+        "public func f(x: Int) -> Int { return x * 2 + 1; }");
+    ASSERT_NE(module, nullptr);
+    ASSERT_TRUE(jit.addModule(std::move(module)));
+    void* f = jit.getAddress("f");
+    ASSERT_NE(f, nullptr);
+    EXPECT_EQ(reinterpret_cast<int32_t (*)(int32_t)>(f)(20), 41);
+    EXPECT_EQ(jit.getAddress("g"), nullptr);
+}
+
+TEST(JITTest, LinksModules)
+{
+    Diag diag{ llvm::nulls() };
+    JIT jit{ diag };
+    // each module has the declarations of the ones before it, like the lines
+    //  of the run REPL
+    const std::string decls = "public var x: Int = 5;\n"
+        "private func sq(y: Int) -> Int { return y * y; }\n";
+    std::unique_ptr<llvm::Module> module = generate(jit, decls);
+    ASSERT_NE(module, nullptr);
+    jit.linkExisting(*module);
+    ASSERT_TRUE(jit.addModule(std::move(module)));
+    module = generate(jit, decls +
+        "public func g() -> Int { x = x + 1; return sq(y: x); }");
+    ASSERT_NE(module, nullptr);
+    jit.linkExisting(*module);
+    // only the new function is left to compile
+    EXPECT_TRUE(module->getFunction("sq")->isDeclaration());
+    ASSERT_TRUE(jit.addModule(std::move(module)));
+    void* g = jit.getAddress("g");
+    ASSERT_NE(g, nullptr);
+    // x isn't initialized again, so it keeps its value between calls
+    EXPECT_EQ(reinterpret_cast<int32_t (*)()>(g)(), 36);
+    EXPECT_EQ(reinterpret_cast<int32_t (*)()>(g)(), 49);
+}
@@ -1,6 +1,8 @@
 #include "diag/diag.hpp"
+#include "lexer/sourceManager.hpp"
 #include "lexer/vslLexer.hpp"
 #include "gtest/gtest.h"
+#include <string>
 
 #define valid(src) EXPECT_TRUE(lex(src))
 #define invalid(src) EXPECT_FALSE(lex(src))
@@ -31,3 +33,47 @@ TEST(LexerTest, HandlesNumbers)
     // and so are big numbers like these
     valid("999999999999999999999999999999999");
 }
+
+TEST(LexerTest, HandlesLongRuns)
+{
+    // long enough to go through the vectorized paths of the lexer
+    std::string ident = "a" + std::string(99, 'Z') + "9";
+    std::string number(100, '7');
+    std::string src = ident + std::string(70, ' ') + "\n\t" + number + " // " +
+        std::string(70, 'c') + "\n/* " + std::string(70, '-') + " */ x";
+    Diag diag{ llvm::nulls() };
+    VSLLexer lexer{ diag, src };
+    Token token = lexer.nextToken();
+    EXPECT_TRUE(token.is(TokenKind::IDENTIFIER));
+    EXPECT_EQ(ident, token.getText().str());
+    token = lexer.nextToken();
+    EXPECT_TRUE(token.is(TokenKind::NUMBER));
+    EXPECT_EQ(number, token.getText().str());
+    token = lexer.nextToken();
+    EXPECT_TRUE(token.is(TokenKind::IDENTIFIER));
+    EXPECT_EQ("x", token.getText().str());
+    EXPECT_TRUE(lexer.nextToken().is(TokenKind::END));
+    EXPECT_TRUE(lexer.empty());
+    EXPECT_EQ(0u, diag.getNumWarnings());
+}
+
+TEST(LexerTest, TracksLocations)
+{
+    SourceManager srcMgr;
+    srcMgr.setBuffer("let x\n  /* a\n */ y", "test");
+    Diag diag{ llvm::nulls(), &srcMgr };
+    VSLLexer lexer{ diag, srcMgr.getBuffer() };
+    auto next = [&]
+    {
+        return srcMgr.getLineAndCol(lexer.nextToken().getLoc());
+    };
+    using LineAndCol = std::pair<unsigned, unsigned>;
+    EXPECT_EQ(LineAndCol(1, 1), next());
+    EXPECT_EQ(LineAndCol(1, 5), next());
+    EXPECT_EQ(LineAndCol(3, 5), next());
+    // eof points at the null terminator
+    Token eof = lexer.nextToken();
+    ASSERT_TRUE(eof.is(TokenKind::END));
+    EXPECT_TRUE(srcMgr.contains(eof.getLoc()));
+    EXPECT_EQ(LineAndCol(3, 6), srcMgr.getLineAndCol(eof.getLoc()));
+}
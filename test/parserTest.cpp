@@ -3,6 +3,7 @@
 #include "lexer/vslLexer.hpp"
 #include "parser/vslParser.hpp"
 #include "gtest/gtest.h"
+#include <string>
 
 #define valid(src) EXPECT_TRUE(parse(src))
 #define invalid(src) EXPECT_FALSE(parse(src))
@@ -115,3 +116,110 @@ TEST(ParserTest, Parentheses)
     invalid("public func f() -> Void { (x + 1; }");
     invalid("public func f() -> Void { x + 1); }");
 }
+
+TEST(ParserTest, LongInput)
+{
+    // enough tokens to wrap around the parser's token buffer a few times
+    std::string src = "public func f() -> Void {";
+    for (int i = 0; i < 500; ++i)
+    {
+        src += " x = (y + 1) * 2;";
+    }
+    valid((src + " }").c_str());
+    // unexpected end of input
+    invalid(src.c_str());
+}
+
+TEST(ParserTest, DeepExpressions)
+{
+    // deep enough to overflow the stack if each level was a recursive call
+    const size_t depth = 100000;
+    std::string src = "public func f() -> Void { " + std::string(depth, '(') +
+        "x" + std::string(depth, ')') + "; }";
+    valid(src.c_str());
+    src = "public func f() -> Void { " + std::string(depth, '-') + "x; }";
+    valid(src.c_str());
+    src = "public func f() -> Void { ";
+    for (size_t i = 0; i < depth; ++i)
+    {
+        src += "f(x: ";
+    }
+    src += "x" + std::string(depth, ')') + "; }";
+    valid(src.c_str());
+    // a missing paren deep down is still caught
+    src = "public func f() -> Void { " + std::string(depth, '(') + "x" +
+        std::string(depth - 1, ')') + "; }";
+    invalid(src.c_str());
+}
+
+TEST(ParserTest, CallArgRecovery)
+{
+    VSLContext vslCtx;
+    Diag diag{ llvm::nulls() };
+    VSLLexer lexer{ diag, "public func f() -> Int "
+        "{ return f(x 1, y: g(2, z: 3), w: 4); }" };
+    VSLParser parser{ vslCtx, lexer };
+    parser.parse();
+    // each bad argument is reported once and left out, and the rest are
+    //  still parsed
+    EXPECT_EQ(2u, diag.getNumErrors());
+    ASSERT_EQ(1u, vslCtx.getGlobals().size());
+    auto& node = static_cast<const FunctionNode&>(*vslCtx.getGlobals()[0]);
+    ASSERT_EQ(1u, node.getBody().getStatements().size());
+    auto& ret = static_cast<const ReturnNode&>(
+        *node.getBody().getStatements()[0]);
+    ASSERT_TRUE(ret.getValue().is(Node::CALL));
+    auto& call = static_cast<const CallNode&>(ret.getValue());
+    ASSERT_EQ(2u, call.getNumArgs());
+    EXPECT_EQ("y", call.getArg(0).getName());
+    EXPECT_EQ("w", call.getArg(1).getName());
+    ASSERT_TRUE(call.getArg(0).getValue().is(Node::CALL));
+    auto& inner = static_cast<const CallNode&>(call.getArg(0).getValue());
+    ASSERT_EQ(1u, inner.getNumArgs());
+    EXPECT_EQ("z", inner.getArg(0).getName());
+}
+
+TEST(ParserTest, ClassMembers)
+{
+    VSLContext vslCtx;
+    Diag diag{ llvm::nulls() };
+    VSLLexer lexer{ diag, "public class X { public var x: Int; "
+        "private let y: Bool; public var x: Int; "
+        "public func f() -> Int { return 1; } }" };
+    VSLParser parser{ vslCtx, lexer };
+    parser.parse();
+    // the duplicate field should be reported and left out
+    EXPECT_EQ(1u, diag.getNumErrors());
+    ASSERT_EQ(1u, vslCtx.getGlobals().size());
+    ASSERT_TRUE(vslCtx.getGlobals()[0]->is(Node::CLASS));
+    auto& node = static_cast<const ClassNode&>(*vslCtx.getGlobals()[0]);
+    ASSERT_EQ(2u, node.getNumFields());
+    EXPECT_EQ("x", node.getField(0).getName());
+    EXPECT_EQ("y", node.getField(1).getName());
+    EXPECT_EQ(1u, node.getMethods().size());
+    EXPECT_FALSE(node.hasCtor());
+}
+
+TEST(ParserTest, InternsIdentifiers)
+{
+    VSLContext vslCtx;
+    Diag diag{ llvm::nulls() };
+    VSLLexer lexer{ diag, "public func f(x: Int, y: Int) -> Int "
+        "{ return x; }" };
+    VSLParser parser{ vslCtx, lexer };
+    parser.parse();
+    ASSERT_EQ(0u, diag.getNumErrors());
+    ASSERT_EQ(1u, vslCtx.getGlobals().size());
+    auto& node = static_cast<const FunctionNode&>(*vslCtx.getGlobals()[0]);
+    // every identifier with the same name gets the same dense ID
+    EXPECT_EQ(3u, vslCtx.getNumSymbols());
+    EXPECT_EQ(vslCtx.intern("f"), node.getSymbol());
+    EXPECT_EQ(3u, vslCtx.getNumSymbols());
+    ASSERT_EQ(1u, node.getBody().getStatements().size());
+    auto& ret = static_cast<const ReturnNode&>(
+        *node.getBody().getStatements()[0]);
+    auto& ident = static_cast<const IdentNode&>(ret.getValue());
+    EXPECT_EQ(node.getParam(0).getSymbol(), ident.getSymbol());
+    EXPECT_NE(node.getParam(1).getSymbol(), ident.getSymbol());
+    EXPECT_LT(ident.getSymbol().getId(), vslCtx.getNumSymbols());
+}
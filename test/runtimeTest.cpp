@@ -0,0 +1,224 @@
+#include "vslrt.h"
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <cstring>
+#include <set>
+#include <thread>
+#include <vector>
+
+TEST(RuntimeTest, AllocatesDistinctAlignedBlocks)
+{
+    for (uint32_t sizeClass = 0; sizeClass < VSL_NUM_SIZE_CLASSES;
+        ++sizeClass)
+    {
+        const size_t size = (sizeClass + 1) * VSL_SIZE_CLASS_STEP;
+        std::vector<char*> blocks;
+        // enough to need more than one chunk
+        for (size_t i = 0; i < 1024; ++i)
+        {
+            auto* block = static_cast<char*>(vsl_alloc(sizeClass));
+            ASSERT_NE(block, nullptr);
+            EXPECT_EQ(reinterpret_cast<uintptr_t>(block) %
+                VSL_SIZE_CLASS_STEP, 0u);
+            // the whole block should be usable without clobbering the others
+            std::memset(block, static_cast<int>(i), size);
+            blocks.push_back(block);
+        }
+        for (size_t i = 0; i < blocks.size(); ++i)
+        {
+            EXPECT_EQ(blocks[i][0], static_cast<char>(i));
+            EXPECT_EQ(blocks[i][size - 1], static_cast<char>(i));
+        }
+        EXPECT_EQ(std::set<char*>(blocks.begin(), blocks.end()).size(),
+            blocks.size());
+        for (char* block : blocks)
+        {
+            vsl_free(block, sizeClass);
+        }
+    }
+}
+
+TEST(RuntimeTest, ReusesFreedBlocks)
+{
+    void* a = vsl_alloc(1);
+    void* b = vsl_alloc(1);
+    vsl_free(a, 1);
+    vsl_free(b, 1);
+    vsl_free(nullptr, 1);
+    // last in, first out
+    EXPECT_EQ(vsl_alloc(1), b);
+    EXPECT_EQ(vsl_alloc(1), a);
+    // other size classes have their own blocks
+    void* c = vsl_alloc(2);
+    EXPECT_NE(c, a);
+    EXPECT_NE(c, b);
+    vsl_free(a, 1);
+    vsl_free(b, 1);
+    vsl_free(c, 2);
+}
+
+TEST(RuntimeTest, FreesFromOtherThreads)
+{
+    std::vector<void*> blocks;
+    std::thread producer{ [&blocks]
+        {
+            for (size_t i = 0; i < 256; ++i)
+            {
+                blocks.push_back(vsl_alloc(0));
+            }
+        } };
+    producer.join();
+    // the blocks end up in this thread's pool
+    for (void* block : blocks)
+    {
+        vsl_free(block, 0);
+    }
+    std::set<void*> reused;
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+        reused.insert(vsl_alloc(0));
+    }
+    EXPECT_EQ(reused, std::set<void*>(blocks.begin(), blocks.end()));
+    for (void* block : reused)
+    {
+        vsl_free(block, 0);
+    }
+}
+
+TEST(RuntimeTest, ReusesBlocksOfExitedThreads)
+{
+    std::set<void*> blocks;
+    std::thread producer{ [&blocks]
+        {
+            for (size_t i = 0; i < 64; ++i)
+            {
+                blocks.insert(vsl_alloc(3));
+            }
+            for (void* block : blocks)
+            {
+                vsl_free(block, 3);
+            }
+        } };
+    producer.join();
+    // a new thread has nothing of its own, so it gets what the producer left
+    void* reused = nullptr;
+    std::thread consumer{ [&reused]
+        {
+            reused = vsl_alloc(3);
+            vsl_free(reused, 3);
+        } };
+    consumer.join();
+    EXPECT_EQ(blocks.count(reused), 1u);
+}
+
+// counts how many times the objects in the brc tests get destroyed
+static int destroyed;
+
+static void countDestroy(void*)
+{
+    ++destroyed;
+}
+
+TEST(RuntimeTest, BiasedOwnerCountsWithoutSharing)
+{
+    destroyed = 0;
+    vsl_brc hdr;
+    vsl_brc_init(&hdr);
+    vsl_brc_retain(&hdr);
+    EXPECT_EQ(hdr.biased, 2);
+    EXPECT_EQ(hdr.shared, 0);
+    EXPECT_EQ(vsl_brc_release(&hdr, countDestroy), 0);
+    EXPECT_NE(vsl_brc_release(&hdr, countDestroy), 0);
+    // the caller destroys it, not the runtime
+    EXPECT_EQ(destroyed, 0);
+}
+
+TEST(RuntimeTest, BiasedMergesAfterOtherThreadsRelease)
+{
+    destroyed = 0;
+    vsl_brc hdr;
+    vsl_brc_init(&hdr);
+    vsl_brc_retain(&hdr);
+    // the other thread's release leaves the shared count negative, so the
+    //  object gets queued up for this thread to merge
+    std::thread other{ [&hdr]
+        {
+            EXPECT_EQ(vsl_brc_release(&hdr, countDestroy), 0);
+        } };
+    other.join();
+    EXPECT_NE(hdr.shared & VSL_BRC_QUEUED, 0);
+    vsl_brc_collect();
+    EXPECT_EQ(hdr.owner, nullptr);
+    EXPECT_EQ(hdr.shared, VSL_BRC_ONE | VSL_BRC_MERGED);
+    EXPECT_EQ(destroyed, 0);
+    // after merging, the owner goes through the shared count like everyone
+    EXPECT_NE(vsl_brc_release(&hdr, countDestroy), 0);
+}
+
+TEST(RuntimeTest, BiasedOwnerDestroysQueuedObjects)
+{
+    destroyed = 0;
+    vsl_brc hdr;
+    vsl_brc_init(&hdr);
+    vsl_brc_retain(&hdr);
+    std::thread other{ [&hdr]
+        {
+            EXPECT_EQ(vsl_brc_release(&hdr, countDestroy), 0);
+        } };
+    other.join();
+    // the biased count still includes the other thread's reference, so the
+    //  object only turns out to be dead once it's merged
+    EXPECT_EQ(vsl_brc_release(&hdr, countDestroy), 0);
+    EXPECT_EQ(destroyed, 0);
+    vsl_brc_collect();
+    EXPECT_EQ(destroyed, 1);
+}
+
+TEST(RuntimeTest, BiasedMergesAfterOwnerExits)
+{
+    destroyed = 0;
+    vsl_brc hdr;
+    std::thread owner{ [&hdr]
+        {
+            vsl_brc_init(&hdr);
+            vsl_brc_retain(&hdr);
+            EXPECT_EQ(vsl_brc_release(&hdr, countDestroy), 0);
+        } };
+    owner.join();
+    // nobody's left to merge the owner's reference, so this thread has to
+    EXPECT_NE(vsl_brc_release(&hdr, countDestroy), 0);
+    EXPECT_EQ(destroyed, 0);
+}
+
+TEST(RuntimeTest, BiasedSharedBetweenThreads)
+{
+    const int numThreads = 4;
+    destroyed = 0;
+    vsl_brc hdr;
+    vsl_brc_init(&hdr);
+    std::vector<std::thread> threads;
+    int dead = 0;
+    for (int i = 0; i < numThreads; ++i)
+    {
+        // each thread gets a reference of its own
+        vsl_brc_retain(&hdr);
+        threads.emplace_back([&hdr, &dead]
+            {
+                for (int j = 0; j < 1000; ++j)
+                {
+                    vsl_brc_retain(&hdr);
+                    EXPECT_EQ(vsl_brc_release(&hdr, countDestroy), 0);
+                }
+                if (vsl_brc_release(&hdr, countDestroy))
+                {
+                    __atomic_fetch_add(&dead, 1, __ATOMIC_RELAXED);
+                }
+            });
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    vsl_brc_collect();
+    EXPECT_EQ(vsl_brc_release(&hdr, countDestroy) + dead + destroyed, 1);
+}
@@ -0,0 +1,81 @@
+#include "driver/serverProtocol.hpp"
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+TEST(ServerTest, SendsRequests)
+{
+    int socks[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, socks), 0);
+    int pipes[numRequestFds][2];
+    int fds[numRequestFds];
+    for (int i = 0; i < numRequestFds; ++i)
+    {
+        ASSERT_EQ(pipe(pipes[i]), 0);
+        fds[i] = pipes[i][1];
+    }
+    std::vector<std::string> args{ "vsl", "-O2", "", "a file.vsl" };
+    ASSERT_TRUE(sendRequest(socks[0], args, fds));
+    std::vector<std::string> received;
+    int receivedFds[numRequestFds];
+    ASSERT_TRUE(receiveRequest(socks[1], received, receivedFds));
+    EXPECT_EQ(received, args);
+    // the descriptors are new ones for the same pipes
+    for (int i = 0; i < numRequestFds; ++i)
+    {
+        char c = static_cast<char>('0' + i);
+        EXPECT_EQ(write(receivedFds[i], &c, 1), 1);
+        close(receivedFds[i]);
+        close(pipes[i][1]);
+        char got = 0;
+        EXPECT_EQ(read(pipes[i][0], &got, 1), 1);
+        EXPECT_EQ(got, c);
+        close(pipes[i][0]);
+    }
+    ASSERT_TRUE(sendStatus(socks[1], 3));
+    int status = 0;
+    ASSERT_TRUE(receiveStatus(socks[0], status));
+    EXPECT_EQ(status, 3);
+    // a server that goes away doesn't leave the client hanging
+    close(socks[1]);
+    EXPECT_FALSE(receiveStatus(socks[0], status));
+    close(socks[0]);
+}
+
+TEST(ServerTest, RejectsBadRequests)
+{
+    int socks[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, socks), 0);
+    // no descriptors
+    uint32_t size = 4;
+    ASSERT_EQ(write(socks[0], &size, sizeof size),
+        static_cast<ssize_t>(sizeof size));
+    ASSERT_EQ(write(socks[0], "vsl", 4), 4);
+    std::vector<std::string> args;
+    int fds[numRequestFds];
+    EXPECT_FALSE(receiveRequest(socks[1], args, fds));
+    close(socks[0]);
+    close(socks[1]);
+    // a good request followed by a cut off one
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, socks), 0);
+    int pipeFds[2];
+    ASSERT_EQ(pipe(pipeFds), 0);
+    int sent[numRequestFds] = { pipeFds[0], pipeFds[1], pipeFds[1],
+        pipeFds[1] };
+    ASSERT_TRUE(sendRequest(socks[0], { "vsl" }, sent));
+    ASSERT_EQ(write(socks[0], "x", 1), 1);
+    close(socks[0]);
+    ASSERT_TRUE(receiveRequest(socks[1], args, fds));
+    EXPECT_EQ(args, std::vector<std::string>{ "vsl" });
+    for (int fd : fds)
+    {
+        close(fd);
+    }
+    EXPECT_FALSE(receiveRequest(socks[1], args, fds));
+    close(socks[1]);
+    close(pipeFds[0]);
+    close(pipeFds[1]);
+}
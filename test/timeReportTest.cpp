@@ -0,0 +1,34 @@
+#include "diag/timeReport.hpp"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+#include <string>
+
+TEST(TimeReportTest, PrintsPhasesInOrder)
+{
+    TimeReport report;
+    {
+        TimeReport::Scope parser{ &report, "parser" };
+        // nested phases pause the outer one
+        TimeReport::Scope lexer{ &report, "lexer" };
+    }
+    {
+        TimeReport::Scope lexer{ &report, "lexer" };
+    }
+    // a null report doesn't time anything
+    {
+        TimeReport::Scope nothing{ nullptr, "nothing" };
+    }
+    std::string json;
+    llvm::raw_string_ostream os{ json };
+    report.printJSON(os);
+    os.flush();
+    size_t parser = json.find("\"parser\": { \"wall\": ");
+    size_t lexer = json.find("\"lexer\": { \"wall\": ");
+    ASSERT_NE(parser, std::string::npos);
+    ASSERT_NE(lexer, std::string::npos);
+    EXPECT_LT(parser, lexer);
+    // phases that run more than once only show up once
+    EXPECT_EQ(json.find("\"lexer\"", lexer + 1), std::string::npos);
+    EXPECT_EQ(json.find("nothing"), std::string::npos);
+    EXPECT_NE(json.find("\"peak\": "), std::string::npos);
+}